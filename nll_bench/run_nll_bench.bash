@@ -0,0 +1,207 @@
+#!/bin/bash
+
+# nll_bench - reproducible location throughput benchmark for NLLoc
+#
+# Generates a synthetic network, a layered velocity model, 2D and 3D travel-time grids and numEvents synthetic
+# events (Vel2Grid, Grid2Time, Time2EQ), then locates the events with NLLoc in several configurations
+# and reports events/s, per-event latency (p50, p99) and peak RSS of each configuration in
+# <workDir>/nll_bench_results.txt (tab separated, one line per configuration).
+# Per-event latencies are taken from the NLLoc run statistics file (LOCPERF 1, <output root>.sum.perf).
+# All random choices use fixed seeds, so the inputs are identical for every run.
+#
+# usage: run_nll_bench.bash <NLL bin dir> <workDir> [<numEvents> [<configurations>]]
+#    configurations: space separated list from the following (default all), or any <search>_<misfit>_<grids>[_disk]
+#       with search oct, met or grid, misfit edt (EDT_OT_WT), l1 (L1_NORM) or gau (GAU_ANALYTIC), grids 2d or 3d:
+#       oct_edt_3d_mem    OCTTREE search, EDT_OT_WT misfit, 3D grids in memory
+#       oct_edt_3d_disk   OCTTREE search, EDT_OT_WT misfit, 3D grids read from disk
+#       oct_l1_3d_mem     OCTTREE search, L1_NORM misfit, 3D grids in memory
+#       met_edt_3d_mem    Metropolis search, EDT_OT_WT misfit, 3D grids in memory
+#       grid_gau_3d_mem   grid search, GAU_ANALYTIC misfit, 3D grids
+#       oct_edt_2d        OCTTREE search, EDT_OT_WT misfit, 2D grids
+#
+# also run by CMake target nll_bench (cmake --build . --target nll_bench, or: make nll_bench)
+#
+# 20261016 AJL - added
+
+
+BIN_DIR=$1
+WORK_DIR=$2
+NUM_EVENTS=${3:-200}
+CONFIGS=${4:-"oct_edt_3d_mem oct_edt_3d_disk oct_l1_3d_mem met_edt_3d_mem grid_gau_3d_mem oct_edt_2d"}
+
+if [ -z "${BIN_DIR}" ] || [ -z "${WORK_DIR}" ]; then
+	echo "usage: $0 <NLL bin dir> <workDir> [<numEvents> [<configurations>]]"
+	exit 1
+fi
+BIN_DIR=$(cd ${BIN_DIR} && pwd)
+for PROG in Vel2Grid Grid2Time Time2EQ NLLoc; do
+	if [ ! -x ${BIN_DIR}/${PROG} ]; then
+		echo "ERROR: program not found: ${BIN_DIR}/${PROG}"
+		exit 1
+	fi
+done
+
+mkdir -p ${WORK_DIR}
+cd ${WORK_DIR}
+rm -rf run model time2d time3d obs loc
+mkdir -p run model time2d time3d obs loc
+
+NUM_STATIONS=16
+SEED=12345
+
+
+echo "nll_bench: generating synthetic network and ${NUM_EVENTS} events"
+
+# stations, random in 100x100 km area
+awk -v n=${NUM_STATIONS} -v seed=${SEED} 'BEGIN {
+	srand(seed);
+	for (i = 0; i < n; i++)
+		printf("GTSRCE  ST%02d  XYZ  %.3f %.3f 0.0 0.0\n", i, -50.0 + 100.0 * rand(), -50.0 + 100.0 * rand());
+}' > run/stations.in
+
+# events, random in 60x60 km area, depth 2-30 km
+awk -v n=${NUM_EVENTS} -v seed=$((SEED + 1)) 'BEGIN {
+	srand(seed);
+	for (i = 0; i < n; i++)
+		printf("EQSRCE  EV%05d  XYZ  %.3f %.3f %.3f 0.0\n", i, -30.0 + 60.0 * rand(), -30.0 + 60.0 * rand(), 2.0 + 28.0 * rand());
+}' > run/events.in
+
+# common control statements
+cat > run/common.in << EOF
+CONTROL 1 ${SEED}
+TRANS  SIMPLE  45.0 10.0 0.0
+INCLUDE run/stations.in
+EOF
+
+# velocity model
+cat > run/model.in << EOF
+LAYER   0.0  5.00 0.0  2.89 0.0  2.6 0.0
+LAYER   5.0  5.80 0.0  3.35 0.0  2.7 0.0
+LAYER  15.0  6.40 0.0  3.70 0.0  2.8 0.0
+LAYER  30.0  8.00 0.0  4.62 0.0  3.3 0.0
+EOF
+
+# 2D and 3D model and time grids
+cat run/common.in run/model.in > run/grid2d.in
+cat >> run/grid2d.in << EOF
+VGOUT  ./model/bench2d
+VGTYPE P
+VGGRID  2 151 46  0.0 0.0 -2.0  1.0 1.0 1.0  SLOW_LEN
+GTFILES  ./model/bench2d  ./time2d/bench P
+GTMODE GRID2D ANGLES_NO
+GT_PLFD  1.0e-3  0
+EOF
+cat run/common.in run/model.in > run/grid3d.in
+cat >> run/grid3d.in << EOF
+VGOUT  ./model/bench3d
+VGTYPE P
+VGGRID  121 121 46  -60.0 -60.0 -2.0  1.0 1.0 1.0  SLOW_LEN
+GTFILES  ./model/bench3d  ./time3d/bench P
+GTMODE GRID3D ANGLES_NO
+GT_PLFD  1.0e-3  0
+EOF
+
+# synthetic arrivals, from 2D grids
+cat run/grid2d.in > run/synth.in
+cat >> run/synth.in << EOF
+EQFILES ./time2d/bench ./obs/synth.obs
+EQMODE SRCE_TO_STA
+EQVPVS  1.73
+EQQUAL2ERR 0.05 0.1 0.5 1.0 99999.9
+INCLUDE run/events.in
+EOF
+awk '{printf("EQSTA  %s  P  GAU 0.02  GAU 0.05\nEQSTA  %s  S  GAU 0.04  GAU 0.10\n", $2, $2)}' run/stations.in >> run/synth.in
+
+for CTRL in grid2d grid3d; do
+	if ! ${BIN_DIR}/Vel2Grid run/${CTRL}.in > run/Vel2Grid_${CTRL}.log 2>&1 \
+			|| ! ${BIN_DIR}/Grid2Time run/${CTRL}.in > run/Grid2Time_${CTRL}.log 2>&1; then
+		echo "ERROR: generating ${CTRL} grids, see ${WORK_DIR}/run/*_${CTRL}.log"
+		exit 1
+	fi
+done
+if ! ${BIN_DIR}/Time2EQ run/synth.in > run/Time2EQ.log 2>&1; then
+	echo "ERROR: generating synthetic arrivals, see ${WORK_DIR}/run/Time2EQ.log"
+	exit 1
+fi
+
+
+# locate events with each configuration
+
+RESULTS=nll_bench_results.txt
+{
+	echo "# nll_bench  date $(date -u +%Y-%m-%dT%H:%M:%SZ)  host $(uname -n)  cpus $(getconf _NPROCESSORS_ONLN 2>/dev/null)  events ${NUM_EVENTS}  stations ${NUM_STATIONS}"
+	echo "# latency: elapsed time of location of each event (sec), maxrss: peak resident set size of NLLoc (kB on Linux)"
+	printf "config\tevents\tlocated\twall_s\tevents_per_s\tlatency_p50_s\tlatency_p99_s\tlatency_mean_s\tmaxrss\n"
+} > ${RESULTS}
+
+for CONFIG in ${CONFIGS}; do
+
+	SEARCH=$(echo ${CONFIG} | cut -d_ -f1)
+	METHOD=$(echo ${CONFIG} | cut -d_ -f2)
+	GRIDS=$(echo ${CONFIG} | cut -d_ -f3)
+	ACCESS=$(echo ${CONFIG} | cut -d_ -f4)
+
+	case ${SEARCH} in
+		oct) LOCSEARCH="LOCSEARCH  OCT 10 10 4 0.01 20000 5000 0 1" ;;
+		met) LOCSEARCH="LOCSEARCH  MET 10000 1000 4000 5000 5 -1 0.01 8.0 1.0e-10" ;;
+		grid) LOCSEARCH="LOCSEARCH  GRID 5000" ;;
+		*) echo "ERROR: unknown configuration: ${CONFIG}"; continue ;;
+	esac
+	if [ ${SEARCH} = grid ]; then
+		LOCGRID="LOCGRID  51 51 31  -50.0 -50.0 -2.0  2.0 2.0 1.0   PROB_DENSITY  SAVE"
+	else
+		LOCGRID="LOCGRID  101 101 41  -50.0 -50.0 -2.0  1.0 1.0 1.0   PROB_DENSITY  SAVE"
+	fi
+	case ${METHOD} in
+		edt) LOCMETH_NAME=EDT_OT_WT ;;
+		l1) LOCMETH_NAME=L1_NORM ;;
+		gau) LOCMETH_NAME=GAU_ANALYTIC ;;
+		*) echo "ERROR: unknown configuration: ${CONFIG}"; continue ;;
+	esac
+	# maximum number of 3D grids in memory, 0 = grids read from disk
+	MAX_NUM_3D_GRID=-1
+	[ "${ACCESS}" = disk ] && MAX_NUM_3D_GRID=0
+	TIME_ROOT=./time${GRIDS}/bench
+
+	cat run/common.in > run/${CONFIG}.in
+	cat >> run/${CONFIG}.in << EOF
+LOCSIG nll_bench
+LOCCOM nll_bench ${CONFIG}
+LOCFILES ./obs/synth.obs NLLOC_OBS  ${TIME_ROOT}  ./loc/${CONFIG}
+LOCHYPOUT SAVE_NLLOC_ALL
+${LOCSEARCH}
+${LOCGRID}
+LOCMETH ${LOCMETH_NAME} 9999.0 4 -1 -1 1.73 ${MAX_NUM_3D_GRID} -1.0 1
+LOCGAU 0.2 0.0
+LOCGAU2 0.02 0.05 2.0
+LOCPHASEID  P   P p
+LOCPHASEID  S   S s
+LOCQUAL2ERR 0.1 0.5 1.0 2.0 99999.9
+LOCANGLES ANGLES_NO 5
+LOCPERF 1
+EOF
+
+	echo "nll_bench: locating with configuration ${CONFIG}"
+	rm -f loc/${CONFIG}.*
+	if ! ${BIN_DIR}/NLLoc run/${CONFIG}.in > run/NLLoc_${CONFIG}.log 2>&1 || [ ! -f loc/${CONFIG}.sum.perf ]; then
+		echo "ERROR: running NLLoc, see ${WORK_DIR}/run/NLLoc_${CONFIG}.log"
+		continue
+	fi
+
+	# per-event latencies (field after "total") sorted, nearest-rank percentiles
+	awk '$1 == "EVENT" {for (i = 4; i < NF; i++) if ($i == "total") print $(i + 1)}' loc/${CONFIG}.sum.perf | sort -g > run/${CONFIG}.latency
+	awk -v config=${CONFIG} '
+		FILENAME ~ /latency$/ {lat[n++] = $1; sum += $1; next}
+		$1 == "EVENT" && $3 == "LOCATED" {nlocated++}
+		$1 == "RUN" {for (i = 2; i < NF; i++) {if ($i == "events") nev = $(i + 1); if ($i == "wall") wall = $(i + 1); if ($i == "maxRSS") rss = $(i + 1)}}
+		function pct(p,  k) {if (n < 1) return -1; k = int(p * n + 0.999999) - 1; if (k < 0) k = 0; return lat[k]}
+		END {
+			printf("%s\t%d\t%d\t%.3f\t%.2f\t%.6f\t%.6f\t%.6f\t%s\n", config, nev, nlocated, wall, wall > 0 ? nev / wall : 0,
+				pct(0.50), pct(0.99), n > 0 ? sum / n : -1, rss);
+		}' run/${CONFIG}.latency loc/${CONFIG}.sum.perf >> ${RESULTS}
+
+done
+
+echo
+echo "nll_bench: results in ${WORK_DIR}/${RESULTS}"
+cat ${RESULTS}
@@ -159,6 +159,15 @@ float wvfrnt_dtemps;
 char fn_gt_input[MAXLINE_LONG], fn_gt_output[MAXLINE_LONG];
 int iSwapBytesOnInput;
 
+// 20261016 agent - added compressed time grid output
+int gt_compress; /* 1 = write compressed time grids */
+double gt_compress_max_error; /* maximum absolute error of compressed time grid values (sec) */
+int gt_compress_brick_size; /* size of compressed grid bricks (nodes) */
+
+// 20261016 agent - added grid bundle output
+int gt_bundle; /* 1 = append time and angle grids to grid bundle <output root>.bundle */
+char gt_bundle_root[MAXLINE_LONG]; /* grid bundle root (GTFILES output root) */
+
 
 /* function declarations */
 
@@ -166,6 +175,9 @@ int ReadGrid2TimeInput(FILE*);
 int get_gt_files(char*);
 int get_grid_mode(char*);
 int get_gt_plfd(char*);
+int get_gt_compress(char*);
+int get_gt_bundle(char*);
+int AppendToGridBundle(char*, char*);
 int GenTimeGrid(GridDesc*, SourceDesc*, GridDesc*, char*);
 int GenAngleGrid(GridDesc*, SourceDesc*, GridDesc*, int);
 void InitTimeGrid(GridDesc*, GridDesc*);
@@ -627,6 +639,8 @@ int GenTimeGrid(GridDesc* pmgrid, SourceDesc* psource, GridDesc* ptt_grid, char*
         itemp = ptt_grid->numx;
         ptt_grid->numx = 1;
     }
+    if (gt_compress)
+        setCompressedGrid(ptt_grid, gt_compress_brick_size, gt_compress_max_error);
     istat = WriteGrid3dBuf(ptt_grid, psource, filename, "time");
     if (grid_mode == GRID_TIME_2D)
         ptt_grid->numx = itemp;
@@ -634,6 +648,8 @@ int GenTimeGrid(GridDesc* pmgrid, SourceDesc* psource, GridDesc* ptt_grid, char*
         nll_puterr("ERROR: writing slowness grid to disk.");
         return (-1);
     }
+    if (gt_bundle && AppendToGridBundle(filename, "time") < 0)
+        return (-1);
 
 
     return (0);
@@ -912,6 +928,22 @@ int ReadGrid2TimeInput(FILE* fp_input) {
         }
 
 
+        /* read compressed time grid output params */
+
+        if (strcmp(param, "GT_COMPRESS") == 0) {
+            if ((istat = get_gt_compress(strchr(line, ' '))) < 0)
+                nll_puterr("ERROR: reading compressed grid params.");
+        }
+
+
+        /* read grid bundle output params */
+
+        if (strcmp(param, "GT_BUNDLE") == 0) {
+            if ((istat = get_gt_bundle(strchr(line, ' '))) < 0)
+                nll_puterr("ERROR: reading grid bundle params.");
+        }
+
+
         /*read transform params */
 
         if (strcmp(param, "TRANS") == 0) {
@@ -978,6 +1010,7 @@ int get_gt_files(char* line1) {
     if (istat < 4)
         iSwapBytesOnInput = 0;
 
+    strcpy(gt_bundle_root, fn_gt_output); // 20261016 agent - added, grids of all wave types go to the same bundle
     strcat(strcat(fn_gt_input, "."), waveType);
     strcat(strcat(fn_gt_output, "."), waveType);
 
@@ -1057,6 +1090,69 @@ int get_gt_plfd(char* line1) {
 
 }
 
+/*** function to read compressed time grid output params ***/
+
+int get_gt_compress(char* line1) {
+    int istat;
+
+    gt_compress_brick_size = COMPRESSED_GRID_BRICK_SIZE_DEFAULT;
+    istat = sscanf(line1, "%lf %d", &gt_compress_max_error, &gt_compress_brick_size);
+
+    sprintf(MsgStr, "Grid2Time GT_COMPRESS: max_error %g  brick_size %d",
+            gt_compress_max_error, gt_compress_brick_size);
+    nll_putmsg(3, MsgStr);
+
+    if (istat < 1 || gt_compress_max_error <= 0.0
+            || gt_compress_brick_size < 1 || gt_compress_brick_size > COMPRESSED_GRID_BRICK_SIZE_MAX) {
+        gt_compress = 0;
+        sprintf(MsgStr, "ERROR: GT_COMPRESS: max_error must be > 0 and brick_size in range 1-%d", COMPRESSED_GRID_BRICK_SIZE_MAX);
+        nll_puterr(MsgStr);
+        return (-1);
+    }
+
+    gt_compress = 1;
+
+    return (0);
+
+}
+
+/*** function to read grid bundle output params ***/
+
+int get_gt_bundle(char* line1) {
+    int istat;
+
+    istat = sscanf(line1, "%d", &gt_bundle);
+
+    sprintf(MsgStr, "Grid2Time GT_BUNDLE: %d", gt_bundle);
+    nll_putmsg(3, MsgStr);
+
+    if (istat < 1) {
+        gt_bundle = 0;
+        return (-1);
+    }
+
+    return (0);
+
+}
+
+/*** function to move grid files <filename>.<file_type>.* into grid bundle <output root>.bundle ***/
+
+int AppendToGridBundle(char* filename, char* file_type) {
+
+    char grid_root[2 * MAXLINE_LONG];
+
+    sprintf(grid_root, "%s.%s", filename, file_type);
+    if (GridBundle_AppendGrid(gt_bundle_root, grid_root, 1) < 0) {
+        nll_puterr2("ERROR: appending grid to grid bundle", grid_root);
+        return (-1);
+    }
+    sprintf(MsgStr, "Grid appended to grid bundle: %s.%s", gt_bundle_root, GRID_BUNDLE_EXT);
+    nll_putmsg(1, MsgStr);
+
+    return (0);
+
+}
+
 /*** function to read Wavefront params ***/
 
 int get_gt_wavefront(char* line1) {
@@ -1161,6 +1257,8 @@ int GenAngleGrid(GridDesc* ptgrid, SourceDesc* psource, GridDesc* pagrid, int an
         nll_puterr("ERROR: writing take-off angles grid to disk.");
         return (-1);
     }
+    if (gt_bundle && AppendToGridBundle(filename, angle_mode == ANGLE_MODE_YES ? "angle" : "inclination") < 0)
+        return (-1);
 
 
     return (0);
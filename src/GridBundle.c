@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+/*   GridBundle.c
+
+        Program to append grid files to a grid bundle file
+
+ */
+
+
+/*
+        history:
+
+        ver 01    20261016  agent  Original version
+
+
+.........1.........2.........3.........4.........5.........6.........7.........8
+
+ */
+
+
+
+#include "GridLib.h"
+
+
+// defines
+
+
+// globals
+
+
+// functions
+
+int DoBundleProcess(int argc, char *argv[], int remove_files);
+
+
+
+/*** Program to append grid files to a grid bundle */
+
+#define PNAME  "GridBundle"
+
+int main(int argc, char *argv[]) {
+
+    int narg;
+    int remove_files = 0;
+
+
+    // set program name
+
+    strcpy(prog_name, PNAME);
+
+
+    // check command line for correct usage
+
+    fprintf(stdout, "\n%s Arguments: ", prog_name);
+    for (narg = 0; narg < argc; narg++)
+        fprintf(stdout, "<%s> ", argv[narg]);
+    fprintf(stdout, "\n");
+
+    if (argc > 2) {
+        if (argc > 3)
+            remove_files = atoi(argv[3]);
+    } else {
+        disp_usage(PNAME,
+                "<bundle root> <input grid(s)> [<remove>]\n"
+                "   bundle root - grids are appended to file <bundle root>.bundle, the input grid file roots must have the form <bundle root>.<name>\n"
+                "   input grid(s) - grid buffer files (*.buf) or grid roots to append, may contain wildcards, e.g. time/layer.*.time\n"
+                "   remove - 1 to remove the input grid files after appending (default 0)"
+                );
+        exit(-1);
+    }
+
+    if (DoBundleProcess(argc, argv, remove_files) < 0)
+        exit(-1);
+
+    exit(0);
+
+}
+
+/*** returns 1 if file name ends with grid buffer file extension .buf */
+
+static int gridbundle_is_buf_file(char *fn_grid) {
+
+    size_t len = strlen(fn_grid);
+
+    return (len > 4 && strcmp(fn_grid + len - 4, ".buf") == 0);
+
+}
+
+int DoBundleProcess(int argc, char *argv[], int remove_files) {
+
+#define MAX_NUM_INPUT_FILES 16384
+    char (*fn_grid_in_list)[FILENAME_MAX] = malloc(MAX_NUM_INPUT_FILES * sizeof (*fn_grid_in_list));
+    char fn_grid_in_base[FILENAME_MAX];
+    strcpy(fn_grid_in_base, argv[2]);
+    // 20261017 agent - added, input may be grid root(s) (e.g. time/layer.*.time), as for other Grid programs
+    if (!gridbundle_is_buf_file(fn_grid_in_base))
+        strcat(fn_grid_in_base, ".buf");
+
+    // check for wildcards in input file name
+    int numFiles;
+    if ((numFiles = ExpandWildCards(fn_grid_in_base, fn_grid_in_list, MAX_NUM_INPUT_FILES)) < 1) {
+        nll_puterr2("ERROR: no matching grid files found: ", fn_grid_in_base);
+        free(fn_grid_in_list);
+        return (-1);
+    }
+    if (numFiles >= MAX_NUM_INPUT_FILES) {
+        sprintf(MsgStr, "WARNING: maximum number of grid files exceeded, only first %d will be processed.", MAX_NUM_INPUT_FILES);
+        nll_puterr(MsgStr);
+    }
+
+
+    // bundle root
+    char bundle_root[FILENAME_MAX];
+    strcpy(bundle_root, argv[1]);
+
+    char fn_grid_in[FILENAME_MAX];
+    int numAppended = 0;
+
+
+    for (int nFile = 0; nFile < numFiles; nFile++) {
+
+        // input file name
+        strcpy(fn_grid_in, fn_grid_in_list[nFile]);
+        if (gridbundle_is_buf_file(fn_grid_in)) {
+            *strrchr(fn_grid_in, '.') = '\0'; // remove extension from input filename
+        } else {
+            sprintf(MsgStr, "WARNING: not a grid buffer file (*.buf), skipping: %s", fn_grid_in);
+            nll_putmsg(1, MsgStr);
+            continue; // not grid buffer file
+        }
+
+        sprintf(MsgStr, "Appending grid: %s -> %s.%s", fn_grid_in, bundle_root, GRID_BUNDLE_EXT);
+        nll_putmsg(0, MsgStr);
+
+        if (GridBundle_AppendGrid(bundle_root, fn_grid_in, remove_files) < 0) {
+            nll_puterr2("ERROR: appending grid to grid bundle", fn_grid_in);
+            free(fn_grid_in_list);
+            return (-1);
+        }
+        numAppended++;
+
+    }
+
+    sprintf(MsgStr, "%d grids appended to grid bundle: %s.%s", numAppended, bundle_root, GRID_BUNDLE_EXT);
+    nll_putmsg(0, MsgStr);
+
+    free(fn_grid_in_list);
+
+    if (numAppended < 1) {
+        nll_puterr2("ERROR: no grid files appended: ", fn_grid_in_base);
+        return (-1);
+    }
+
+    return (0);
+
+}
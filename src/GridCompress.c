@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+/*   GridCompress.c
+
+        Program to convert travel time grid files to compressed grid files, or compressed grid files back to regular grid files
+
+ */
+
+
+/*
+        history:
+
+        ver 01    20261016  agent  Original version
+
+
+.........1.........2.........3.........4.........5.........6.........7.........8
+
+ */
+
+
+
+#include "GridLib.h"
+
+
+// defines
+
+
+// globals
+
+
+// functions
+
+int DoCompressProcess(int argc, char *argv[], double max_error, int brick_size);
+
+
+
+/*** Program to compress time grid files */
+
+#define PNAME  "GridCompress"
+
+int main(int argc, char *argv[]) {
+
+    int narg;
+    double max_error;
+    int brick_size = COMPRESSED_GRID_BRICK_SIZE_DEFAULT;
+
+
+    // set program name
+
+    strcpy(prog_name, PNAME);
+
+
+    // check command line for correct usage
+
+    fprintf(stdout, "\n%s Arguments: ", prog_name);
+    for (narg = 0; narg < argc; narg++)
+        fprintf(stdout, "<%s> ", argv[narg]);
+    fprintf(stdout, "\n");
+
+    if (argc > 3) {
+        max_error = atof(argv[3]);
+        if (argc > 4)
+            brick_size = atoi(argv[4]);
+    } else {
+        disp_usage(PNAME,
+                "<input grid(s)> <output grid path> <max_error> [<brick_size>]\n"
+                "   input grid(s) - grid buffer files (*.buf) or grid roots, may contain wildcards, e.g. time/layer.P.*.time\n"
+                "   max_error - maximum absolute error of compressed grid values (e.g. 0.0001 sec), <= 0 to write regular (uncompressed) grids\n"
+                "   brick_size - number of grid nodes along each side of a compressed grid brick (default 8)"
+                );
+        exit(-1);
+    }
+    if (brick_size < 1 || brick_size > COMPRESSED_GRID_BRICK_SIZE_MAX) {
+        sprintf(MsgStr, "ERROR: brick_size must be in range 1-%d", COMPRESSED_GRID_BRICK_SIZE_MAX);
+        nll_puterr(MsgStr);
+        exit(-1);
+    }
+
+    if (DoCompressProcess(argc, argv, max_error, brick_size) < 0)
+        exit(-1);
+
+    exit(0);
+
+}
+
+/*** returns 1 if file name ends with grid buffer file extension .buf */
+
+static int gridcompress_is_buf_file(char *fn_grid) {
+
+    size_t len = strlen(fn_grid);
+
+    return (len > 4 && strcmp(fn_grid + len - 4, ".buf") == 0);
+
+}
+
+int DoCompressProcess(int argc, char *argv[], double max_error, int brick_size) {
+    int istat;
+
+
+#define MAX_NUM_INPUT_FILES 4096
+    char (*fn_grid_in_list)[FILENAME_MAX] = malloc(MAX_NUM_INPUT_FILES * sizeof (*fn_grid_in_list));
+    char fn_grid_in_base[FILENAME_MAX];
+    strcpy(fn_grid_in_base, argv[1]);
+    // 20261017 agent - added, input may be grid root(s) (e.g. time/layer.P.*.time), as for other Grid programs
+    if (!gridcompress_is_buf_file(fn_grid_in_base))
+        strcat(fn_grid_in_base, ".buf");
+
+    // check for wildcards in input file name
+    int numFiles;
+    if ((numFiles = ExpandWildCards(fn_grid_in_base, fn_grid_in_list, MAX_NUM_INPUT_FILES)) < 1) {
+        nll_puterr2("ERROR: no matching grid files found: ", fn_grid_in_base);
+        free(fn_grid_in_list);
+        return (-1);
+    }
+    if (numFiles >= MAX_NUM_INPUT_FILES) {
+        sprintf(MsgStr, "WARNING: maximum number of grid files exceeded, only first %d will be processed.", MAX_NUM_INPUT_FILES);
+        nll_puterr(MsgStr);
+    }
+
+
+    // output file root
+    char grid_out_path[FILENAME_MAX];
+    strcpy(grid_out_path, argv[2]);
+
+    char fn_grid_in[FILENAME_MAX];
+    char fn_grid_out[FILENAME_MAX];
+    FILE *fp_grid_in;
+    FILE *fp_grid_in_hdr;
+    GridDesc grid;
+    SourceDesc sourceDesc;
+    char file_type[FILENAME_MAX];
+
+
+    int numProcessed = 0;
+    for (int nFile = 0; nFile < numFiles; nFile++) {
+
+        // input file name
+        strcpy(fn_grid_in, fn_grid_in_list[nFile]);
+        if (gridcompress_is_buf_file(fn_grid_in)) {
+            *strrchr(fn_grid_in, '.') = '\0'; // remove extension from output filename
+        } else {
+            // 20261017 agent - added message, was skipped silently
+            sprintf(MsgStr, "WARNING: not a grid buffer file (*.buf), skipping: %s", fn_grid_in);
+            nll_putmsg(1, MsgStr);
+            continue; // not grid buffer file
+        }
+
+        // output file name
+        char *cpos;
+        if ((cpos = strrchr(fn_grid_in, '/')) != NULL) {
+            cpos++;
+        } else {
+            cpos = fn_grid_in;
+        }
+        sprintf(fn_grid_out, "%s/%s", grid_out_path, cpos);
+
+        // set grid file type (e.g. time, ...)
+        if (strrchr(fn_grid_in, '.') != NULL) {
+            strcpy(file_type, strrchr(fn_grid_in, '.') + 1);
+            *strrchr(fn_grid_out, '.') = '\0'; // remove type from output filename
+        } else {
+            strcpy(file_type, "");
+        }
+
+        // open input grid file
+        if ((istat = OpenGrid3dFile(fn_grid_in, &fp_grid_in, &fp_grid_in_hdr,
+                &grid, file_type, &sourceDesc, 0)) < 0 || fp_grid_in == NULL) {
+            nll_puterr2("ERROR: opening input grid file", fn_grid_in);
+            free(fn_grid_in_list);
+            return (-1);
+        }
+        if (grid.type != GRID_TIME && grid.type != GRID_TIME_2D) {
+            sprintf(MsgStr, "WARNING: not a time grid, skipping: %s", fn_grid_in);
+            nll_putmsg(1, MsgStr);
+            CloseGrid3dFile(&grid, &fp_grid_in, &fp_grid_in_hdr);
+            continue;
+        }
+        if (isCascadingGrid(&grid)) {
+            sprintf(MsgStr, "WARNING: cascading grids cannot be compressed, skipping: %s", fn_grid_in);
+            nll_putmsg(1, MsgStr);
+            CloseGrid3dFile(&grid, &fp_grid_in, &fp_grid_in_hdr);
+            continue;
+        }
+        // set map projection if available, so will be written to output grid header
+        if (strlen(grid.mapProjStr) > 0) {
+            strcpy(MapProjStr[0], grid.mapProjStr);
+        }
+
+        sprintf(MsgStr, "Processing grid: %s -> %s", fn_grid_in, fn_grid_out);
+        nll_putmsg(0, MsgStr);
+
+        // read input grid
+        grid.buffer = AllocateGrid(&grid);
+        if (grid.buffer == NULL) {
+            nll_puterr("ERROR: allocating memory for grid buffer.\n");
+            free(fn_grid_in_list);
+            return (-1);
+        }
+        if (ReadGrid3dBuf(&grid, fp_grid_in) < 0) {
+            nll_puterr2("ERROR: reading grid file", fn_grid_in);
+            free(fn_grid_in_list);
+            return (-1);
+        }
+        CloseGrid3dFile(&grid, &fp_grid_in, &fp_grid_in_hdr);
+
+        // write output grid, compressed or regular
+        grid.iSwapBytes = 0;
+        if (max_error > 0.0) {
+            setCompressedGrid(&grid, brick_size, max_error);
+        } else {
+            grid.flagGridCompressed = IS_NOT_COMPRESSED;
+        }
+        if ((istat = WriteGrid3dBuf(&grid, &sourceDesc, fn_grid_out, file_type)) < 0) {
+            nll_puterr("ERROR: writing output grid to disk.\n");
+            free(fn_grid_in_list);
+            return (-1);
+        }
+
+        FreeGrid(&grid);
+        numProcessed++;
+
+    }
+
+    free(fn_grid_in_list);
+
+    // 20261017 agent - added, error if no grid processed
+    if (numProcessed < 1) {
+        nll_puterr2("ERROR: no travel time grid files processed: ", fn_grid_in_base);
+        return (-1);
+    }
+
+    return (0);
+
+}
@@ -45,36 +45,56 @@ e-mail: anthony@alomax.net  web: http://www.alomax.net
 
 
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <pthread.h>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#endif
+
 #include "GridLib.h"
 
+// 20261016 agent - grid bundles are read through memory streams (fmemopen()), available in POSIX.1-2008 and GNU C libraries
+#if defined(_GNU_SOURCE) || (defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200809L)
+#define GRID_BUNDLE_MEMSTREAM
+#endif
+
 // define globals
+// 20261017 agent - control parameters set by control file statements (CONTROL, TRANS, LOCSRCE/GTSRCE, LOCPHASEID,
+//    LOCQUAL2ERR, ...) are thread local, so that concurrent NLLoc() runs in different threads do not share them
 
 int nll_mode;
-PhaseIdent PhaseID[MAX_NUM_PHASE_ID];
-int NumPhaseID;
-char fn_control[MAXLINE]; /* control file name */
-FILE *fp_control; /* control file pointer */
-char fn_output[MAXLINE]; /* output file name */
+NLL_THREAD_LOCAL PhaseIdent PhaseID[MAX_NUM_PHASE_ID];
+NLL_THREAD_LOCAL int NumPhaseID;
+NLL_THREAD_LOCAL char fn_control[MAXLINE]; /* control file name */
+NLL_THREAD_LOCAL FILE *fp_control; /* control file pointer */
+NLL_THREAD_LOCAL char fn_output[MAXLINE]; /* output file name */
 
 /* miscellaneous */
-int RandomNumSeed;
-int NumFilesOpen;
-int NumGridBufFilesOpen, NumGridHdrFilesOpen;
-int NumAllocations;
+NLL_THREAD_LOCAL int RandomNumSeed;
+NLL_THREAD_LOCAL int NumFilesOpen;
+NLL_THREAD_LOCAL int NumGridBufFilesOpen, NumGridHdrFilesOpen;
+NLL_THREAD_LOCAL int NumAllocations;
+NLL_THREAD_LOCAL size_t NumGridBytesRead; // 20261016 agent - added
+NLL_THREAD_LOCAL char HypoPerfLine[MAXLINE_LONG]; // 20261016 agent - added
 
 /* algorithm constants */
 int prog_mode_3d;
 int prog_mode_2dto3d;
 
-int GeometryMode;
+NLL_THREAD_LOCAL int GeometryMode;
 
 /* 3D grid description */
 int grid_type; /* grid type (VELOCITY, SLOWNESS, SLOW2, etc) */
 GridDesc grid_in;
 
 /* source */
-int NumSources;
-SourceDesc Source[MAX_NUM_SOURCES];
+NLL_THREAD_LOCAL int NumSources;
+NLL_THREAD_LOCAL SourceDesc *Source; // 20261017 agent - list of MAX_NUM_SOURCES sources allocated by AllocSources()
 
 /* stations */
 //int NumStations;
@@ -84,24 +104,24 @@ StationDesc Station[MAX_NUM_SOURCES];
 int PhaseFormat;
 int MAX_NUM_STATIONS;
 int MAX_NUM_ARRIVALS;
-int NumArrivals;
-ArrivalDesc* Arrival;
+NLL_THREAD_LOCAL int NumArrivals;
+NLL_THREAD_LOCAL ArrivalDesc* Arrival;
 
 /* hypocenter */
-HypoDesc Hypocenter;
+NLL_THREAD_LOCAL HypoDesc Hypocenter;
 
-char map_trans_type[NUM_PROJ_MAX][MAXLINE]; /* name of projection */
-int map_itype[NUM_PROJ_MAX]; /* int id of projection */
-char MapProjStr[NUM_PROJ_MAX][2 * MAXLINE]; /* string description of proj params */
-char map_ref_ellipsoid[NUM_PROJ_MAX][MAXLINE]; /* name of reference ellipsoid */
+NLL_THREAD_LOCAL char map_trans_type[NUM_PROJ_MAX][MAXLINE]; /* name of projection */
+NLL_THREAD_LOCAL int map_itype[NUM_PROJ_MAX]; /* int id of projection */
+NLL_THREAD_LOCAL char MapProjStr[NUM_PROJ_MAX][2 * MAXLINE]; /* string description of proj params */
+NLL_THREAD_LOCAL char map_ref_ellipsoid[NUM_PROJ_MAX][MAXLINE]; /* name of reference ellipsoid */
 /* general map parameters */
-double map_orig_lat[NUM_PROJ_MAX], map_orig_long[NUM_PROJ_MAX], map_rot[NUM_PROJ_MAX], map_scale_factor[NUM_PROJ_MAX];
-long map_false_easting[NUM_PROJ_MAX];
-double map_cosang[NUM_PROJ_MAX], map_sinang[NUM_PROJ_MAX]; /* rotation */
+NLL_THREAD_LOCAL double map_orig_lat[NUM_PROJ_MAX], map_orig_long[NUM_PROJ_MAX], map_rot[NUM_PROJ_MAX], map_scale_factor[NUM_PROJ_MAX];
+NLL_THREAD_LOCAL long map_false_easting[NUM_PROJ_MAX];
+NLL_THREAD_LOCAL double map_cosang[NUM_PROJ_MAX], map_sinang[NUM_PROJ_MAX]; /* rotation */
 /* LAMBERT projection parameters */
-double map_lambert_1st_std_paral[NUM_PROJ_MAX], map_lambert_2nd_std_paral[NUM_PROJ_MAX];
+NLL_THREAD_LOCAL double map_lambert_1st_std_paral[NUM_PROJ_MAX], map_lambert_2nd_std_paral[NUM_PROJ_MAX];
 /* SDC Short Distance Coversion projection parameters */
-double map_sdc_xltkm[NUM_PROJ_MAX], map_sdc_xlnkm[NUM_PROJ_MAX];
+NLL_THREAD_LOCAL double map_sdc_xltkm[NUM_PROJ_MAX], map_sdc_xlnkm[NUM_PROJ_MAX];
 
 /* constants */
 double cPI;
@@ -109,21 +129,21 @@ double cRPD;
 double c111;
 
 /* include file */
-char fn_include[FILENAME_MAX];
-FILE* fp_include;
-FILE* fp_input_save;
+NLL_THREAD_LOCAL char fn_include[FILENAME_MAX];
+NLL_THREAD_LOCAL FILE* fp_include;
+NLL_THREAD_LOCAL FILE* fp_input_save;
 
 /* take-off angle */
 TakeOffAngles AnglesNULL;
 
 /* quality to error mapping (hypo71, etc) */
-double Quality2Error[MAX_NUM_QUALITY_LEVELS];
-int NumQuality2ErrorLevels;
+NLL_THREAD_LOCAL double Quality2Error[MAX_NUM_QUALITY_LEVELS];
+NLL_THREAD_LOCAL int NumQuality2ErrorLevels;
 
 // int ModelCoordsMode;  // 20200608 AJL - bug fix (e-mail 07/06/2020 03:11 陈俊磊)
-int ModelCoordsMode;
+NLL_THREAD_LOCAL int ModelCoordsMode;
 
-char ExpandWildCards_pattern[FILENAME_MAX];
+NLL_THREAD_LOCAL char ExpandWildCards_pattern[FILENAME_MAX];
 
 
 
@@ -278,6 +298,34 @@ void SwapBackIncludeFP(FILE **fp_io) {
 
 }
 
+/** function to allocate the source list of the calling thread
+ *
+ * returns < 0 on error
+ */
+
+// 20261017 agent - added, source list is thread local
+
+int AllocSources() {
+
+    if (Source == NULL && (Source = (SourceDesc *) calloc(MAX_NUM_SOURCES, sizeof (SourceDesc))) == NULL) {
+        nll_puterr("ERROR: allocating memory for sources.");
+        return (-1);
+    }
+
+    return (0);
+
+}
+
+/** function to free the source list of the calling thread */
+
+void FreeSources() {
+
+    free(Source);
+    Source = NULL;
+    NumSources = 0;
+
+}
+
 /** function to read source params from input line */
 
 int GetNextSource(char* in_line) {
@@ -290,6 +338,8 @@ int GetNextSource(char* in_line) {
         nll_puterr2("ERROR: to many sources, ignoring source", srce_in->label);
         return (0);
     }
+    if (AllocSources() < 0)
+        return (-1);
 
     srce_in = Source + NumSources;
     istat = GetSource(in_line, srce_in, NumSources);
@@ -954,6 +1004,825 @@ void setCascadingGrid(GridDesc* pgrid) {
 
 }
 
+/** function to determine if a grid is type Compressed 3D grid
+ *
+ * 20261016 agent - added
+ */
+
+int isCompressedGrid(GridDesc* pgrid) {
+
+    return (pgrid->flagGridCompressed == IS_COMPRESSED);
+
+}
+
+/** function set a grid as type Compressed 3D grid
+ *
+ * 20261016 agent - added
+ *
+ *  Only travel time grids are written compressed, other grid types (e.g. angle grids with bit-packed values) are always
+ *  written as raw grid values.
+ */
+
+void setCompressedGrid(GridDesc* pgrid, int brick_size, double max_error) {
+
+    pgrid->flagGridCompressed = IS_COMPRESSED;
+
+    if (brick_size < 1)
+        brick_size = COMPRESSED_GRID_BRICK_SIZE_DEFAULT;
+    if (brick_size > COMPRESSED_GRID_BRICK_SIZE_MAX)
+        brick_size = COMPRESSED_GRID_BRICK_SIZE_MAX;
+    pgrid->gridDesc_Compressed.brick_size = brick_size;
+    pgrid->gridDesc_Compressed.max_error = max_error > 0.0 ? max_error : COMPRESSED_GRID_MAX_ERROR_DEFAULT;
+
+}
+
+/** function to determine if a grid will be written to disk as a compressed grid
+ *
+ * 20261016 agent - added
+ */
+
+static int writeAsCompressedGrid(GridDesc* pgrid) {
+
+    return (isCompressedGrid(pgrid) && !isCascadingGrid(pgrid)
+            && (pgrid->type == GRID_TIME || pgrid->type == GRID_TIME_2D));
+
+}
+
+
+/* compressed grid buffer file layout (native byte order):
+ *   file header: magic[8], version, brick_size, numx, numy, numz, sizeof(GRID_FLOAT_TYPE), reserved  (int32)
+ *   brick index: num_bricks + 1 byte offsets of bricks from start of file  (int64)
+ *   bricks in x, y, z brick order, grid nodes in each brick in x, y, z order:
+ *      brick minimum value and quantization step (double), number of bits per residual and 4 anchor values (int32), then
+ *      bit-packed zigzag encoded prediction residuals of quantized values (nbits > 0), or raw grid values (nbits == COMPRESSED_BRICK_RAW),
+ *      or no values (nbits == 0, all residuals are zero)
+ */
+#define COMPRESSED_GRID_MAGIC "NLLBRICK"
+#define COMPRESSED_GRID_VERSION 1
+#define COMPRESSED_GRID_HEADER_SIZE (8 + 7 * sizeof (int32_t))
+#define COMPRESSED_BRICK_HEADER_SIZE (2 * sizeof (double) + 5 * sizeof (int32_t))
+#define COMPRESSED_BRICK_RAW -1
+#define COMPRESSED_BRICK_MAX_QBITS 24 // maximum number of bits of quantized values
+#define COMPRESSED_BRICK_MAX_NBITS 32 // maximum number of bits of packed prediction residuals
+
+typedef struct {
+    int nbx, nby, nbz; // number of bricks along each axis
+    long num_bricks;
+} CompressedGridBricks;
+
+static void compressed_grid_bricks(GridDesc* pgrid, CompressedGridBricks* pbricks) {
+
+    int brick_size = pgrid->gridDesc_Compressed.brick_size;
+
+    pbricks->nbx = (pgrid->numx + brick_size - 1) / brick_size;
+    pbricks->nby = (pgrid->numy + brick_size - 1) / brick_size;
+    pbricks->nbz = (pgrid->numz + brick_size - 1) / brick_size;
+    pbricks->num_bricks = (long) pbricks->nbx * (long) pbricks->nby * (long) pbricks->nbz;
+
+}
+
+/** function to get grid index ranges of a brick */
+
+static int compressed_brick_range(GridDesc* pgrid, CompressedGridBricks* pbricks, long ibrick,
+        int *ix0, int *iy0, int *iz0, int *bx, int *by, int *bz) {
+
+    int brick_size = pgrid->gridDesc_Compressed.brick_size;
+
+    *iz0 = (int) (ibrick % pbricks->nbz) * brick_size;
+    *iy0 = (int) ((ibrick / pbricks->nbz) % pbricks->nby) * brick_size;
+    *ix0 = (int) (ibrick / ((long) pbricks->nbz * (long) pbricks->nby)) * brick_size;
+    *bx = pgrid->numx - *ix0 < brick_size ? pgrid->numx - *ix0 : brick_size;
+    *by = pgrid->numy - *iy0 < brick_size ? pgrid->numy - *iy0 : brick_size;
+    *bz = pgrid->numz - *iz0 < brick_size ? pgrid->numz - *iz0 : brick_size;
+
+    return (*bx * *by * *bz);
+
+}
+
+/** function to get predicted quantized value of a brick node from the previously decoded nodes of the brick
+ *
+ *  The origin node of the brick and its neighbours along each axis are anchors stored in the brick header, other nodes
+ *  on the axis lines through the origin are linearly extrapolated, and all other nodes are predicted with the Lorenzo
+ *  predictor (exact for values varying linearly along each axis, as travel times do away from the source).
+ */
+
+static inline int64_t compressed_brick_predict(int32_t *qvalues, int32_t *anchors, int ix, int iy, int iz, int by, int bz) {
+
+    long n = ((long) ix * by + iy) * bz + iz;
+    long dx = (long) by * bz;
+
+    // nodes on axis lines through brick origin
+    if (iy == 0 && iz == 0) {
+        if (ix < 2)
+            return (anchors[ix == 0 ? 0 : 3]);
+        return (2 * (int64_t) qvalues[n - dx] - qvalues[n - 2 * dx]);
+    }
+    if (ix == 0 && iz == 0) {
+        if (iy < 2)
+            return (anchors[2]);
+        return (2 * (int64_t) qvalues[n - bz] - qvalues[n - 2 * bz]);
+    }
+    if (ix == 0 && iy == 0) {
+        if (iz < 2)
+            return (anchors[1]);
+        return (2 * (int64_t) qvalues[n - 1] - qvalues[n - 2]);
+    }
+
+    // Lorenzo predictor, reduces to 2D predictor on faces of brick through origin
+    int64_t pred = 0;
+    if (ix > 0)
+        pred += qvalues[n - dx];
+    if (iy > 0)
+        pred += qvalues[n - bz];
+    if (iz > 0)
+        pred += qvalues[n - 1];
+    if (ix > 0 && iy > 0)
+        pred -= qvalues[n - dx - bz];
+    if (ix > 0 && iz > 0)
+        pred -= qvalues[n - dx - 1];
+    if (iy > 0 && iz > 0)
+        pred -= qvalues[n - bz - 1];
+    if (ix > 0 && iy > 0 && iz > 0)
+        pred += qvalues[n - dx - bz - 1];
+
+    return (pred);
+
+}
+
+/** function to encode a brick of grid values, returns size of encoded brick in bytes
+ *
+ *  Values are quantized to steps of 2 * max_error above the brick minimum value, the differences between the quantized
+ *  values and their predicted values (see compressed_brick_predict()) are bit-packed.  Each decoded value is checked
+ *  against the original value, a brick is stored raw if any value exceeds the error bound or the quantized range is too large.
+ */
+
+static size_t compressed_brick_encode(GRID_FLOAT_TYPE *values, int bx, int by, int bz, double max_error,
+        int32_t *qvalues, unsigned char *brickbuf) {
+
+    int nvalues = bx * by * bz;
+    double vmin = values[0];
+    double vmax = values[0];
+    int n;
+    for (n = 1; n < nvalues; n++) {
+        if (values[n] < vmin)
+            vmin = values[n];
+        if (values[n] > vmax)
+            vmax = values[n];
+    }
+    // quantization step, reduced by float precision of grid values so that decoded values are within error bound
+    double step = 2.0 * (max_error - 2.0 * FLT_EPSILON * fmax(fabs(vmin), fabs(vmax)));
+    int32_t anchors[4] = {0, 0, 0, 0}; // quantized values at brick nodes (0,0,0), (0,0,1), (0,1,0), (1,0,0)
+
+    int32_t nbits = 0;
+    if (!isfinite(vmin) || !isfinite(vmax) || step <= 0.0) {
+        nbits = COMPRESSED_BRICK_RAW;
+    } else if (vmax > vmin) {
+        if (floor((vmax - vmin) / step + 0.5) >= (double) (1 << COMPRESSED_BRICK_MAX_QBITS)) {
+            nbits = COMPRESSED_BRICK_RAW;
+        } else {
+            // quantize and check that decoded values are within error bound
+            for (n = 0; n < nvalues; n++) {
+                qvalues[n] = (int32_t) floor((values[n] - vmin) / step + 0.5);
+                GRID_FLOAT_TYPE decoded = (GRID_FLOAT_TYPE) (vmin + (double) qvalues[n] * step);
+                if (fabs((double) decoded - (double) values[n]) > max_error) {
+                    nbits = COMPRESSED_BRICK_RAW;
+                    break;
+                }
+            }
+            // find number of bits needed for zigzag encoded prediction residuals
+            if (nbits != COMPRESSED_BRICK_RAW) {
+                anchors[0] = qvalues[0];
+                anchors[1] = bz > 1 ? qvalues[1] : 0;
+                anchors[2] = by > 1 ? qvalues[bz] : 0;
+                anchors[3] = bx > 1 ? qvalues[by * bz] : 0;
+                uint64_t umax = 0;
+                n = 0;
+                for (int ix = 0; ix < bx; ix++)
+                    for (int iy = 0; iy < by; iy++)
+                        for (int iz = 0; iz < bz; iz++, n++) {
+                            int64_t resid = qvalues[n] - compressed_brick_predict(qvalues, anchors, ix, iy, iz, by, bz);
+                            uint64_t u = resid < 0 ? ((uint64_t) (-resid) << 1) - 1 : (uint64_t) resid << 1;
+                            if (u > umax)
+                                umax = u;
+                        }
+                while (nbits < 64 && (umax >> nbits) != 0)
+                    nbits++;
+                if (nbits > COMPRESSED_BRICK_MAX_NBITS)
+                    nbits = COMPRESSED_BRICK_RAW;
+            }
+        }
+    }
+
+    unsigned char *pbrick = brickbuf;
+    memcpy(pbrick, &vmin, sizeof (double));
+    pbrick += sizeof (double);
+    memcpy(pbrick, &step, sizeof (double));
+    pbrick += sizeof (double);
+    memcpy(pbrick, &nbits, sizeof (int32_t));
+    pbrick += sizeof (int32_t);
+    memcpy(pbrick, anchors, sizeof (anchors));
+    pbrick += sizeof (anchors);
+
+    if (nbits == COMPRESSED_BRICK_RAW) {
+        memcpy(pbrick, values, (size_t) nvalues * sizeof (GRID_FLOAT_TYPE));
+        pbrick += (size_t) nvalues * sizeof (GRID_FLOAT_TYPE);
+    } else if (nbits > 0) {
+        // pack residuals, least significant bits first
+        uint64_t bits = 0;
+        int nbits_stored = 0;
+        n = 0;
+        for (int ix = 0; ix < bx; ix++)
+            for (int iy = 0; iy < by; iy++)
+                for (int iz = 0; iz < bz; iz++, n++) {
+                    int64_t resid = qvalues[n] - compressed_brick_predict(qvalues, anchors, ix, iy, iz, by, bz);
+                    uint64_t u = resid < 0 ? ((uint64_t) (-resid) << 1) - 1 : (uint64_t) resid << 1;
+                    bits |= u << nbits_stored;
+                    nbits_stored += nbits;
+                    while (nbits_stored >= 8) {
+                        *pbrick++ = (unsigned char) (bits & 0xff);
+                        bits >>= 8;
+                        nbits_stored -= 8;
+                    }
+                }
+        if (nbits_stored > 0)
+            *pbrick++ = (unsigned char) (bits & 0xff);
+    }
+
+    return ((size_t) (pbrick - brickbuf));
+
+}
+
+/** function to decode a brick of grid values */
+
+static int compressed_brick_decode(unsigned char *brickbuf, size_t brick_bytes, int bx, int by, int bz,
+        int32_t *qvalues, GRID_FLOAT_TYPE *values) {
+
+    int nvalues = bx * by * bz;
+    double vmin, step;
+    int32_t nbits;
+    int32_t anchors[4];
+    int n;
+
+    if (brick_bytes < COMPRESSED_BRICK_HEADER_SIZE)
+        return (-1);
+
+    unsigned char *pbrick = brickbuf;
+    memcpy(&vmin, pbrick, sizeof (double));
+    pbrick += sizeof (double);
+    memcpy(&step, pbrick, sizeof (double));
+    pbrick += sizeof (double);
+    memcpy(&nbits, pbrick, sizeof (int32_t));
+    pbrick += sizeof (int32_t);
+    memcpy(anchors, pbrick, sizeof (anchors));
+    pbrick += sizeof (anchors);
+    brick_bytes -= COMPRESSED_BRICK_HEADER_SIZE;
+
+    if (nbits == COMPRESSED_BRICK_RAW) {
+        if (brick_bytes < (size_t) nvalues * sizeof (GRID_FLOAT_TYPE))
+            return (-1);
+        memcpy(values, pbrick, (size_t) nvalues * sizeof (GRID_FLOAT_TYPE));
+    } else {
+        if (nbits < 0 || nbits > COMPRESSED_BRICK_MAX_NBITS || brick_bytes < ((size_t) nvalues * (size_t) nbits + 7) / 8)
+            return (-1);
+        uint64_t mask = ((uint64_t) 1 << nbits) - 1;
+        uint64_t bits = 0;
+        int nbits_avail = 0;
+        n = 0;
+        for (int ix = 0; ix < bx; ix++)
+            for (int iy = 0; iy < by; iy++)
+                for (int iz = 0; iz < bz; iz++, n++) {
+                    while (nbits_avail < nbits) {
+                        bits |= (uint64_t) (*pbrick++) << nbits_avail;
+                        nbits_avail += 8;
+                    }
+                    uint64_t u = bits & mask;
+                    bits >>= nbits;
+                    nbits_avail -= nbits;
+                    int64_t resid = (u & 1) ? -(int64_t) ((u + 1) >> 1) : (int64_t) (u >> 1);
+                    qvalues[n] = (int32_t) (resid + compressed_brick_predict(qvalues, anchors, ix, iy, iz, by, bz));
+                    values[n] = (GRID_FLOAT_TYPE) (vmin + (double) qvalues[n] * step);
+                }
+    }
+
+    return (0);
+
+}
+
+/** function to write compressed grid buffer file
+ *
+ * 20261016 agent - added
+ */
+
+static int WriteGrid3dBuf_Compressed(GridDesc* pgrid, FILE *fpio) {
+
+    CompressedGridBricks bricks;
+    compressed_grid_bricks(pgrid, &bricks);
+    int brick_size = pgrid->gridDesc_Compressed.brick_size;
+    int brick_nodes = brick_size * brick_size * brick_size;
+
+    int64_t *brick_offset = (int64_t *) malloc((size_t) (bricks.num_bricks + 1) * sizeof (int64_t));
+    GRID_FLOAT_TYPE *values = (GRID_FLOAT_TYPE *) malloc((size_t) brick_nodes * sizeof (GRID_FLOAT_TYPE));
+    int32_t *qvalues = (int32_t *) malloc((size_t) brick_nodes * sizeof (int32_t));
+    unsigned char *brickbuf = (unsigned char *) malloc(COMPRESSED_BRICK_HEADER_SIZE + (size_t) brick_nodes * sizeof (GRID_FLOAT_TYPE));
+    if (brick_offset == NULL || values == NULL || qvalues == NULL || brickbuf == NULL) {
+        nll_puterr("ERROR: allocating memory for compressed grid output.");
+        free(brick_offset);
+        free(values);
+        free(qvalues);
+        free(brickbuf);
+        return (-1);
+    }
+
+    // file header
+    int32_t header[7] = {COMPRESSED_GRID_VERSION, brick_size, pgrid->numx, pgrid->numy, pgrid->numz, sizeof (GRID_FLOAT_TYPE), 0};
+    int istat = 0;
+    if (fwrite(COMPRESSED_GRID_MAGIC, 8, 1, fpio) != 1 || fwrite(header, sizeof (header), 1, fpio) != 1)
+        istat = -1;
+
+    // placeholder for brick index, written after bricks
+    long offset = COMPRESSED_GRID_HEADER_SIZE + (bricks.num_bricks + 1) * sizeof (int64_t);
+    if (istat == 0 && fseek(fpio, offset, SEEK_SET) != 0)
+        istat = -1;
+
+    GRID_FLOAT_TYPE *buffer = (GRID_FLOAT_TYPE *) pgrid->buffer;
+    long numyz = (long) pgrid->numy * (long) pgrid->numz;
+    int ix0, iy0, iz0, bx, by, bz;
+    long ibrick;
+    for (ibrick = 0; istat == 0 && ibrick < bricks.num_bricks; ibrick++) {
+        compressed_brick_range(pgrid, &bricks, ibrick, &ix0, &iy0, &iz0, &bx, &by, &bz);
+        GRID_FLOAT_TYPE *pvalue = values;
+        for (int ix = ix0; ix < ix0 + bx; ix++)
+            for (int iy = iy0; iy < iy0 + by; iy++)
+                for (int iz = iz0; iz < iz0 + bz; iz++)
+                    *pvalue++ = buffer[ix * numyz + iy * pgrid->numz + iz];
+        size_t brick_bytes = compressed_brick_encode(values, bx, by, bz, pgrid->gridDesc_Compressed.max_error, qvalues, brickbuf);
+        if (fwrite(brickbuf, brick_bytes, 1, fpio) != 1)
+            istat = -1;
+        brick_offset[ibrick] = offset;
+        offset += brick_bytes;
+    }
+    brick_offset[bricks.num_bricks] = offset;
+
+    // brick index
+    if (istat == 0 && (fseek(fpio, COMPRESSED_GRID_HEADER_SIZE, SEEK_SET) != 0
+            || fwrite(brick_offset, (size_t) (bricks.num_bricks + 1) * sizeof (int64_t), 1, fpio) != 1))
+        istat = -1;
+
+    if (istat < 0) {
+        nll_puterr2("ERROR: writing compressed grid buffer output file", pgrid->title);
+    } else if (message_flag >= 2) {
+        sprintf(MsgStr, "Compressed grid: brick_size %d  max_error %g  size %ld bytes (%.1f%% of uncompressed)",
+                brick_size, pgrid->gridDesc_Compressed.max_error, offset,
+                100.0 * (double) offset / (double) ((long) pgrid->numx * numyz * (long) sizeof (GRID_FLOAT_TYPE)));
+        nll_putmsg(2, MsgStr);
+    }
+
+    free(brick_offset);
+    free(values);
+    free(qvalues);
+    free(brickbuf);
+
+    return (istat);
+
+}
+
+/** function to read and decode entire compressed grid buffer file to grid buffer
+ *
+ * 20261016 agent - added
+ */
+
+static int ReadGrid3dBuf_Compressed(GridDesc* pgrid, FILE *fpio) {
+
+    if (pgrid->iSwapBytes) {
+        nll_puterr2("ERROR: byte swapping not supported for compressed grid file", pgrid->title);
+        return (-1);
+    }
+
+    // 20261016 agent - added, for sub-grid only bricks containing sub-grid nodes are read
+    GridDesc grid_file = *pgrid;
+    unsetSubGrid(&grid_file);
+    int sx0 = 0, sy0 = 0, sz0 = 0;
+    if (isSubGrid(pgrid)) {
+        sx0 = pgrid->gridDesc_SubGrid.ix0;
+        sy0 = pgrid->gridDesc_SubGrid.iy0;
+        sz0 = pgrid->gridDesc_SubGrid.iz0;
+    }
+
+    CompressedGridBricks bricks;
+    compressed_grid_bricks(&grid_file, &bricks);
+    int brick_size = pgrid->gridDesc_Compressed.brick_size;
+    int brick_nodes = brick_size * brick_size * brick_size;
+
+    // check file header
+    char magic[8];
+    int32_t header[7];
+    if (fseek(fpio, 0, SEEK_SET) != 0 || fread(magic, 8, 1, fpio) != 1 || fread(header, sizeof (header), 1, fpio) != 1
+            || strncmp(magic, COMPRESSED_GRID_MAGIC, 8) != 0 || header[0] != COMPRESSED_GRID_VERSION || header[1] != brick_size
+            || header[2] != grid_file.numx || header[3] != grid_file.numy || header[4] != grid_file.numz
+            || header[5] != (int32_t) sizeof (GRID_FLOAT_TYPE)) {
+        nll_puterr2("ERROR: invalid compressed grid file header or header does not match grid description", pgrid->title);
+        return (-1);
+    }
+
+    int64_t *brick_offset = (int64_t *) malloc((size_t) (bricks.num_bricks + 1) * sizeof (int64_t));
+    GRID_FLOAT_TYPE *values = (GRID_FLOAT_TYPE *) malloc((size_t) brick_nodes * sizeof (GRID_FLOAT_TYPE));
+    int32_t *qvalues = (int32_t *) malloc((size_t) brick_nodes * sizeof (int32_t));
+    unsigned char *brickbuf = (unsigned char *) malloc(COMPRESSED_BRICK_HEADER_SIZE + (size_t) brick_nodes * sizeof (GRID_FLOAT_TYPE));
+    if (brick_offset == NULL || values == NULL || qvalues == NULL || brickbuf == NULL) {
+        nll_puterr("ERROR: allocating memory for compressed grid input.");
+        free(brick_offset);
+        free(values);
+        free(qvalues);
+        free(brickbuf);
+        return (-1);
+    }
+
+    int istat = 0;
+    if (fread(brick_offset, (size_t) (bricks.num_bricks + 1) * sizeof (int64_t), 1, fpio) != 1)
+        istat = -1;
+
+    // bricks follow index in brick order
+    GRID_FLOAT_TYPE *buffer = (GRID_FLOAT_TYPE *) pgrid->buffer;
+    long numyz = (long) pgrid->numy * (long) pgrid->numz;
+    int ix0, iy0, iz0, bx, by, bz;
+    int brick_skipped = 0;
+    long ibrick;
+    for (ibrick = 0; istat == 0 && ibrick < bricks.num_bricks; ibrick++) {
+        int nvalues = compressed_brick_range(&grid_file, &bricks, ibrick, &ix0, &iy0, &iz0, &bx, &by, &bz);
+        if (ix0 + bx <= sx0 || ix0 >= sx0 + pgrid->numx || iy0 + by <= sy0 || iy0 >= sy0 + pgrid->numy
+                || iz0 + bz <= sz0 || iz0 >= sz0 + pgrid->numz) {
+            brick_skipped = 1; // no sub-grid nodes in brick
+            continue;
+        }
+        if (brick_skipped && fseek(fpio, (long) brick_offset[ibrick], SEEK_SET) != 0) {
+            istat = -1;
+            break;
+        }
+        brick_skipped = 0;
+        int64_t brick_bytes = brick_offset[ibrick + 1] - brick_offset[ibrick];
+        if (brick_bytes < (int64_t) COMPRESSED_BRICK_HEADER_SIZE
+                || brick_bytes > (int64_t) (COMPRESSED_BRICK_HEADER_SIZE + (size_t) nvalues * sizeof (GRID_FLOAT_TYPE))
+                || fread(brickbuf, (size_t) brick_bytes, 1, fpio) != 1
+                || compressed_brick_decode(brickbuf, (size_t) brick_bytes, bx, by, bz, qvalues, values) < 0) {
+            istat = -1;
+            break;
+        }
+        NumGridBytesRead += (size_t) brick_bytes;
+        GRID_FLOAT_TYPE *pvalue = values;
+        for (int ix = ix0 - sx0; ix < ix0 - sx0 + bx; ix++)
+            for (int iy = iy0 - sy0; iy < iy0 - sy0 + by; iy++)
+                for (int iz = iz0 - sz0; iz < iz0 - sz0 + bz; iz++, pvalue++)
+                    if (ix >= 0 && ix < pgrid->numx && iy >= 0 && iy < pgrid->numy && iz >= 0 && iz < pgrid->numz)
+                        buffer[ix * numyz + iy * pgrid->numz + iz] = *pvalue;
+    }
+
+    if (istat < 0)
+        nll_puterr2("ERROR: reading compressed grid file", pgrid->title);
+
+    free(brick_offset);
+    free(values);
+    free(qvalues);
+    free(brickbuf);
+
+    return (istat);
+
+}
+
+
+/* cache of decoded bricks for reading single values of compressed grids from disk, one cache per thread */
+#define COMPRESSED_BRICK_CACHE_SIZE 256
+
+typedef struct {
+    char *title; // identifier of grid containing brick, NULL if cache entry not used
+    long ibrick;
+    int ix0, iy0, iz0, by, bz;
+    GRID_FLOAT_TYPE *values;
+} CompressedBrickCacheEntry;
+
+static NLL_THREAD_LOCAL CompressedBrickCacheEntry *CompressedBrickCache = NULL;
+static NLL_THREAD_LOCAL unsigned char *CompressedBrickCacheBuf = NULL; // encoded brick
+static NLL_THREAD_LOCAL int32_t *CompressedBrickCacheQValues = NULL; // quantized values of decoded brick
+static NLL_THREAD_LOCAL int CompressedBrickCacheBrickNodes = 0; // size of brick for which buffers are allocated
+
+/** function to free cache of decoded bricks of compressed grids for the current thread
+ *
+ * 20261016 agent - added
+ */
+
+void FreeCompressedGridCache() {
+
+    if (CompressedBrickCache != NULL) {
+        for (int n = 0; n < COMPRESSED_BRICK_CACHE_SIZE; n++) {
+            free(CompressedBrickCache[n].title);
+            free(CompressedBrickCache[n].values);
+        }
+        free(CompressedBrickCache);
+        CompressedBrickCache = NULL;
+    }
+    free(CompressedBrickCacheBuf);
+    CompressedBrickCacheBuf = NULL;
+    free(CompressedBrickCacheQValues);
+    CompressedBrickCacheQValues = NULL;
+    CompressedBrickCacheBrickNodes = 0;
+
+}
+
+/** function to read compressed grid value at index location from disk through the brick cache
+ *
+ * 20261016 agent - added
+ */
+
+static GRID_FLOAT_TYPE ReadGrid3dValue_Compressed(FILE *fpgrid, int ix, int iy, int iz, GridDesc * pgrid) {
+
+    int brick_size = pgrid->gridDesc_Compressed.brick_size;
+    CompressedGridBricks bricks;
+    compressed_grid_bricks(pgrid, &bricks);
+    long ibrick = ((long) (ix / brick_size) * bricks.nby + (iy / brick_size)) * bricks.nbz + (iz / brick_size);
+
+    // find cache entry from grid identifier and brick index
+    unsigned long hash = 5381;
+    for (char *pchr = pgrid->title; *pchr != '\0'; pchr++)
+        hash = hash * 33 + (unsigned char) *pchr;
+    hash = hash * 31 + (unsigned long) ibrick;
+    CompressedBrickCacheEntry *pentry;
+
+    if (CompressedBrickCache == NULL) {
+        CompressedBrickCache = (CompressedBrickCacheEntry *) calloc(COMPRESSED_BRICK_CACHE_SIZE, sizeof (CompressedBrickCacheEntry));
+        if (CompressedBrickCache == NULL) {
+            nll_puterr("ERROR: allocating memory for compressed grid brick cache.");
+            return (-VERY_LARGE_FLOAT);
+        }
+    }
+    pentry = CompressedBrickCache + hash % COMPRESSED_BRICK_CACHE_SIZE;
+
+    if (pentry->title == NULL || pentry->ibrick != ibrick || strcmp(pentry->title, pgrid->title) != 0) {
+
+        // read and decode brick
+        if (pgrid->iSwapBytes) {
+            nll_puterr2("ERROR: byte swapping not supported for compressed grid file", pgrid->title);
+            return (-VERY_LARGE_FLOAT);
+        }
+        int brick_nodes = brick_size * brick_size * brick_size;
+        if (brick_nodes > CompressedBrickCacheBrickNodes) {
+            free(CompressedBrickCacheBuf);
+            free(CompressedBrickCacheQValues);
+            CompressedBrickCacheBuf = (unsigned char *) malloc(COMPRESSED_BRICK_HEADER_SIZE + (size_t) brick_nodes * sizeof (GRID_FLOAT_TYPE));
+            CompressedBrickCacheQValues = (int32_t *) malloc((size_t) brick_nodes * sizeof (int32_t));
+            CompressedBrickCacheBrickNodes = brick_nodes;
+        }
+        free(pentry->title);
+        pentry->title = NULL;
+        free(pentry->values);
+        pentry->values = (GRID_FLOAT_TYPE *) malloc((size_t) brick_nodes * sizeof (GRID_FLOAT_TYPE));
+        if (CompressedBrickCacheBuf == NULL || CompressedBrickCacheQValues == NULL || pentry->values == NULL) {
+            CompressedBrickCacheBrickNodes = 0;
+            nll_puterr("ERROR: allocating memory for compressed grid brick cache.");
+            return (-VERY_LARGE_FLOAT);
+        }
+        int bx;
+        int nvalues = compressed_brick_range(pgrid, &bricks, ibrick, &pentry->ix0, &pentry->iy0, &pentry->iz0, &bx, &pentry->by, &pentry->bz);
+        int64_t brick_offset[2];
+        int64_t brick_bytes = -1;
+        if (fseek(fpgrid, COMPRESSED_GRID_HEADER_SIZE + ibrick * sizeof (int64_t), SEEK_SET) == 0
+                && fread(brick_offset, sizeof (brick_offset), 1, fpgrid) == 1)
+            brick_bytes = brick_offset[1] - brick_offset[0];
+        if (brick_bytes < (int64_t) COMPRESSED_BRICK_HEADER_SIZE
+                || brick_bytes > (int64_t) (COMPRESSED_BRICK_HEADER_SIZE + (size_t) nvalues * sizeof (GRID_FLOAT_TYPE))
+                || fseek(fpgrid, (long) brick_offset[0], SEEK_SET) != 0
+                || fread(CompressedBrickCacheBuf, (size_t) brick_bytes, 1, fpgrid) != 1
+                || compressed_brick_decode(CompressedBrickCacheBuf, (size_t) brick_bytes, bx, pentry->by, pentry->bz,
+                CompressedBrickCacheQValues, pentry->values) < 0) {
+            sprintf(MsgStr,
+                    "ERROR: reading compressed grid brick: %s: ix%d iy=%d iz=%d", pgrid->title, ix, iy, iz);
+            nll_puterr(MsgStr);
+            return (-VERY_LARGE_FLOAT);
+        }
+        NumGridBytesRead += (size_t) brick_bytes;
+        pentry->title = strdup(pgrid->title);
+        pentry->ibrick = ibrick;
+    }
+
+    return (pentry->values[((ix - pentry->ix0) * pentry->by + (iy - pentry->iy0)) * pentry->bz + (iz - pentry->iz0)]);
+
+}
+
+/** function to determine if a grid buffer in memory has tiled layout
+ *
+ * 20261016 agent - added
+ */
+
+int isTiledGrid(GridDesc* pgrid) {
+
+    return (pgrid->flagGridTiled == IS_TILED);
+
+}
+
+/** function to set or unset tiled layout for a grid buffer in memory, must be set before the buffer is allocated
+ *
+ * 20261016 agent - added
+ *
+ *  Cascading grids always have the regular layout.
+ */
+
+void setTiledGrid(GridDesc* pgrid, int tiled) {
+
+    pgrid->flagGridTiled = (tiled && !isCascadingGrid(pgrid)) ? IS_TILED : IS_NOT_TILED;
+
+}
+
+/** functions to get offset in grid buffer of grid node of grid with tiled layout,
+ *  the offset is a sum of independent x, y and z terms */
+
+static inline long TiledGridOffsetX(GridDesc* pgrid, int ix) {
+
+    long numty = (pgrid->numy + GRID_TILE_MASK) >> GRID_TILE_SHIFT;
+    long numtz = (pgrid->numz + GRID_TILE_MASK) >> GRID_TILE_SHIFT;
+
+    return ((((long) (ix >> GRID_TILE_SHIFT) * numty * numtz) << (3 * GRID_TILE_SHIFT)) + ((ix & GRID_TILE_MASK) << (2 * GRID_TILE_SHIFT)));
+
+}
+
+static inline long TiledGridOffsetY(GridDesc* pgrid, int iy) {
+
+    long numtz = (pgrid->numz + GRID_TILE_MASK) >> GRID_TILE_SHIFT;
+
+    return ((((long) (iy >> GRID_TILE_SHIFT) * numtz) << (3 * GRID_TILE_SHIFT)) + ((iy & GRID_TILE_MASK) << GRID_TILE_SHIFT));
+
+}
+
+static inline long TiledGridOffsetZ(int iz) {
+
+    return (((long) (iz >> GRID_TILE_SHIFT) << (3 * GRID_TILE_SHIFT)) + (iz & GRID_TILE_MASK));
+
+}
+
+static inline long TiledGridOffset(GridDesc* pgrid, int ix, int iy, int iz) {
+
+    return (TiledGridOffsetX(pgrid, ix) + TiledGridOffsetY(pgrid, iy) + TiledGridOffsetZ(iz));
+
+}
+
+/** function to get size in bytes of buffer of grid with tiled layout, the grid is padded to a whole number of tiles
+ *
+ * 20261016 agent - added
+ */
+
+size_t TiledGridBufferSize(GridDesc* pgrid) {
+
+    size_t numtx = (pgrid->numx + GRID_TILE_MASK) >> GRID_TILE_SHIFT;
+    size_t numty = (pgrid->numy + GRID_TILE_MASK) >> GRID_TILE_SHIFT;
+    size_t numtz = (pgrid->numz + GRID_TILE_MASK) >> GRID_TILE_SHIFT;
+
+    return ((numtx * numty * numtz << (3 * GRID_TILE_SHIFT)) * sizeof (GRID_FLOAT_TYPE));
+
+}
+
+/** function to copy grid values between a regular layout buffer and the tiled layout grid buffer */
+
+static void tiled_grid_copy(GridDesc* pgrid, GRID_FLOAT_TYPE *regular, int to_tiled) {
+
+    GRID_FLOAT_TYPE *tiled = (GRID_FLOAT_TYPE *) pgrid->buffer;
+    int ix, iy, iz;
+
+    for (ix = 0; ix < pgrid->numx; ix++) {
+        for (iy = 0; iy < pgrid->numy; iy++) {
+            for (iz = 0; iz < pgrid->numz; iz++) {
+                if (to_tiled)
+                    tiled[TiledGridOffset(pgrid, ix, iy, iz)] = *regular;
+                else
+                    *regular = tiled[TiledGridOffset(pgrid, ix, iy, iz)];
+                regular++;
+            }
+        }
+    }
+
+}
+
+/** function to get buffer offsets of the corners 000, 001, 010, 011, 100, 101, 110, 111 of a grid cell
+ *
+ * 20261016 agent - added
+ */
+
+static inline void gridCellOffsets(GridDesc* pgrid, int ix0, int iy0, int iz0, int ix1, int iy1, int iz1, long *offset) {
+
+    long ox0, ox1, oy0, oy1, oz0, oz1;
+
+    if (isTiledGrid(pgrid)) {
+        ox0 = TiledGridOffsetX(pgrid, ix0);
+        ox1 = TiledGridOffsetX(pgrid, ix1);
+        oy0 = TiledGridOffsetY(pgrid, iy0);
+        oy1 = TiledGridOffsetY(pgrid, iy1);
+        oz0 = TiledGridOffsetZ(iz0);
+        oz1 = TiledGridOffsetZ(iz1);
+    } else {
+        long numz = pgrid->numz;
+        long numyz = (long) pgrid->numy * numz;
+        ox0 = ix0 * numyz;
+        ox1 = ix1 * numyz;
+        oy0 = iy0 * numz;
+        oy1 = iy1 * numz;
+        oz0 = iz0;
+        oz1 = iz1;
+    }
+    offset[0] = ox0 + oy0 + oz0;
+    offset[1] = ox0 + oy0 + oz1;
+    offset[2] = ox0 + oy1 + oz0;
+    offset[3] = ox0 + oy1 + oz1;
+    offset[4] = ox1 + oy0 + oz0;
+    offset[5] = ox1 + oy0 + oz1;
+    offset[6] = ox1 + oy1 + oz0;
+    offset[7] = ox1 + oy1 + oz1;
+
+}
+
+
+/** function to determine if a grid is a sub-grid of its grid file
+ *
+ * 20261016 agent - added
+ */
+
+int isSubGrid(GridDesc* pgrid) {
+
+    return (pgrid->flagGridSubGrid == IS_SUBGRID);
+
+}
+
+/** function to set a grid to the sub-grid of its grid file containing a box, must be set before the buffer is allocated
+ *
+ * 20261016 agent - added
+ *
+ *  The sub-grid includes the grid nodes on or just outside the box, so values can be interpolated anywhere in the box.
+ *  Cascading grids are always read completely.
+ *
+ *  returns 1 if the grid is set to a sub-grid, 0 if the sub-grid would be the complete grid
+ */
+
+int setSubGrid(GridDesc* pgrid, double xmin, double xmax, double ymin, double ymax, double zmin, double zmax) {
+
+    if (isCascadingGrid(pgrid) || isSubGrid(pgrid))
+        return (0);
+
+    int ix0 = (int) floor((xmin - pgrid->origx) / pgrid->dx);
+    int ix1 = (int) ceil((xmax - pgrid->origx) / pgrid->dx);
+    int iy0 = (int) floor((ymin - pgrid->origy) / pgrid->dy);
+    int iy1 = (int) ceil((ymax - pgrid->origy) / pgrid->dy);
+    int iz0 = (int) floor((zmin - pgrid->origz) / pgrid->dz);
+    int iz1 = (int) ceil((zmax - pgrid->origz) / pgrid->dz);
+    ix0 = ix0 < 0 ? 0 : ix0;
+    iy0 = iy0 < 0 ? 0 : iy0;
+    iz0 = iz0 < 0 ? 0 : iz0;
+    ix1 = ix1 > pgrid->numx - 1 ? pgrid->numx - 1 : ix1;
+    iy1 = iy1 > pgrid->numy - 1 ? pgrid->numy - 1 : iy1;
+    iz1 = iz1 > pgrid->numz - 1 ? pgrid->numz - 1 : iz1;
+    if (ix1 < ix0 || iy1 < iy0 || iz1 < iz0)
+        return (0);
+    if (ix0 == 0 && iy0 == 0 && iz0 == 0 && ix1 == pgrid->numx - 1 && iy1 == pgrid->numy - 1 && iz1 == pgrid->numz - 1)
+        return (0);
+
+    GridDesc_SubGrid* psub = &(pgrid->gridDesc_SubGrid);
+    psub->ix0 = ix0;
+    psub->iy0 = iy0;
+    psub->iz0 = iz0;
+    psub->numx = pgrid->numx;
+    psub->numy = pgrid->numy;
+    psub->numz = pgrid->numz;
+    psub->origx = pgrid->origx;
+    psub->origy = pgrid->origy;
+    psub->origz = pgrid->origz;
+
+    pgrid->numx = ix1 - ix0 + 1;
+    pgrid->numy = iy1 - iy0 + 1;
+    pgrid->numz = iz1 - iz0 + 1;
+    pgrid->origx = psub->origx + (double) ix0 * pgrid->dx;
+    pgrid->origy = psub->origy + (double) iy0 * pgrid->dy;
+    pgrid->origz = psub->origz + (double) iz0 * pgrid->dz;
+    pgrid->flagGridSubGrid = IS_SUBGRID;
+
+    return (1);
+
+}
+
+/** function to restore the geometry of the grid file of a sub-grid, must be called before the buffer is allocated
+ *
+ * 20261016 agent - added
+ */
+
+void unsetSubGrid(GridDesc* pgrid) {
+
+    if (!isSubGrid(pgrid))
+        return;
+
+    GridDesc_SubGrid* psub = &(pgrid->gridDesc_SubGrid);
+    pgrid->numx = psub->numx;
+    pgrid->numy = psub->numy;
+    pgrid->numz = psub->numz;
+    pgrid->origx = psub->origx;
+    pgrid->origy = psub->origy;
+    pgrid->origz = psub->origz;
+    pgrid->flagGridSubGrid = IS_NOT_SUBGRID;
+
+}
+
 /** function to write grid buffer and header to disk ***/
 
 int WriteGrid3dBuf(GridDesc* pgrid, SourceDesc* psrce, char* filename, char* file_type) {
@@ -964,6 +1833,22 @@ int WriteGrid3dBuf(GridDesc* pgrid, SourceDesc* psrce, char* filename, char* fil
     char fname[FILENAME_MAX];
 
 
+    // 20261016 agent - added, grid files have regular layout
+    if (isTiledGrid(pgrid)) {
+        GridDesc grid_regular = *pgrid;
+        setTiledGrid(&grid_regular, 0);
+        grid_regular.buffer_size = (size_t) pgrid->numx * (size_t) pgrid->numy * (size_t) pgrid->numz * sizeof (GRID_FLOAT_TYPE);
+        if ((grid_regular.buffer = malloc(grid_regular.buffer_size)) == NULL) {
+            nll_puterr("ERROR: allocating memory for grid buffer output.");
+            return (-1);
+        }
+        tiled_grid_copy(pgrid, (GRID_FLOAT_TYPE *) grid_regular.buffer, 0);
+        istat = WriteGrid3dBuf(&grid_regular, psrce, filename, file_type);
+        free(grid_regular.buffer);
+        return (istat);
+    }
+
+
     /* write buffer file */
 
     if (file_type != NULL) {
@@ -977,7 +1862,14 @@ int WriteGrid3dBuf(GridDesc* pgrid, SourceDesc* psrce, char* filename, char* fil
     }
     NumFilesOpen++;
 
-    if (fwrite((char *) pgrid->buffer, pgrid->buffer_size, 1, fpio) != 1) {
+    if (writeAsCompressedGrid(pgrid)) {
+        // 20261016 agent - added
+        if (WriteGrid3dBuf_Compressed(pgrid, fpio) < 0) {
+            fclose(fpio);
+            NumFilesOpen--;
+            return (-1);
+        }
+    } else if (fwrite((char *) pgrid->buffer, pgrid->buffer_size, 1, fpio) != 1) {
         nll_puterr("ERROR: writing grid buffer output file.");
         return (-1);
     }
@@ -1045,6 +1937,12 @@ int WriteGrid3dHdr(GridDesc* pgrid, SourceDesc* psrce,
     }
     fprintf(fpio, "\n");
 
+    // write extra compressed grid header line
+    // 20261016 agent - added
+    if (writeAsCompressedGrid(pgrid)) {
+        fprintf(fpio, "COMPRESSED_GRID %d %g\n", pgrid->gridDesc_Compressed.brick_size, pgrid->gridDesc_Compressed.max_error);
+    }
+
 
     fclose(fpio);
     NumFilesOpen--;
@@ -1135,6 +2033,7 @@ void* AllocateGrid_Cascading(GridDesc* pgrid, int allocate_buffer) {
     // DEBUG pgrid->buffer_size -= 128  * sizeof (GRID_FLOAT_TYPE);
     if (allocate_buffer) {
         pgrid->buffer = (void *) malloc(pgrid->buffer_size);
+        pgrid->buffer_mapped = 0;
         if (pgrid->buffer != NULL)
             NumAllocations++;
     }
@@ -1234,8 +2133,16 @@ void* AllocateGrid(GridDesc * pgrid) {
         return (pgrid->buffer);
     }
 
-    pgrid->buffer_size = (size_t) (pgrid->numx * pgrid->numy * pgrid->numz * sizeof (GRID_FLOAT_TYPE));
-    pgrid->buffer = (void *) malloc(pgrid->buffer_size);
+    if (isTiledGrid(pgrid)) {
+        // 20261016 agent - added, tiles aligned to cache lines
+        pgrid->buffer_size = TiledGridBufferSize(pgrid);
+        if (posix_memalign(&(pgrid->buffer), GRID_TILE_ALIGN, pgrid->buffer_size) != 0)
+            pgrid->buffer = NULL;
+    } else {
+        pgrid->buffer_size = (size_t) (pgrid->numx * pgrid->numy * pgrid->numz * sizeof (GRID_FLOAT_TYPE));
+        pgrid->buffer = (void *) malloc(pgrid->buffer_size);
+    }
+    pgrid->buffer_mapped = 0;
     if (pgrid->buffer != NULL)
         NumAllocations++;
 
@@ -1277,7 +2184,13 @@ void FreeGrid(GridDesc * pgrid) {
     }
 
     if (pgrid->buffer != NULL) {
-        free(pgrid->buffer);
+        if (pgrid->buffer_mapped) {
+            if (pgrid->buffer_mapped == 1) // buffer in grid bundle is unmapped with the bundle
+                munmap(pgrid->buffer, pgrid->buffer_size);
+            pgrid->buffer_mapped = 0;
+        } else {
+            free(pgrid->buffer);
+        }
         pgrid->buffer = NULL;
         NumAllocations--;
     }
@@ -1289,7 +2202,10 @@ int InitializeGrid(GridDesc* pgrid, GRID_FLOAT_TYPE init_value) {
 
     GRID_FLOAT_TYPE *gbuf;
 
-    gbuf = (GRID_FLOAT_TYPE *) pgrid->buffer + pgrid->numx * pgrid->numy * pgrid->numz;
+    if (isTiledGrid(pgrid))
+        gbuf = (GRID_FLOAT_TYPE *) pgrid->buffer + pgrid->buffer_size / sizeof (GRID_FLOAT_TYPE); // 20261016 agent - added
+    else
+        gbuf = (GRID_FLOAT_TYPE *) pgrid->buffer + pgrid->numx * pgrid->numy * pgrid->numz;
 
     while (gbuf-- > (GRID_FLOAT_TYPE *) pgrid->buffer)
         *gbuf = init_value;
@@ -2110,6 +3026,44 @@ int swapBytes(GRID_FLOAT_TYPE *buffer, long bufsize) {
     return (0);
 }
 
+/** function to read sub-grid of regular grid file into grid buffer, only the file blocks containing the sub-grid are read */
+
+static int ReadGrid3dBuf_SubGrid(GridDesc* pgrid, FILE *fpio) {
+
+    GridDesc_SubGrid* psub = &(pgrid->gridDesc_SubGrid);
+    GRID_FLOAT_TYPE *buffer = (GRID_FLOAT_TYPE *) pgrid->buffer;
+    long numyz_file = (long) psub->numy * (long) psub->numz;
+    size_t numread;
+    int ix, iy;
+
+    // if sub-grid has all z nodes, the y-z block for each x is contiguous in grid file
+    int read_yz_block = (pgrid->numz == psub->numz);
+    if (read_yz_block)
+        numread = (size_t) pgrid->numy * (size_t) pgrid->numz;
+    else
+        numread = (size_t) pgrid->numz;
+
+    for (ix = 0; ix < pgrid->numx; ix++) {
+        for (iy = 0; iy < (read_yz_block ? 1 : pgrid->numy); iy++) {
+            long offset = sizeof (GRID_FLOAT_TYPE)
+                    * ((long) (psub->ix0 + ix) * numyz_file + (long) (psub->iy0 + iy) * psub->numz + psub->iz0);
+            if (fseek(fpio, offset, SEEK_SET) != 0 || fread(buffer, sizeof (GRID_FLOAT_TYPE), numread, fpio) != numread) {
+                nll_puterr2("ERROR: reading sub-grid from grid file", pgrid->title);
+                return (-1);
+            }
+            NumGridBytesRead += numread * sizeof (GRID_FLOAT_TYPE);
+            buffer += numread;
+        }
+    }
+
+    if (pgrid->iSwapBytes)
+        swapBytes(pgrid->buffer, (long) pgrid->numx * (long) pgrid->numy * (long) pgrid->numz);
+
+    return (0);
+
+}
+
+
 /** function to read entire grid buffer from disk ***/
 
 int ReadGrid3dBuf(GridDesc* pgrid, FILE * fpio) {
@@ -2118,6 +3072,30 @@ int ReadGrid3dBuf(GridDesc* pgrid, FILE * fpio) {
 
 
 
+    // 20261016 agent - added, grid file is read to regular layout buffer, then copied to tiled layout grid buffer
+    if (isTiledGrid(pgrid)) {
+        GridDesc grid_regular = *pgrid;
+        setTiledGrid(&grid_regular, 0);
+        grid_regular.buffer_size = (size_t) pgrid->numx * (size_t) pgrid->numy * (size_t) pgrid->numz * sizeof (GRID_FLOAT_TYPE);
+        if ((grid_regular.buffer = malloc(grid_regular.buffer_size)) == NULL) {
+            nll_puterr2("ERROR: allocating memory for reading tiled grid", pgrid->title);
+            return (-1);
+        }
+        int istat = ReadGrid3dBuf(&grid_regular, fpio);
+        if (istat == 0)
+            tiled_grid_copy(pgrid, (GRID_FLOAT_TYPE *) grid_regular.buffer, 1);
+        free(grid_regular.buffer);
+        return (istat);
+    }
+
+    // 20261016 agent - added
+    if (isCompressedGrid(pgrid))
+        return (ReadGrid3dBuf_Compressed(pgrid, fpio));
+
+    // 20261016 agent - added
+    if (isSubGrid(pgrid))
+        return (ReadGrid3dBuf_SubGrid(pgrid, fpio));
+
     // 20161021 AJL  readsize = pgrid->numx * pgrid->numy * pgrid->numz * sizeof (GRID_FLOAT_TYPE);
     readsize = pgrid->buffer_size;
 
@@ -2129,6 +3107,7 @@ int ReadGrid3dBuf(GridDesc* pgrid, FILE * fpio) {
         nll_puterr2("ERROR: reading grid file", pgrid->title);
         return (-1);
     }
+    NumGridBytesRead += readsize;
 
     if (pgrid->iSwapBytes)
         swapBytes(pgrid->buffer, readsize / sizeof (float));
@@ -2136,6 +3115,66 @@ int ReadGrid3dBuf(GridDesc* pgrid, FILE * fpio) {
     return (0);
 }
 
+/** function to map entire grid buffer file read-only into memory
+ *
+ * 20261016 agent - added
+ *
+ *  Grid values are paged in from disk on demand and are shared through the system page cache, so grids need not fit in memory.
+ *  Returns the mapped buffer, or NULL if the grid cannot be mapped (e.g. byte swapping required), in which case the grid
+ *  may still be read from disk.  The buffer must be released with FreeGrid().  The buffer of a grid opened from a grid
+ *  bundle points into the mapped bundle file.
+ */
+
+void* MapGrid3dBuf(GridDesc* pgrid, FILE * fpio) {
+
+    struct stat grid_stat;
+    void *buffer;
+
+
+    if (fpio == NULL || pgrid->iSwapBytes || isCompressedGrid(pgrid))
+        return (NULL);
+
+    // mapped grid file has regular layout and all grid nodes
+    setTiledGrid(pgrid, 0);
+    unsetSubGrid(pgrid);
+
+    if (isCascadingGrid(pgrid)) {
+        // set cascading grid indices and buffer size without allocating buffer
+        AllocateGrid_Cascading(pgrid, 0);
+    } else {
+        pgrid->buffer_size = (size_t) (pgrid->numx * pgrid->numy * pgrid->numz * sizeof (GRID_FLOAT_TYPE));
+    }
+
+    // 20261016 agent - added, grid in a grid bundle is already mapped with the bundle file
+    if (pgrid->bundle_buffer != NULL) {
+        if (pgrid->bundle_buffer_size < pgrid->buffer_size) {
+            nll_puterr2("ERROR: grid buffer in grid bundle smaller than grid size, cannot map grid", pgrid->title);
+            return (NULL);
+        }
+        pgrid->buffer = pgrid->bundle_buffer;
+        pgrid->buffer_mapped = 2;
+        NumAllocations++;
+        return (pgrid->buffer);
+    }
+
+    if (fstat(fileno(fpio), &grid_stat) != 0 || (size_t) grid_stat.st_size < pgrid->buffer_size) {
+        nll_puterr2("ERROR: grid buffer file size smaller than grid size, cannot map grid file", pgrid->title);
+        return (NULL);
+    }
+
+    buffer = mmap(NULL, pgrid->buffer_size, PROT_READ, MAP_SHARED, fileno(fpio), 0);
+    if (buffer == MAP_FAILED) {
+        nll_puterr2("ERROR: mapping grid file to memory", pgrid->title);
+        return (NULL);
+    }
+    NumAllocations++;
+
+    pgrid->buffer = buffer;
+    pgrid->buffer_mapped = 1;
+
+    return (pgrid->buffer);
+}
+
 /** function to read y-z sheet of grid buffer from disk ***/
 
 int ReadGrid3dBufSheet(GRID_FLOAT_TYPE* sheetbuf, GridDesc* pgrid_disk,
@@ -2155,26 +3194,442 @@ int ReadGrid3dBufSheet(GRID_FLOAT_TYPE* sheetbuf, GridDesc* pgrid_disk,
     }
 
 
+    // 20261016 agent - added
+    if (isCompressedGrid(pgrid_disk)) {
+        for (int iy = 0; iy < pgrid_disk->numy; iy++) {
+            for (int iz = 0; iz < pgrid_disk->numz; iz++) {
+                *sheetbuf = ReadGrid3dValue_Compressed(fpio, ix, iy, iz, pgrid_disk);
+                if (*sheetbuf == -VERY_LARGE_FLOAT)
+                    return (-1);
+                sheetbuf++;
+            }
+        }
+        return (0);
+    }
+
     /* calculate offset in bytes */
 
-    offset = sizeof (GRID_FLOAT_TYPE) * (ix * (pgrid_disk->numy * pgrid_disk->numz));
-    fseek(fpio, offset, SEEK_SET);
+    offset = sizeof (GRID_FLOAT_TYPE) * (ix * (pgrid_disk->numy * pgrid_disk->numz));
+    fseek(fpio, offset, SEEK_SET);
+
+
+    /* calculate number of bytes to read */
+
+    readsize = pgrid_disk->numy * pgrid_disk->numz * sizeof (GRID_FLOAT_TYPE);
+
+
+    /* read sheet from grid file to buffer */
+
+    if (fread((char *) sheetbuf, readsize, 1, fpio) != 1) {
+        nll_puterr("ERROR: reading x-sheet grid file.");
+        return (-1);
+    }
+    NumGridBytesRead += readsize;
+
+    if (pgrid_disk->iSwapBytes)
+        swapBytes(sheetbuf, readsize / sizeof (GRID_FLOAT_TYPE));
+
+    return (0);
+}
+
+/** grid bundle file structures, see GridLib.h
+ *
+ * 20261016 agent - added
+ */
+
+typedef struct {
+    char magic[8]; // GRID_BUNDLE_MAGIC, not null terminated
+    int32_t version; // GRID_BUNDLE_VERSION
+    int32_t reserved;
+    int64_t index_offset; // offset in bytes of index in bundle file
+    int64_t num_entries; // number of GridBundleEntry in index
+}
+GridBundleHeader;
+
+typedef struct {
+    char name[GRID_BUNDLE_NAME_LEN]; // grid file root relative to bundle root, e.g. P.STA.time
+    int64_t hdr_offset, hdr_size; // offset and size in bytes of grid header file contents
+    int64_t buf_offset, buf_size; // offset and size in bytes of grid buffer file contents
+}
+GridBundleEntry;
+
+typedef struct {
+    char root[FILENAME_MAX]; // bundle root, grid file roots are <root>.<name>
+    size_t root_len;
+    char *map; // mapped bundle file
+    size_t map_size;
+    GridBundleEntry *entries; // copy of index, sorted by name
+    long num_entries;
+}
+GridBundle;
+
+// registered grid bundles, shared by all threads and kept until GridBundle_CloseAll()
+static GridBundle GridBundleList[MAX_NUM_GRID_BUNDLES];
+static int NumGridBundles = 0;
+static pthread_mutex_t GridBundleMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** function to skip leading ./ of file path, so that e.g. ./time/layer and time/layer give the same bundle names */
+
+static char* GridBundle_skip_dot_slash(char *path) {
+
+    while (strncmp(path, "./", 2) == 0)
+        path += 2;
+    return (path);
+}
+
+static int GridBundle_compare_entry(const void *entry1, const void *entry2) {
+
+    return (strcmp(((GridBundleEntry *) entry1)->name, ((GridBundleEntry *) entry2)->name));
+}
+
+/** function to open and register the grid bundle <bundle_root>.bundle, if it exists
+ *
+ *  The bundle file is mapped read-only into memory.  Opening a bundle that is already registered has no effect.
+ *  Returns the number of grids in the bundle, 0 if there is no bundle file, or -1 on error.
+ */
+
+int GridBundle_Open(char *bundle_root) {
+
+    char fn_bundle[FILENAME_MAX];
+    struct stat bundle_stat;
+    int fd;
+
+
+    pthread_mutex_lock(&GridBundleMutex);
+
+    for (int n = 0; n < NumGridBundles; n++) {
+        if (strcmp(GridBundleList[n].root, bundle_root) == 0) {
+            long num_entries = GridBundleList[n].num_entries;
+            pthread_mutex_unlock(&GridBundleMutex);
+            return (num_entries);
+        }
+    }
+
+    snprintf(fn_bundle, sizeof (fn_bundle), "%s.%s", bundle_root, GRID_BUNDLE_EXT);
+    if ((fd = open(fn_bundle, O_RDONLY)) < 0) {
+        pthread_mutex_unlock(&GridBundleMutex);
+        return (0);
+    }
+
+#ifndef GRID_BUNDLE_MEMSTREAM
+    nll_puterr2("ERROR: cannot read grid bundle: C library memory streams needed (function fmemopen(); see compiler define _GNU_SOURCE)", fn_bundle);
+    close(fd);
+    pthread_mutex_unlock(&GridBundleMutex);
+    return (-1);
+#endif
+
+    if (NumGridBundles >= MAX_NUM_GRID_BUNDLES) {
+        sprintf(MsgStr, "ERROR: maximum number of grid bundles (%d) exceeded, cannot open: %s", MAX_NUM_GRID_BUNDLES, fn_bundle);
+        nll_puterr(MsgStr);
+        close(fd);
+        pthread_mutex_unlock(&GridBundleMutex);
+        return (-1);
+    }
+
+    if (fstat(fd, &bundle_stat) != 0 || (size_t) bundle_stat.st_size < sizeof (GridBundleHeader)) {
+        nll_puterr2("ERROR: grid bundle file too small", fn_bundle);
+        close(fd);
+        pthread_mutex_unlock(&GridBundleMutex);
+        return (-1);
+    }
+    size_t map_size = (size_t) bundle_stat.st_size;
+    char *map = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        nll_puterr2("ERROR: mapping grid bundle file to memory", fn_bundle);
+        pthread_mutex_unlock(&GridBundleMutex);
+        return (-1);
+    }
+
+    // check header and index
+    GridBundleHeader header;
+    memcpy(&header, map, sizeof (GridBundleHeader));
+    int ierr = strncmp(header.magic, GRID_BUNDLE_MAGIC, sizeof (header.magic)) != 0 || header.version != GRID_BUNDLE_VERSION
+            || header.index_offset < (int64_t) sizeof (GridBundleHeader) || header.num_entries < 0
+            || (size_t) header.index_offset + (size_t) header.num_entries * sizeof (GridBundleEntry) > map_size;
+    GridBundleEntry *entries = NULL;
+    if (!ierr) {
+        entries = malloc((header.num_entries > 0 ? header.num_entries : 1) * sizeof (GridBundleEntry));
+        memcpy(entries, map + header.index_offset, header.num_entries * sizeof (GridBundleEntry));
+        for (long n = 0; n < header.num_entries && !ierr; n++) {
+            GridBundleEntry *entry = entries + n;
+            ierr = memchr(entry->name, '\0', GRID_BUNDLE_NAME_LEN) == NULL
+                    || entry->hdr_offset < 0 || entry->hdr_size <= 0 || (size_t) (entry->hdr_offset + entry->hdr_size) > map_size
+                    || entry->buf_offset < 0 || entry->buf_size <= 0 || (size_t) (entry->buf_offset + entry->buf_size) > map_size;
+        }
+    }
+    if (ierr) {
+        nll_puterr2("ERROR: invalid grid bundle file", fn_bundle);
+        free(entries);
+        munmap(map, map_size);
+        pthread_mutex_unlock(&GridBundleMutex);
+        return (-1);
+    }
+    qsort(entries, header.num_entries, sizeof (GridBundleEntry), GridBundle_compare_entry);
+
+    GridBundle *pbundle = GridBundleList + NumGridBundles;
+    strcpy(pbundle->root, bundle_root);
+    pbundle->root_len = strlen(GridBundle_skip_dot_slash(bundle_root));
+    pbundle->map = map;
+    pbundle->map_size = map_size;
+    pbundle->entries = entries;
+    pbundle->num_entries = header.num_entries;
+    NumGridBundles++;
+
+    pthread_mutex_unlock(&GridBundleMutex);
+
+    if (message_flag >= 1) {
+        sprintf(MsgStr, "INFO: opened grid bundle: %s  (%ld grids)", fn_bundle, (long) header.num_entries);
+        nll_putmsg(1, MsgStr);
+    }
+
+    return (header.num_entries);
+}
+
+/** function to unmap and unregister all grid bundles
+ *
+ *  No grids opened from a bundle may be in use.
+ */
+
+void GridBundle_CloseAll() {
+
+    pthread_mutex_lock(&GridBundleMutex);
+    for (int n = 0; n < NumGridBundles; n++) {
+        munmap(GridBundleList[n].map, GridBundleList[n].map_size);
+        free(GridBundleList[n].entries);
+    }
+    NumGridBundles = 0;
+    pthread_mutex_unlock(&GridBundleMutex);
+
+}
+
+/** function to find grid with file root fname in the registered grid bundles
+ *
+ *  Returns 1 and sets pointers to the grid header and buffer file contents if found, 0 otherwise.
+ */
+
+static int GridBundle_Find(char *fname, char **phdr, size_t *phdr_size, char **pbuf, size_t *pbuf_size) {
+
+    GridBundleEntry key;
+    int found = 0;
+
+
+    fname = GridBundle_skip_dot_slash(fname);
+    pthread_mutex_lock(&GridBundleMutex);
+    for (int n = 0; n < NumGridBundles && !found; n++) {
+        GridBundle *pbundle = GridBundleList + n;
+        if (strncmp(fname, GridBundle_skip_dot_slash(pbundle->root), pbundle->root_len) != 0 || fname[pbundle->root_len] != '.'
+                || strlen(fname + pbundle->root_len + 1) >= GRID_BUNDLE_NAME_LEN)
+            continue;
+        strcpy(key.name, fname + pbundle->root_len + 1);
+        GridBundleEntry *entry = bsearch(&key, pbundle->entries, pbundle->num_entries, sizeof (GridBundleEntry), GridBundle_compare_entry);
+        if (entry != NULL) {
+            *phdr = pbundle->map + entry->hdr_offset;
+            *phdr_size = entry->hdr_size;
+            *pbuf = pbundle->map + entry->buf_offset;
+            *pbuf_size = entry->buf_size;
+            found = 1;
+        }
+    }
+    pthread_mutex_unlock(&GridBundleMutex);
+
+    return (found);
+}
+
+/** function to open read-only stream on grid file contents in a grid bundle */
+
+static FILE* GridBundle_fopen(char *data, size_t size) {
+
+#ifdef GRID_BUNDLE_MEMSTREAM
+    return (fmemopen(data, size, "r"));
+#else
+    return (NULL);
+#endif
+}
+
+/** function to read contents of a file into allocated memory */
+
+static char* GridBundle_read_file(char *fname, int64_t *psize) {
+
+    FILE *fp;
+    char *data = NULL;
+    long size;
+
+
+    if ((fp = fopen(fname, "r")) == NULL) {
+        nll_puterr2("ERROR: opening grid file", fname);
+        return (NULL);
+    }
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    rewind(fp);
+    if (size <= 0 || (data = malloc(size)) == NULL || fread(data, size, 1, fp) != 1) {
+        nll_puterr2("ERROR: reading grid file", fname);
+        free(data);
+        fclose(fp);
+        return (NULL);
+    }
+    fclose(fp);
+
+    *psize = size;
+    return (data);
+}
+
+/** function to write data to bundle file at current position followed by zero padding to GRID_BUNDLE_ALIGN */
+
+static int GridBundle_write_aligned(FILE *fp, char *data, int64_t size) {
+
+    static const char zeros[GRID_BUNDLE_ALIGN] = {0};
+
+    if (size > 0 && fwrite(data, size, 1, fp) != 1)
+        return (-1);
+    long npad = (GRID_BUNDLE_ALIGN - ftell(fp) % GRID_BUNDLE_ALIGN) % GRID_BUNDLE_ALIGN;
+    if (npad > 0 && fwrite(zeros, npad, 1, fp) != 1)
+        return (-1);
+
+    return (0);
+}
+
+/** function to flush bundle file stream and its data to disk */
+
+static int GridBundle_sync(FILE *fp) {
+
+    if (fflush(fp) != 0 || fsync(fileno(fp)) != 0)
+        return (-1);
+
+    return (0);
+}
+
+/** function to append grid header and buffer files <grid_root>.hdr and <grid_root>.buf to grid bundle <bundle_root>.bundle
+ *
+ *  grid_root must be <bundle_root>.<name>, e.g. bundle_root.P.STA.time.  The bundle file is created if it does not exist,
+ *  a grid already in the bundle with the same name is replaced (the space of the replaced grid is not reclaimed).
+ *  The bundle file is locked during the append, so several processes may append to the same bundle.
+ *  20261017 agent - the grid and the new index are written at the end of the bundle file, then the header is rewritten to
+ *    point to the new index (the space of the previous index is not reclaimed); if the append is interrupted the bundle
+ *    keeps its previous contents, and processes reading the bundle are not affected by the append.
+ *  If remove_files, the grid header and buffer files are removed after a successful append.
+ */
 
+int GridBundle_AppendGrid(char *bundle_root, char *grid_root, int remove_files) {
 
-    /* calculate number of bytes to read */
+    char fn_bundle[FILENAME_MAX], fn_hdr[FILENAME_MAX], fn_buf[FILENAME_MAX];
+    char *root = GridBundle_skip_dot_slash(bundle_root);
+    char *grid = GridBundle_skip_dot_slash(grid_root);
+    size_t root_len = strlen(root);
+    char *name = grid + root_len + 1;
 
-    readsize = pgrid_disk->numy * pgrid_disk->numz * sizeof (GRID_FLOAT_TYPE);
 
+    if (strncmp(grid, root, root_len) != 0 || grid[root_len] != '.' || strlen(name) >= GRID_BUNDLE_NAME_LEN) {
+        sprintf(MsgStr, "ERROR: grid file root %s is not in grid bundle %s", grid_root, bundle_root);
+        nll_puterr(MsgStr);
+        return (-1);
+    }
 
-    /* read sheet from grid file to buffer */
+    // read grid header and buffer files
+    snprintf(fn_hdr, sizeof (fn_hdr), "%s.hdr", grid_root);
+    snprintf(fn_buf, sizeof (fn_buf), "%s.buf", grid_root);
+    int64_t hdr_size, buf_size;
+    char *hdr_data = GridBundle_read_file(fn_hdr, &hdr_size);
+    if (hdr_data == NULL)
+        return (-1);
+    char *buf_data = GridBundle_read_file(fn_buf, &buf_size);
+    if (buf_data == NULL) {
+        free(hdr_data);
+        return (-1);
+    }
 
-    if (fread((char *) sheetbuf, readsize, 1, fpio) != 1) {
-        nll_puterr("ERROR: reading x-sheet grid file.");
+    // open and lock bundle file, create if necessary
+    snprintf(fn_bundle, sizeof (fn_bundle), "%s.%s", bundle_root, GRID_BUNDLE_EXT);
+    int fd;
+    FILE *fp = NULL;
+    if ((fd = open(fn_bundle, O_RDWR | O_CREAT, 0644)) < 0 || (fp = fdopen(fd, "r+")) == NULL) {
+        nll_puterr2("ERROR: opening grid bundle file", fn_bundle);
+        if (fd >= 0)
+            close(fd);
+        free(hdr_data);
+        free(buf_data);
+        return (-1);
+    }
+    flock(fd, LOCK_EX);
+
+    // read header and index
+    GridBundleHeader header;
+    GridBundleEntry *entries = NULL;
+    int ierr = 0;
+    fseek(fp, 0, SEEK_END);
+    if (ftell(fp) == 0) {
+        // new bundle, write empty bundle
+        memset(&header, 0, sizeof (GridBundleHeader));
+        memcpy(header.magic, GRID_BUNDLE_MAGIC, sizeof (header.magic));
+        header.version = GRID_BUNDLE_VERSION;
+        header.index_offset = GRID_BUNDLE_ALIGN;
+        header.num_entries = 0;
+        ierr = GridBundle_write_aligned(fp, (char *) &header, sizeof (GridBundleHeader)) < 0
+                || GridBundle_sync(fp) < 0;
+    } else {
+        rewind(fp);
+        ierr = fread(&header, sizeof (GridBundleHeader), 1, fp) != 1
+                || strncmp(header.magic, GRID_BUNDLE_MAGIC, sizeof (header.magic)) != 0 || header.version != GRID_BUNDLE_VERSION
+                || header.num_entries < 0;
+    }
+    if (!ierr) {
+        entries = malloc((header.num_entries + 1) * sizeof (GridBundleEntry));
+        fseek(fp, header.index_offset, SEEK_SET);
+        if (header.num_entries > 0)
+            ierr = fread(entries, sizeof (GridBundleEntry), header.num_entries, fp) != (size_t) header.num_entries;
+    }
+
+    // 20261017 agent - bug fix, grid data was written over old index and header last, an interrupted append corrupted the bundle
+    // write grid data and new index after end of file, then header
+    if (!ierr) {
+        long nentry;
+        for (nentry = 0; nentry < header.num_entries; nentry++) {
+            if (strcmp(entries[nentry].name, name) == 0)
+                break;
+        }
+        if (nentry == header.num_entries) {
+            header.num_entries++;
+            memset(entries + nentry, 0, sizeof (GridBundleEntry));
+            strcpy(entries[nentry].name, name);
+        }
+        fseek(fp, 0, SEEK_END);
+        ierr = GridBundle_write_aligned(fp, NULL, 0) < 0;
+        entries[nentry].hdr_offset = ftell(fp);
+        entries[nentry].hdr_size = hdr_size;
+        ierr = ierr || GridBundle_write_aligned(fp, hdr_data, hdr_size) < 0;
+        entries[nentry].buf_offset = ftell(fp);
+        entries[nentry].buf_size = buf_size;
+        ierr = ierr || GridBundle_write_aligned(fp, buf_data, buf_size) < 0;
+        header.index_offset = ftell(fp);
+        ierr = ierr || fwrite(entries, sizeof (GridBundleEntry), header.num_entries, fp) != (size_t) header.num_entries;
+        // grid data and index must be on disk before header points to them
+        ierr = ierr || GridBundle_sync(fp) < 0;
+        rewind(fp);
+        ierr = ierr || fwrite(&header, sizeof (GridBundleHeader), 1, fp) != 1;
+        ierr = ierr || GridBundle_sync(fp) < 0;
+    }
+
+    flock(fd, LOCK_UN);
+    fclose(fp);
+    free(entries);
+    free(hdr_data);
+    free(buf_data);
+
+    if (ierr) {
+        nll_puterr2("ERROR: writing grid bundle file", fn_bundle);
         return (-1);
     }
 
-    if (pgrid_disk->iSwapBytes)
-        swapBytes(sheetbuf, readsize / sizeof (GRID_FLOAT_TYPE));
+    if (remove_files) {
+        remove(fn_hdr);
+        remove(fn_buf);
+    }
+
+    if (message_flag >= 2) {
+        sprintf(MsgStr, "INFO: grid %s appended to grid bundle: %s", name, fn_bundle);
+        nll_putmsg(2, MsgStr);
+    }
 
     return (0);
 }
@@ -2190,8 +3645,14 @@ int ReadGrid3dHdr(GridDesc* pgrid, SourceDesc* psrce, char* filename, char* file
 
     /* read header file */
 
+    // 20261016 agent - added, check for grid in a registered grid bundle
+    char *bundle_hdr, *bundle_buf;
+    size_t bundle_hdr_size, bundle_buf_size;
+    sprintf(fname, "%s.%s", filename, file_type);
+    int in_bundle = GridBundle_Find(fname, &bundle_hdr, &bundle_hdr_size, &bundle_buf, &bundle_buf_size);
+
     sprintf(fname, "%s.%s.hdr", filename, file_type);
-    if ((fpio = fopen(fname, "r")) == NULL) {
+    if ((fpio = in_bundle ? GridBundle_fopen(bundle_hdr, bundle_hdr_size) : fopen(fname, "r")) == NULL) {
         if (message_flag >= 1)
             nll_puterr2("ERROR: opening grid header file: %s", fname);
         return (-1);
@@ -2225,6 +3686,23 @@ int ReadGrid3dHdr(GridDesc* pgrid, SourceDesc* psrce, char* filename, char* file
         }
     }
 
+    // grid buffer has regular layout and all grid nodes until set otherwise
+    pgrid->flagGridTiled = IS_NOT_TILED; // 20261016 agent - added
+    pgrid->flagGridSubGrid = IS_NOT_SUBGRID; // 20261016 agent - added
+
+    // check if compressed grid
+    // 20261016 agent - added
+    pgrid->flagGridCompressed = IS_NOT_COMPRESSED;
+    rewind(fpio);
+    while (fgets(line, MAXLINE_LONG, fpio) != NULL) {
+        int brick_size;
+        double max_error;
+        int istat = sscanf(line, "%s %d %lf", tag, &brick_size, &max_error);
+        if (istat == 3 && strcmp(tag, "COMPRESSED_GRID") == 0) {
+            setCompressedGrid(pgrid, brick_size, max_error);
+        }
+    }
+
     // check if cascading grid
     pgrid->flagGridCascading = IS_NOT_CASCADING;
     int num_z_merge_depths;
@@ -2300,14 +3778,19 @@ int OpenGrid3dFile(char *fname, FILE **fp_grid, FILE **fp_hdr,
 
     char fn_grid[FILENAME_MAX], fn_hdr[FILENAME_MAX];
 
+    // 20261016 agent - added, check for grid in a registered grid bundle, the bundle is used in place of grid files
+    char *bundle_hdr, *bundle_buf;
+    size_t bundle_hdr_size, bundle_buf_size;
+    int in_bundle = GridBundle_Find(fname, &bundle_hdr, &bundle_hdr_size, &bundle_buf, &bundle_buf_size);
+
     /* open grid file and header file */
 
     sprintf(fn_grid, "%s.buf", fname);
     if (message_flag >= 3) {
-        sprintf(MsgStr, "Opening Grid File: %s", fn_grid);
+        sprintf(MsgStr, "Opening Grid File: %s%s", fn_grid, in_bundle ? " (in grid bundle)" : "");
         nll_putmsg(3, MsgStr);
     }
-    if ((*fp_grid = fopen(fn_grid, "r")) == NULL) {
+    if ((*fp_grid = in_bundle ? GridBundle_fopen(bundle_buf, bundle_buf_size) : fopen(fn_grid, "r")) == NULL) {
         if (message_flag >= 3) {
             sprintf(MsgStr, "WARNING: cannot open grid buffer file: %s", fn_grid);
             nll_putmsg(3, MsgStr);
@@ -2318,7 +3801,7 @@ int OpenGrid3dFile(char *fname, FILE **fp_grid, FILE **fp_hdr,
         NumFilesOpen++;
     }
     sprintf(fn_hdr, "%s.hdr", fname);
-    if ((*fp_hdr = fopen(fn_hdr, "r")) == NULL) {
+    if ((*fp_hdr = in_bundle ? GridBundle_fopen(bundle_hdr, bundle_hdr_size) : fopen(fn_hdr, "r")) == NULL) {
         if (message_flag >= 3) {
             sprintf(MsgStr,
                     "WARNING: cannot open grid header file: %s", fn_hdr);
@@ -2337,6 +3820,9 @@ int OpenGrid3dFile(char *fname, FILE **fp_grid, FILE **fp_hdr,
     // initialize key fields
     pgrid->array = NULL;
     pgrid->buffer = NULL;
+    pgrid->buffer_mapped = 0;
+    pgrid->bundle_buffer = in_bundle ? bundle_buf : NULL; // 20261016 agent - added
+    pgrid->bundle_buffer_size = in_bundle ? bundle_buf_size : 0;
 
 
     /* read header file */
@@ -2387,6 +3873,23 @@ int OpenGrid3dFile(char *fname, FILE **fp_grid, FILE **fp_hdr,
         }
     }
 
+    // grid buffer has regular layout and all grid nodes until set otherwise
+    pgrid->flagGridTiled = IS_NOT_TILED; // 20261016 agent - added
+    pgrid->flagGridSubGrid = IS_NOT_SUBGRID; // 20261016 agent - added
+
+    // check if compressed grid
+    // 20261016 agent - added
+    pgrid->flagGridCompressed = IS_NOT_COMPRESSED;
+    rewind(*fp_hdr);
+    while (fgets(line, MAXLINE_LONG, *fp_hdr) != NULL) {
+        int brick_size;
+        double max_error;
+        int istat = sscanf(line, "%s %d %lf", tag, &brick_size, &max_error);
+        if (istat == 3 && strcmp(tag, "COMPRESSED_GRID") == 0) {
+            setCompressedGrid(pgrid, brick_size, max_error);
+        }
+    }
+
     // check if cascading grid
     pgrid->flagGridCascading = IS_NOT_CASCADING;
     int num_z_merge_depths;
@@ -2423,6 +3926,31 @@ int OpenGrid3dFile(char *fname, FILE **fp_grid, FILE **fp_hdr,
 
 }
 
+/** function to open grid buffer file of a grid opened before with OpenGrid3dFile()
+ *
+ * 20261016 agent - added, allows reopening the grid buffer file without reading the grid header
+ */
+
+FILE* OpenGrid3dBufFile(char *fname, GridDesc* pgrid) {
+
+    char fn_grid[FILENAME_MAX];
+    FILE *fp_grid;
+
+
+    if (pgrid->bundle_buffer != NULL) {
+        fp_grid = GridBundle_fopen(pgrid->bundle_buffer, pgrid->bundle_buffer_size);
+    } else {
+        sprintf(fn_grid, "%s.buf", fname);
+        fp_grid = fopen(fn_grid, "r");
+    }
+    if (fp_grid != NULL) {
+        NumGridBufFilesOpen++;
+        NumFilesOpen++;
+    }
+
+    return (fp_grid);
+}
+
 /** function to close grid file and header ***/
 
 void CloseGrid3dFile(GridDesc* pgrid, FILE **fp_grid, FILE **fp_hdr) {
@@ -2556,6 +4084,7 @@ GRID_FLOAT_TYPE ReadCascadingGrid3dValue(FILE *fpgrid, int ix_casc, int iy_casc,
             nll_puterr(MsgStr);
             return (-VERY_LARGE_FLOAT);
         }
+        NumGridBytesRead += sizeof (GRID_FLOAT_TYPE);
         if (pgrid->iSwapBytes)
             swapBytes(&fvalue, 1);
     } else {
@@ -2836,7 +4365,10 @@ GRID_FLOAT_TYPE ReadGrid3dValue(FILE *fpgrid, int ix, int iy, int iz, GridDesc *
 
     /* get fvalue */
 
-    if (fpgrid != NULL) {
+    if (fpgrid != NULL && isCompressedGrid(pgrid)) {
+        // 20261016 agent - added
+        fvalue = ReadGrid3dValue_Compressed(fpgrid, ix, iy, iz, pgrid);
+    } else if (fpgrid != NULL) {
         /* calculate offset in bytes */
         numyz = pgrid->numy * pgrid->numz;
         offset = sizeof (GRID_FLOAT_TYPE) * (ix * numyz + iy * pgrid->numz + iz);
@@ -2848,8 +4380,12 @@ GRID_FLOAT_TYPE ReadGrid3dValue(FILE *fpgrid, int ix, int iy, int iz, GridDesc *
             nll_puterr(MsgStr);
             return (-VERY_LARGE_FLOAT);
         }
+        NumGridBytesRead += sizeof (GRID_FLOAT_TYPE);
         if (pgrid->iSwapBytes)
             swapBytes(&fvalue, 1);
+    } else if (isTiledGrid(pgrid)) {
+        // 20261016 agent - added
+        fvalue = ((GRID_FLOAT_TYPE *) pgrid->buffer)[TiledGridOffset(pgrid, ix, iy, iz)];
     } else {
 
         fvalue = ((GRID_FLOAT_TYPE ***) pgrid->array)[ix][iy][iz];
@@ -3110,6 +4646,8 @@ GRID_FLOAT_TYPE ReadAbsInterpGrid3d(FILE *fpgrid, GridDesc* pgrid, double xloc,
     if (xdiff + ydiff + zdiff < SMALL_FLOAT) {
         if (fpgrid != NULL)
             value = ReadGrid3dValue(fpgrid, ix0, iy0, iz0, pgrid, 0);
+        else if (isTiledGrid(pgrid))
+            value = *(buffer + TiledGridOffset(pgrid, ix0, iy0, iz0));
         else
             value = *(buffer + ix0 * numyz + iy0 * numz + iz0);
         return (value);
@@ -3118,7 +4656,19 @@ GRID_FLOAT_TYPE ReadAbsInterpGrid3d(FILE *fpgrid, GridDesc* pgrid, double xloc,
 
     /* read vertex values from grid file or array */
 
-    if (fpgrid != NULL) {
+    if (fpgrid == NULL && isTiledGrid(pgrid)) {
+        // 20261016 agent - added, tiled layout, cell corners usually in same tile
+        long offset[8];
+        gridCellOffsets(pgrid, ix0, iy0, iz0, ix1, iy1, iz1, offset);
+        vval000 = buffer[offset[0]];
+        vval001 = buffer[offset[1]];
+        vval010 = buffer[offset[2]];
+        vval011 = buffer[offset[3]];
+        vval100 = buffer[offset[4]];
+        vval101 = buffer[offset[5]];
+        vval110 = buffer[offset[6]];
+        vval111 = buffer[offset[7]];
+    } else if (fpgrid != NULL) {
         vval000 = ReadGrid3dValue(fpgrid, ix0, iy0, iz0, pgrid, 0);
         vval001 = ReadGrid3dValue(fpgrid, ix0, iy0, iz1, pgrid, 0);
         vval010 = ReadGrid3dValue(fpgrid, ix0, iy1, iz0, pgrid, 0);
@@ -3175,6 +4725,364 @@ GRID_FLOAT_TYPE ReadAbsInterpGrid3d(FILE *fpgrid, GridDesc* pgrid, double xloc,
 }
 
 
+/** batched interpolation of several 3D grids at the same location
+ *
+ * 20261016 agent - added
+ */
+
+/* cube of grid nodes containing an interpolation point, shared by grids with identical geometry */
+typedef struct {
+    int status; // -1 = point outside grid, 1 = point at grid node, 0 = interpolate
+    long offset[8]; // buffer offsets of cube corners 000, 001, 010, 011, 100, 101, 110, 111
+    DOUBLE xdiff, ydiff, zdiff;
+} InterpCube3d;
+
+/* set interpolation cube, same calculation as in ReadAbsInterpGrid3d() */
+
+static void setInterpCube3d(GridDesc* pgrid, double xloc, double yloc, double zloc, InterpCube3d *pcube) {
+
+    DOUBLE xoff, yoff, zoff;
+    int ix0, ix1, iy0, iy1, iz0, iz1;
+
+    xoff = (xloc - pgrid->origx) / pgrid->dx;
+    yoff = (yloc - pgrid->origy) / pgrid->dy;
+    zoff = (zloc - pgrid->origz) / pgrid->dz;
+
+    ix0 = (int) (xoff - VERY_SMALL_DOUBLE);
+    iy0 = (int) (yoff - VERY_SMALL_DOUBLE);
+    iz0 = (int) (zoff - VERY_SMALL_DOUBLE);
+
+    ix1 = (ix0 < pgrid->numx - 1) ? ix0 + 1 : ix0;
+    iy1 = (iy0 < pgrid->numy - 1) ? iy0 + 1 : iy0;
+    iz1 = (iz0 < pgrid->numz - 1) ? iz0 + 1 : iz0;
+
+    pcube->xdiff = xoff - (DOUBLE) ix0;
+    pcube->ydiff = yoff - (DOUBLE) iy0;
+    pcube->zdiff = zoff - (DOUBLE) iz0;
+
+    if (pcube->xdiff < 0.0 || pcube->xdiff > 1.0 || pcube->ydiff < 0.0 || pcube->ydiff > 1.0
+            || pcube->zdiff < 0.0 || pcube->zdiff > 1.0) {
+        pcube->status = -1;
+        return;
+    }
+
+    gridCellOffsets(pgrid, ix0, iy0, iz0, ix1, iy1, iz1, pcube->offset);
+
+    pcube->status = (pcube->xdiff + pcube->ydiff + pcube->zdiff < SMALL_FLOAT) ? 1 : 0;
+
+}
+
+/* interpolate grid value in cube, same calculation as in ReadAbsInterpGrid3d() */
+
+static GRID_FLOAT_TYPE interpCube3d(GridDesc* pgrid, InterpCube3d *pcube) {
+
+    GRID_FLOAT_TYPE *buffer = (GRID_FLOAT_TYPE *) pgrid->buffer;
+    DOUBLE vval000, vval001, vval010, vval011, vval100, vval101, vval110, vval111;
+
+    if (pcube->status < 0)
+        return (-VERY_LARGE_FLOAT);
+    if (pcube->status > 0)
+        return (buffer[pcube->offset[0]]);
+
+    vval000 = buffer[pcube->offset[0]];
+    vval001 = buffer[pcube->offset[1]];
+    vval010 = buffer[pcube->offset[2]];
+    vval011 = buffer[pcube->offset[3]];
+    vval100 = buffer[pcube->offset[4]];
+    vval101 = buffer[pcube->offset[5]];
+    vval110 = buffer[pcube->offset[6]];
+    vval111 = buffer[pcube->offset[7]];
+
+    if (pgrid->type == GRID_ANGLE || pgrid->type == GRID_ANGLE_2D) {
+        return (InterpCubeAngles(pcube->xdiff, pcube->ydiff, pcube->zdiff,
+                vval000, vval001, vval010, vval011,
+                vval100, vval101, vval110, vval111));
+    }
+    if (pgrid->type != GRID_SSST_TIMECORR) {
+        if (vval000 < 0.0 || vval010 < 0.0 || vval100 < 0.0 || vval110 < 0.0
+                || vval001 < 0.0 || vval011 < 0.0 || vval101 < 0.0 || vval111 < 0.0) {
+            return (-VERY_LARGE_FLOAT);
+        }
+    }
+
+    return (InterpCubeLagrange(pcube->xdiff, pcube->ydiff, pcube->zdiff,
+            vval000, vval001, vval010, vval011,
+            vval100, vval101, vval110, vval111));
+}
+
+/* check if two grids have identical geometry and buffer layout */
+
+static int isSameGridGeometry(GridDesc* pgrid1, GridDesc* pgrid2) {
+
+    return (pgrid1->numx == pgrid2->numx && pgrid1->numy == pgrid2->numy && pgrid1->numz == pgrid2->numz
+            && pgrid1->origx == pgrid2->origx && pgrid1->origy == pgrid2->origy && pgrid1->origz == pgrid2->origz
+            && pgrid1->dx == pgrid2->dx && pgrid1->dy == pgrid2->dy && pgrid1->dz == pgrid2->dz
+            && isTiledGrid(pgrid1) == isTiledGrid(pgrid2));
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(GRID_FLOAT_TYPE_DOUBLE)
+#define INTERP_BATCH_AVX2
+
+/* interpolate 4 time grids in a cube with AVX2 gathers
+ *
+ * corner values are converted to double and blended in the same order as InterpCubeLagrange(),
+ * without fused multiply-add, so results are identical to the scalar calculation.
+ */
+
+__attribute__((target("avx2")))
+static void interpCube3d_x4_avx2(GridDesc** pgrids, InterpCube3d *pcube, GRID_FLOAT_TYPE *values) {
+
+    int n, k, mask_neg = 0;
+    __m256i base;
+    __m256d vval[8];
+    __m256d zero = _mm256_setzero_pd();
+
+    base = _mm256_set_epi64x((long long) (uintptr_t) pgrids[3]->buffer, (long long) (uintptr_t) pgrids[2]->buffer,
+            (long long) (uintptr_t) pgrids[1]->buffer, (long long) (uintptr_t) pgrids[0]->buffer);
+    for (k = 0; k < 8; k++) {
+        __m256i addr = _mm256_add_epi64(base, _mm256_set1_epi64x((long long) (pcube->offset[k] * (long) sizeof (GRID_FLOAT_TYPE))));
+        vval[k] = _mm256_cvtps_pd(_mm256_i64gather_ps((float const *) 0, addr, 1));
+        mask_neg |= _mm256_movemask_pd(_mm256_cmp_pd(vval[k], zero, _CMP_LT_OQ));
+    }
+
+    __m256d xdiff = _mm256_set1_pd(pcube->xdiff);
+    __m256d ydiff = _mm256_set1_pd(pcube->ydiff);
+    __m256d zdiff = _mm256_set1_pd(pcube->zdiff);
+    __m256d oneMinusXdiff = _mm256_set1_pd(1.0 - pcube->xdiff);
+    __m256d oneMinusYdiff = _mm256_set1_pd(1.0 - pcube->ydiff);
+    __m256d oneMinusZdiff = _mm256_set1_pd(1.0 - pcube->zdiff);
+
+    __m256d v00 = _mm256_add_pd(_mm256_mul_pd(vval[0], oneMinusZdiff), _mm256_mul_pd(vval[1], zdiff));
+    __m256d v01 = _mm256_add_pd(_mm256_mul_pd(vval[2], oneMinusZdiff), _mm256_mul_pd(vval[3], zdiff));
+    __m256d v10 = _mm256_add_pd(_mm256_mul_pd(vval[4], oneMinusZdiff), _mm256_mul_pd(vval[5], zdiff));
+    __m256d v11 = _mm256_add_pd(_mm256_mul_pd(vval[6], oneMinusZdiff), _mm256_mul_pd(vval[7], zdiff));
+    __m256d v0 = _mm256_add_pd(_mm256_mul_pd(oneMinusYdiff, v00), _mm256_mul_pd(ydiff, v01));
+    __m256d v1 = _mm256_add_pd(_mm256_mul_pd(oneMinusYdiff, v10), _mm256_mul_pd(ydiff, v11));
+    __m256d value = _mm256_add_pd(_mm256_mul_pd(oneMinusXdiff, v0), _mm256_mul_pd(xdiff, v1));
+
+    _mm_storeu_ps(values, _mm256_cvtpd_ps(value));
+
+    // check for invalid / mask nodes
+    for (n = 0; n < 4; n++) {
+        if ((mask_neg & (1 << n)) && pgrids[n]->type != GRID_SSST_TIMECORR)
+            values[n] = -VERY_LARGE_FLOAT;
+    }
+
+}
+
+#endif
+
+/** function to read values from several 3D grids in memory at the same absolute location with interpolation
+ *
+ *  Returns in values[n] the same value as ReadAbsInterpGrid3d(NULL, pgrids[n], xloc, yloc, zloc, 0).
+ *  The interpolation cube is calculated once for each run of grids with identical geometry, and time grids
+ *  are interpolated 4 at a time with AVX2 if supported by the CPU.
+ *  Grids must be regular (not cascading) 3D grids with the grid buffer in memory.
+ */
+
+void ReadAbsInterpGrid3dBatch(GridDesc** pgrids, int ngrids, double xloc, double yloc, double zloc, GRID_FLOAT_TYPE *values) {
+
+    int n, nstart, nend;
+    InterpCube3d cube;
+
+#ifdef INTERP_BATCH_AVX2
+    int use_avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+    for (nstart = 0; nstart < ngrids; nstart = nend) {
+
+        // find run of grids with same geometry
+        for (nend = nstart + 1; nend < ngrids && isSameGridGeometry(pgrids[nstart], pgrids[nend]); nend++)
+            ;
+        setInterpCube3d(pgrids[nstart], xloc, yloc, zloc, &cube);
+
+        n = nstart;
+#ifdef INTERP_BATCH_AVX2
+        if (use_avx2 && cube.status == 0) {
+            for (; n + 4 <= nend; n += 4) {
+                if (pgrids[n]->type == GRID_TIME && pgrids[n + 1]->type == GRID_TIME
+                        && pgrids[n + 2]->type == GRID_TIME && pgrids[n + 3]->type == GRID_TIME) {
+                    interpCube3d_x4_avx2(pgrids + n, &cube, values + n);
+                } else {
+                    for (int m = n; m < n + 4; m++)
+                        values[m] = interpCube3d(pgrids[m], &cube);
+                }
+            }
+        }
+#endif
+        for (; n < nend; n++)
+            values[n] = interpCube3d(pgrids[n], &cube);
+    }
+
+}
+
+/** end of batched interpolation of several 3D grids */
+
+
+/** interpolation of a 3D grid along a z-column
+ *
+ * 20261016 agent - added
+ */
+
+/* x-y position of a z-column in a grid, same calculation as in ReadAbsInterpGrid3d() */
+typedef struct {
+    int status; // -1 = column outside grid, 0 = inside
+    int ix0, ix1, iy0, iy1;
+    DOUBLE xdiff, ydiff;
+} InterpColumn3d;
+
+static void setInterpColumn3d(GridDesc* pgrid, double xloc, double yloc, InterpColumn3d *pcol) {
+
+    DOUBLE xoff, yoff;
+
+    xoff = (xloc - pgrid->origx) / pgrid->dx;
+    yoff = (yloc - pgrid->origy) / pgrid->dy;
+
+    pcol->ix0 = (int) (xoff - VERY_SMALL_DOUBLE);
+    pcol->iy0 = (int) (yoff - VERY_SMALL_DOUBLE);
+    pcol->ix1 = (pcol->ix0 < pgrid->numx - 1) ? pcol->ix0 + 1 : pcol->ix0;
+    pcol->iy1 = (pcol->iy0 < pgrid->numy - 1) ? pcol->iy0 + 1 : pcol->iy0;
+
+    pcol->xdiff = xoff - (DOUBLE) pcol->ix0;
+    pcol->ydiff = yoff - (DOUBLE) pcol->iy0;
+
+    pcol->status = (pcol->xdiff < 0.0 || pcol->xdiff > 1.0 || pcol->ydiff < 0.0 || pcol->ydiff > 1.0) ? -1 : 0;
+
+}
+
+/* set z index and interpolation cube of a point in a z-column, same calculation as in setInterpCube3d() */
+
+static void setInterpColumnCube3d(GridDesc* pgrid, InterpColumn3d *pcol, double zloc, int *piz0, int *piz1, InterpCube3d *pcube) {
+
+    DOUBLE zoff;
+
+    zoff = (zloc - pgrid->origz) / pgrid->dz;
+    *piz0 = (int) (zoff - VERY_SMALL_DOUBLE);
+    *piz1 = (*piz0 < pgrid->numz - 1) ? *piz0 + 1 : *piz0;
+
+    pcube->xdiff = pcol->xdiff;
+    pcube->ydiff = pcol->ydiff;
+    pcube->zdiff = zoff - (DOUBLE) *piz0;
+
+    if (pcube->zdiff < 0.0 || pcube->zdiff > 1.0) {
+        pcube->status = -1;
+        return;
+    }
+
+    gridCellOffsets(pgrid, pcol->ix0, pcol->iy0, *piz0, pcol->ix1, pcol->iy1, *piz1, pcube->offset);
+
+    pcube->status = (pcube->xdiff + pcube->ydiff + pcube->zdiff < SMALL_FLOAT) ? 1 : 0;
+
+}
+
+#ifdef INTERP_BATCH_AVX2
+
+/* interpolate 4 points of a z-column of a regular (not tiled) time grid with AVX2 gathers
+ *
+ * the 4 cell corner columns are read with unit stride, arithmetic as in interpCube3d_x4_avx2()
+ */
+
+__attribute__((target("avx2")))
+static void interpColumn3d_x4_avx2(GridDesc* pgrid, InterpColumn3d *pcol, int *iz0, int *iz1, InterpCube3d *pcube,
+        GRID_FLOAT_TYPE *values) {
+
+    int n, k, mask_neg = 0;
+    long numz = pgrid->numz;
+    long numyz = (long) pgrid->numy * numz;
+    GRID_FLOAT_TYPE *buffer = (GRID_FLOAT_TYPE *) pgrid->buffer;
+    GRID_FLOAT_TYPE * column[4];
+    __m128i index0 = _mm_set_epi32(iz0[3], iz0[2], iz0[1], iz0[0]);
+    __m128i index1 = _mm_set_epi32(iz1[3], iz1[2], iz1[1], iz1[0]);
+    __m256d vval[8];
+    __m256d zero = _mm256_setzero_pd();
+
+    // corner columns 00, 01, 10, 11
+    column[0] = buffer + pcol->ix0 * numyz + pcol->iy0 * numz;
+    column[1] = buffer + pcol->ix0 * numyz + pcol->iy1 * numz;
+    column[2] = buffer + pcol->ix1 * numyz + pcol->iy0 * numz;
+    column[3] = buffer + pcol->ix1 * numyz + pcol->iy1 * numz;
+    for (k = 0; k < 4; k++) {
+        vval[2 * k] = _mm256_cvtps_pd(_mm_i32gather_ps(column[k], index0, 4));
+        vval[2 * k + 1] = _mm256_cvtps_pd(_mm_i32gather_ps(column[k], index1, 4));
+    }
+    for (k = 0; k < 8; k++)
+        mask_neg |= _mm256_movemask_pd(_mm256_cmp_pd(vval[k], zero, _CMP_LT_OQ));
+
+    __m256d xdiff = _mm256_set1_pd(pcol->xdiff);
+    __m256d ydiff = _mm256_set1_pd(pcol->ydiff);
+    __m256d zdiff = _mm256_set_pd(pcube[3].zdiff, pcube[2].zdiff, pcube[1].zdiff, pcube[0].zdiff);
+    __m256d oneMinusXdiff = _mm256_set1_pd(1.0 - pcol->xdiff);
+    __m256d oneMinusYdiff = _mm256_set1_pd(1.0 - pcol->ydiff);
+    __m256d oneMinusZdiff = _mm256_sub_pd(_mm256_set1_pd(1.0), zdiff);
+
+    __m256d v00 = _mm256_add_pd(_mm256_mul_pd(vval[0], oneMinusZdiff), _mm256_mul_pd(vval[1], zdiff));
+    __m256d v01 = _mm256_add_pd(_mm256_mul_pd(vval[2], oneMinusZdiff), _mm256_mul_pd(vval[3], zdiff));
+    __m256d v10 = _mm256_add_pd(_mm256_mul_pd(vval[4], oneMinusZdiff), _mm256_mul_pd(vval[5], zdiff));
+    __m256d v11 = _mm256_add_pd(_mm256_mul_pd(vval[6], oneMinusZdiff), _mm256_mul_pd(vval[7], zdiff));
+    __m256d v0 = _mm256_add_pd(_mm256_mul_pd(oneMinusYdiff, v00), _mm256_mul_pd(ydiff, v01));
+    __m256d v1 = _mm256_add_pd(_mm256_mul_pd(oneMinusYdiff, v10), _mm256_mul_pd(ydiff, v11));
+    __m256d value = _mm256_add_pd(_mm256_mul_pd(oneMinusXdiff, v0), _mm256_mul_pd(xdiff, v1));
+
+    _mm_storeu_ps(values, _mm256_cvtpd_ps(value));
+
+    // check for invalid / mask nodes
+    for (n = 0; n < 4; n++) {
+        if (mask_neg & (1 << n))
+            values[n] = -VERY_LARGE_FLOAT;
+    }
+
+}
+
+#endif
+
+/** function to read values of a 3D grid in memory along a z-column at an absolute x-y location with interpolation
+ *
+ *  Returns in values[n] the same value as ReadAbsInterpGrid3d(NULL, pgrid, xloc, yloc, zloc[n], 0), n = 0 to nz - 1.
+ *  The x-y position in the grid is calculated once for the column; for regular (not tiled) time grids the
+ *  4 cell corner columns are read with unit z stride, 4 points at a time with AVX2 if supported by the CPU.
+ *  Grid must be a regular (not cascading) 3D grid with the grid buffer in memory.
+ */
+
+void ReadAbsInterpGrid3dColumn(GridDesc* pgrid, double xloc, double yloc, double *zloc, int nz, GRID_FLOAT_TYPE *values) {
+
+    int n, k;
+    int iz0[4], iz1[4];
+    InterpColumn3d col;
+    InterpCube3d cube[4];
+
+    setInterpColumn3d(pgrid, xloc, yloc, &col);
+    if (col.status < 0) {
+        for (n = 0; n < nz; n++)
+            values[n] = -VERY_LARGE_FLOAT;
+        return;
+    }
+
+#ifdef INTERP_BATCH_AVX2
+    int use_avx2 = __builtin_cpu_supports("avx2") && pgrid->type == GRID_TIME && !isTiledGrid(pgrid);
+#endif
+
+    for (n = 0; n < nz; n += 4) {
+        int num = nz - n < 4 ? nz - n : 4;
+        int interp4 = num == 4;
+        for (k = 0; k < num; k++) {
+            setInterpColumnCube3d(pgrid, &col, zloc[n + k], iz0 + k, iz1 + k, cube + k);
+            interp4 = interp4 && cube[k].status == 0;
+        }
+#ifdef INTERP_BATCH_AVX2
+        if (use_avx2 && interp4) {
+            interpColumn3d_x4_avx2(pgrid, &col, iz0, iz1, cube, values + n);
+            continue;
+        }
+#endif
+        for (k = 0; k < num; k++)
+            values[n + k] = interpCube3d(pgrid, cube + k);
+    }
+
+}
+
+/** end of interpolation of a 3D grid along a z-column */
+
+
 /** function to read grid data from disk or buffer at absolute location with interpolation ***/
 
 /* 2D version - ix assumed = 0 */
@@ -3538,6 +5446,11 @@ int _WriteLocation(FILE *fpio, HypoDesc* phypo, ArrivalDesc* parrivals,
         fprintf(fpio, "\n");
 
 
+        // 20261016 agent - added, per-stage timing and counters of the location (LOCPERF)
+        if (HypoPerfLine[0] != '\0')
+            fprintf(fpio, "%s\n", HypoPerfLine);
+
+
         /* write differential loc parameters */
         if (nll_mode == MODE_DIFFERENTIAL
                 || phypo->event_id >= 0) { // 20110620 AJL - preserve event id if available
@@ -3946,7 +5859,7 @@ int ReadArrival(char* line, ArrivalDesc* parr, int iReadType) {
     int istat, istat2;
     long int idate, ihrmin;
     char *line_calc;
-    static char label[ARRIVAL_LABEL_LEN];
+    static NLL_THREAD_LOCAL char label[ARRIVAL_LABEL_LEN];
 
     // new values NLL PHASE_2 format
     // 20060629 AJL - Added
@@ -4862,7 +6775,7 @@ void MonthDay(int year, int yearday, int* pmonth, int* pday) {
 
 char* CurrTimeStr(void) {
 
-    static char timestr[MAXLINE];
+    static NLL_THREAD_LOCAL char timestr[MAXLINE];
     time_t curr_time;
 
     curr_time = time(NULL);
@@ -4943,6 +6856,76 @@ int ExpandWildCards(char* fileFilter, char fileList[][FILENAME_MAX], int maxNumF
 
 }
 
+/** function to check for and expand wild card characters in filenames
+        and to return an allocated list of equivalent files
+ *
+ *  the list has at least one element and must be freed by the caller
+ *  returns number of files, < 0 on error
+ */
+
+// 20261017 agent - added, list sized from the number of files instead of maxNumFiles
+
+int ExpandWildCardsAlloc(char* fileFilter, char (**pfileList)[FILENAME_MAX], int maxNumFiles) {
+
+    int nfiles;
+    char *pchr;
+    char directory[FILENAME_MAX];
+    struct dirent **namelist;
+    int n;
+
+
+    /* check for no '*' or '?' character */
+
+    if ((pchr = strchr(fileFilter, '*')) == NULL && (pchr = strchr(fileFilter, '?')) == NULL) {
+        if ((*pfileList = calloc(1, FILENAME_MAX)) == NULL) {
+            nll_puterr("ERROR: allocating memory for file list.");
+            return (-1);
+        }
+        strcpy((*pfileList)[0], fileFilter);
+        return (1);
+    }
+
+
+    // get directory and filename
+    if ((pchr = strrchr(fileFilter, '/')) != NULL) {
+        strncpy(directory, fileFilter, pchr - fileFilter);
+        directory[pchr - fileFilter] = '\0';
+        strcpy(ExpandWildCards_pattern, pchr + 1);
+    } else {
+        strcpy(directory, ".");
+        strcpy(ExpandWildCards_pattern, fileFilter);
+    }
+
+
+    /* expand wildcard file names into list of files */
+
+    n = scandir(directory, &namelist, fnmatch_wrapper, alphasort);
+    if ((*pfileList = calloc(n > 1 ? n : 1, FILENAME_MAX)) == NULL) {
+        nll_puterr("ERROR: allocating memory for file list.");
+        nfiles = -1;
+    } else if (n <= 0) {
+        nll_puterr2("ERROR: expanding wildcard filenames in: ", fileFilter);
+        nfiles = -1;
+    } else if (n > maxNumFiles) {
+        sprintf(MsgStr,
+                "ERROR: too many files: expanding wildcard filenames in: %s, max number of files = %d",
+                fileFilter, maxNumFiles);
+        nll_puterr(MsgStr);
+        nfiles = -1;
+    } else {
+        for (nfiles = 0; nfiles < n; nfiles++)
+            sprintf((*pfileList)[nfiles], "%s/%s", directory, namelist[nfiles]->d_name);
+    }
+    if (n > 0) {
+        while (--n >= 0)
+            free(namelist[n]);
+        free(namelist);
+    }
+
+    return (nfiles);
+
+}
+
 /** function to wrap fnmatch */
 
 int fnmatch_wrapper(const struct dirent * entry) {
@@ -5198,8 +7181,8 @@ int ReadTakeOffAnglesFile(char *fname, double xloc, double yloc, double zloc,
 
 double normal_dist_deviate() {
 
-    static int iset = 0;
-    static float gset;
+    static NLL_THREAD_LOCAL int iset = 0;
+    static NLL_THREAD_LOCAL float gset;
     double fac, r, v1, v2;
 
     if (iset == 0) {
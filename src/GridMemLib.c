@@ -33,6 +33,9 @@ tel: +33(0)493752502  e-mail: anthony@alomax.net  web: http://www.alomax.net
 
 
 
+#include <pthread.h>
+#include <sys/resource.h>
+
 #include "GridLib.h"
 //#include "ran1.h"
 #include "GridMemLib.h"
@@ -42,8 +45,35 @@ tel: +33(0)493752502  e-mail: anthony@alomax.net  web: http://www.alomax.net
 GridMemStruct** GridMemList;
 int GridMemListSize;
 int GridMemListNumElements;
-int Num3DGridReadToMemory, MaxNum3DGridMemory;
+NLL_THREAD_LOCAL int Num3DGridReadToMemory;
+NLL_THREAD_LOCAL long GridMemThreadNumHits; // 20261016 agent - added
+NLL_THREAD_LOCAL long GridMemThreadNumMisses; // 20261016 agent - added
+int MaxNum3DGridMemory;
 int GridMemListTotalNumElementsAdded;
+size_t MaxBytes3DGridMemory;
+size_t GridMemListNumBytes;
+
+// 20261016 agent - added, serializes access to the grid memory list, which is shared by all LOCPARALLEL location threads
+static pthread_mutex_t GridMemListMutex = PTHREAD_MUTEX_INITIALIZER;
+// 20261016 agent - added, signals end of reading of a grid from disk (GridMemStruct reading flag)
+static pthread_cond_t GridMemListReadCond = PTHREAD_COND_INITIALIZER;
+// 20261016 agent - added, number of NLLoc() runs currently using the grid memory list
+static int GridMemListNumUsers = 0;
+
+// 20261016 agent - added, hash index on grid file name, LRU use counter and cache statistics of grid memory list
+static GridMemStruct* GridMemHash[GRID_MEM_HASHSIZE];
+static unsigned long GridMemListUseCount = 0;
+static long GridMemNumHits = 0;
+static long GridMemNumMisses = 0;
+static long GridMemNumEvictions = 0;
+static long GridMemNumNotCached = 0;
+static long GridMemNumPrefetched = 0;
+// 20261016 agent - added, pool of grid headers and open grid buffer files, see NLL_OpenGrid3dFile()
+static long GridFilePoolNumEntries = 0;
+static long GridFilePoolNumHits = 0;
+static long GridFilePoolNumMisses = 0;
+static pthread_mutex_t GridFilePoolMutex = PTHREAD_MUTEX_INITIALIZER;
+static size_t GridMemListPeakNumBytes = 0;
 
 
 /*------------------------------------------------------------/ */
@@ -52,10 +82,157 @@ int GridMemListTotalNumElementsAdded;
 #define USE_GRID_LIST 1
 #define GRIDMEM_MESSAGE 2
 
+/*** hash index of GridMemList on grid file name ***/
+// 20261016 agent - added
+
+static unsigned gridmem_hash(char* title) {
+
+    unsigned hashval;
+
+    for (hashval = 0; *title != '\0'; title++)
+        hashval = *title + 31 * hashval;
+
+    return (hashval % GRID_MEM_HASHSIZE);
+
+}
+
+static void gridmem_hash_add(GridMemStruct* pGridMemStruct) {
+
+    unsigned hashval = gridmem_hash(pGridMemStruct->pgrid->title);
+
+    pGridMemStruct->hash_next = GridMemHash[hashval];
+    GridMemHash[hashval] = pGridMemStruct;
+
+}
+
+static void gridmem_hash_remove(GridMemStruct* pGridMemStruct) {
+
+    GridMemStruct** ppnext = GridMemHash + gridmem_hash(pGridMemStruct->pgrid->title);
+
+    for (; *ppnext != NULL; ppnext = &((*ppnext)->hash_next)) {
+        if (*ppnext == pGridMemStruct) {
+            *ppnext = pGridMemStruct->hash_next;
+            break;
+        }
+    }
+    pGridMemStruct->hash_next = NULL;
+
+}
+
+/*** function to find element of GridMemList holding the buffer of grid desc ***/
+// 20261016 agent - added, a grid allocated outside of GridMemList may have the same name as a grid in the list
+
+static GridMemStruct* gridmem_find_buffer(GridDesc* pgrid) {
+
+    GridMemStruct* pGridMemStruct = GridMemList_FindGridDesc(pgrid);
+
+    if (pGridMemStruct != NULL && pGridMemStruct->buffer != pgrid->buffer)
+        return (NULL);
+
+    return (pGridMemStruct);
+
+}
+
 /*** wrapper function to allocate buffer for 3D grid ***/
 
+static void* nll_allocate_grid(GridDesc* pgrid, int prefetch, unsigned long prefetch_min_last_used);
+
 void* NLL_AllocateGrid(GridDesc* pgrid) {
-    int index, nactive, ngrid_read, n;
+
+    void* fptr;
+
+    pthread_mutex_lock(&GridMemListMutex);
+    fptr = nll_allocate_grid(pgrid, 0, 0);
+    pthread_mutex_unlock(&GridMemListMutex);
+
+    return (fptr);
+}
+
+/*** function to get size in bytes of buffer for 3D grid, without allocating buffer ***/
+
+static size_t gridmem_buffer_size(GridDesc* pgrid) {
+
+    GridDesc grid_tmp;
+
+    if (isTiledGrid(pgrid))
+        return (TiledGridBufferSize(pgrid)); // 20261016 agent - added
+    if (!isCascadingGrid(pgrid))
+        return ((size_t) pgrid->numx * (size_t) pgrid->numy * (size_t) pgrid->numz * sizeof (GRID_FLOAT_TYPE));
+
+    // cascading grid, buffer size depends on merge depths
+    grid_tmp = *pgrid;
+    grid_tmp.gridDesc_Cascading.zindex = NULL;
+    grid_tmp.gridDesc_Cascading.xyz_scale = NULL;
+    AllocateGrid_Cascading(&grid_tmp, 0); // sets buffer size but does not allocate buffer
+    FreeGrid_Cascading(&grid_tmp);
+
+    return (grid_tmp.buffer_size);
+
+}
+
+/*** function to find least recently used inactive grid in GridMemList, with last use before use count max_last_used,
+ *    returns NULL if all grids active ***/
+
+static GridMemStruct* gridmem_lru_inactive(unsigned long max_last_used) {
+
+    int n;
+    GridMemStruct* pGridMemStruct;
+    GridMemStruct* pGridMemStructLRU = NULL;
+
+    for (n = 0; n < GridMemListNumElements; n++) {
+        pGridMemStruct = GridMemList[n];
+        // 20261017 agent - inactive grids never read (e.g. time grid file open failed) can also be removed, were never freed and held a list slot
+        if (!pGridMemStruct->active && !pGridMemStruct->reading && pGridMemStruct->last_used < max_last_used
+                && (pGridMemStructLRU == NULL || pGridMemStruct->last_used < pGridMemStructLRU->last_used))
+            pGridMemStructLRU = pGridMemStruct;
+    }
+
+    return (pGridMemStructLRU);
+
+}
+
+/*** function to allocate grid outside of GridMemList, grid is freed when no longer used by location ***/
+
+static void* gridmem_allocate_not_cached(GridDesc* pgrid, char* reason, int prefetch) {
+
+    if (message_flag >= GRIDMEM_MESSAGE)
+        printf("GridMemManager: %s (%d): %s\n", reason, GridMemListNumElements, pgrid->title);
+
+    // grid prefetch only loads grids into GridMemList
+    if (prefetch)
+        return (NULL);
+
+    GridMemNumNotCached++;
+    return (AllocateGrid(pgrid));
+
+}
+
+/*** function to check if grid in GridMemList has the geometry and buffer layout of a grid with the same file name
+ *
+ * 20261016 agent - added, grids in memory may be sub-grids of the grid file or have tiled layout
+ ***/
+
+static int gridmem_same_geometry(GridDesc* pgrid, GridMemStruct* pGridMemStruct) {
+
+    GridDesc* pgrid_mem = pGridMemStruct->pgrid;
+
+    return (pgrid->numx == pgrid_mem->numx && pgrid->numy == pgrid_mem->numy && pgrid->numz == pgrid_mem->numz
+            && pgrid->origx == pgrid_mem->origx && pgrid->origy == pgrid_mem->origy && pgrid->origz == pgrid_mem->origz
+            && isTiledGrid(pgrid) == isTiledGrid(pgrid_mem));
+
+}
+
+/*** function to allocate buffer for 3D grid in GridMemList, must be called with GridMemListMutex locked
+ *
+ * if prefetch != 0, does not mark a grid already in list as active, does not count statistics,
+ *    does not remove grids used at or after use count prefetch_min_last_used,
+ *    and returns NULL instead of allocating a grid outside of GridMemList
+ */
+
+static void* nll_allocate_grid(GridDesc* pgrid, int prefetch, unsigned long prefetch_min_last_used) {
+    int nactive, n;
+    size_t num_bytes;
+    unsigned long max_last_used = prefetch ? prefetch_min_last_used : ULONG_MAX;
     void* fptr = NULL;
     GridMemStruct* pGridMemStruct = NULL;
 
@@ -63,58 +240,73 @@ void* NLL_AllocateGrid(GridDesc* pgrid) {
 
     if (USE_GRID_LIST) {
 
-        if ((index = GridMemList_IndexOfGridDesc(0, pgrid)) >= 0) {
+        // 20261016 agent - added, grid in list with different geometry or layout (e.g. sub-grid of previous run) cannot be used
+        if ((pGridMemStruct = GridMemList_FindGridDesc(pgrid)) != NULL && !gridmem_same_geometry(pgrid, pGridMemStruct)) {
+            if (pGridMemStruct->active > 0 || pGridMemStruct->reading)
+                return (gridmem_allocate_not_cached(pgrid, "Grid in use with different geometry", prefetch));
+            GridMemList_RemoveElementAt(pGridMemStruct->index);
+            pGridMemStruct = NULL;
+        }
+        if (pGridMemStruct != NULL) {
             // already in list
-                    //int XX_last = NumAllocations;
-            pGridMemStruct = GridMemList_ElementAt(index);
-                    //printf("XXX: Already in list: NumAllocations %d->%d\n", XX_last, NumAllocations);
-            pGridMemStruct->active = 1;
+            pGridMemStruct->last_used = ++GridMemListUseCount;
+            if (prefetch)
+                return (pGridMemStruct->buffer);
+            pGridMemStruct->active++; // 20261016 agent - active is a count of users, grid may be in use by several location threads
+            GridMemNumHits++;
+            GridMemThreadNumHits++;
             fptr = pGridMemStruct->buffer;
             if (message_flag >= GRIDMEM_MESSAGE)
-                printf("GridMemManager: Grid exists in mem (%d/%d): %s\n", index, GridMemListNumElements, pGridMemStruct->pgrid->title);
+                printf("GridMemManager: Grid exists in mem (%d/%d): %s\n", pGridMemStruct->index, GridMemListNumElements, pGridMemStruct->pgrid->title);
             return (fptr);
         } else {
+            if (!prefetch) {
+                GridMemNumMisses++;
+                GridMemThreadNumMisses++;
+            }
             // check number of active grids in list
             nactive = 0;
-            ngrid_read = 0;
             for (n = 0; n < GridMemList_NumElements(); n++) {
                 pGridMemStruct = GridMemList_ElementAt(n);
-                nactive += pGridMemStruct->active;
-                ngrid_read += pGridMemStruct->grid_read;
+                nactive += pGridMemStruct->active > 0;
             }
             // list already full of active grids, do normal allocation
             if (MaxNum3DGridMemory > 0 && nactive >= MaxNum3DGridMemory) {
-                    //int XX_last = NumAllocations;
-                fptr = AllocateGrid(pgrid);
-                    //printf("XXX: Memory Full: NumAllocations %d->%d\n", XX_last, NumAllocations);
-                if (message_flag >= GRIDMEM_MESSAGE)
-                    printf("GridMemManager: Memory full (%d/%d): %s\n", index, GridMemListNumElements, pGridMemStruct->pgrid->title);
-                return (fptr);
+                return (gridmem_allocate_not_cached(pgrid, "Memory full", prefetch));
             }
-            // try to replace an inactive grid if possible
-            if (MaxNum3DGridMemory > 0 && ngrid_read >= MaxNum3DGridMemory) {
-                for (n = GridMemList_NumElements() - 1; n >= 0; n--) {
-                    pGridMemStruct = GridMemList_ElementAt(n);
-                    //int XX_last = NumAllocations;
-                    if (!pGridMemStruct->active && (fptr = GridMemList_TryToReplaceElementAt(pGridMemStruct, pgrid)) != NULL) {
+            // 20261016 agent - added, byte budget, evict least recently used inactive grids until grid fits
+            if (MaxBytes3DGridMemory > 0) {
+                num_bytes = gridmem_buffer_size(pgrid);
+                if (num_bytes > MaxBytes3DGridMemory)
+                    return (gridmem_allocate_not_cached(pgrid, "Grid larger than memory budget", prefetch));
+                while (GridMemListNumBytes + num_bytes > MaxBytes3DGridMemory) {
+                    if ((pGridMemStruct = gridmem_lru_inactive(max_last_used)) == NULL)
+                        return (gridmem_allocate_not_cached(pgrid, "Memory budget full of active grids", prefetch));
+                    GridMemNumEvictions++;
+                    if (GridMemListNumBytes - pGridMemStruct->num_bytes + num_bytes <= MaxBytes3DGridMemory
+                            && (fptr = GridMemList_TryToReplaceElementAt(pGridMemStruct, pgrid)) != NULL) {
                         // found and replaced identical size grid
-                    //printf("XXX: Replaced Element: NumAllocations %d->%d\n", XX_last, NumAllocations);
                         return (fptr);
                     }
+                    GridMemList_RemoveElementAt(pGridMemStruct->index);
                 }
-                if (message_flag >= GRIDMEM_MESSAGE)
-                    printf("GridMemManager: Failed to re-used grid memory list element (%s)\n", pgrid->title);
             }
-            // remove an inactive grid if necessary
-            if (MaxNum3DGridMemory > 0 && ngrid_read >= MaxNum3DGridMemory) {
-                for (n = GridMemList_NumElements() - 1; n >= 0; n--) {
-                    pGridMemStruct = GridMemList_ElementAt(n);
-                    if (!pGridMemStruct->active && pGridMemStruct->grid_read) {
+            // count limit, replace or remove least recently used inactive grid if necessary
+            // 20261016 agent - bug fix, also count active grids not yet read (e.g. being read by prefetch thread), list size is limited to MaxNum3DGridMemory
+            // 20261017 agent - bug fix, count all grids in list, inactive grids not read also hold a list slot
+            if (MaxNum3DGridMemory > 0 && GridMemList_NumElements() >= MaxNum3DGridMemory) {
+                if ((pGridMemStruct = gridmem_lru_inactive(max_last_used)) != NULL) {
+                    GridMemNumEvictions++;
                     //int XX_last = NumAllocations;
-                        GridMemList_RemoveElementAt(n);
-                    //printf("XXX: Removed Element: NumAllocations %d->%d\n", XX_last, NumAllocations);
-                        break;
+                    if ((fptr = GridMemList_TryToReplaceElementAt(pGridMemStruct, pgrid)) != NULL) {
+                        // found and replaced identical size grid
+                        //printf("XXX: Replaced Element: NumAllocations %d->%d\n", XX_last, NumAllocations);
+                        return (fptr);
                     }
+                    GridMemList_RemoveElementAt(pGridMemStruct->index);
+                } else {
+                    // 20261017 agent - bug fix, list full of grids in use, adding an element would overflow the list
+                    return (gridmem_allocate_not_cached(pgrid, "Failed to re-use grid memory list element", prefetch));
                 }
             }
             // create new list element
@@ -140,17 +332,24 @@ void* NLL_AllocateGrid(GridDesc* pgrid) {
 /*** wrapper function to free buffer for 3D grid ***/
 
 void NLL_FreeGrid(GridDesc* pgrid) {
-    int index;
     GridMemStruct* pGridMemStruct;
 
     //printf("IN: NLL_FreeGrid\n");
-    if (USE_GRID_LIST && (index = GridMemList_IndexOfGridDesc(0, pgrid)) >= 0) {
-        pGridMemStruct = GridMemList_ElementAt(index);
-        pGridMemStruct->active = 0;
+    // 20261016 agent - added, memory mapped grids are not in grid memory list
+    if (pgrid->buffer != NULL && pgrid->buffer_mapped) {
+        FreeGrid(pgrid);
+        return;
+    }
+    pthread_mutex_lock(&GridMemListMutex);
+    if (USE_GRID_LIST && (pGridMemStruct = gridmem_find_buffer(pgrid)) != NULL) {
+        if (pGridMemStruct->active > 0)
+            pGridMemStruct->active--;
         //pgrid->buffer = NULL;
+        pthread_mutex_unlock(&GridMemListMutex);
 
         return;
     }
+    pthread_mutex_unlock(&GridMemListMutex);
 
     FreeGrid(pgrid);
 }
@@ -159,9 +358,21 @@ void NLL_FreeGrid(GridDesc* pgrid) {
 /*** free all memory used by grid memory list ***/
 // 20131227 AJL - bug fix, added this function.  Before, grid memory was not freed.
 
+static void nll_free_grid_memory();
+static void gridfile_pool_free();
+
 void NLL_FreeGridMemory() {
 
+    pthread_mutex_lock(&GridMemListMutex);
+    nll_free_grid_memory();
+    pthread_mutex_unlock(&GridMemListMutex);
+
+}
+
+static void nll_free_grid_memory() {
+
     int index;
+
     int numElements = GridMemListNumElements;
     // 20141219 AJL - bug fix, GridMemListNumElements is decremented each time GridMemList_RemoveElementAt() called!)
     //for (index = 0; index < GridMemListNumElements; index++) {
@@ -170,6 +381,84 @@ void NLL_FreeGridMemory() {
     }
     free(GridMemList); // 20141219 AJL - bug fix, added this free
     GridMemList = NULL;
+    gridfile_pool_free(); // 20261016 agent - added
+
+}
+
+/*** open grid memory list for use by a location run ***/
+// 20261016 agent - added, the grid memory list is initialized by the first of concurrent NLLoc() runs
+
+void NLL_GridMemoryOpen() {
+
+    pthread_mutex_lock(&GridMemListMutex);
+    if (GridMemListNumUsers == 0) {
+        MaxNum3DGridMemory = -1;
+        GridMemList = NULL;
+        GridMemListSize = 0;
+        GridMemListNumElements = 0;
+        GridMemListTotalNumElementsAdded = 0;
+        MaxBytes3DGridMemory = 0;
+        GridMemListNumBytes = GridMemListPeakNumBytes = 0;
+        GridMemListUseCount = 0;
+        GridMemNumHits = GridMemNumMisses = GridMemNumEvictions = GridMemNumNotCached = GridMemNumPrefetched = 0;
+        pthread_mutex_lock(&GridFilePoolMutex);
+        GridFilePoolNumHits = GridFilePoolNumMisses = 0;
+        pthread_mutex_unlock(&GridFilePoolMutex);
+    }
+    GridMemListNumUsers++;
+    pthread_mutex_unlock(&GridMemListMutex);
+
+}
+
+/*** close grid memory list after a location run ***/
+// 20261016 agent - added, the grid memory list is freed by the last of concurrent NLLoc() runs
+
+void NLL_GridMemoryClose() {
+
+    pthread_mutex_lock(&GridMemListMutex);
+    if (GridMemListNumUsers > 0)
+        GridMemListNumUsers--;
+    if (GridMemListNumUsers == 0)
+        nll_free_grid_memory();
+    pthread_mutex_unlock(&GridMemListMutex);
+
+}
+
+/*** return grid memory list use counter, incremented at each use of a grid in list ***/
+// 20261016 agent - added
+
+unsigned long NLL_GridMemoryUseCount() {
+
+    unsigned long use_count;
+
+    pthread_mutex_lock(&GridMemListMutex);
+    use_count = GridMemListUseCount;
+    pthread_mutex_unlock(&GridMemListMutex);
+
+    return (use_count);
+
+}
+
+/*** print grid memory list statistics ***/
+// 20261016 agent - added
+
+void NLL_GridMemoryPrintStats() {
+
+    pthread_mutex_lock(&GridMemListMutex);
+    if (GridMemNumHits + GridMemNumMisses > 0) {
+        sprintf(MsgStr, "GridMemManager: grids in memory: %d  %.1f MB (peak %.1f MB, budget %.1f MB)  hits: %ld  misses: %ld  evictions: %ld  not cached: %ld  prefetched: %ld",
+                GridMemListNumElements, (double) GridMemListNumBytes / (1024.0 * 1024.0), (double) GridMemListPeakNumBytes / (1024.0 * 1024.0),
+                (double) MaxBytes3DGridMemory / (1024.0 * 1024.0), GridMemNumHits, GridMemNumMisses, GridMemNumEvictions, GridMemNumNotCached, GridMemNumPrefetched);
+        nll_putmsg(1, MsgStr);
+    }
+    pthread_mutex_lock(&GridFilePoolMutex);
+    if (GridFilePoolNumHits + GridFilePoolNumMisses > 0) {
+        sprintf(MsgStr, "GridFilePool: grid headers cached: %ld  hits: %ld  misses: %ld",
+                GridFilePoolNumEntries, GridFilePoolNumHits, GridFilePoolNumMisses);
+        nll_putmsg(1, MsgStr);
+    }
+    pthread_mutex_unlock(&GridFilePoolMutex);
+    pthread_mutex_unlock(&GridMemListMutex);
 
 }
 
@@ -179,12 +468,11 @@ void*** NLL_CreateGridArray(GridDesc* pgrid) {
 
     void*** fptr = NULL;
 
-    int index;
     GridMemStruct* pGridMemStruct;
 
     //printf("IN: NLL_CreateGridArray\n");
-    if (USE_GRID_LIST && (index = GridMemList_IndexOfGridDesc(0, pgrid)) >= 0) {
-        pGridMemStruct = GridMemList_ElementAt(index);
+    pthread_mutex_lock(&GridMemListMutex);
+    if (USE_GRID_LIST && (pGridMemStruct = gridmem_find_buffer(pgrid)) != NULL) {
         fptr = pGridMemStruct->array;
         if (isCascadingGrid(pgrid)) {
             pgrid->gridDesc_Cascading.num_z_merge_depths = pGridMemStruct->pgrid->gridDesc_Cascading.num_z_merge_depths;
@@ -197,6 +485,7 @@ void*** NLL_CreateGridArray(GridDesc* pgrid) {
     } else {
         fptr = CreateGridArray(pgrid);
     }
+    pthread_mutex_unlock(&GridMemListMutex);
 
     return (fptr);
 }
@@ -207,39 +496,107 @@ void NLL_DestroyGridArray(GridDesc* pgrid) {
 
     //printf("NLL_DestroyGridArray: %s\n", pgrid->title);
 
-    int index;
-
     //printf("IN: NLL_DestroyGridArray\n");
-    if (USE_GRID_LIST && (index = GridMemList_IndexOfGridDesc(0, pgrid)) >= 0) {
+    // 20261016 agent - added, memory mapped grids are not in grid memory list
+    if (pgrid->buffer != NULL && pgrid->buffer_mapped) {
+        DestroyGridArray(pgrid);
+        return;
+    }
+    pthread_mutex_lock(&GridMemListMutex);
+    if (USE_GRID_LIST && gridmem_find_buffer(pgrid) != NULL) {
         pgrid->array = NULL;
+        pthread_mutex_unlock(&GridMemListMutex);
 
         return;
     }
+    pthread_mutex_unlock(&GridMemListMutex);
 
     DestroyGridArray(pgrid);
 }
 
+/*** function to read grid of GridMemList element from disk, must be called with GridMemListMutex locked
+ *
+ * 20261016 agent - added, grid is read with GridMemListMutex unlocked, so other threads can use the grid memory
+ *    list during the read; element is active for the calling thread, so it cannot be removed during the read
+ */
+
+static void gridmem_read_element(GridMemStruct* pGridMemStruct, FILE* fpio) {
+
+    // another thread may be reading this grid
+    while (pGridMemStruct->reading)
+        pthread_cond_wait(&GridMemListReadCond, &GridMemListMutex);
+
+    if (!pGridMemStruct->grid_read) {
+        pGridMemStruct->reading = 1;
+        pthread_mutex_unlock(&GridMemListMutex);
+        ReadGrid3dBuf(pGridMemStruct->pgrid, fpio);
+        pthread_mutex_lock(&GridMemListMutex);
+        pGridMemStruct->grid_read = 1;
+        pGridMemStruct->reading = 0;
+        pthread_cond_broadcast(&GridMemListReadCond);
+    }
+
+}
+
 /*** wrapper function to read entire grid buffer from disk ***/
 
 int NLL_ReadGrid3dBuf(GridDesc* pgrid, FILE* fpio) {
 
-    int index;
     GridMemStruct* pGridMemStruct;
 
     //printf("IN: NLL_ReadGrid3dBuf\n");
-    if (USE_GRID_LIST && (index = GridMemList_IndexOfGridDesc(0, pgrid)) >= 0) {
-        pGridMemStruct = GridMemList_ElementAt(index);
-        if (!pGridMemStruct->grid_read) {
-            ReadGrid3dBuf(pGridMemStruct->pgrid, fpio);
-            pGridMemStruct->grid_read = 1;
-        }
+    pthread_mutex_lock(&GridMemListMutex);
+    if (USE_GRID_LIST && (pGridMemStruct = gridmem_find_buffer(pgrid)) != NULL) {
+        gridmem_read_element(pGridMemStruct, fpio);
+        pthread_mutex_unlock(&GridMemListMutex);
     } else {
+        pthread_mutex_unlock(&GridMemListMutex);
         ReadGrid3dBuf(pgrid, fpio);
     }
 
     return (0);
 }
 
+/*** function to load 3D grid into GridMemList ahead of its use by a location (look-ahead grid prefetch)
+ *
+ * 20261016 agent - added
+ * The grid is added to GridMemList and read from disk if there is room for it in the list, possibly after
+ *    removal of least recently used inactive grids last used before use count min_last_used (see
+ *    NLL_GridMemoryUseCount()); the grid is left inactive in the list.  If the grid is already in the list
+ *    it is marked as recently used.  pgrid is not modified.
+ *
+ * returns 1 if grid read into list, 0 otherwise
+ */
+
+int NLL_PrefetchGrid(GridDesc* pgrid, FILE* fpio, unsigned long min_last_used) {
+
+    GridMemStruct* pGridMemStruct;
+    GridDesc grid_tmp;
+
+
+    if (!USE_GRID_LIST || fpio == NULL)
+        return (0);
+
+    pthread_mutex_lock(&GridMemListMutex);
+    if ((pGridMemStruct = GridMemList_FindGridDesc(pgrid)) != NULL && gridmem_same_geometry(pgrid, pGridMemStruct)) {
+        nll_allocate_grid(pgrid, 1, min_last_used); // marks grid as recently used
+        pthread_mutex_unlock(&GridMemListMutex);
+        return (0);
+    }
+    grid_tmp = *pgrid;
+    if (nll_allocate_grid(&grid_tmp, 1, min_last_used) == NULL || (pGridMemStruct = GridMemList_FindGridDesc(&grid_tmp)) == NULL) {
+        pthread_mutex_unlock(&GridMemListMutex);
+        return (0);
+    }
+    GridMemNumPrefetched++;
+    gridmem_read_element(pGridMemStruct, fpio);
+    pGridMemStruct->active--;
+    pthread_mutex_unlock(&GridMemListMutex);
+
+    return (1);
+
+}
+
 /*** add GridDescription to GridMemList ***/
 
 GridMemStruct* GridMemList_AddGridDesc(GridDesc* pgrid) {
@@ -255,6 +612,10 @@ GridMemStruct* GridMemList_AddGridDesc(GridDesc* pgrid) {
     pnewGridMemStruct->array = CreateGridArray(pnewGridMemStruct->pgrid);
     pnewGridMemStruct->active = 1;
     pnewGridMemStruct->grid_read = 0;
+    pnewGridMemStruct->num_bytes = pnewGridMemStruct->buffer != NULL ? pnewGridMemStruct->pgrid->buffer_size : 0;
+    pnewGridMemStruct->last_used = ++GridMemListUseCount;
+    pnewGridMemStruct->hash_next = NULL;
+    pnewGridMemStruct->reading = 0;
 
     GridMemList_AddElement(pnewGridMemStruct);
 
@@ -275,9 +636,14 @@ void GridMemList_AddElement(GridMemStruct* pnewGridMemStruct) {
 
     //printf("IN: GridMemList_AddElement\n");
     if (GridMemListSize <= GridMemListNumElements) {
+        // 20261017 agent - bug fix, list is not enlarged past MaxNum3DGridMemory, allow more elements instead of writing past end of list
+        //    (callers check list size, should not happen)
+        if (MaxNum3DGridMemory > 0 && GridMemListSize >= MaxNum3DGridMemory) {
+            nll_puterr("WARNING: GridMemManager: grid memory list full, enlarging list past LOCMETH maxNum3DGridMemory.");
+        }
         // allocate enlarged list
         newGridMemListSize = GridMemListSize + LIST_SIZE_INCREMENT;
-        if (newGridMemListSize > MaxNum3DGridMemory) {
+        if (newGridMemListSize > MaxNum3DGridMemory && GridMemListSize < MaxNum3DGridMemory) {
             newGridMemListSize = MaxNum3DGridMemory;
         }
         newGridMemList = (GridMemStruct**)
@@ -297,8 +663,13 @@ void GridMemList_AddElement(GridMemStruct* pnewGridMemStruct) {
 
     // load new element
     GridMemList[GridMemListNumElements] = pnewGridMemStruct;
+    pnewGridMemStruct->index = GridMemListNumElements;
     GridMemListNumElements++;
     GridMemListTotalNumElementsAdded++;
+    gridmem_hash_add(pnewGridMemStruct);
+    GridMemListNumBytes += pnewGridMemStruct->num_bytes;
+    if (GridMemListNumBytes > GridMemListPeakNumBytes)
+        GridMemListPeakNumBytes = GridMemListNumBytes;
 
     if (message_flag >= GRIDMEM_MESSAGE)
         printf("GridMemManager: Add grid (%d): %s\n", GridMemListNumElements - 1, pnewGridMemStruct->pgrid->title);
@@ -320,6 +691,8 @@ void GridMemList_RemoveElementAt(int index) {
     pGridMemStruct = GridMemList[index];
     if (message_flag >= GRIDMEM_MESSAGE)
         printf("GridMemManager: Remove grid (%d/%d): %s\n", index, GridMemListNumElements, pGridMemStruct->pgrid->title);
+    gridmem_hash_remove(pGridMemStruct);
+    GridMemListNumBytes -= pGridMemStruct->num_bytes;
     DestroyGridArray(pGridMemStruct->pgrid);
     FreeGrid(pGridMemStruct->pgrid);
     free(pGridMemStruct->pgrid);
@@ -329,8 +702,10 @@ void GridMemList_RemoveElementAt(int index) {
 
 
     // shift down element references
-    for (n = index; n < GridMemListNumElements - 1; n++)
+    for (n = index; n < GridMemListNumElements - 1; n++) {
         GridMemList[n] = GridMemList[n + 1];
+        GridMemList[n]->index = n;
+    }
 
     GridMemList[n] = NULL;
     GridMemListNumElements--;
@@ -376,6 +751,10 @@ GridMemStruct* GridMemList_TryToReplaceElementAt(GridMemStruct* pGridMemStruct,
         //printf("return 5\n");
         return (NULL);
     }
+    // 20261016 agent - added
+    if (isTiledGrid(pgrid) != isTiledGrid(pGridMemStruct->pgrid)) {
+        return (NULL);
+    }
     if (pgrid->flagGridCascading) {
         if (pgrid->gridDesc_Cascading.num_z_merge_depths != pGridMemStruct->pgrid->gridDesc_Cascading.num_z_merge_depths) {
             //printf("return 6\n");
@@ -391,6 +770,8 @@ GridMemStruct* GridMemList_TryToReplaceElementAt(GridMemStruct* pGridMemStruct,
     /* following should not be needed, since only dependent (?) on above parameters
      * also, makes allocations and probably inefficient*/
     size_t buffer_size = (size_t) (pgrid->numx * pgrid->numy * pgrid->numz * sizeof (GRID_FLOAT_TYPE));
+    if (isTiledGrid(pgrid))
+        buffer_size = TiledGridBufferSize(pgrid); // 20261016 agent - added
     if (pgrid->flagGridCascading) {
         AllocateGrid_Cascading(pgrid, 0); // sets buffer size but does not allocate buffer
         buffer_size = pgrid->buffer_size;
@@ -410,6 +791,7 @@ GridMemStruct* GridMemList_TryToReplaceElementAt(GridMemStruct* pGridMemStruct,
         FreeGrid_Cascading(pGridMemStruct->pgrid);
     }
     //size_t buffer_size = pGridMemStruct->pgrid->buffer_size;
+    gridmem_hash_remove(pGridMemStruct);
     *(pGridMemStruct->pgrid) = *pgrid;
     pGridMemStruct->pgrid->buffer = pGridMemStruct->buffer;
     pGridMemStruct->pgrid->buffer_size = buffer_size;
@@ -418,6 +800,8 @@ GridMemStruct* GridMemList_TryToReplaceElementAt(GridMemStruct* pGridMemStruct,
     strcpy(pGridMemStruct->pgrid->title, pgrid->title);
     pGridMemStruct->active = 1;
     pGridMemStruct->grid_read = 0;
+    pGridMemStruct->last_used = ++GridMemListUseCount;
+    gridmem_hash_add(pGridMemStruct);
 
     GridMemListTotalNumElementsAdded++;
 
@@ -437,16 +821,32 @@ GridMemStruct* GridMemList_ElementAt(int index) {
     return (GridMemList[index]);
 }
 
+/*** find element of grid desc in GridMemList, returns NULL if not found ***/
+// 20261016 agent - added, hashed lookup on grid file name (title)
+
+GridMemStruct* GridMemList_FindGridDesc(GridDesc* pgrid) {
+
+    GridMemStruct* pGridMemStruct;
+
+    for (pGridMemStruct = GridMemHash[gridmem_hash(pgrid->title)]; pGridMemStruct != NULL; pGridMemStruct = pGridMemStruct->hash_next) {
+        if (strcmp(pGridMemStruct->pgrid->title, pgrid->title) == 0)
+            return (pGridMemStruct);
+    }
+
+    return (NULL);
+
+}
+
 /*** find index of grid desc in GridMemList ***/
 
 int GridMemList_IndexOfGridDesc(int verbose, GridDesc* pgrid) {
 
     //printf("IN: GridMemList_IndexOfGridDesc\n");
-    int n;
-    for (n = 0; n < GridMemListNumElements; n++) {
-        if (verbose) printf("indexOf: %s ==? %s\n", GridMemList[n]->pgrid->title, pgrid->title);
-        if (strcmp(GridMemList[n]->pgrid->title, pgrid->title) == 0)
-            return (n);
+    GridMemStruct* pGridMemStruct;
+
+    if ((pGridMemStruct = GridMemList_FindGridDesc(pgrid)) != NULL) {
+        if (verbose) printf("indexOf: %s == %s\n", pGridMemStruct->pgrid->title, pgrid->title);
+        return (pGridMemStruct->index);
     }
 
     if (verbose) printf("indexOf: NOT FOUND\n");
@@ -466,6 +866,344 @@ int GridMemList_NumElements() {
 
 
 
+
+/*------------------------------------------------------------/ */
+/** pool of grid headers and open grid buffer files for persistence of opened grids across events
+ *
+ * 20261016 agent - added
+ *
+ *  The grid description and source read from the grid header by OpenGrid3dFile() are kept for the whole run, keyed on grid
+ *  file name, and shared by all threads.  Grid buffer files of grids read from disk during location are kept open in a pool
+ *  shared by all threads, so that opening a grid already opened for a previous event needs no file system access.
+ *
+ * 20261017 agent - the pool of open grid buffer files is shared by all threads, its size is limited to a fraction of the
+ *  process open file limit (RLIMIT_NOFILE); a grid buffer file is closed when its grid is in memory; grids that could not
+ *  be opened are not kept in the pool, so grid files created later are found.
+ */
+
+typedef struct gridFilePoolEntry {
+    char *fname; // grid file name, without .hdr/.buf extension
+    int iSwapBytes;
+    int istat; // return value of OpenGrid3dFile()
+    int have_buffer_file; // = 1 if grid buffer file was opened
+    GridDesc *pgrid; // grid description read from header
+    int have_srce; // = 1 if source read from header (time and angle grids)
+    char srce_label[SOURCE_LABEL_LEN];
+    double srce_x, srce_y, srce_z;
+    struct gridFilePoolEntry *hash_next;
+} GridFilePoolEntry;
+
+typedef struct {
+    GridFilePoolEntry *entry; // grid of open grid buffer file, NULL if slot not used
+    FILE *fp_grid;
+    int in_use; // = 1 while grid buffer file is used by an arrival
+    unsigned long last_used;
+} GridFilePoolSlot;
+
+static GridFilePoolEntry* GridFilePoolHash[GRID_MEM_HASHSIZE];
+static GridFilePoolSlot* GridFilePoolSlots = NULL;
+static int GridFilePoolNumSlots = 0;
+static unsigned long GridFilePoolUseCount = 0;
+
+/*** find grid in pool, call with GridFilePoolMutex locked ***/
+
+static GridFilePoolEntry* gridfile_pool_find(char *fname, int iSwapBytes) {
+
+    GridFilePoolEntry* entry;
+
+    for (entry = GridFilePoolHash[gridmem_hash(fname)]; entry != NULL; entry = entry->hash_next) {
+        if (entry->iSwapBytes == iSwapBytes && strcmp(entry->fname, fname) == 0)
+            return (entry);
+    }
+
+    return (NULL);
+}
+
+/*** add grid opened with OpenGrid3dFile() to pool ***/
+
+static GridFilePoolEntry* gridfile_pool_add(char *fname, int iSwapBytes, int istat, FILE *fp_grid, GridDesc* pgrid, SourceDesc* psrce, int have_srce) {
+
+    GridFilePoolEntry* entry;
+
+    pthread_mutex_lock(&GridFilePoolMutex);
+    if ((entry = gridfile_pool_find(fname, iSwapBytes)) == NULL) { // may have been added by another thread
+        entry = (GridFilePoolEntry*) calloc(1, sizeof (GridFilePoolEntry));
+        entry->fname = strdup(fname);
+        entry->iSwapBytes = iSwapBytes;
+        entry->istat = istat;
+        entry->have_buffer_file = fp_grid != NULL;
+        entry->pgrid = (GridDesc*) malloc(sizeof (GridDesc));
+        *(entry->pgrid) = *pgrid;
+        if ((entry->have_srce = have_srce)) {
+            strcpy(entry->srce_label, psrce->label);
+            entry->srce_x = psrce->x;
+            entry->srce_y = psrce->y;
+            entry->srce_z = psrce->z;
+        }
+        unsigned hashval = gridmem_hash(fname);
+        entry->hash_next = GridFilePoolHash[hashval];
+        GridFilePoolHash[hashval] = entry;
+        GridFilePoolNumEntries++;
+    }
+    pthread_mutex_unlock(&GridFilePoolMutex);
+
+    return (entry);
+}
+
+/*** close grid buffer files in pool not in use, call with GridFilePoolMutex locked ***/
+
+static void gridfile_pool_close_unused() {
+
+    for (int n = 0; n < GridFilePoolNumSlots; n++) {
+        GridFilePoolSlot* pslot = GridFilePoolSlots + n;
+        if (pslot->entry != NULL && !pslot->in_use) {
+            fclose(pslot->fp_grid);
+            pslot->entry = NULL;
+            pslot->fp_grid = NULL;
+        }
+    }
+
+}
+
+/*** free all grids in pool, the grid buffer files of all threads must be closed ***/
+
+static void gridfile_pool_free() {
+
+    pthread_mutex_lock(&GridFilePoolMutex);
+    gridfile_pool_close_unused();
+    free(GridFilePoolSlots);
+    GridFilePoolSlots = NULL;
+    GridFilePoolNumSlots = 0;
+    for (int n = 0; n < GRID_MEM_HASHSIZE; n++) {
+        GridFilePoolEntry* entry = GridFilePoolHash[n];
+        while (entry != NULL) {
+            GridFilePoolEntry* next = entry->hash_next;
+            free(entry->fname);
+            free(entry->pgrid);
+            free(entry);
+            entry = next;
+        }
+        GridFilePoolHash[n] = NULL;
+    }
+    GridFilePoolNumEntries = 0;
+    pthread_mutex_unlock(&GridFilePoolMutex);
+
+}
+
+/*** allocate slots of pool, number of slots is GRID_FILE_POOL_NUM_OPEN or less to keep open file limit
+ *   headroom for grid and other files open during location, call with GridFilePoolMutex locked ***/
+
+static void gridfile_pool_alloc_slots() {
+
+    struct rlimit rlim;
+
+    GridFilePoolNumSlots = GRID_FILE_POOL_NUM_OPEN;
+    if (getrlimit(RLIMIT_NOFILE, &rlim) == 0 && rlim.rlim_cur != RLIM_INFINITY
+            && rlim.rlim_cur / GRID_FILE_POOL_RLIMIT_FRACTION < (rlim_t) GridFilePoolNumSlots)
+        GridFilePoolNumSlots = (int) (rlim.rlim_cur / GRID_FILE_POOL_RLIMIT_FRACTION);
+    GridFilePoolSlots = (GridFilePoolSlot*) calloc(GridFilePoolNumSlots > 0 ? GridFilePoolNumSlots : 1, sizeof (GridFilePoolSlot));
+
+    if (message_flag >= 2) {
+        sprintf(MsgStr, "GridFilePool: up to %d grid buffer files kept open (open file limit %ld)",
+                GridFilePoolNumSlots, getrlimit(RLIMIT_NOFILE, &rlim) == 0 && rlim.rlim_cur != RLIM_INFINITY ? (long) rlim.rlim_cur : -1L);
+        nll_putmsg(2, MsgStr);
+    }
+
+}
+
+/*** get slot with unused open grid buffer file of grid, or an empty slot (least recently used unused slot is
+ *   emptied if necessary), NULL if all slots are in use, call with GridFilePoolMutex locked ***/
+
+static GridFilePoolSlot* gridfile_pool_slot(GridFilePoolEntry* entry) {
+
+    GridFilePoolSlot* pslot_free = NULL;
+
+    if (GridFilePoolSlots == NULL)
+        gridfile_pool_alloc_slots();
+
+    for (int n = 0; n < GridFilePoolNumSlots; n++) {
+        GridFilePoolSlot* pslot = GridFilePoolSlots + n;
+        if (pslot->in_use)
+            continue;
+        if (pslot->entry == entry)
+            return (pslot);
+        if (pslot_free == NULL || (pslot_free->entry != NULL && (pslot->entry == NULL || pslot->last_used < pslot_free->last_used)))
+            pslot_free = pslot;
+    }
+    if (pslot_free != NULL && pslot_free->entry != NULL) {
+        fclose(pslot_free->fp_grid); // unused files in pool are not counted as open by a thread
+        pslot_free->entry = NULL;
+        pslot_free->fp_grid = NULL;
+    }
+
+    return (pslot_free);
+}
+
+/*** put open grid buffer file of grid into an empty slot, marked in use ***/
+
+static void gridfile_pool_put(GridFilePoolEntry* entry, FILE* fp_grid) {
+
+    GridFilePoolSlot* pslot;
+
+    pthread_mutex_lock(&GridFilePoolMutex);
+    if ((pslot = gridfile_pool_slot(entry)) != NULL) {
+        if (pslot->entry != NULL) // unused open file of same grid
+            fclose(pslot->fp_grid);
+        pslot->entry = entry;
+        pslot->fp_grid = fp_grid;
+        pslot->in_use = 1;
+        pslot->last_used = ++GridFilePoolUseCount;
+    } // else all slots in use, file will be closed by NLL_CloseGrid3dFile()
+    pthread_mutex_unlock(&GridFilePoolMutex);
+
+}
+
+/*** get unused open grid buffer file of grid from pool, marked in use, NULL if none ***/
+
+static FILE* gridfile_pool_get(GridFilePoolEntry* entry) {
+
+    FILE* fp_grid = NULL;
+
+    pthread_mutex_lock(&GridFilePoolMutex);
+    for (int n = 0; n < GridFilePoolNumSlots; n++) {
+        GridFilePoolSlot* pslot = GridFilePoolSlots + n;
+        if (pslot->entry == entry && !pslot->in_use) {
+            pslot->in_use = 1;
+            pslot->last_used = ++GridFilePoolUseCount;
+            fp_grid = pslot->fp_grid;
+            NumGridBufFilesOpen++;
+            NumFilesOpen++;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&GridFilePoolMutex);
+
+    return (fp_grid);
+}
+
+/*** wrapper function to open grid file and read header through pool, same arguments and return value as OpenGrid3dFile()
+ *
+ *  The grid header file is never left open (*fp_hdr is NULL).  Grids must be closed with NLL_CloseGrid3dFile().
+ */
+
+int NLL_OpenGrid3dFile(char *fname, FILE **fp_grid, FILE **fp_hdr, GridDesc* pgrid, char* file_type, SourceDesc* psrce, int iSwapBytes) {
+
+    GridFilePoolEntry* entry;
+    int istat;
+
+
+    pthread_mutex_lock(&GridFilePoolMutex);
+    if ((entry = gridfile_pool_find(fname, iSwapBytes)) != NULL)
+        GridFilePoolNumHits++;
+    else
+        GridFilePoolNumMisses++;
+    pthread_mutex_unlock(&GridFilePoolMutex);
+
+    if (entry == NULL) {
+        // first open of grid, read header and add grid to pool
+        SourceDesc srce;
+        if (psrce != NULL)
+            srce = *psrce;
+        else
+            memset(&srce, 0, sizeof (SourceDesc));
+        istat = OpenGrid3dFile(fname, fp_grid, fp_hdr, pgrid, file_type, &srce, iSwapBytes);
+        // 20261017 agent - bug fix, grid that could not be opened is not added to pool, was never opened again for the whole run
+        if (istat < 0)
+            return (istat);
+        int have_srce = strncmp(file_type, "time", 4) == 0 || strncmp(file_type, "angle", 4) == 0;
+        entry = gridfile_pool_add(fname, iSwapBytes, istat, *fp_grid, pgrid, &srce, have_srce);
+        if (psrce != NULL)
+            *psrce = srce;
+        fclose(*fp_hdr);
+        *fp_hdr = NULL;
+        NumGridHdrFilesOpen--;
+        NumFilesOpen--;
+        if (*fp_grid != NULL)
+            gridfile_pool_put(entry, *fp_grid);
+        return (istat);
+    }
+
+    *fp_grid = NULL;
+    *fp_hdr = NULL;
+    if (message_flag >= 3) {
+        sprintf(MsgStr, "Opening Grid File: %s.buf (grid header from pool)", fname);
+        nll_putmsg(3, MsgStr);
+    }
+
+    // grid description and source from pool, cascading grid index arrays are not changed by OpenGrid3dFile()
+    int *zindex = pgrid->gridDesc_Cascading.zindex;
+    int *xyz_scale = pgrid->gridDesc_Cascading.xyz_scale;
+    *pgrid = *(entry->pgrid);
+    pgrid->gridDesc_Cascading.zindex = zindex;
+    pgrid->gridDesc_Cascading.xyz_scale = xyz_scale;
+    if (psrce != NULL && entry->have_srce) {
+        strcpy(psrce->label, entry->srce_label);
+        psrce->x = entry->srce_x;
+        psrce->y = entry->srce_y;
+        psrce->z = entry->srce_z;
+        psrce->is_coord_xyz = 1;
+    }
+
+    // open grid buffer file from pool, or reopen grid buffer file
+    if (entry->have_buffer_file) {
+        if ((*fp_grid = gridfile_pool_get(entry)) != NULL) {
+            rewind(*fp_grid);
+        } else if ((*fp_grid = OpenGrid3dBufFile(fname, pgrid)) != NULL) {
+            gridfile_pool_put(entry, *fp_grid);
+        } else {
+            nll_puterr2("ERROR: opening grid buffer file", fname);
+            return (-1);
+        }
+    }
+
+    return (entry->istat);
+
+}
+
+/*** wrapper function to close grid file opened with NLL_OpenGrid3dFile()
+ *
+ *  The grid buffer file is kept open in pool, unless grid is in memory (read to memory or mapped).
+ */
+
+void NLL_CloseGrid3dFile(GridDesc* pgrid, FILE **fp_grid, FILE **fp_hdr) {
+
+    if (*fp_grid != NULL && GridFilePoolSlots != NULL) {
+        pthread_mutex_lock(&GridFilePoolMutex);
+        for (int n = 0; n < GridFilePoolNumSlots; n++) {
+            GridFilePoolSlot* pslot = GridFilePoolSlots + n;
+            if (pslot->entry != NULL && pslot->fp_grid == *fp_grid) {
+                pslot->in_use = 0;
+                if (pgrid != NULL && pgrid->buffer != NULL) {
+                    // 20261017 agent - added, grid in memory, grid buffer file not needed
+                    pslot->entry = NULL;
+                    pslot->fp_grid = NULL;
+                } else {
+                    // file kept open in pool
+                    *fp_grid = NULL;
+                    NumGridBufFilesOpen--;
+                    NumFilesOpen--;
+                }
+                break;
+            }
+        }
+        pthread_mutex_unlock(&GridFilePoolMutex);
+    }
+
+    CloseGrid3dFile(pgrid, fp_grid, fp_hdr);
+
+}
+
+/*** close grid buffer files kept open in pool and not in use ***/
+
+void NLL_GridFilePoolClose() {
+
+    pthread_mutex_lock(&GridFilePoolMutex);
+    gridfile_pool_close_unused();
+    pthread_mutex_unlock(&GridFilePoolMutex);
+
+}
+
+
 /** end of 3D grid memory management routines */
 /*------------------------------------------------------------/ */
 
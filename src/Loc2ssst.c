@@ -108,6 +108,7 @@ char fn_hypos_in[FILENAME_MAX];
 char fn_ls_output[FILENAME_MAX];
 char fn_time_input[FILENAME_MAX] = "";
 int ihave_time_input_grids = 0;
+int ls_bundle = 0; // 20261016 agent - added, 1 = append output grids to grid bundle <output root>.bundle
 double VpVsRatio;
 int iSwapBytesOnInput;
 
@@ -122,6 +123,7 @@ double get_ssst_value(double xval, double yval, double zval,
 int open_traveltime_grid(ArrivalDesc* parr, char *fn_time_grid_input, char *stacode, char *phasecode, double vp_vs_ratio, double *ptfact);
 int add_ssst_to_traveltime_grid(char *phasecode, char *stacode, GridDesc *pssst_grid, GridDesc *ptraveltime_grid, GridDesc *pssst_time_grid, SourceDesc* psrce, double tfact);
 int GenAngleGrid(GridDesc* ptgrid, SourceDesc* psource, char *filename, GridDesc* pagrid, int angle_mode);
+int AppendToGridBundle(char *filename, char *file_type);
 
 
 /*** program to sum event scatter files */
@@ -181,6 +183,7 @@ int main(int argc, char** argv) {
         exit(-1);
     }
 
+    GridBundle_CloseAll(); // 20261016 agent - added
 
 
     exit(0);
@@ -212,6 +215,40 @@ int get_ls_outfile(char* line1) {
     return (0);
 }
 
+/*** function to read grid bundle output params ***/
+// 20261016 agent - added
+
+int get_ls_bundle(char* line1) {
+
+    int istat = sscanf(line1, "%d", &ls_bundle);
+
+    sprintf(MsgStr, "LSBUNDLE:  %d", ls_bundle);
+    nll_putmsg(1, MsgStr);
+
+    if (istat < 1) {
+        ls_bundle = 0;
+        return (-1);
+    }
+
+    return (0);
+}
+
+/*** function to move grid files <filename>.<file_type>.* into grid bundle <output root>.bundle ***/
+// 20261016 agent - added
+
+int AppendToGridBundle(char *filename, char *file_type) {
+
+    char grid_root[3 * MAXLINE_LONG];
+
+    sprintf(grid_root, "%s.%s", filename, file_type);
+    if (GridBundle_AppendGrid(fn_ls_output, grid_root, 1) < 0) {
+        nll_puterr2("ERROR: appending grid to grid bundle", grid_root);
+        return (-1);
+    }
+
+    return (0);
+}
+
 /*** function to read hypocenter filters ***/
 
 int get_ls_phstat(char* line1) {
@@ -318,6 +355,10 @@ int GetNLLoc_Files(char* line1) {
     sprintf(MsgStr, "LOCFILES:  InputTimeGrids: %s.* iSwapBytesOnInput: %d", fn_time_input, iSwapBytesOnInput);
     nll_putmsg(1, MsgStr);
 
+    // 20261016 agent - added, input time grids are read from grid bundle <grid root>.bundle if it exists
+    if (GridBundle_Open(fn_time_input) < 0)
+        nll_puterr2("ERROR: LOCFILES: opening grid bundle, will use grid files", fn_time_input);
+
     return (0);
 }
 
@@ -489,6 +530,14 @@ int ReadLoc2ssstInput(FILE * fp_input) {
         }
 
 
+        // read grid bundle output params
+
+        if (strcmp(param, "LSBUNDLE") == 0) {
+            if ((istat = get_ls_bundle(strchr(line, ' '))) < 0)
+                nll_puterr("ERROR: reading LSBUNDLE parameters.");
+        }
+
+
         // read grid params
 
         if (strcmp(param, "LSGRID") == 0) {
@@ -944,6 +993,8 @@ int DoLoc2ssst() {
             nll_puterr2("ERROR: writing SSST grid to disk", filename);
             return (-1);
         }
+        if (ls_bundle && AppendToGridBundle(filename, "ssst") < 0)
+            return (-1);
         // save station coordinates to file
         char fn_stations[3*FILENAME_MAX];
         FILE* fp_stations;
@@ -988,6 +1039,8 @@ int DoLoc2ssst() {
                 nll_puterr2("ERROR: writing SSST corrected time grid to disk", filename);
                 return (-1);
             }
+            if (ls_bundle && AppendToGridBundle(filename, "time") < 0)
+                return (-1);
             nll_putmsg2(1, "INFO: SSST corrected time grid written to disk", filename);
 
             // angles
@@ -1371,6 +1424,8 @@ int GenAngleGrid(GridDesc* ptgrid, SourceDesc* psource, char *filename, GridDesc
         nll_puterr("ERROR: writing take-off angles grid to disk.");
         return (-1);
     }
+    if (ls_bundle && AppendToGridBundle(filename, angle_mode == ANGLE_MODE_YES ? "angle" : "inclination") < 0)
+        return (-1);
 
 
     return (0);
@@ -247,11 +247,11 @@ int main(int argc, char *argv[]) {
 
 
     NumLocGrids = 0;
-    NumEvents = NumEventsLocated = NumLocationsCompleted = 0;
-    NumCompDesc = 0;
-    NumLocAlias = 0;
-    NumLocExclude = NumLocInclude = 0;
-    NumTimeDelays = 0;
+    pNLLocContext->NumEvents = pNLLocContext->NumEventsLocated = pNLLocContext->NumLocationsCompleted = 0;
+    pNLLocContext->NumCompDesc = 0;
+    pNLLocContext->NumLocAlias = 0;
+    pNLLocContext->NumLocExclude = pNLLocContext->NumLocInclude = 0;
+    pNLLocContext->NumTimeDelays = 0;
     NumPhaseID = 0;
     DistStaGridMax = 0.0;
     MinNumArrLoc = 0;
@@ -381,25 +381,25 @@ int main(int argc, char *argv[]) {
     numHypocentersAssigned = 0;
 
 
-    for (nObsFile = 0; nObsFile < NumObsFiles; nObsFile++) {
+    for (nObsFile = 0; nObsFile < pNLLocContext->NumObsFiles; nObsFile++) {
 
         i_end_of_input = 0;
 
         nll_putmsg(2, "");
-        snprintf(MsgStr, sizeof(MsgStr), "... Reading observation file %s", fn_loc_obs[nObsFile]);
+        snprintf(MsgStr, sizeof(MsgStr), "... Reading observation file %s", pNLLocContext->fn_loc_obs[nObsFile]);
         nll_putmsg(1, MsgStr);
 
         /* open observation file */
 
-        if ((fp_obs = fopen(fn_loc_obs[nObsFile], "r")) == NULL) {
-            nll_puterr2("ERROR: opening observations file", fn_loc_obs[nObsFile]);
+        if ((fp_obs = fopen(pNLLocContext->fn_loc_obs[nObsFile], "r")) == NULL) {
+            nll_puterr2("ERROR: opening observations file", pNLLocContext->fn_loc_obs[nObsFile]);
             continue;
         } else {
             NumFilesOpen++;
         }
 
         /* extract info from filename */
-        if ((istat = ExtractFilenameInfo(fn_loc_obs[nObsFile], ftype_obs))
+        if ((istat = ExtractFilenameInfo(pNLLocContext->fn_loc_obs[nObsFile], ftype_obs))
                 < 0)
             nll_puterr("WARNING: error extracting information from filename.");
 
@@ -542,7 +542,7 @@ int main(int argc, char *argv[]) {
 
     /* construct weight matrix (TV82, eq. 10-9; MEN92, eq. 12) */
     /*DD
-                    if ((istat = ConstWeightMatrix(NumArrivalsLocation, Arrival,
+                    if ((istat = ConstWeightMatrix(pNLLocContext, NumArrivalsLocation, Arrival,
                                     &Gauss)) < 0) {
                             nll_puterr("ERROR: constructing weight matrix - NLLoc requires non-zero observation or modelisation errors.");
                             // close time grid files and continue
@@ -612,7 +612,7 @@ int main(int argc, char *argv[]) {
     nll_putmsg(1, MsgStr);
 
     //ngrid = 0;
-    if ((NumLocationsCompleted = LocateDiff(fn_loc_obs[nObsFile], fn_path_output, numArrivalsReject)) < 0) {
+    if ((pNLLocContext->NumLocationsCompleted = LocateDiff(pNLLocContext->fn_loc_obs[nObsFile], fn_path_output, numArrivalsReject)) < 0) {
         if (istat == GRID_NOT_INSIDE)
             //break;
             goto cleanup;
@@ -663,12 +663,15 @@ cleanup:
             NLL_FreeGrid(&(Arrival[narr].gdesc));
         }
     }
-    NLL_FreeGridMemory();
 
     /* close time grid files (opened in function GetObservations) */
 
+    // 20261016 agent - moved before NLL_FreeGridMemory(), grid buffer files kept open in grid file pool must be closed before grid memory is freed
     for (narr = 0; narr < NumArrivalsLocation; narr++)
-        CloseGrid3dFile(&(Arrival[narr].gdesc), &(Arrival[narr].fpgrid), &(Arrival[narr].fphdr));
+        NLL_CloseGrid3dFile(&(Arrival[narr].gdesc), &(Arrival[narr].fpgrid), &(Arrival[narr].fphdr));
+    NLL_GridFilePoolClose();
+
+    NLL_FreeGridMemory();
 
     if (iLocated) {
         nll_putmsg(2, "");
@@ -681,12 +684,12 @@ cleanup:
 
 
 
-    NumEvents = NumHypocenters;
-    NumEventsLocated = numHypocentersAssigned;
+    pNLLocContext->NumEvents = NumHypocenters;
+    pNLLocContext->NumEventsLocated = numHypocentersAssigned;
     nll_putmsg(2, "");
     sprintf(MsgStr,
             "No more observation files.  %d events read,  %d events located,  %d locations completed.",
-            NumEvents, NumEventsLocated, NumLocationsCompleted);
+            pNLLocContext->NumEvents, pNLLocContext->NumEventsLocated, pNLLocContext->NumLocationsCompleted);
     nll_putmsg(0, MsgStr);
     nll_putmsg(2, "");
 
@@ -1269,7 +1272,7 @@ int LocateDiff(char* fn_obs, char* fn_path_output, int numArrivalsReject) {
                                     phypo->num_dur_mag = 0;
                                     for (n = 0; n < MAX_NUM_MAG_METHODS; n++)
                                             CalculateMagnitude(&DiffHypocenters[n], Arrival, NumArrivals,
-                                                    Component, NumCompDesc, Magnitude + n);
+                                                    pNLLocContext->Component, pNLLocContext->NumCompDesc, Magnitude + n);
                                     // calculate estimated VpVs ratio
                                     CalculateVpVsEstimate(&DiffHypocenters[n], Arrival, NumArrivals);
              */
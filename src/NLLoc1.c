@@ -61,6 +61,8 @@ tel: +33(0)493752502  e-mail: anthony@alomax.net  web: http://www.alomax.net
 
 #define EXTERN_MODE 1
 
+#include <pthread.h>
+
 #include "GridLib.h"
 #include "ran1/ran1.h"
 #include "velmod.h"
@@ -76,62 +78,24 @@ tel: +33(0)493752502  e-mail: anthony@alomax.net  web: http://www.alomax.net
 #include "custom_eth/eth_functions.h"
 #endif
 
-/** function to perform global search event locations */
-
-int NLLoc
-(
-
-        // calling parameters
-        char *pid_main, // CUSTOM_ETH only: snap id
-        char *fn_control_main, // NLLoc control file: full path and name (set to NULL if *param_line_array not NULL)
-        char **param_line_array, // array of NLLoc control file lines (set to NULL if fn_control_main not NULL)
-        int n_param_lines, // number of elements (parameter lines) in array param_line_array (use 0 if fn_control_main not NULL)
-        char **obs_line_array, // array of observations file lines (set to NULL if obs file name is read from NLLoc control file)
-        int n_obs_lines, // number of elements (obs file lines) in array obs_line_array (set to 0 if obs file name is read from NLLoc control file)
-        int return_locations, // if = 1, return Locations with basic information (HypoDesc* phypo, ArrivalDesc* parrivals, int narrivals, GridDesc* pgrid
-        int return_oct_tree_grid, // if = 1 and LOCSEARCH OCT used, includes location probabily density oct-tree structure in Locations (Tree3D* poctTree)
-        int return_scatter_sample, // if = 1, includes location location scatter sample data in Locations (float* pscatterSample)
-
-        // returned parameters
-        LocNode **ploc_list_head // pointer to pointer to head of list of LocNodes containing Location's for located events (see phaseloclist.h), *ploc_list_head must be initialized to NULL on first call to NLLoc()
-
-        ) {
-
-    int istat, n;
-    int i_end_of_input, iLocated;
-    int narr, ngrid, nObsFile;
-    int numArrivalsIgnore, numSArrivalsLocation;
-    int numArrivalsReject;
-    int maxArrExceeded = 0;
-    int n_file_root_count = 1;
-    char fn_root_out[FILENAME_MAX], fn_root_out_last[FILENAME_MAX];
-    char fname[2*FILENAME_MAX];
-    char targetfname[3*FILENAME_MAX];
-    //char sys_command[2 * FILENAME_MAX];
-    char *chr;
-    FILE *fp_obs = NULL, *fpio;
-
-    char *ppath;
-
-    int return_value = EXIT_NORMAL;
-
+/** function to set default values of control parameters and per-event globals
+ *
+ * called for the calling thread and for each LOCPARALLEL location thread before reading control file
+ */
 
-    /* set program name */
-    strcpy(prog_name, PNAME);
+static void NLLoc_SetDefaults() {
 
+    int n;
 
-    // DD
-    nll_mode = MODE_ABSOLUTE;
 
     /* set constants */
 
     SetConstants();
     NumLocGrids = 0;
-    NumEvents = NumEventsLocated = NumLocationsCompleted = 0;
-    NumCompDesc = 0;
-    NumLocAlias = 0;
-    NumLocExclude = NumLocInclude = 0;
-    NumTimeDelays = 0;
+    pNLLocContext->NumCompDesc = 0;
+    pNLLocContext->NumLocAlias = 0;
+    pNLLocContext->NumLocExclude = pNLLocContext->NumLocInclude = 0;
+    pNLLocContext->NumTimeDelays = 0;
     NumPhaseID = 0;
     DistStaGridMax = 0.0;
     MinNumArrLoc = 0;
@@ -148,8 +112,6 @@ int NLLoc
     NumTimeDelaySurface = 0;
     topo_surface_index = -1;
     iRejectDuplicateArrivals = 1;
-    strcpy(fn_root_out_last, "");
-    ;
 
     // Search prior or posteriour PDF
     iUseSearchPrior = 0;
@@ -162,13 +124,6 @@ int NLLoc
     iSetStationDistributionWeights = 0;
     stationDistributionWeightCutoff = -1;
 
-    // GridMemLib
-    MaxNum3DGridMemory = -1;
-    GridMemList = NULL;
-    GridMemListSize = 0;
-    GridMemListNumElements = 0;
-    GridMemListTotalNumElementsAdded = 0;
-
     // otime limits
     OtimeLimitList = NULL;
     NumOtimeLimit = 0;
@@ -180,6 +135,16 @@ int NLLoc
     // Gauss2
     iUseGauss2 = 0;
 
+    // parallel location
+    LocParallelNumThreads = 0;
+    LocOctParallelNumThreads = 0;
+    LocPrefetchNumEvents = 0;
+    iTiledGridsInMemory = 0;
+    iLocGridROI = 0;
+
+    // timing and run statistics
+    LocPerfMode = LOC_PERF_OFF;
+
 
     // output
     iSaveNLLocEvent = iSaveNLLocSum = iSaveHypo71Event = iSaveHypo71Sum
@@ -191,109 +156,1194 @@ int NLLoc
     // 20220131 AJL - added
     iSaveNLLocEvent_JSON = 0;
 
-    // GNU C library extensions to support memory streams (function open_memstream).
-    char *bp_memory_stream = NULL;
+}
 
-    int is_nll_control_json_file = 0;
+/** function to set path to output files from output file root */
 
-    /* open control file */
+static void NLLoc_SetOutPath() {
 
-    if (fn_control_main != NULL) {
-        strcpy(fn_control, fn_control_main);
-        if ((fp_control = fopen(fn_control, "r")) == NULL) {
-            nll_puterr("FATAL ERROR: opening control file.");
-            return_value = EXIT_ERROR_FILEIO;
-            goto cleanup_return;
+    char *ppath;
+
+    strcpy(f_outpath, fn_path_output);
+    if ((ppath = strrchr(f_outpath, '/')) != NULL
+            || (ppath = strrchr(f_outpath, '\\')) != NULL)
+        *(ppath + 1) = '\0';
+    else
+        strcpy(f_outpath, "");
+
+}
+
+/** function to open velocity model files if needed */
+
+static void NLLoc_OpenModelGrids() {
+
+    int istat;
+    char fname[2*FILENAME_MAX];
+
+
+    // 20101005 AJL
+    // open velocity files if needed
+    fp_model_grid_P = fp_model_hdr_P = NULL;
+    fp_model_grid_S = fp_model_hdr_S = NULL;
+    if (LocMethod == METH_OT_STACK) {
+        snprintf(fname, sizeof(fname), "%s.%s", fn_loc_grids, "P.mod");
+        if ((istat = OpenGrid3dFile(fname, &fp_model_grid_P, &fp_model_hdr_P,
+                &model_grid_P, " ", NULL, iSwapBytesOnInput)) < 0) {
+            sprintf(MsgStr, "WARNING: LocMethod == OT_STACK, but cannot open velocity model file %s.*", fname);
+            nll_putmsg(1, MsgStr);
         } else {
-            NumFilesOpen++;
+            sprintf(MsgStr, "INFO: LocMethod == OT_STACK, sucessfully opened velocity model file %s.*", fname);
+            nll_putmsg(1, MsgStr);
+
+        }
+        snprintf(fname, sizeof(fname), "%s.%s", fn_loc_grids, "S.mod");
+        if ((istat = OpenGrid3dFile(fname, &fp_model_grid_S, &fp_model_hdr_S,
+                &model_grid_S, " ", NULL, iSwapBytesOnInput)) < 0) {
+            sprintf(MsgStr, "WARNING: LocMethod == OT_STACK, but cannot open velocity model file %s.*", fname);
+            nll_putmsg(1, MsgStr);
+        } else {
+            sprintf(MsgStr, "INFO: LocMethod == OT_STACK, sucessfully opened velocity model file %s.*", fname);
+            nll_putmsg(1, MsgStr);
+
         }
-    } else {
-        fp_control = NULL;
     }
 
-    // test if control file is nll-control JSON
-    if (fp_control != NULL) {
-        if ((is_nll_control_json_file = is_nll_control_json(fp_control))) {
-            // read nll-control JSON into array of NLLoc control file lines
-            param_line_array = json_read_nll_control(fp_control, &n_param_lines);
-            if (fp_control != NULL) {
-                fclose(fp_control);
-                NumFilesOpen--;
-            }
-            if (param_line_array == NULL) {
-                nll_puterr("FATAL ERROR: reading nll-control JSON file.");
-                return_value = EXIT_ERROR_FILEIO;
-                goto cleanup_return;
-            }
+}
+
+/** function to close velocity model files */
+
+static void NLLoc_CloseModelGrids() {
+
+    if (fp_model_grid_P != NULL) {
+        CloseGrid3dFile(NULL, &fp_model_grid_P, &fp_model_hdr_P);
+    }
+    if (fp_model_grid_S != NULL) {
+        CloseGrid3dFile(NULL, &fp_model_grid_S, &fp_model_hdr_S);
+    }
+
+}
+
+/* control file input, for initialization of control parameters of location and oct-tree threads */
+typedef struct {
+    char *fn_control; // control file name, NULL if control lines in param_line_array
+    char **param_line_array;
+    int n_param_lines;
+} NLLocControlInput;
+
+/** function to initialize thread copy of control parameters, control file reading sets the process wide
+ *    grid memory parameters, so must be called for one thread at a time
+ *
+ * returns < 0 on error
+ */
+
+// 20261016 agent - added, factored from NLLoc_LocParallelThread(), also used by oct-tree threads (LOCPARALLEL NumOctThreads)
+
+static int NLLoc_InitThread(void *arg) {
+
+    NLLocControlInput *pcontrol = (NLLocControlInput *) arg;
+
+    int istat;
+    FILE *fp_control_thread;
+
+
+    NLLoc_SetDefaults();
+    if (pcontrol->fn_control != NULL) {
+        if ((fp_control_thread = fopen(pcontrol->fn_control, "r")) == NULL) {
+            istat = -1;
+        } else {
+            istat = ReadNLLoc_Input(fp_control_thread, NULL, 0);
+            fclose(fp_control_thread);
         }
+    } else {
+        istat = ReadNLLoc_Input(NULL, pcontrol->param_line_array, pcontrol->n_param_lines);
+    }
+    if (istat < 0) {
+        nll_puterr("FATAL ERROR: reading control file for location thread.");
+        return (-1);
     }
 
+    NLLoc_SetOutPath();
+    ConvertSourceLoc(0, Source, NumSources, 1, 1);
+    NLLoc_OpenModelGrids();
 
-#ifdef CUSTOM_ETH
-    /* SH 02/27/2004
-    added snap_pid   */
-    strcpy(snap_pid, pid_main);
-    /* SH 02AUG2004 not needed any more
-    // AJL 20040527 added snap param file
-    if (argc > 3)
-    strcpy(snap_param_file, argv[3]);
-    else
-    strcpy(snap_param_file, "snap_param.txt");
-     */
-#endif
+    return (0);
 
+}
 
-    /* read NLLoc control statements from control file */
+/** function to clean up thread copy of control parameters */
 
-    if ((istat = ReadNLLoc_Input(fp_control, param_line_array, n_param_lines)) < 0) {
-        nll_puterr("FATAL ERROR: reading control file.");
-        return_value = EXIT_ERROR_FILEIO;
-        goto cleanup_return;
+static void NLLoc_CleanupThread() {
+
+    NLLoc_CloseModelGrids();
+    NLL_GridFilePoolClose(); // 20261016 agent - added
+    FreeSources(); // 20261017 agent - added
+
+}
+
+/** function to initialize hypo fields that may be modified when reading observations */
+
+static void NLLoc_InitHypoObsFields() {
+
+    Hypocenter.amp_mag = MAGNITUDE_NULL;
+    Hypocenter.num_amp_mag = 0;
+    Hypocenter.dur_mag = MAGNITUDE_NULL;
+    Hypocenter.num_dur_mag = 0;
+    strcpy(Hypocenter.public_id, "None");
+    Hypocenter.focMech.dipDir = 0.0;
+    Hypocenter.focMech.dipAng = 0.0;
+    Hypocenter.focMech.rake = 0.0;
+    Hypocenter.focMech.misfit = 0.0;
+    Hypocenter.focMech.nObs = -1;
+
+}
+
+/** function to set random number stream of an event
+ *
+ * Each event has an independent random number stream seeded from the run seed (CONTROL randomNumberSeed) and the
+ * event number in input order, so that results of an event do not depend on the events located before it, or on
+ * which LOCPARALLEL thread locates it: serial and parallel runs give identical results.
+ */
+
+// 20261017 agent - added, was re-seed per event for LOCPARALLEL only
+
+static void NLLoc_SetEventRandomStream(long n_event) {
+
+    RandStream rand_stream;
+
+    rand_stream_seed(&rand_stream, (uint64_t) RandomNumSeed, (uint64_t) n_event);
+    rand_stream_set(&rand_stream);
+
+}
+
+/** function to set output file root and check arrivals of event just read
+ *
+ * returns < 0 if event cannot be located
+ */
+
+static int NLLoc_PrepareEvent(int numArrivalsIgnore, int numArrivalsReject, int numSArrivalsLocation,
+        char *fn_root_out, char *fn_root_out_last, int *pn_file_root_count) {
+
+    int istat;
+
+
+    /* set number of arrivals to be used in location */
+
+    NumArrivalsLocation = NumArrivals - numArrivalsIgnore;
+    NumArrivalsRead = NumArrivals + numArrivalsReject;
+
+    nll_putmsg(2, "");
+    // AJL 20040720 SetOutName(Arrival + 0, fn_path_output, fn_root_out, fn_root_out_last, 1);
+    SetOutName(Arrival + 0, fn_path_output, fn_root_out, fn_root_out_last, iSaveDecSec, iSavePublicID, Hypocenter.public_id, pn_file_root_count);
+    //strcpy(fn_root_out_last, fn_root_out); /* save filename */
+    sprintf(MsgStr,
+            "... %d observations read, %d will be used for location (%s).",
+            NumArrivalsRead, NumArrivalsLocation, fn_root_out);
+    nll_putmsg(1, MsgStr);
+
+    /* sort to get rejected arrivals at end of arrivals array */
+
+    if ((istat = SortArrivalsIgnore(Arrival, NumArrivalsRead)) < 0) {
+        nll_puterr("ERROR: sorting arrivals by ignore flag.");
+        return (-1);
     }
-    if (fp_control != NULL) {
-        fclose(fp_control);
-        NumFilesOpen--;
+
+
+    /* check for minimum number of arrivals */
+
+    if (NumArrivalsLocation < MinNumArrLoc) {
+        sprintf(MsgStr,
+                "WARNING: too few observations to locate (%d available, %d needed), skipping event.", NumArrivalsLocation, MinNumArrLoc);
+        nll_putmsg(1, MsgStr);
+        sprintf(MsgStr,
+                "INFO: %d observations needed (specified in control file entry LOCMETH).",
+                MinNumArrLoc);
+        nll_putmsg(2, MsgStr);
+        return (-1);
     }
 
 
-    /* read observation lines into memory stream (must read control file first) */
+    /* check for minimum number of S arrivals */
 
-    if (n_obs_lines > 0) {
-#ifdef _GNU_SOURCE
-        size_t memory_stream_size;
-        FILE *fp_memory_stream = NULL;
-        // read lines into memory memory stream
-        fp_memory_stream = open_memstream(&bp_memory_stream, &memory_stream_size);
-        if (fp_memory_stream == NULL) {
-            nll_puterr("FATAL ERROR: Cannot pass observations file lines as string array to NLLoc function: GNU C library extensions needed to support memory streams (function open_memstream).");
-            return_value = EXIT_ERROR_MEMORY;
-            goto cleanup_return;
+    if (numSArrivalsLocation < MinNumSArrLoc) {
+        sprintf(MsgStr,
+                "WARNING: too few S observations to locate (%d available, %d needed), skipping event.", numSArrivalsLocation, MinNumSArrLoc);
+        nll_putmsg(1, MsgStr);
+        sprintf(MsgStr,
+                "INFO: %d S observations needed (specified in control file entry LOCMETH).",
+                MinNumSArrLoc);
+        nll_putmsg(2, MsgStr);
+        return (-1);
+    }
+
+    return (0);
+
+}
+
+/** function to add stations of event just read to station list
+ *
+ * for LOCPARALLEL, the station list of each thread is kept a copy of the shared station list station_list_shared,
+ *    for serial location set station_list_shared to NULL
+ */
+
+static void NLLoc_AddToStationList(SourceDesc *station_list_shared, int *pnum_stations_shared) {
+
+    int n;
+
+
+    // station distribution weighting
+    if (iSetStationDistributionWeights || iSaveNLLocSum || octtreeParams.use_stations_density) {
+        //printf(">>>>>>>>>>> NumStations %d, NumArrivals %d, numArrivalsReject %d\n", NumStations, NumArrivals, numArrivalsReject);
+        int i_check_station_has_XYZ_coords = 0;
+        if (station_list_shared != NULL) {
+            for (n = NumStationPhases; n < *pnum_stations_shared; n++)
+                StationPhaseList[n] = station_list_shared[n];
+            NumStationPhases = *pnum_stations_shared;
         }
-        for (n = 0; n < n_obs_lines; n++) {
-            fprintf(fp_memory_stream, "%s", obs_line_array[n]);
-            /*DEBUG*///printf("%s", obs_line_array[n]);
+        NumStationPhases = addToStationList(StationPhaseList, NumStationPhases, Arrival, NumArrivalsRead, 0, i_check_station_has_XYZ_coords);
+        if (station_list_shared != NULL) {
+            for (n = *pnum_stations_shared; n < NumStationPhases; n++)
+                station_list_shared[n] = StationPhaseList[n];
+            *pnum_stations_shared = NumStationPhases;
         }
-        fclose(fp_memory_stream);
-        //
-        fp_obs = fmemopen(bp_memory_stream, memory_stream_size, "r");
+        if (iSetStationDistributionWeights)
+            setStationDistributionWeights(StationPhaseList, NumStationPhases, Arrival, NumArrivals);
 
-        NumObsFiles = 1;
-#else
-        nll_puterr("FATAL ERROR: Cannot pass observations file lines as string array to NLLoc function: GNU C library extensions needed to support memory streams (function open_memstream(); see compiler define _GNU_SOURCE).");
-        return_value = EXIT_ERROR_MEMORY;
-        goto cleanup_return;
+    }
+
+}
+
+/** function to locate event for each location grid
+ *
+ * returns < 0 on error, 1 if location completed for all grids, 0 otherwise
+ */
+
+static int NLLoc_LocateEvent(char *fn_obs, char *fn_root_out, int numArrivalsReject,
+        int return_locations, int return_oct_tree_grid, int return_scatter_sample, LocNode **ploc_list_head) {
+
+    int istat, ngrid;
+
+
+    /* sort to get location arrivals in time order */
+
+    if ((istat = SortArrivalsIgnore(Arrival, NumArrivals)) < 0) {
+        nll_puterr("ERROR: sorting arrivals by ignore flag.");
+        return (-1);
+    }
+    if ((istat = SortArrivalsTime(Arrival, NumArrivalsLocation)) < 0) {
+        nll_puterr("ERROR: sorting arrivals by time.");
+        return (-1);
+    }
+
+
+    /* construct weight matrix (TV82, eq. 10-9; MEN92, eq. 12) */
+
+    double time_perf = LocPerf_Time(); // 20261016 agent - added
+    istat = ConstWeightMatrix(pNLLocContext, NumArrivalsLocation, Arrival, &Gauss);
+    LocPerf_Stage(PERF_WEIGHT, time_perf);
+    if (istat < 0) {
+        nll_puterr("ERROR: constructing weight matrix - NLLoc requires non-zero observation or modelisation errors.");
+        /* close time grid files and continue */
+        return (-1);
+    }
+
+
+    /* calculate weighted mean of obs arrival times   */
+    /*	(TV82, eq. A-38) */
+
+    CalcCenteredTimesObs(NumArrivalsLocation, Arrival, &Gauss, &Hypocenter);
+
+
+    /* preform location for each grid */
+
+    sprintf(MsgStr,
+            "Locating... (Files open: Tot:%d Buf:%d Hdr:%d  Alloc: %d  3DMem: used:%d/avail:%d/load:%d) ...",
+            NumFilesOpen, NumGridBufFilesOpen, NumGridHdrFilesOpen, NumAllocations, Num3DGridReadToMemory, GridMemListSize, GridMemListTotalNumElementsAdded);
+    nll_putmsg(1, MsgStr);
+
+    for (ngrid = 0; ngrid < NumLocGrids; ngrid++) {
+        if ((istat = Locate(pNLLocContext, ngrid, fn_obs, fn_root_out, numArrivalsReject, return_locations, return_oct_tree_grid, return_scatter_sample, ploc_list_head)) < 0) {
+            if (istat == GRID_NOT_INSIDE)
+                break;
+            else {
+                nll_puterr("ERROR: location failed.");
+                return (-1);
+            }
+        }
+    }
+    //printf("XXX: Located: NumAllocations %d->%d\n", XX_last, NumAllocations);
+    //XX_last = NumAllocations;
+
+    return (istat == 0 && ngrid == NumLocGrids);
+
+}
+
+/** function to release grids and weight matrix of event after location */
+
+static void NLLoc_CleanupEvent(int iLocated, char *fn_root_out) {
+
+    int narr;
+
+
+    /* release grid buffer or sheet storage */
+
+    // 20130413 AJL - bug? fix, release memory for all arrivals read
+    //for (narr = 0; narr < NumArrivalsLocation; narr++) {
+    for (narr = 0; narr < NumArrivals; narr++) {
+        //printf("DEBUG: FREE: narr %d Arrival[narr] %s %s n_companion %d n_time_grid %d  flag_ignore %d\n", narr, Arrival[narr].label, Arrival[narr].phase, Arrival[narr].n_companion, Arrival[narr].n_time_grid, Arrival[narr].flag_ignore);
+        // check has opened time grid
+        //if (Arrival[narr].n_time_grid < 0) {
+        //if (Arrival[narr].n_time_grid < 0 && !Arrival[narr].flag_ignore) { // 20160925 AJL - bug fix, ignored arrivals should already have grids freed
+        if (Arrival[narr].n_companion < 0 && Arrival[narr].n_time_grid < 0 && !Arrival[narr].flag_ignore) { // 20170207 AJL - bug fix
+            DestroyGridArray(&(Arrival[narr].sheetdesc));
+            FreeGrid(&(Arrival[narr].sheetdesc));
+            NLL_DestroyGridArray(&(Arrival[narr].gdesc));
+            NLL_FreeGrid(&(Arrival[narr].gdesc));
+        }
+    }
+    //  20141219 AJL - bug fix, should be outside events/obs loop!
+    //NLL_FreeGridMemory();
+
+    /* close time grid files (opened in function GetObservations) */
+
+    // 20130413 AJL - bug? fix, release memory for all arrivals read
+    //for (narr = 0; narr < NumArrivalsLocation; narr++) {
+    for (narr = 0; narr < NumArrivals; narr++) {
+        NLL_CloseGrid3dFile(&(Arrival[narr].gdesc), &(Arrival[narr].fpgrid), &(Arrival[narr].fphdr));
+    }
+
+    if (iLocated) {
+        nll_putmsg(1, "");
+        //20231114 AJL //sprintf(MsgStr, "Finished event location, output files: %s.* <%s.grid0.loc.hyp>", fn_root_out, fn_root_out);
+        sprintf(MsgStr, "Finished location: %s.grid0.loc.hyp", fn_root_out);
+        nll_putmsg(0, MsgStr);
+    } else
+        nll_putmsg(0, "");
+
+    // 201101013 AJL - Bug fix - this cleanup was done in NLLocLib.c->clean_memory() which puts the cleanup incorrectly inside the Locate loop
+    CleanWeightMatrix();
+
+    // 20261016 agent - added
+    LocPerf_EndEvent(fn_root_out, iLocated);
+
+    //printf("XXX: Cleaned: NumAllocations %d->%d\n", XX_last, NumAllocations);
+
+}
+
+
+
+/*------------------------------------------------------------/ */
+/** look-ahead grid prefetch (LOCPREFETCH)
+ *
+ * During serial location, a prefetch thread reads the observation file up to LocPrefetchNumEvents events
+ * ahead of the event being located and loads the 3D time grids needed by these events into the grid
+ * memory list (see GridMemLib.c->NLL_PrefetchGrid()), so that grid reads from disk overlap location of the
+ * current event.  The prefetch thread has its own location run context (observation reader state, station
+ * tables) and re-reads the control file to initialize its copy of the control parameters, reads observations
+ * with its own copy of the arrivals and hypocenter, and prints no messages.
+ * Prefetched grids are only a cache of grid files, so location results do not depend on prefetch.
+ */
+
+typedef struct {
+    NLLocControlInput *pcontrol;
+    char *fn_obs;
+    int num_events_ahead;
+    // access only with mutex locked
+    long num_events_started; // number of events read or being read by the location thread
+    int stop;
+    int init_done;
+    int init_error;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} LocPrefetchState;
+
+/** prefetch thread */
+
+static void* NLLoc_PrefetchThread(void *arg) {
+
+    LocPrefetchState *state = (LocPrefetchState *) arg;
+
+    int istat, narr;
+    int i_end_of_input = 0, num_arrivals = 0;
+    int numArrivalsIgnore, numArrivalsReject, numSArrivalsLocation;
+    int maxArrExceeded = 0;
+    long num_events_read = 0, num_events_started, n_event_first;
+    unsigned long *use_count_event = NULL;
+    FILE *fp_obs_prefetch = NULL;
+
+    /* initialize thread copy of location run context and control parameters, location thread waits */
+
+    if ((pNLLocContext = NLLocContext_New()) == NULL)
+        istat = -1;
+    else
+        istat = NLLoc_InitThread(state->pcontrol);
+    message_flag = -1;
+    iPrefetchGridsOnInput = 1;
+    if (istat == 0 && (fp_obs_prefetch = fopen(state->fn_obs, "r")) == NULL)
+        istat = -1;
+    // grid memory use count at start of reading of each event in look-ahead window
+    if (istat == 0 && (use_count_event = (unsigned long *) malloc((state->num_events_ahead + 1) * sizeof (unsigned long))) == NULL)
+        istat = -1;
+    if (istat == 0)
+        ExtractFilenameInfo(state->fn_obs, ftype_obs);
+
+    pthread_mutex_lock(&state->mutex);
+    state->init_error = istat < 0;
+    state->init_done = 1;
+    pthread_cond_broadcast(&state->cond);
+    pthread_mutex_unlock(&state->mutex);
+
+
+    /* read events ahead of location thread and load their time grids */
+
+    while (istat == 0 && !i_end_of_input) {
+
+        pthread_mutex_lock(&state->mutex);
+        while (!state->stop && num_events_read >= state->num_events_started + state->num_events_ahead)
+            pthread_cond_wait(&state->cond, &state->mutex);
+        istat = state->stop;
+        num_events_started = state->num_events_started;
+        pthread_mutex_unlock(&state->mutex);
+        if (istat)
+            break;
+
+        // do not remove grids loaded or used for events from event being read or located by location thread up to this event
+        use_count_event[num_events_read % (state->num_events_ahead + 1)] = NLL_GridMemoryUseCount();
+        n_event_first = num_events_started - 1;
+        if (n_event_first < 0 || n_event_first > num_events_read)
+            n_event_first = num_events_read;
+        PrefetchGridsMinLastUsed = use_count_event[n_event_first % (state->num_events_ahead + 1)];
+
+        NLLoc_InitHypoObsFields();
+        if ((num_arrivals = GetObservations(fp_obs_prefetch,
+                ftype_obs, fn_loc_grids, Arrival,
+                &i_end_of_input, &numArrivalsIgnore,
+                &numArrivalsReject,
+                MaxNumArrLoc, &Hypocenter,
+                &maxArrExceeded, &numSArrivalsLocation, 0)) == 0)
+            break;
+        num_events_read++;
+
+        /* close time grid files (opened in function GetObservations) */
+        for (narr = 0; narr < num_arrivals; narr++)
+            NLL_CloseGrid3dFile(&(Arrival[narr].gdesc), &(Arrival[narr].fpgrid), &(Arrival[narr].fphdr));
+
+    }
+
+
+    /* clean up thread */
+
+    if (fp_obs_prefetch != NULL)
+        fclose(fp_obs_prefetch);
+    free(use_count_event);
+    if (pNLLocContext != NULL) {
+        NLLoc_CleanupThread();
+        NLLocContext_Free(pNLLocContext);
+        pNLLocContext = NULL;
+    }
+    if (Arrival != NULL) {
+        free(Arrival);
+        Arrival = NULL;
+    }
+
+    return (NULL);
+
+}
+
+/** function to start prefetch thread for an observation file
+ *
+ * returns < 0 if prefetch thread could not be started
+ */
+
+static int NLLoc_PrefetchStart(LocPrefetchState *state, NLLocControlInput *pcontrol, char *fn_obs, int num_events_ahead) {
+
+    state->pcontrol = pcontrol;
+    state->fn_obs = fn_obs;
+    state->num_events_ahead = num_events_ahead;
+    state->num_events_started = 0;
+    state->stop = 0;
+    state->init_done = 0;
+    state->init_error = 0;
+    pthread_mutex_init(&state->mutex, NULL);
+    pthread_cond_init(&state->cond, NULL);
+
+    if (pthread_create(&state->thread, NULL, NLLoc_PrefetchThread, state) != 0) {
+        nll_puterr("WARNING: creating look-ahead grid prefetch thread, time grids will not be prefetched.");
+        pthread_mutex_destroy(&state->mutex);
+        pthread_cond_destroy(&state->cond);
+        return (-1);
+    }
+
+    // wait for initialization of prefetch thread, control file reading sets process wide grid memory parameters
+    pthread_mutex_lock(&state->mutex);
+    while (!state->init_done)
+        pthread_cond_wait(&state->cond, &state->mutex);
+    pthread_mutex_unlock(&state->mutex);
+    if (state->init_error)
+        nll_puterr("WARNING: initializing look-ahead grid prefetch thread, time grids will not be prefetched.");
+
+    return (0);
+
+}
+
+/** function to signal prefetch thread that location thread starts reading next event */
+
+static void NLLoc_PrefetchNextEvent(LocPrefetchState *state) {
+
+    pthread_mutex_lock(&state->mutex);
+    state->num_events_started++;
+    pthread_cond_broadcast(&state->cond);
+    pthread_mutex_unlock(&state->mutex);
+
+}
+
+/** function to stop prefetch thread */
+
+static void NLLoc_PrefetchStop(LocPrefetchState *state) {
+
+    pthread_mutex_lock(&state->mutex);
+    state->stop = 1;
+    pthread_cond_broadcast(&state->cond);
+    pthread_mutex_unlock(&state->mutex);
+
+    pthread_join(state->thread, NULL);
+    pthread_mutex_destroy(&state->mutex);
+    pthread_cond_destroy(&state->cond);
+
+}
+
+
+
+/** function to read and locate all events in observation files, one event at a time */
+
+static int NLLoc_LocSerial(FILE *fp_obs, int n_obs_lines, int num_obs_files, NLLocControlInput *pcontrol,
+        int return_locations, int return_oct_tree_grid, int return_scatter_sample, LocNode **ploc_list_head) {
+
+    int istat;
+    int i_end_of_input, iLocated;
+    int iPrefetch;
+    LocPrefetchState prefetch;
+    int nObsFile;
+    int numArrivalsIgnore, numSArrivalsLocation;
+    int numArrivalsReject;
+    int maxArrExceeded = 0;
+    int n_file_root_count = 1;
+    long n_event = 0;
+    char fn_root_out[FILENAME_MAX], fn_root_out_last[FILENAME_MAX];
+
+
+    strcpy(fn_root_out_last, "");
+
+    for (nObsFile = 0; nObsFile < num_obs_files; nObsFile++) {
+
+        i_end_of_input = 0;
+
+        nll_putmsg(2, "");
+        snprintf(MsgStr, sizeof(MsgStr), "... Reading observation file %s", pNLLocContext->fn_loc_obs[nObsFile]);
+        nll_putmsg(1, MsgStr);
+
+        // check if observations are read from file(s)
+        if ((n_obs_lines <= 0)) {
+            /* open observation file */
+            if ((fp_obs = fopen(pNLLocContext->fn_loc_obs[nObsFile], "r")) == NULL) {
+                nll_puterr2("ERROR: opening observations file",
+                        pNLLocContext->fn_loc_obs[nObsFile]);
+                continue;
+            } else {
+                NumFilesOpen++;
+            }
+            /* extract info from filename */
+            if ((istat = ExtractFilenameInfo(pNLLocContext->fn_loc_obs[nObsFile], ftype_obs)) < 0)
+                nll_puterr("WARNING: error extracting information from filename.");
+        }
+
+        // 20261016 agent - added, look-ahead grid prefetch (LOCPREFETCH), observations must be read from file
+        iPrefetch = LocPrefetchNumEvents > 0 && n_obs_lines <= 0
+                && NLLoc_PrefetchStart(&prefetch, pcontrol, pNLLocContext->fn_loc_obs[nObsFile], LocPrefetchNumEvents) == 0;
+
+
+        /* read arrivals and locate event for each  */
+        /*		event (set of observations) in file */
+
+        NumArrivals = 0;
+        while (1) {
+
+            iLocated = 0;
+
+            if (i_end_of_input)
+                break;
+
+            if (NumArrivals != OBS_FILE_SKIP_INPUT_LINE) {
+                nll_putmsg(2, "");
+                sprintf(MsgStr,
+                        "Reading next set of observations (Files open: Tot:%d Buf:%d Hdr:%d  Alloc: %d) ...",
+                        NumFilesOpen, NumGridBufFilesOpen, NumGridHdrFilesOpen, NumAllocations);
+                nll_putmsg(1, MsgStr);
+            }
+
+            // initialize hypo fields that may be modified when reading observations
+            NLLoc_InitHypoObsFields();
+
+            /* read next set of observations */
+
+            if (iPrefetch)
+                NLLoc_PrefetchNextEvent(&prefetch);
+
+            LocPerf_BeginEvent(); // 20261016 agent - added
+            NumArrivalsLocation = 0;
+            if ((NumArrivals = GetObservations(fp_obs,
+                    ftype_obs, fn_loc_grids, Arrival,
+                    &i_end_of_input, &numArrivalsIgnore,
+                    &numArrivalsReject,
+                    MaxNumArrLoc, &Hypocenter,
+                    &maxArrExceeded, &numSArrivalsLocation, 0)) == 0)
+                break;
+
+            // event number counted as in parallel location (see NLLoc_LocParallelReadEvent())
+            NLLoc_SetEventRandomStream(n_event++);
+
+            if (NumArrivals < 0)
+                goto cleanup;
+
+            //int XX_last = NumAllocations;
+
+            if (NLLoc_PrepareEvent(numArrivalsIgnore, numArrivalsReject, numSArrivalsLocation,
+                    fn_root_out, fn_root_out_last, &n_file_root_count) < 0)
+                goto cleanup;
+
+
+            /* process arrivals */
+
+            /* add stations to station list */
+
+            NLLoc_AddToStationList(NULL, NULL);
+
+            /* locate */
+
+            if ((istat = NLLoc_LocateEvent(pNLLocContext->fn_loc_obs[nObsFile], fn_root_out, numArrivalsReject,
+                    return_locations, return_oct_tree_grid, return_scatter_sample, ploc_list_head)) < 0)
+                goto cleanup;
+
+            pNLLocContext->NumEventsLocated++;
+            if (istat > 0)
+                pNLLocContext->NumLocationsCompleted++;
+            iLocated = 1;
+
+cleanup:
+            ;
+
+            pNLLocContext->NumEvents++;
+            //n_file_root_count++;
+
+            NLLoc_CleanupEvent(iLocated, fn_root_out);
+
+        } /* next event */
+
+        if (iPrefetch)
+            NLLoc_PrefetchStop(&prefetch);
+
+        nll_putmsg(2, "");
+        sprintf(MsgStr, "...end of observation file detected.");
+        nll_putmsg(1, MsgStr);
+
+        if ((n_obs_lines <= 0)) { // observations are read from file(s)
+            fclose(fp_obs);
+            NumFilesOpen--;
+        } else { // observation lines are read from memory stream (20101110 AJL)
+            // AJL 20101110 - Bug fix for function version
+            fclose(fp_obs);
+        }
+
+    } /* next observation file */
+
+    return (0);
+
+}
+
+
+
+/*------------------------------------------------------------/ */
+/** parallel location (LOCPARALLEL)
+ *
+ * Events are read one at a time under a lock by a pool of location threads, each event is located
+ * concurrently by the thread that read it, and each thread then waits for its commit turn (see
+ * NLLocLib.c->LocParallel_BeginCommit()) to save the location and update run statistics in event input order.
+ * Per-event state and control parameters are thread local (see NLL_THREAD_LOCAL), each thread
+ * re-reads the control file to initialize its copy of the control parameters.
+ * Each event has its own random number stream from the event input order (see NLLoc_SetEventRandomStream()),
+ * as in serial location, so results are identical to serial location for any number of threads.
+ */
+
+typedef struct {
+    // control file
+    NLLocControlInput control;
+    // observations input, shared by all threads, access only with read_mutex locked
+    FILE *fp_obs_lines; // memory stream for observation lines, NULL if observations are read from file(s)
+    FILE *fp_obs;
+    int num_obs_files;
+    int n_obs_file;
+    int i_end_of_input;
+    int num_arrivals_last;
+    long next_ticket;
+    char fn_root_out_last[FILENAME_MAX];
+    int n_file_root_count;
+    SourceDesc *station_list;
+    int num_stations;
+    // returned locations
+    int return_locations;
+    int return_oct_tree_grid;
+    int return_scatter_sample;
+    LocNode **ploc_list_head;
+    // location run context of the calling NLLoc()
+    NLLocContext *pcontext;
+    // thread startup, access only with init_mutex locked
+    int num_threads_started;
+    int num_threads_initialized;
+    int threads_start_done;
+    int init_error;
+    pthread_mutex_t init_mutex;
+    pthread_cond_t init_cond;
+    pthread_mutex_t read_mutex;
+} LocParallelState;
+
+/** function to read next event for a location thread, must be called with read_mutex locked
+ *
+ * returns 0 if no more events, 1 if event read and ready for location, -1 if event read but cannot be located
+ */
+
+static int NLLoc_LocParallelReadEvent(LocParallelState *state, char *fn_root_out, int *pnObsFile, int *pnumArrivalsReject, long *pticket) {
+
+    int istat;
+    int numArrivalsIgnore, numSArrivalsLocation;
+    int maxArrExceeded = 0;
+
+
+    NumArrivals = 0;
+
+    while (1) {
+
+        /* open next observation file */
+
+        if (state->fp_obs == NULL) {
+            if (state->n_obs_file >= state->num_obs_files)
+                return (0);
+            nll_putmsg(2, "");
+            snprintf(MsgStr, sizeof(MsgStr), "... Reading observation file %s", pNLLocContext->fn_loc_obs[state->n_obs_file]);
+            nll_putmsg(1, MsgStr);
+            if (state->fp_obs_lines != NULL) {
+                state->fp_obs = state->fp_obs_lines;
+            } else {
+                // file may be closed by another thread, so not counted in thread local NumFilesOpen
+                if ((state->fp_obs = fopen(pNLLocContext->fn_loc_obs[state->n_obs_file], "r")) == NULL) {
+                    nll_puterr2("ERROR: opening observations file",
+                            pNLLocContext->fn_loc_obs[state->n_obs_file]);
+                    state->n_obs_file++;
+                    continue;
+                }
+                /* extract info from filename */
+                if ((istat = ExtractFilenameInfo(pNLLocContext->fn_loc_obs[state->n_obs_file], ftype_obs)) < 0)
+                    nll_puterr("WARNING: error extracting information from filename.");
+            }
+            state->i_end_of_input = 0;
+            state->num_arrivals_last = 0;
+        }
+
+        /* read next set of observations */
+
+        if (!state->i_end_of_input) {
+
+            if (state->num_arrivals_last != OBS_FILE_SKIP_INPUT_LINE) {
+                nll_putmsg(2, "");
+                sprintf(MsgStr,
+                        "Reading next set of observations (Files open: Tot:%d Buf:%d Hdr:%d  Alloc: %d) ...",
+                        NumFilesOpen, NumGridBufFilesOpen, NumGridHdrFilesOpen, NumAllocations);
+                nll_putmsg(1, MsgStr);
+            }
+
+            NLLoc_InitHypoObsFields();
+
+            LocPerf_BeginEvent(); // 20261016 agent - added
+            NumArrivalsLocation = 0;
+            NumArrivals = GetObservations(state->fp_obs,
+                    ftype_obs, fn_loc_grids, Arrival,
+                    &(state->i_end_of_input), &numArrivalsIgnore,
+                    pnumArrivalsReject,
+                    MaxNumArrLoc, &Hypocenter,
+                    &maxArrExceeded, &numSArrivalsLocation, 0);
+            state->num_arrivals_last = NumArrivals;
+
+            if (NumArrivals != 0) {
+                *pnObsFile = state->n_obs_file;
+                *pticket = state->next_ticket++;
+                if (NumArrivals < 0)
+                    return (-1);
+                if (NLLoc_PrepareEvent(numArrivalsIgnore, *pnumArrivalsReject, numSArrivalsLocation,
+                        fn_root_out, state->fn_root_out_last, &(state->n_file_root_count)) < 0)
+                    return (-1);
+                NLLoc_AddToStationList(state->station_list, &(state->num_stations));
+                return (1);
+            }
+
+        }
+
+        /* end of observation file */
+
+        nll_putmsg(2, "");
+        sprintf(MsgStr, "...end of observation file detected.");
+        nll_putmsg(1, MsgStr);
+        fclose(state->fp_obs);
+        state->fp_obs = NULL;
+        state->n_obs_file++;
+
+    }
+
+}
+
+/** location thread */
+
+static void* NLLoc_LocParallelThread(void *arg) {
+
+    LocParallelState *state = (LocParallelState *) arg;
+
+    int istat, iLocated;
+    int nObsFile = 0, numArrivalsReject = 0;
+    long ticket = 0;
+    char fn_root_out[FILENAME_MAX];
+
+    // use location run context of the calling NLLoc()
+    pNLLocContext = state->pcontext;
+
+    /* initialize thread copy of control parameters, one thread at a time */
+
+    pthread_mutex_lock(&state->init_mutex);
+
+    if (NLLoc_InitThread(&(state->control)) < 0) {
+        state->init_error = 1;
+    } else if (LocOctParallelNumThreads > 1) {
+        // 20261016 agent - added, oct-tree threads of this location thread
+        OctParallel_Init(LocOctParallelNumThreads, NLLoc_InitThread, NLLoc_CleanupThread, &(state->control));
+    }
+
+    // wait for all threads to be initialized, control file reading sets process wide grid memory parameters
+    state->num_threads_initialized++;
+    pthread_cond_broadcast(&state->init_cond);
+    while (!state->threads_start_done || state->num_threads_initialized < state->num_threads_started)
+        pthread_cond_wait(&state->init_cond, &state->init_mutex);
+
+    pthread_mutex_unlock(&state->init_mutex);
+
+
+    /* read and locate events */
+
+    while (!state->init_error) {
+
+        iLocated = 0;
+
+        pthread_mutex_lock(&state->read_mutex);
+        istat = NLLoc_LocParallelReadEvent(state, fn_root_out, &nObsFile, &numArrivalsReject, &ticket);
+        pthread_mutex_unlock(&state->read_mutex);
+
+        if (istat == 0) // no more events
+            break;
+
+        LocParallel_SetTicket(ticket);
+
+        if (istat > 0) {
+            NLLoc_SetEventRandomStream(ticket);
+            if ((istat = NLLoc_LocateEvent(pNLLocContext->fn_loc_obs[nObsFile], fn_root_out, numArrivalsReject,
+                    state->return_locations, state->return_oct_tree_grid, state->return_scatter_sample, state->ploc_list_head)) >= 0)
+                iLocated = 1;
+        }
+
+        /* update counters and release event in event input order */
+
+        LocParallel_BeginCommit();
+        pNLLocContext->NumEvents++;
+        if (iLocated) {
+            pNLLocContext->NumEventsLocated++;
+            if (istat > 0)
+                pNLLocContext->NumLocationsCompleted++;
+        }
+        NLLoc_CleanupEvent(iLocated, fn_root_out);
+        LocParallel_EndCommit();
+
+    }
+
+
+    /* clean up thread */
+
+    OctParallel_Free(); // 20261016 agent - added
+    NLLoc_CloseModelGrids();
+    NLL_GridFilePoolClose(); // 20261016 agent - added
+    freeOctArena(octArena); // 20261016 agent - added
+    octArena = NULL;
+    TTCache_Free(); // 20261016 agent - added
+    FreeCompressedGridCache(); // 20261016 agent - added
+    FreeSources(); // 20261017 agent - added
+    if (Arrival != NULL) {
+        free(Arrival);
+        Arrival = NULL;
+    }
+
+    return (NULL);
+
+}
+
+/** function to read and locate all events using LocParallelNumThreads location threads
+ *
+ * returns < 0 on error
+ */
+
+static int NLLoc_LocParallel(char *fn_control_in, char **param_line_array, int n_param_lines, FILE *fp_obs_lines, int num_obs_files,
+        int return_locations, int return_oct_tree_grid, int return_scatter_sample, LocNode **ploc_list_head) {
+
+    int n, num_threads;
+    pthread_t *threads;
+    LocParallelState state;
+
+
+    num_threads = LocParallelNumThreads;
+
+    sprintf(MsgStr, "Locating with %d parallel location threads (LOCPARALLEL) ...", num_threads);
+    nll_putmsg(1, MsgStr);
+
+    state.control.fn_control = fn_control_in;
+    state.control.param_line_array = param_line_array;
+    state.control.n_param_lines = n_param_lines;
+    state.fp_obs_lines = fp_obs_lines;
+    state.fp_obs = NULL;
+    state.num_obs_files = num_obs_files;
+    state.n_obs_file = 0;
+    state.i_end_of_input = 0;
+    state.num_arrivals_last = 0;
+    state.next_ticket = 0;
+    strcpy(state.fn_root_out_last, "");
+    state.n_file_root_count = 1;
+    state.num_stations = 0;
+    state.return_locations = return_locations;
+    state.return_oct_tree_grid = return_oct_tree_grid;
+    state.return_scatter_sample = return_scatter_sample;
+    state.ploc_list_head = ploc_list_head;
+    state.pcontext = pNLLocContext;
+    state.num_threads_started = 0;
+    state.num_threads_initialized = 0;
+    state.threads_start_done = 0;
+    state.init_error = 0;
+
+    if ((state.station_list = (SourceDesc *) calloc(MAX_NUM_ARRIVALS, sizeof (SourceDesc))) == NULL
+            || (threads = (pthread_t *) malloc(num_threads * sizeof (pthread_t))) == NULL) {
+        nll_puterr("ERROR: allocating memory for parallel location.");
+        free(state.station_list);
+        return (-1);
+    }
+    pthread_mutex_init(&state.init_mutex, NULL);
+    pthread_cond_init(&state.init_cond, NULL);
+    pthread_mutex_init(&state.read_mutex, NULL);
+    LocParallel_Reset();
+
+    /* start location threads */
+
+    pthread_mutex_lock(&state.init_mutex);
+    for (n = 0; n < num_threads; n++) {
+        if (pthread_create(threads + n, NULL, NLLoc_LocParallelThread, &state) != 0) {
+            sprintf(MsgStr, "WARNING: cannot create parallel location thread, using %d threads.", n);
+            nll_putmsg(1, MsgStr);
+            if (n == 0)
+                state.init_error = 1;
+            break;
+        }
+        state.num_threads_started++;
+    }
+    state.threads_start_done = 1;
+    pthread_cond_broadcast(&state.init_cond);
+    pthread_mutex_unlock(&state.init_mutex);
+
+    /* wait for all events to be located */
+
+    for (n = 0; n < state.num_threads_started; n++)
+        pthread_join(threads[n], NULL);
+
+    // install shared station list for output
+    for (n = 0; n < state.num_stations; n++)
+        StationPhaseList[n] = state.station_list[n];
+    NumStationPhases = state.num_stations;
+
+    // observation stream left open by error
+    if (state.fp_obs != NULL)
+        fclose(state.fp_obs);
+    else if (fp_obs_lines != NULL && state.n_obs_file == 0)
+        fclose(fp_obs_lines);
+
+    pthread_mutex_destroy(&state.init_mutex);
+    pthread_cond_destroy(&state.init_cond);
+    pthread_mutex_destroy(&state.read_mutex);
+    free(threads);
+    free(state.station_list);
+
+    if (state.init_error)
+        return (-1);
+
+    return (0);
+
+}
+
+/** end of parallel location */
+/*------------------------------------------------------------/ */
+
+
+/*------------------------------------------------------------/ */
+/** location run
+ *
+ * A location run is opened by NLLoc_Open(), which reads the control statements and opens output and model files,
+ * observations are located by one or more calls to NLLoc_LocateObs() and NLLoc_Close() writes the cumulative
+ * run statistics and frees the run.  All three must be called from the same thread, control parameters are
+ * thread local.  NLLoc() performs a complete location run.
+ */
+
+// 20261017 agent - added, NLLoc() split into open, locate and close of a location run (used by NLLoc --serve)
+
+/* location run state, see NLLoc_Open() */
+struct NLLocRun {
+    NLLocContext *pcontext; // location run context
+    NLLocContext *pcontext_caller; // location run context of calling thread before NLLoc_Open()
+    NLLocControlInput control_input; // control input for initialization of location and oct-tree threads
+    int is_nll_control_json_file; // if = 1, control_input.param_line_array read from nll-control JSON file
+    int return_value; // return value of run, != EXIT_NORMAL after error
+};
+
+
+/** function to open a location run: read control statements, open summary and model files
+ *
+ * returns location run, NULL on error with error code in *preturn_value
+ */
+
+NLLocRun* NLLoc_Open
+(
+
+        // calling parameters
+        char *pid_main, // CUSTOM_ETH only: snap id
+        char *fn_control_main, // NLLoc control file: full path and name (set to NULL if *param_line_array not NULL)
+        char **param_line_array, // array of NLLoc control file lines (set to NULL if fn_control_main not NULL)
+        int n_param_lines, // number of elements (parameter lines) in array param_line_array (use 0 if fn_control_main not NULL)
+        int locate_in_calling_thread, // if = 1, events are located by the calling thread (LOCPARALLEL NumThreads not used) and oct-tree threads are started once for the run
+
+        // returned parameters
+        int *preturn_value // EXIT_NORMAL, or error code if location run could not be opened
+
+        ) {
+
+    int istat;
+    char fname[2*FILENAME_MAX];
+    char targetfname[3*FILENAME_MAX];
+    //char sys_command[2 * FILENAME_MAX];
+    char *chr;
+    NLLocRun *prun;
+
+
+    /* set program name */
+    strcpy(prog_name, PNAME);
+
+
+    // DD
+    nll_mode = MODE_ABSOLUTE;
+
+    /* set constants and defaults */
+
+    NLLoc_SetDefaults();
+
+    if ((prun = (NLLocRun *) calloc(1, sizeof (NLLocRun))) == NULL) {
+        *preturn_value = EXIT_ERROR_MEMORY;
+        return (NULL);
+    }
+    prun->return_value = EXIT_NORMAL;
+
+    // location run context, 20261016 agent - added, run state is private to this location run
+    prun->pcontext_caller = pNLLocContext;
+    if ((prun->pcontext = pNLLocContext = NLLocContext_New()) == NULL) {
+        pNLLocContext = prun->pcontext_caller;
+        free(prun);
+        *preturn_value = EXIT_ERROR_MEMORY;
+        return (NULL);
+    }
+    pNLLocContext->NumEvents = pNLLocContext->NumEventsLocated = pNLLocContext->NumLocationsCompleted = 0;
+
+    // GridMemLib
+    NLL_GridMemoryOpen();
+
+    /* open control file */
+
+    if (fn_control_main != NULL) {
+        strcpy(fn_control, fn_control_main);
+        if ((fp_control = fopen(fn_control, "r")) == NULL) {
+            nll_puterr("FATAL ERROR: opening control file.");
+            prun->return_value = EXIT_ERROR_FILEIO;
+            goto error_return;
+        } else {
+            NumFilesOpen++;
+        }
+    } else {
+        fp_control = NULL;
+    }
+
+    // test if control file is nll-control JSON
+    if (fp_control != NULL) {
+        if ((prun->is_nll_control_json_file = is_nll_control_json(fp_control))) {
+            // read nll-control JSON into array of NLLoc control file lines
+            param_line_array = json_read_nll_control(fp_control, &n_param_lines);
+            if (fp_control != NULL) {
+                fclose(fp_control);
+                NumFilesOpen--;
+            }
+            prun->control_input.param_line_array = param_line_array;
+            prun->control_input.n_param_lines = n_param_lines;
+            if (param_line_array == NULL) {
+                nll_puterr("FATAL ERROR: reading nll-control JSON file.");
+                prun->return_value = EXIT_ERROR_FILEIO;
+                goto error_return;
+            }
+        }
+    }
+
+
+#ifdef CUSTOM_ETH
+    /* SH 02/27/2004
+    added snap_pid   */
+    strcpy(snap_pid, pid_main);
+    /* SH 02AUG2004 not needed any more
+    // AJL 20040527 added snap param file
+    if (argc > 3)
+    strcpy(snap_param_file, argv[3]);
+    else
+    strcpy(snap_param_file, "snap_param.txt");
+     */
 #endif
+
+
+    /* read NLLoc control statements from control file */
+
+    if ((istat = ReadNLLoc_Input(fp_control, param_line_array, n_param_lines)) < 0) {
+        nll_puterr("FATAL ERROR: reading control file.");
+        prun->return_value = EXIT_ERROR_FILEIO;
+        goto error_return;
+    }
+    if (fp_control != NULL) {
+        fclose(fp_control);
+        NumFilesOpen--;
     }
 
+    // control input for location and oct-tree threads
+    prun->control_input.fn_control = (fn_control_main != NULL && !prun->is_nll_control_json_file) ? fn_control : NULL;
+    prun->control_input.param_line_array = param_line_array;
+    prun->control_input.n_param_lines = n_param_lines;
+
+    if (locate_in_calling_thread && LocParallelNumThreads > 0) {
+        nll_putmsg(1, "INFO: LOCPARALLEL NumThreads not used, events are located one at a time by the calling thread.");
+        LocParallelNumThreads = 0;
+    }
 
 
     // get path to output files
-    strcpy(f_outpath, fn_path_output);
-    if ((ppath = strrchr(f_outpath, '/')) != NULL
-            || (ppath = strrchr(f_outpath, '\\')) != NULL)
-        *(ppath + 1) = '\0';
-    else
-        strcpy(f_outpath, "");
+    NLLoc_SetOutPath();
 
 
     // copy control file to output directory
@@ -339,295 +1389,162 @@ int NLLoc
     if (!iSaveNone) {
         if ((istat = OpenSummaryFiles(fn_path_output, "grid")) < 0) {
             nll_puterr("FATAL ERROR: opening hypocenter summary files.");
-            return_value = EXIT_ERROR_FILEIO;
-            goto cleanup_return;
+            prun->return_value = EXIT_ERROR_FILEIO;
+            goto error_return;
         }
     }
 
-    // 20101005 AJL
     // open velocity files if needed
-    fp_model_grid_P = fp_model_hdr_P = NULL;
-    fp_model_grid_S = fp_model_hdr_S = NULL;
-    if (LocMethod == METH_OT_STACK) {
-        snprintf(fname, sizeof(fname), "%s.%s", fn_loc_grids, "P.mod");
-        if ((istat = OpenGrid3dFile(fname, &fp_model_grid_P, &fp_model_hdr_P,
-                &model_grid_P, " ", NULL, iSwapBytesOnInput)) < 0) {
-            sprintf(MsgStr, "WARNING: LocMethod == OT_STACK, but cannot open velocity model file %s.*", fname);
-            nll_putmsg(1, MsgStr);
-        } else {
-            sprintf(MsgStr, "INFO: LocMethod == OT_STACK, sucessfully opened velocity model file %s.*", fname);
-            nll_putmsg(1, MsgStr);
-
-        }
-        snprintf(fname, sizeof(fname), "%s.%s", fn_loc_grids, "S.mod");
-        if ((istat = OpenGrid3dFile(fname, &fp_model_grid_S, &fp_model_hdr_S,
-                &model_grid_S, " ", NULL, iSwapBytesOnInput)) < 0) {
-            sprintf(MsgStr, "WARNING: LocMethod == OT_STACK, but cannot open velocity model file %s.*", fname);
-            nll_putmsg(1, MsgStr);
-        } else {
-            sprintf(MsgStr, "INFO: LocMethod == OT_STACK, sucessfully opened velocity model file %s.*", fname);
-            nll_putmsg(1, MsgStr);
+    NLLoc_OpenModelGrids();
 
-        }
+    // 20261016 agent - added, timing and run statistics (LOCPERF)
+    if (LocPerf_OpenRun(iSaveNone ? NULL : fn_path_output) < 0) {
+        prun->return_value = EXIT_ERROR_FILEIO;
+        goto error_return;
     }
 
+    // 20261016 agent - added, oct-tree threads (LOCPARALLEL 0 NumOctThreads)
+    if (LocParallelNumThreads == 0 && LocOctParallelNumThreads > 1)
+        OctParallel_Init(LocOctParallelNumThreads, NLLoc_InitThread, NLLoc_CleanupThread, &prun->control_input);
 
-    /* perform location for each observation file */
-
-    for (nObsFile = 0; nObsFile < NumObsFiles; nObsFile++) {
-
-        i_end_of_input = 0;
-
-        nll_putmsg(2, "");
-        snprintf(MsgStr, sizeof(MsgStr), "... Reading observation file %s", fn_loc_obs[nObsFile]);
-        nll_putmsg(1, MsgStr);
-
-        // check if observations are read from file(s)
-        if ((n_obs_lines <= 0)) {
-            /* open observation file */
-            if ((fp_obs = fopen(fn_loc_obs[nObsFile], "r")) == NULL) {
-                nll_puterr2("ERROR: opening observations file",
-                        fn_loc_obs[nObsFile]);
-                continue;
-            } else {
-                NumFilesOpen++;
-            }
-            /* extract info from filename */
-            if ((istat = ExtractFilenameInfo(fn_loc_obs[nObsFile], ftype_obs)) < 0)
-                nll_puterr("WARNING: error extracting information from filename.");
-        }
-
-
-        /* read arrivals and locate event for each  */
-        /*		event (set of observations) in file */
-
-        NumArrivals = 0;
-        while (1) {
-
-            iLocated = 0;
-
-            if (i_end_of_input)
-                break;
-
-            if (NumArrivals != OBS_FILE_SKIP_INPUT_LINE) {
-                nll_putmsg(2, "");
-                sprintf(MsgStr,
-                        "Reading next set of observations (Files open: Tot:%d Buf:%d Hdr:%d  Alloc: %d) ...",
-                        NumFilesOpen, NumGridBufFilesOpen, NumGridHdrFilesOpen, NumAllocations);
-                nll_putmsg(1, MsgStr);
-            }
-
-            // initialize hypo fields that may be modified when reading observations
-            Hypocenter.amp_mag = MAGNITUDE_NULL;
-            Hypocenter.num_amp_mag = 0;
-            Hypocenter.dur_mag = MAGNITUDE_NULL;
-            Hypocenter.num_dur_mag = 0;
-            strcpy(Hypocenter.public_id, "None");
-            Hypocenter.focMech.dipDir = 0.0;
-            Hypocenter.focMech.dipAng = 0.0;
-            Hypocenter.focMech.rake = 0.0;
-            Hypocenter.focMech.misfit = 0.0;
-            Hypocenter.focMech.nObs = -1;
-
-            /* read next set of observations */
-
-            NumArrivalsLocation = 0;
-            if ((NumArrivals = GetObservations(fp_obs,
-                    ftype_obs, fn_loc_grids, Arrival,
-                    &i_end_of_input, &numArrivalsIgnore,
-                    &numArrivalsReject,
-                    MaxNumArrLoc, &Hypocenter,
-                    &maxArrExceeded, &numSArrivalsLocation, 0)) == 0)
-                break;
-
-            if (NumArrivals < 0)
-                goto cleanup;
-
-
-            /* set number of arrivals to be used in location */
-
-            NumArrivalsLocation = NumArrivals - numArrivalsIgnore;
-            NumArrivalsRead = NumArrivals + numArrivalsReject;
-
-            nll_putmsg(2, "");
-            // AJL 20040720 SetOutName(Arrival + 0, fn_path_output, fn_root_out, fn_root_out_last, 1);
-            SetOutName(Arrival + 0, fn_path_output, fn_root_out, fn_root_out_last, iSaveDecSec, iSavePublicID, Hypocenter.public_id, &n_file_root_count);
-            //strcpy(fn_root_out_last, fn_root_out); /* save filename */
-            sprintf(MsgStr,
-                    "... %d observations read, %d will be used for location (%s).",
-                    NumArrivalsRead, NumArrivalsLocation, fn_root_out);
-            nll_putmsg(1, MsgStr);
-
-            //int XX_last = NumAllocations;
+    *preturn_value = EXIT_NORMAL;
 
-            /* sort to get rejected arrivals at end of arrivals array */
+    return (prun);
 
-            if ((istat = SortArrivalsIgnore(Arrival, NumArrivalsRead)) < 0) {
-                nll_puterr("ERROR: sorting arrivals by ignore flag.");
-                goto cleanup;
-            }
 
+error_return:
 
-            /* check for minimum number of arrivals */
+    *preturn_value = NLLoc_Close(prun);
 
-            if (NumArrivalsLocation < MinNumArrLoc) {
-                sprintf(MsgStr,
-                        "WARNING: too few observations to locate (%d available, %d needed), skipping event.", NumArrivalsLocation, MinNumArrLoc);
-                nll_putmsg(1, MsgStr);
-                sprintf(MsgStr,
-                        "INFO: %d observations needed (specified in control file entry LOCMETH).",
-                        MinNumArrLoc);
-                nll_putmsg(2, MsgStr);
-                goto cleanup;
-            }
+    return (NULL);
 
+}
 
-            /* check for minimum number of S arrivals */
 
-            if (numSArrivalsLocation < MinNumSArrLoc) {
-                sprintf(MsgStr,
-                        "WARNING: too few S observations to locate (%d available, %d needed), skipping event.", numSArrivalsLocation, MinNumSArrLoc);
-                nll_putmsg(1, MsgStr);
-                sprintf(MsgStr,
-                        "INFO: %d S observations needed (specified in control file entry LOCMETH).",
-                        MinNumSArrLoc);
-                nll_putmsg(2, MsgStr);
-                goto cleanup;
-            }
+/** function to locate events in observation lines, or in observation files of control statements, with an open location run
+ *
+ * returns EXIT_NORMAL, or error code
+ */
 
+int NLLoc_LocateObs
+(
 
-            /* process arrivals */
+        // calling parameters
+        NLLocRun *prun, // location run opened by NLLoc_Open()
+        char **obs_line_array, // array of observations file lines (set to NULL if obs file name is read from NLLoc control file)
+        int n_obs_lines, // number of elements (obs file lines) in array obs_line_array (set to 0 if obs file name is read from NLLoc control file)
+        int return_locations, // if = 1, return Locations with basic information (HypoDesc* phypo, ArrivalDesc* parrivals, int narrivals, GridDesc* pgrid
+        int return_oct_tree_grid, // if = 1 and LOCSEARCH OCT used, includes location probabily density oct-tree structure in Locations (Tree3D* poctTree)
+        int return_scatter_sample, // if = 1, includes location location scatter sample data in Locations (float* pscatterSample)
 
-            /* add stations to station list */
+        // returned parameters
+        LocNode **ploc_list_head // pointer to pointer to head of list of LocNodes containing Location's for located events (see phaseloclist.h), *ploc_list_head must be initialized to NULL on first call
 
-            // station distribution weighting
-            if (iSetStationDistributionWeights || iSaveNLLocSum || octtreeParams.use_stations_density) {
-                //printf(">>>>>>>>>>> NumStations %d, NumArrivals %d, numArrivalsReject %d\n", NumStations, NumArrivals, numArrivalsReject);
-                int i_check_station_has_XYZ_coords = 0;
-                NumStationPhases = addToStationList(StationPhaseList, NumStationPhases, Arrival, NumArrivalsRead, 0, i_check_station_has_XYZ_coords);
-                if (iSetStationDistributionWeights)
-                    setStationDistributionWeights(StationPhaseList, NumStationPhases, Arrival, NumArrivals);
+        ) {
 
-            }
+    int n;
+    FILE *fp_obs = NULL;
 
-            /* sort to get location arrivals in time order */
+    // GNU C library extensions to support memory streams (function open_memstream).
+    char *bp_memory_stream = NULL;
 
-            if ((istat = SortArrivalsIgnore(Arrival, NumArrivals)) < 0) {
-                nll_puterr("ERROR: sorting arrivals by ignore flag.");
-                goto cleanup;
-            }
-            if ((istat = SortArrivalsTime(Arrival, NumArrivalsLocation)) < 0) {
-                nll_puterr("ERROR: sorting arrivals by time.");
-                goto cleanup;
-            }
+    int return_value = EXIT_NORMAL;
 
 
-            /* construct weight matrix (TV82, eq. 10-9; MEN92, eq. 12) */
+    pNLLocContext = prun->pcontext;
 
-            if ((istat = ConstWeightMatrix(NumArrivalsLocation, Arrival, &Gauss)) < 0) {
-                nll_puterr("ERROR: constructing weight matrix - NLLoc requires non-zero observation or modelisation errors.");
-                /* close time grid files and continue */
-                goto cleanup;
-            }
+    /* read observation lines into memory stream (must read control file first) */
 
+    if (n_obs_lines > 0) {
+#ifdef NLL_MEMSTREAM  // 20261016 agent - changed from _GNU_SOURCE
+        size_t memory_stream_size;
+        FILE *fp_memory_stream = NULL;
+        // read lines into memory memory stream
+        fp_memory_stream = open_memstream(&bp_memory_stream, &memory_stream_size);
+        if (fp_memory_stream == NULL) {
+            nll_puterr("FATAL ERROR: Cannot pass observations file lines as string array to NLLoc function: GNU C library extensions needed to support memory streams (function open_memstream).");
+            return_value = EXIT_ERROR_MEMORY;
+            goto cleanup_return;
+        }
+        for (n = 0; n < n_obs_lines; n++) {
+            fprintf(fp_memory_stream, "%s", obs_line_array[n]);
+            /*DEBUG*///printf("%s", obs_line_array[n]);
+        }
+        fclose(fp_memory_stream);
+        //
+        fp_obs = fmemopen(bp_memory_stream, memory_stream_size, "r");
 
-            /* calculate weighted mean of obs arrival times   */
-            /*	(TV82, eq. A-38) */
+        pNLLocContext->NumObsFiles = 1;
+#else
+        nll_puterr("FATAL ERROR: Cannot pass observations file lines as string array to NLLoc function: GNU C library extensions needed to support memory streams (function open_memstream(); see compiler define _GNU_SOURCE).");
+        return_value = EXIT_ERROR_MEMORY;
+        goto cleanup_return;
+#endif
+    }
 
-            CalcCenteredTimesObs(NumArrivalsLocation, Arrival, &Gauss, &Hypocenter);
 
+    /* perform location for each observation file */
 
-            /* preform location for each grid */
+    if (LocParallelNumThreads > 0) {
+        // 20261016 agent - added parallel location
+        if (LocPrefetchNumEvents > 0)
+            nll_putmsg(1, "INFO: LOCPREFETCH not used with LOCPARALLEL, location threads read next events while other events are located.");
+        if (NLLoc_LocParallel(prun->control_input.fn_control,
+                prun->control_input.param_line_array, prun->control_input.n_param_lines, n_obs_lines > 0 ? fp_obs : NULL, pNLLocContext->NumObsFiles,
+                return_locations, return_oct_tree_grid, return_scatter_sample, ploc_list_head) < 0) {
+            nll_puterr("FATAL ERROR: parallel location.");
+            return_value = EXIT_ERROR_LOCATE;
+            goto cleanup_return;
+        }
+    } else {
+        NLLoc_LocSerial(fp_obs, n_obs_lines, pNLLocContext->NumObsFiles, &prun->control_input,
+                return_locations, return_oct_tree_grid, return_scatter_sample, ploc_list_head);
+    }
 
-            sprintf(MsgStr,
-                    "Locating... (Files open: Tot:%d Buf:%d Hdr:%d  Alloc: %d  3DMem: used:%d/avail:%d/load:%d) ...",
-                    NumFilesOpen, NumGridBufFilesOpen, NumGridHdrFilesOpen, NumAllocations, Num3DGridReadToMemory, GridMemListSize, GridMemListTotalNumElementsAdded);
-            nll_putmsg(1, MsgStr);
 
-            for (ngrid = 0; ngrid < NumLocGrids; ngrid++) {
-                if ((istat = Locate(ngrid, fn_loc_obs[nObsFile], fn_root_out, numArrivalsReject, return_locations, return_oct_tree_grid, return_scatter_sample, ploc_list_head)) < 0) {
-                    if (istat == GRID_NOT_INSIDE)
-                        break;
-                    else {
-                        nll_puterr("ERROR: location failed.");
-                        goto cleanup;
-                    }
-                }
-            }
-            //printf("XXX: Located: NumAllocations %d->%d\n", XX_last, NumAllocations);
-            //XX_last = NumAllocations;
+cleanup_return:
 
-            NumEventsLocated++;
-            if (istat == 0 && ngrid == NumLocGrids)
-                NumLocationsCompleted++;
-            iLocated = 1;
+    if (bp_memory_stream != NULL) {
+        free(bp_memory_stream);
+        bp_memory_stream = NULL;
+    }
 
-cleanup:
-            ;
+    if (return_value != EXIT_NORMAL)
+        prun->return_value = return_value;
 
-            NumEvents++;
-            //n_file_root_count++;
+    return (return_value);
 
-            /* release grid buffer or sheet storage */
-
-            // 20130413 AJL - bug? fix, release memory for all arrivals read
-            //for (narr = 0; narr < NumArrivalsLocation; narr++) {
-            for (narr = 0; narr < NumArrivals; narr++) {
-                //printf("DEBUG: FREE: narr %d Arrival[narr] %s %s n_companion %d n_time_grid %d  flag_ignore %d\n", narr, Arrival[narr].label, Arrival[narr].phase, Arrival[narr].n_companion, Arrival[narr].n_time_grid, Arrival[narr].flag_ignore);
-                // check has opened time grid
-                //if (Arrival[narr].n_time_grid < 0) {
-                //if (Arrival[narr].n_time_grid < 0 && !Arrival[narr].flag_ignore) { // 20160925 AJL - bug fix, ignored arrivals should already have grids freed
-                if (Arrival[narr].n_companion < 0 && Arrival[narr].n_time_grid < 0 && !Arrival[narr].flag_ignore) { // 20170207 AJL - bug fix
-                    DestroyGridArray(&(Arrival[narr].sheetdesc));
-                    FreeGrid(&(Arrival[narr].sheetdesc));
-                    NLL_DestroyGridArray(&(Arrival[narr].gdesc));
-                    NLL_FreeGrid(&(Arrival[narr].gdesc));
-                }
-            }
-            //  20141219 AJL - bug fix, should be outside events/obs loop!
-            //NLL_FreeGridMemory();
+}
 
-            /* close time grid files (opened in function GetObservations) */
 
-            // 20130413 AJL - bug? fix, release memory for all arrivals read
-            //for (narr = 0; narr < NumArrivalsLocation; narr++) {
-            for (narr = 0; narr < NumArrivals; narr++) {
-                CloseGrid3dFile(&(Arrival[narr].gdesc), &(Arrival[narr].fpgrid), &(Arrival[narr].fphdr));
-            }
+/** function to close a location run: write cumulative run statistics, close files and free the location run
+ *
+ * returns return value of location run: EXIT_NORMAL, or error code of first error
+ */
 
-            if (iLocated) {
-                nll_putmsg(1, "");
-                //20231114 AJL //sprintf(MsgStr, "Finished event location, output files: %s.* <%s.grid0.loc.hyp>", fn_root_out, fn_root_out);
-                sprintf(MsgStr, "Finished location: %s.grid0.loc.hyp", fn_root_out);
-                nll_putmsg(0, MsgStr);
-            } else
-                nll_putmsg(0, "");
+int NLLoc_Close(NLLocRun *prun) {
 
-            // 201101013 AJL - Bug fix - this cleanup was done in NLLocLib.c->clean_memory() which puts the cleanup incorrectly inside the Locate loop
-            CleanWeightMatrix();
+    int n;
+    int ngrid;
+    char fname[2*FILENAME_MAX];
+    char targetfname[3*FILENAME_MAX];
+    //char sys_command[2 * FILENAME_MAX];
+    FILE *fpio;
 
-            //printf("XXX: Cleaned: NumAllocations %d->%d\n", XX_last, NumAllocations);
+    int return_value = prun->return_value;
 
-        } /* next event */
 
-        nll_putmsg(2, "");
-        sprintf(MsgStr, "...end of observation file detected.");
-        nll_putmsg(1, MsgStr);
+    pNLLocContext = prun->pcontext;
 
-        if ((n_obs_lines <= 0)) { // observations are read from file(s)
-            fclose(fp_obs);
-            NumFilesOpen--;
-        } else { // observation lines are read from memory stream (20101110 AJL)
-            // AJL 20101110 - Bug fix for function version
-            fclose(fp_obs);
-        }
+    OctParallel_Free();
 
-    } /* next observation file */
+    if (return_value != EXIT_NORMAL)
+        goto cleanup_return;
 
     nll_putmsg(2, "");
     sprintf(MsgStr,
             "No more observation files.  %d events read,  %d events located,  %d locations completed.",
-            NumEvents, NumEventsLocated, NumLocationsCompleted);
+            pNLLocContext->NumEvents, pNLLocContext->NumEventsLocated, pNLLocContext->NumLocationsCompleted);
     nll_putmsg(1, MsgStr);
     nll_putmsg(2, "");
 
@@ -719,21 +1636,24 @@ cleanup:
     }
 
 
-    // clean up before leaving NLLoc function
+    // clean up before leaving location run
 cleanup_return:
 
     //  20141219 AJL - bug? fix, moved here from inside events/obs loop!
-    NLL_FreeGridMemory();
+    NLL_GridFilePoolClose(); // 20261016 agent - added, grid buffer files of this thread must be closed before grid memory
+    LocPerf_CloseRun(); // 20261016 agent - added
+    NLL_GridMemoryPrintStats(); // 20261016 agent - added
+    NLL_GridMemoryClose();
 
     if (!iSaveNone)
         CloseSummaryFiles();
 
-    if (fp_model_grid_P != NULL) {
-        CloseGrid3dFile(NULL, &fp_model_grid_P, &fp_model_hdr_P);
-    }
-    if (fp_model_grid_S != NULL) {
-        CloseGrid3dFile(NULL, &fp_model_grid_S, &fp_model_hdr_S);
-    }
+    NLLoc_CloseModelGrids();
+    freeOctArena(octArena); // 20261016 agent - added
+    octArena = NULL;
+    TTCache_Free(); // 20261016 agent - added
+    FreeCompressedGridCache(); // 20261016 agent - added
+    FreeSources(); // 20261017 agent - added
 
     // AEH/AJL 20080709
     if (Arrival != NULL) {
@@ -756,31 +1676,66 @@ cleanup_return:
         free_surface(model_surface + n);
     }
 
-    if (bp_memory_stream != NULL) {
-        free(bp_memory_stream);
-        bp_memory_stream = NULL;
-    }
-
     // clean up memory allocations in read_nll_control_json
-    if (is_nll_control_json_file) {
-        for (int i = 0; i < n_param_lines; i++) {
-            if (param_line_array[i] != NULL) {
-                free(param_line_array[i]);
+    if (prun->is_nll_control_json_file) {
+        for (int i = 0; i < prun->control_input.n_param_lines; i++) {
+            if (prun->control_input.param_line_array[i] != NULL) {
+                free(prun->control_input.param_line_array[i]);
             }
         }
-        n_param_lines = 0;
-        if (param_line_array != NULL) {
-            free(param_line_array);
+        prun->control_input.n_param_lines = 0;
+        if (prun->control_input.param_line_array != NULL) {
+            free(prun->control_input.param_line_array);
         }
-        param_line_array = NULL;
+        prun->control_input.param_line_array = NULL;
     }
 
+    NLLocContext_Free(pNLLocContext);
+    pNLLocContext = prun->pcontext_caller;
+    free(prun);
+
     return (return_value);
 
 }
 
 
 
+/** function to perform global search event locations */
+
+int NLLoc
+(
+
+        // calling parameters
+        char *pid_main, // CUSTOM_ETH only: snap id
+        char *fn_control_main, // NLLoc control file: full path and name (set to NULL if *param_line_array not NULL)
+        char **param_line_array, // array of NLLoc control file lines (set to NULL if fn_control_main not NULL)
+        int n_param_lines, // number of elements (parameter lines) in array param_line_array (use 0 if fn_control_main not NULL)
+        char **obs_line_array, // array of observations file lines (set to NULL if obs file name is read from NLLoc control file)
+        int n_obs_lines, // number of elements (obs file lines) in array obs_line_array (set to 0 if obs file name is read from NLLoc control file)
+        int return_locations, // if = 1, return Locations with basic information (HypoDesc* phypo, ArrivalDesc* parrivals, int narrivals, GridDesc* pgrid
+        int return_oct_tree_grid, // if = 1 and LOCSEARCH OCT used, includes location probabily density oct-tree structure in Locations (Tree3D* poctTree)
+        int return_scatter_sample, // if = 1, includes location location scatter sample data in Locations (float* pscatterSample)
+
+        // returned parameters
+        LocNode **ploc_list_head // pointer to pointer to head of list of LocNodes containing Location's for located events (see phaseloclist.h), *ploc_list_head must be initialized to NULL on first call to NLLoc()
+
+        ) {
+
+    int return_value;
+    NLLocRun *prun;
+
+
+    if ((prun = NLLoc_Open(pid_main, fn_control_main, param_line_array, n_param_lines, 0, &return_value)) == NULL)
+        return (return_value);
+
+    NLLoc_LocateObs(prun, obs_line_array, n_obs_lines, return_locations, return_oct_tree_grid, return_scatter_sample, ploc_list_head);
+
+    return (NLLoc_Close(prun));
+
+}
+
+
+
 
 
 
@@ -104,6 +104,11 @@ e-mail: anthony@alomax.net  web: http://www.alomax.net
 
 
 
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/resource.h>
+
 #include "GridLib.h"
 #include "ran1/ran1.h"
 #include "velmod.h"
@@ -111,6 +116,7 @@ e-mail: anthony@alomax.net  web: http://www.alomax.net
 #include "calc_crust_corr.h"
 #include "phaseloclist.h"
 #include "otime_limit.h"
+#include "edt_kernel.h"
 #include "NLLocLib.h"
 #include "json_io.h"
 
@@ -121,149 +127,236 @@ e-mail: anthony@alomax.net  web: http://www.alomax.net
 
 // define globals
 
-char f_outpath[FILENAME_MAX];
-GaussLocParams Gauss;
-Gauss2LocParams Gauss2;
-int iUseGauss2;
-ScatterParams Scatter;
-int NumEvents;
-int NumEventsLocated;
-int NumLocationsCompleted;
-int NumObsFiles;
-int NumArrivalsRead;
-int NumArrivalsLocation;
-char fn_loc_obs[MAX_NUM_OBS_FILES][FILENAME_MAX];
-char ftype_obs[MAXLINE];
-char fn_loc_grids[FILENAME_MAX], fn_path_output[FILENAME_MAX];
-int iSwapBytesOnInput;
-FILE *fp_model_grid_P;
-FILE *fp_model_hdr_P;
-GridDesc model_grid_P;
-FILE *fp_model_grid_S;
-FILE *fp_model_hdr_S;
-GridDesc model_grid_S;
-int SearchType;
-SearchPdfGridDesc SearchPrior;
-int iUseSearchPrior;
-SearchPdfGridDesc SearchPosterior;
-int iUseSearchPosterior;
-int LocMethod;
-int EDT_use_otime_weight;
-int EDT_otime_weight_active;
-double DistStaGridMin;
-double DistStaGridMax;
-int MinNumArrLoc;
-int MaxNumArrLoc;
-int MinNumSArrLoc;
-double VpVsRatio;
-char LocSignature[MAXLINE_LONG];
-GridDesc LocGrid[MAX_NUM_LOCATION_GRIDS];
-int NumLocGrids;
-int LocGridSave[MAX_NUM_LOCATION_GRIDS]; /* !should be in GridDesc */
+NLL_THREAD_LOCAL char f_outpath[FILENAME_MAX];
+NLL_THREAD_LOCAL GaussLocParams Gauss;
+NLL_THREAD_LOCAL Gauss2LocParams Gauss2;
+NLL_THREAD_LOCAL int iUseGauss2;
+NLL_THREAD_LOCAL ScatterParams Scatter;
+
+// location run context
+// 20261016 agent - added, default context is used by programs that do not call NLLoc()
+static NLLocContext NLLocContextDefault = {.commit_mutex = PTHREAD_MUTEX_INITIALIZER, .commit_cond = PTHREAD_COND_INITIALIZER};
+NLL_THREAD_LOCAL NLLocContext *pNLLocContext = &NLLocContextDefault;
+
+/** create a new, empty location run context */
+
+NLLocContext* NLLocContext_New() {
+
+    NLLocContext* pcontext = calloc(1, sizeof (NLLocContext));
+    if (pcontext == NULL) {
+        nll_puterr("ERROR: allocating memory for location run context.");
+        return (NULL);
+    }
+    pthread_mutex_init(&(pcontext->commit_mutex), NULL);
+    pthread_cond_init(&(pcontext->commit_cond), NULL);
+
+    return (pcontext);
+
+}
+
+/** free a location run context created with NLLocContext_New() */
+
+void NLLocContext_Free(NLLocContext* pcontext) {
+
+    if (pcontext == NULL)
+        return;
+
+    pthread_mutex_destroy(&(pcontext->commit_mutex));
+    pthread_cond_destroy(&(pcontext->commit_cond));
+    free(pcontext->fn_loc_obs);
+    free(pcontext);
+
+}
+
+/* run globals, each is a field of the location run context of the current thread */
+// 20261017 agent - moved here from NLLocLib.h, names are private to NLLocLib.c
+#define NumEvents (pNLLocContext->NumEvents)
+#define NumEventsLocated (pNLLocContext->NumEventsLocated)
+#define NumLocationsCompleted (pNLLocContext->NumLocationsCompleted)
+#define NumObsFiles (pNLLocContext->NumObsFiles)
+#define fn_loc_obs (pNLLocContext->fn_loc_obs)
+#define pSumFileHypNLLoc (pNLLocContext->pSumFileHypNLLoc)
+#define pSumFileHypo71 (pNLLocContext->pSumFileHypo71)
+#define pSumFileHypoEll (pNLLocContext->pSumFileHypoEll)
+#define pSumFileHypoInv (pNLLocContext->pSumFileHypoInv)
+#define pSumFileHypoInvY2K (pNLLocContext->pSumFileHypoInvY2K)
+#define pSumFileAlberto4 (pNLLocContext->pSumFileAlberto4)
+#define pSumFileFmamp (pNLLocContext->pSumFileFmamp)
+#define iWriteHypHeader (pNLLocContext->iWriteHypHeader)
+#define EventTime (pNLLocContext->EventTime)
+#define EventID (pNLLocContext->EventID)
+#define Component (pNLLocContext->Component)
+#define NumCompDesc (pNLLocContext->NumCompDesc)
+#define LocAlias (pNLLocContext->LocAlias)
+#define NumLocAlias (pNLLocContext->NumLocAlias)
+#define LocExclude (pNLLocContext->LocExclude)
+#define NumLocExclude (pNLLocContext->NumLocExclude)
+#define LocInclude (pNLLocContext->LocInclude)
+#define NumLocInclude (pNLLocContext->NumLocInclude)
+#define TimeDelay (pNLLocContext->TimeDelay)
+#define NumTimeDelays (pNLLocContext->NumTimeDelays)
+#define hashtab (pNLLocContext->hashtab)
+
+NLL_THREAD_LOCAL int LocParallelNumThreads;
+NLL_THREAD_LOCAL int LocOctParallelNumThreads;
+NLL_THREAD_LOCAL int LocPrefetchNumEvents;
+NLL_THREAD_LOCAL int LocPerfMode;
+NLL_THREAD_LOCAL LocPerfStats LocPerfEvent;
+NLL_THREAD_LOCAL int NumArrivalsRead;
+NLL_THREAD_LOCAL int NumArrivalsLocation;
+NLL_THREAD_LOCAL char ftype_obs[MAXLINE];
+NLL_THREAD_LOCAL char fn_loc_grids[FILENAME_MAX], fn_path_output[FILENAME_MAX];
+NLL_THREAD_LOCAL int iSwapBytesOnInput;
+NLL_THREAD_LOCAL int iMapGridsOnInput;
+NLL_THREAD_LOCAL int iTiledGridsInMemory;
+NLL_THREAD_LOCAL int iLocGridROI;
+NLL_THREAD_LOCAL double LocGridROIMargin;
+NLL_THREAD_LOCAL double LocGridROIMin[3], LocGridROIMax[3];
+NLL_THREAD_LOCAL int iPrefetchGridsOnInput;
+NLL_THREAD_LOCAL unsigned long PrefetchGridsMinLastUsed;
+NLL_THREAD_LOCAL FILE *fp_model_grid_P;
+NLL_THREAD_LOCAL FILE *fp_model_hdr_P;
+NLL_THREAD_LOCAL GridDesc model_grid_P;
+NLL_THREAD_LOCAL FILE *fp_model_grid_S;
+NLL_THREAD_LOCAL FILE *fp_model_hdr_S;
+NLL_THREAD_LOCAL GridDesc model_grid_S;
+NLL_THREAD_LOCAL int SearchType;
+NLL_THREAD_LOCAL SearchPdfGridDesc SearchPrior;
+NLL_THREAD_LOCAL int iUseSearchPrior;
+NLL_THREAD_LOCAL SearchPdfGridDesc SearchPosterior;
+NLL_THREAD_LOCAL int iUseSearchPosterior;
+NLL_THREAD_LOCAL int LocMethod;
+NLL_THREAD_LOCAL int EDT_use_otime_weight;
+NLL_THREAD_LOCAL int EDT_otime_weight_active;
+NLL_THREAD_LOCAL int EDT_kernel;
+NLL_THREAD_LOCAL double DistStaGridMin;
+NLL_THREAD_LOCAL double DistStaGridMax;
+NLL_THREAD_LOCAL int MinNumArrLoc;
+NLL_THREAD_LOCAL int MaxNumArrLoc;
+NLL_THREAD_LOCAL int MinNumSArrLoc;
+NLL_THREAD_LOCAL double VpVsRatio;
+NLL_THREAD_LOCAL char LocSignature[MAXLINE_LONG];
+NLL_THREAD_LOCAL GridDesc LocGrid[MAX_NUM_LOCATION_GRIDS];
+NLL_THREAD_LOCAL int NumLocGrids;
+NLL_THREAD_LOCAL int LocGridSave[MAX_NUM_LOCATION_GRIDS]; /* !should be in GridDesc */
 //int Num3DGridReadToMemory, MaxNum3DGridMemory;
-int iWriteHypHeader[MAX_NUM_LOCATION_GRIDS];
-char HypoInverseArchiveSumHdr[MAXLINE_LONG];
-int iSaveNLLocEvent, iSaveNLLocSum, iSaveNLLocOctree,
+NLL_THREAD_LOCAL char HypoInverseArchiveSumHdr[MAXLINE_LONG];
+NLL_THREAD_LOCAL int iSaveNLLocEvent, iSaveNLLocSum, iSaveNLLocOctree,
     iSaveHypo71Event, iSaveHypo71Sum,
     iSaveHypoEllEvent, iSaveHypoEllSum,
     iSaveHypoInvSum, iSaveHypoInvY2KArc, iSaveAlberto4Sum, iSaveFmamp,
     iSaveSnapSum, iCalcSedOrigin, iSaveDecSec, iSavePublicID, iSaveNone;
-int iSaveNLLocExpectation;
-int iSaveNLLocEvent_JSON;
-int iUseArrivalPriorWeights;
-int iSetStationDistributionWeights;
-double stationDistributionWeightCutoff;
-double AveInterStationDistance;
-int NumForceOctTreeStaDenWt;
-int iRejectDuplicateArrivals;
-EventTimeExtract EventTime;
-long int EventID;
-int NumMagnitudeMethods;
-MagDesc Magnitude[MAX_NUM_MAG_METHODS];
-CompDesc Component[MAX_NUM_COMP_DESC];
-int NumCompDesc;
-AliasDesc LocAlias[MAX_NUM_LOC_ALIAS];
-int NumLocAlias;
-ExcludeDesc LocExclude[MAX_NUM_LOC_EXCLUDE];
-int NumLocExclude;
-ExcludeDesc LocInclude[MAX_NUM_LOC_INCLUDE];
-int NumLocInclude;
-TimeDelayDesc TimeDelay[MAX_NUM_STA_DELAYS];
-int NumTimeDelays;
-char TimeDelaySurfacePhase[MAX_SURFACES][PHASE_LABEL_LEN];
-double TimeDelaySurfaceMultiplier[MAX_SURFACES];
-int NumTimeDelaySurface;
-int ApplyElevCorrFlag;
-double ElevCorrVelP;
-double ElevCorrVelS;
-int ApplyCrustElevCorrFlag;
-double MinDistCrustElevCorr;
-struct surface *topo_surface;
-int topo_surface_index; // topo surface index is velmod.h.MAX_SURFACES-1 so as not to interferce with any TimeDelaySurfaces read in
-int NumStationPhases;
-SourceDesc StationPhaseList[X_MAX_NUM_ARRIVALS];
-int FixOriginTimeFlag;
-WalkParams Metrop; /* walk parameters */
-int MetNumSamples; /* number of samples to evaluate */
-int MetLearn; /* learning length in number of samples for calculation of sample statistics */
-int MetEquil; /* number of samples to equil before using */
-int MetStartSave; /* number of sample to begin saving */
-int MetSkip; /* number of samples to wait between saves */
-double MetStepInit; /* initial step size (km) (< 0.0 for auto) */
-double MetStepMin; /* minimum step size (km) */
-double MetStepMax; /* maximum step size (km) (NLDiffLoc) */
-double MetStepFact; /* step size factor */
-double MetProbMin; /* minimum likelihood necessary after learn */
-double MetVelocity; /* velocity for conversion of distance to time */
-double MetInititalTemperature; /* initial temperature */
-int MetUse; /* number of samples to use = MetNumSamples - MetEquil */
-OcttreeParams octtreeParams; /* Octtree parameters */
-Tree3D* octTree; /* Octtree */
-ResultTreeNode* resultTreeRoot; /* Octtree likelihood*volume results tree root node */
+NLL_THREAD_LOCAL int iSaveNLLocExpectation;
+NLL_THREAD_LOCAL int iSaveNLLocEvent_JSON;
+NLL_THREAD_LOCAL int iUseArrivalPriorWeights;
+NLL_THREAD_LOCAL int iSetStationDistributionWeights;
+NLL_THREAD_LOCAL double stationDistributionWeightCutoff;
+NLL_THREAD_LOCAL double AveInterStationDistance;
+NLL_THREAD_LOCAL int NumForceOctTreeStaDenWt;
+NLL_THREAD_LOCAL int iRejectDuplicateArrivals;
+NLL_THREAD_LOCAL int NumMagnitudeMethods;
+NLL_THREAD_LOCAL MagDesc Magnitude[MAX_NUM_MAG_METHODS];
+NLL_THREAD_LOCAL char TimeDelaySurfacePhase[MAX_SURFACES][PHASE_LABEL_LEN];
+NLL_THREAD_LOCAL double TimeDelaySurfaceMultiplier[MAX_SURFACES];
+NLL_THREAD_LOCAL int NumTimeDelaySurface;
+NLL_THREAD_LOCAL int ApplyElevCorrFlag;
+NLL_THREAD_LOCAL double ElevCorrVelP;
+NLL_THREAD_LOCAL double ElevCorrVelS;
+NLL_THREAD_LOCAL int ApplyCrustElevCorrFlag;
+NLL_THREAD_LOCAL double MinDistCrustElevCorr;
+NLL_THREAD_LOCAL struct surface *topo_surface;
+NLL_THREAD_LOCAL int topo_surface_index; // topo surface index is velmod.h.MAX_SURFACES-1 so as not to interferce with any TimeDelaySurfaces read in
+NLL_THREAD_LOCAL int NumStationPhases;
+NLL_THREAD_LOCAL SourceDesc StationPhaseList[X_MAX_NUM_ARRIVALS];
+NLL_THREAD_LOCAL int FixOriginTimeFlag;
+NLL_THREAD_LOCAL WalkParams Metrop; /* walk parameters */
+NLL_THREAD_LOCAL int MetNumSamples; /* number of samples to evaluate */
+NLL_THREAD_LOCAL int MetLearn; /* learning length in number of samples for calculation of sample statistics */
+NLL_THREAD_LOCAL int MetEquil; /* number of samples to equil before using */
+NLL_THREAD_LOCAL int MetStartSave; /* number of sample to begin saving */
+NLL_THREAD_LOCAL int MetSkip; /* number of samples to wait between saves */
+NLL_THREAD_LOCAL double MetStepInit; /* initial step size (km) (< 0.0 for auto) */
+NLL_THREAD_LOCAL double MetStepMin; /* minimum step size (km) */
+NLL_THREAD_LOCAL double MetStepMax; /* maximum step size (km) (NLDiffLoc) */
+NLL_THREAD_LOCAL double MetStepFact; /* step size factor */
+NLL_THREAD_LOCAL double MetProbMin; /* minimum likelihood necessary after learn */
+NLL_THREAD_LOCAL double MetVelocity; /* velocity for conversion of distance to time */
+NLL_THREAD_LOCAL double MetInititalTemperature; /* initial temperature */
+NLL_THREAD_LOCAL int MetUse; /* number of samples to use = MetNumSamples - MetEquil */
+NLL_THREAD_LOCAL int MetNumChains; /* number of independent chains */ // 20261016 agent - added
+NLL_THREAD_LOCAL double MetChainRhatMax; /* stop walk when Gelman-Rubin statistic of chains < MetChainRhatMax, <= 1.0 = no check */ // 20261016 agent - added
+NLL_THREAD_LOCAL OcttreeParams octtreeParams; /* Octtree parameters */
+NLL_THREAD_LOCAL Tree3D* octTree; /* Octtree */
+NLL_THREAD_LOCAL ResultTreeNode* resultTreeRoot; /* Octtree likelihood*volume results tree root node */
+NLL_THREAD_LOCAL ResultQueue* resultQueue; /* Octtree search priority queue of results tree leaf nodes */ // 20261016 agent - added
+NLL_THREAD_LOCAL OctArena* octArena; /* Octtree search node arena, kept between events */ // 20261016 agent - added
 //ResultTreeNode* resultTreeLikelihoodRoot;	/* Octtree likelihood results tree root node */
-int angleMode; /* angle mode - ANGLE_MODE_NO, ANGLE_MODE_YES */
-int iAngleQualityMin; /* minimum quality for angles to be used */
-OtimeLimit** OtimeLimitList;
-int NumOtimeLimit;
-StaStatNode *hashtab[MAX_NUM_LOCATION_GRIDS][HASHSIZE];
-int NRdgs_Min;
-double RMS_Max, Gap_Max;
-double P_ResidualMax;
-double S_ResidualMax;
-double Ell_Len3_Max;
-double Hypo_Depth_Min;
-double Hypo_Depth_Max;
-double Hypo_Dist_Max;
+NLL_THREAD_LOCAL int angleMode; /* angle mode - ANGLE_MODE_NO, ANGLE_MODE_YES */
+NLL_THREAD_LOCAL int iAngleQualityMin; /* minimum quality for angles to be used */
+NLL_THREAD_LOCAL OtimeLimit** OtimeLimitList;
+NLL_THREAD_LOCAL int NumOtimeLimit;
+NLL_THREAD_LOCAL int NRdgs_Min;
+NLL_THREAD_LOCAL double RMS_Max, Gap_Max;
+NLL_THREAD_LOCAL double P_ResidualMax;
+NLL_THREAD_LOCAL double S_ResidualMax;
+NLL_THREAD_LOCAL double Ell_Len3_Max;
+NLL_THREAD_LOCAL double Hypo_Depth_Min;
+NLL_THREAD_LOCAL double Hypo_Depth_Max;
+NLL_THREAD_LOCAL double Hypo_Dist_Max;
 //char snap_pid[255];
 
-FILE *pSumFileHypNLLoc[MAX_NUM_LOCATION_GRIDS];
-FILE *pSumFileHypo71[MAX_NUM_LOCATION_GRIDS];
-FILE *pSumFileHypoEll[MAX_NUM_LOCATION_GRIDS];
-FILE *pSumFileHypoInv[MAX_NUM_LOCATION_GRIDS];
-FILE *pSumFileHypoInvY2K[MAX_NUM_LOCATION_GRIDS];
-FILE *pSumFileAlberto4[MAX_NUM_LOCATION_GRIDS];
-FILE *pSumFileFmamp[MAX_NUM_LOCATION_GRIDS];
 
 
 // AJL - 20080710 (valgrind)
 /* locally allocated memory which must be cleaned up */
 
 int clean_memory(int istat);
+static void OctEval_Free();
+static void TTColumn_Free();
+static void MetChain_Free();
+static int MetChain_NumScatterMax();
 
 // EDT_OT_WT_ML allocations
 #define EDT_OT_WT_FLOOR log(0.00001)
-double *ot_ml_arrival = NULL; // array of ot estimate for each arrival
-double *ot_ml_arrival_edt_sum = NULL; // array of weight of ot estimate for each arrival
-int isize_ot_ml_array = 0;
+NLL_THREAD_LOCAL double *ot_ml_arrival = NULL; // array of ot estimate for each arrival
+NLL_THREAD_LOCAL double *ot_ml_arrival_edt_sum = NULL; // array of weight of ot estimate for each arrival
+NLL_THREAD_LOCAL int isize_ot_ml_array = 0;
+
+// EDT_KERNEL_DOUBLE allocations
+// 20261016 agent - added
+NLL_THREAD_LOCAL double *edt_work = NULL; // per-arrival work arrays for double EDT kernel
+NLL_THREAD_LOCAL int isize_edt_work = 0;
 
 // ConstWeightMatrix() allocations
-MatrixDouble wt_matrix = NULL;
-MatrixDouble edt_matrix = NULL;
-int last_matrix_alloc_size = -1;
+NLL_THREAD_LOCAL MatrixDouble wt_matrix = NULL;
+NLL_THREAD_LOCAL MatrixDouble edt_matrix = NULL;
+NLL_THREAD_LOCAL int last_matrix_alloc_size = -1;
 
-/** function to perform grid search location */
+// 20261016 agent - added, SoA hot arrival table for misfit kernels
+static NLL_THREAD_LOCAL ArrivalHotTable ArrivalHot;
+
+/** function to perform grid search location
+ *
+ * 20261017 agent - pcontext is the location run context of the event, it is bound to the calling thread
+ *    during the location so that concurrent NLLoc() runs in different threads each use their own context
+ */
+
+static int locate(NLLocContext *pcontext, int ngrid, char* fn_obs, char* fn_root_out, int numArrivalsReject, int return_locations, int return_oct_tree_grid, int return_scatter_sample, LocNode **ploc_list_head);
+
+int Locate(NLLocContext *pcontext, int ngrid, char* fn_obs, char* fn_root_out, int numArrivalsReject, int return_locations, int return_oct_tree_grid, int return_scatter_sample, LocNode **ploc_list_head) {
+
+    int istat;
+    NLLocContext *pcontext_caller = pNLLocContext;
+
+    pNLLocContext = pcontext;
+    istat = locate(pcontext, ngrid, fn_obs, fn_root_out, numArrivalsReject, return_locations, return_oct_tree_grid, return_scatter_sample, ploc_list_head);
+    pNLLocContext = pcontext_caller;
+
+    return (istat);
 
-int Locate(int ngrid, char* fn_loc_obs, char* fn_root_out, int numArrivalsReject, int return_locations, int return_oct_tree_grid, int return_scatter_sample, LocNode **ploc_list_head) {
+}
+
+static int locate(NLLocContext *pcontext, int ngrid, char* fn_obs, char* fn_root_out, int numArrivalsReject, int return_locations, int return_oct_tree_grid, int return_scatter_sample, LocNode **ploc_list_head) {
 
     int istat, n, narr;
     char fnout[4 * MAXLINE];
@@ -374,7 +467,7 @@ int Locate(int ngrid, char* fn_loc_obs, char* fn_root_out, int numArrivalsReject
                 MetLearn + MetEquil, MetStepInit);
 
         /* allocate scatter array for saved samples */
-        iSizeOfFdata = (1 + MetUse / MetSkip) * 4 * sizeof (float);
+        iSizeOfFdata = MetChain_NumScatterMax() * 4 * sizeof (float); // 20261016 agent - scatter of all Metropolis chains
         if ((fdata = (float *) malloc(iSizeOfFdata)) == NULL) {
             nll_puterr("ERROR: creating array for scatter samples.");
             return (clean_memory(EXIT_ERROR_LOCATE));
@@ -403,7 +496,7 @@ int Locate(int ngrid, char* fn_loc_obs, char* fn_root_out, int numArrivalsReject
         // initialize memory/arrays for regular, initial oct-tree search grid
         // this is an x, y, z array of oct-tree root nodes,
         // a true oct-tree is created at each of these roots
-        octTree = InitializeOcttree(LocGrid + ngrid, &octtreeParams);
+        octTree = InitializeOcttree(LocGrid + ngrid, &octtreeParams, !return_oct_tree_grid);
         //NumAllocations++;
 
         // allocate scatter array for saved samples
@@ -448,8 +541,16 @@ int Locate(int ngrid, char* fn_loc_obs, char* fn_root_out, int numArrivalsReject
     }
 
 
+    /* build hot arrival table for misfit kernels */
+    // 20261016 agent - added
+    if (ArrivalHot_Build(Arrival, NumArrivals) < 0)
+        return (clean_memory(EXIT_ERROR_MEMORY));
+
+
     /* do search */
 
+    double time_perf = LocPerf_Time(); // 20261016 agent - added
+
     if (SearchType == SEARCH_GRID) {
 
         /* grid-search location (fill location grid) */
@@ -475,7 +576,7 @@ int Locate(int ngrid, char* fn_loc_obs, char* fn_root_out, int numArrivalsReject
 
         /* do Octree location (importance sampling) */
         if ((Hypocenter.nScatterSaved =
-                LocOctree(ngrid, NumArrivals, NumArrivalsLocation,
+                LocOctree(pcontext, ngrid, NumArrivals, NumArrivalsLocation,
                 Arrival, LocGrid + ngrid,
                 &Gauss, &Hypocenter, &octtreeParams,
                 octTree, fdata, &oct_node_value_max, &oct_tree_integral)) < 0) {
@@ -485,6 +586,8 @@ int Locate(int ngrid, char* fn_loc_obs, char* fn_root_out, int numArrivalsReject
 
     }
 
+    time_perf = LocPerf_Stage(PERF_SEARCH, time_perf); // 20261016 agent - added
+
     /* 20170911 moved below
 
         // clean up dates, calculate rms
@@ -752,6 +855,8 @@ int Locate(int ngrid, char* fn_loc_obs, char* fn_root_out, int numArrivalsReject
 
     /* search type dependent results saving */
 
+    time_perf = LocPerf_Stage(PERF_STATS, time_perf); // 20261016 agent - added
+
     if (SearchType == SEARCH_GRID) {
 
         /* save location grid to disk */
@@ -777,6 +882,11 @@ int Locate(int ngrid, char* fn_loc_obs, char* fn_root_out, int numArrivalsReject
 
     /* display and save minimum misfit location to file */
 
+    // 20261016 agent - LOCPARALLEL, location saving and accumulation of run statistics done in event input order
+    LocPerf_Stage(PERF_OUTPUT, time_perf);
+    LocParallel_BeginCommit();
+    time_perf = LocPerf_Time(); // wait for commit turn is not counted
+
     if (LocGridSave[ngrid]) {
         /* calculate magnitudes */
         // 20180907 AJL - following 4 lines moved to NLLoc() since may be modified when reading observations
@@ -792,7 +902,10 @@ int Locate(int ngrid, char* fn_loc_obs, char* fn_root_out, int numArrivalsReject
         /* calculate estimated VpVs ratio */
         CalculateVpVsEstimate(&Hypocenter, Arrival, NumArrivals);
         /* save location */
-        if ((istat = SaveLocation(&Hypocenter, ngrid, fn_loc_obs, fnout, numArrivalsReject, "grid", 1, &Gauss)) < 0) {
+        LocPerf_SetHypoLine(); // 20261016 agent - added
+        istat = SaveLocation(&Hypocenter, ngrid, fn_obs, fnout, numArrivalsReject, "grid", 1, &Gauss);
+        HypoPerfLine[0] = '\0';
+        if (istat < 0) {
             nll_puterr("ERROR: saving location.");
             return (clean_memory(istat));
         }
@@ -823,6 +936,7 @@ int Locate(int ngrid, char* fn_loc_obs, char* fn_root_out, int numArrivalsReject
         }
         //printf("Hypo: %s %f %d %d %f %f\n", Hypocenter.locStat, Hypocenter.rms, Hypocenter.nreadings, Hypocenter.gap, Hypocenter.ellipsoid.len3, Hypocenter.z);
     }
+    LocPerf_Stage(PERF_OUTPUT, time_perf); // 20261016 agent - added
 
 
 
@@ -869,7 +983,12 @@ int Locate(int ngrid, char* fn_loc_obs, char* fn_root_out, int numArrivalsReject
     } else if (SearchType == SEARCH_OCTTREE) {
 
         // free results tree - IMPORTANT!
-        freeResultTree(resultTreeRoot);
+        // 20261016 agent - results tree nodes allocated from octArena are released by resetOctArena() in InitializeOcttree()
+        if (octArena == NULL)
+            freeResultTree(resultTreeRoot);
+        resultTreeRoot = NULL;
+        freeResultQueue(resultQueue);
+        resultQueue = NULL;
 
         /* free oct-tree memory */
         if (!return_oct_tree_grid) {
@@ -976,10 +1095,116 @@ int clean_memory(int istat) {
     ot_ml_arrival_edt_sum = NULL;
     isize_ot_ml_array = 0;
 
+    // 20261016 agent - added
+    ArrivalHot_Free();
+    if (edt_work != NULL)
+        free(edt_work);
+    edt_work = NULL;
+    isize_edt_work = 0;
+    OctEval_Free();
+    MetChain_Free();
+
     return (istat);
 
 }
 
+/** function to build the hot arrival table from the per-event values of an ArrivalDesc array */
+
+int ArrivalHot_Build(ArrivalDesc *arrival, int num_arrivals) {
+
+    int narr;
+    ArrivalHotTable *hot = &ArrivalHot;
+
+    if (hot->num_alloc < num_arrivals) {
+        ArrivalHot_Free();
+        hot->obs_centered = (double *) calloc(num_arrivals, sizeof (double));
+        hot->obs_time = (long double *) calloc(num_arrivals, sizeof (long double));
+        hot->error = (double *) calloc(num_arrivals, sizeof (double));
+        hot->amplitude = (double *) calloc(num_arrivals, sizeof (double));
+        hot->station_weight = (double *) calloc(num_arrivals, sizeof (double));
+        hot->apriori_weight = (double *) calloc(num_arrivals, sizeof (double));
+        hot->abs_time = (int *) calloc(num_arrivals, sizeof (int));
+        hot->pred_travel_time = (double *) calloc(num_arrivals, sizeof (double));
+        hot->pred_centered = (double *) calloc(num_arrivals, sizeof (double));
+        hot->weight = (double *) calloc(num_arrivals, sizeof (double));
+        if (hot->obs_centered == NULL || hot->obs_time == NULL || hot->error == NULL || hot->amplitude == NULL
+                || hot->station_weight == NULL || hot->apriori_weight == NULL || hot->abs_time == NULL
+                || hot->pred_travel_time == NULL || hot->pred_centered == NULL || hot->weight == NULL) {
+            nll_puterr("ERROR: allocating hot arrival table.");
+            ArrivalHot_Free();
+            return (-1);
+        }
+        hot->num_alloc = num_arrivals;
+    }
+
+    for (narr = 0; narr < num_arrivals; narr++) {
+        hot->obs_centered[narr] = arrival[narr].obs_centered;
+        hot->obs_time[narr] = arrival[narr].obs_time;
+        hot->error[narr] = arrival[narr].error;
+        hot->amplitude[narr] = arrival[narr].amplitude;
+        hot->station_weight[narr] = arrival[narr].station_weight;
+        hot->apriori_weight[narr] = arrival[narr].apriori_weight;
+        hot->abs_time[narr] = arrival[narr].abs_time;
+        hot->pred_travel_time[narr] = arrival[narr].pred_travel_time;
+        hot->pred_centered[narr] = arrival[narr].pred_centered;
+        hot->weight[narr] = arrival[narr].weight;
+    }
+    hot->arrival = arrival;
+    hot->num_arrivals = num_arrivals;
+
+    return (0);
+
+}
+
+/** function to get the hot arrival table for an ArrivalDesc array, (re)building the table if it was built for other arrivals */
+
+ArrivalHotTable* ArrivalHot_Get(ArrivalDesc *arrival, int num_arrivals) {
+
+    if (ArrivalHot.arrival != arrival || ArrivalHot.num_arrivals < num_arrivals) {
+        if (ArrivalHot_Build(arrival, num_arrivals) < 0)
+            return (NULL);
+    }
+
+    return (&ArrivalHot);
+
+}
+
+/** function to reload hot arrival table predicted travel times after they are set directly in ArrivalDesc */
+
+void ArrivalHot_LoadPred(ArrivalDesc *arrival, int num_arrivals) {
+
+    int narr;
+
+    if (ArrivalHot.arrival != arrival)
+        return;
+
+    if (num_arrivals > ArrivalHot.num_arrivals)
+        num_arrivals = ArrivalHot.num_arrivals;
+    for (narr = 0; narr < num_arrivals; narr++)
+        ArrivalHot.pred_travel_time[narr] = arrival[narr].pred_travel_time;
+
+}
+
+/** function to free the hot arrival table */
+
+void ArrivalHot_Free() {
+
+    ArrivalHotTable *hot = &ArrivalHot;
+
+    free(hot->obs_centered);
+    free(hot->obs_time);
+    free(hot->error);
+    free(hot->amplitude);
+    free(hot->station_weight);
+    free(hot->apriori_weight);
+    free(hot->abs_time);
+    free(hot->pred_travel_time);
+    free(hot->pred_centered);
+    free(hot->weight);
+    memset(hot, 0, sizeof (ArrivalHotTable));
+
+}
+
 /** function to initialize Metropolis walk */
 
 void InitializeMetropolisWalk(GridDesc* ptgrid, ArrivalDesc* parrivals, int
@@ -1047,8 +1272,6 @@ void InitializeMetropolisWalk(GridDesc* ptgrid, ArrivalDesc* parrivals, int
 
 }
 
-static int save_location_count = 0;
-
 /** function to display and save minimum misfit location to file */
 
 int SaveLocation(HypoDesc* hypo, int ngrid, char* fnobs, char *fnout, int numArrivalsReject,
@@ -1255,16 +1478,16 @@ int SaveLocation(HypoDesc* hypo, int ngrid, char* fnobs, char *fnout, int numArr
         if (iUseSearchPosterior && SearchPosterior.first_motion_arrivals != NULL && SearchPosterior.nfirst_motion_arrivals != NULL) {
             SearchPdfGridDesc *searchPdfGrid = &SearchPosterior;
             // write fmamp format with combined event arrivals
-            WriteHypoFmampSearchPosterior(searchPdfGrid, pSumFileFmamp[ngrid], hypo, fnout, save_location_count < 1);
+            WriteHypoFmampSearchPosterior(searchPdfGrid, pSumFileFmamp[ngrid], hypo, fnout, pNLLocContext->save_location_count < 1);
         } else {
             // write fmamp format with event arrivals
-            WriteHypoFmamp(pSumFileFmamp[ngrid], hypo, Arrival, NumArrivals, fnout, save_location_count < 1);
+            WriteHypoFmamp(pSumFileFmamp[ngrid], hypo, Arrival, NumArrivals, fnout, pNLLocContext->save_location_count < 1);
         }
     }
 
     iWriteHypHeader[ngrid] = 0;
 
-    save_location_count++;
+    pNLLocContext->save_location_count++;
 
     return (0);
 
@@ -1530,6 +1753,8 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
 
     SourceDesc* pstation;
 
+    double time_perf = LocPerf_Time(); // 20261016 agent - added
+
     *pnumSArrivals = 0;
 
     /* initalize format specific event data */
@@ -1651,6 +1876,8 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
 
     /* check each arrival and initialize */
 
+    time_perf = LocPerf_Stage(PERF_OBS, time_perf); // 20261016 agent - added
+
     Num3DGridReadToMemory = 0;
     for (nobs = nobs_prev; nobs < nobs_total; nobs++) {
 
@@ -1671,6 +1898,9 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
 
         // make sure station location is null
         arrival[nobs].station.x = arrival[nobs].station.y = arrival[nobs].station.z = -LARGE_DOUBLE;
+        // 20261017 agent - added, geographic location and coordinate flags also null, were left from arrival previously read into this element
+        arrival[nobs].station.dlat = arrival[nobs].station.dlong = arrival[nobs].station.depth = -LARGE_DOUBLE;
+        arrival[nobs].station.is_coord_xyz = arrival[nobs].station.is_coord_latlon = 0;
 
         // set some flags
         read_2d_sheets = 1;
@@ -1769,7 +1999,7 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
                     arrival_phase, arrival[nobs].time_grid_label);
             sprintf(filename, "%s.time", arrival[nobs].fileroot);
             // try opening time grid file for this phase
-            istat = OpenGrid3dFile(filename,
+            istat = NLL_OpenGrid3dFile(filename,
                     &(arrival[nobs].fpgrid),
                     &(arrival[nobs].fphdr),
                     &(arrival[nobs].gdesc), "time",
@@ -1783,7 +2013,7 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
                         eval_phase, arrival[nobs].time_grid_label);
                 sprintf(filename, "%s.time", arrival[nobs].fileroot);
                 /* try opening time grid file for this phase */
-                istat = OpenGrid3dFile(filename,
+                istat = NLL_OpenGrid3dFile(filename,
                         &(arrival[nobs].fpgrid),
                         &(arrival[nobs].fphdr),
                         &(arrival[nobs].gdesc), "time",
@@ -1797,7 +2027,7 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
                 sprintf(arrival[nobs].fileroot, "%s.%s.%s", fn_grids,
                         "P", arrival[nobs].time_grid_label);
                 sprintf(filename, "%s.time", arrival[nobs].fileroot);
-                istat = OpenGrid3dFile(filename,
+                istat = NLL_OpenGrid3dFile(filename,
                         &(arrival[nobs].fpgrid),
                         &(arrival[nobs].fphdr),
                         &(arrival[nobs].gdesc), "time",
@@ -1859,7 +2089,7 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
                             strcpy(arrival[nobs].gdesc.title, arrival[n_time_grid].gdesc.title);
                             istat = 1;
                         } else {
-                            istat = OpenGrid3dFile(filename,
+                            istat = NLL_OpenGrid3dFile(filename,
                                     &(arrival[nobs].fpgrid),
                                     &(arrival[nobs].fphdr),
                                     &(arrival[nobs].gdesc), "time",
@@ -1886,7 +2116,7 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
                         "WARNING: cannot open time grid file: %s: rejecting observation: %s %s",
                         filename, arrival[nobs].label, arrival[nobs].phase);
                 nll_putmsg(2, MsgStr);
-                CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
+                NLL_CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
                 strcpy(arrival[nobs].fileroot, "\0");
                 goto RejectArrival;
             }
@@ -1899,7 +2129,7 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
                 sprintf(MsgStr,
                         "WARNING: initial location search grid not contained inside arrival time grid, rejecting observation: %s %s", arrival[nobs].label, arrival[nobs].phase);
                 nll_putmsg(1, MsgStr);
-                CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
+                NLL_CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
                 goto RejectArrival;
             }
 
@@ -1918,7 +2148,7 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
                     LocGrid[0].origy + (LocGrid[0].dy
                     * (double) (LocGrid[0].numy - 1)) / 2.0)
                     ) != 1) {
-                CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
+                NLL_CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
                 if (istat == -2) {
                     sprintf(MsgStr,
                             "WARNING: distance from grid center to station \n\texceeds maximum station distance, ignoring observation in misfit calculation: %s %s",
@@ -1947,7 +2177,7 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
                     LocGrid[0].origy + (LocGrid[0].dy
                     * (double) (LocGrid[0].numy - 1)) / 2.0)
                     ) != 1) {
-                CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
+                NLL_CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
                 if (istat == -1) {
                     sprintf(MsgStr,
                             "WARNING: greatest distance from initial 3D location search grid to station \n\texceeds 2D time grid size, rejecting observation: %s %s",
@@ -1993,7 +2223,7 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
                     arrival[nobs].label, arrival[nobs].phase);
             nll_putmsg(2, MsgStr);
             arrival[nobs].flag_ignore = 1;
-            CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
+            NLL_CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
             goto IgnoreArrival;
         }
         // no absolute time and not EDT
@@ -2002,7 +2232,7 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
                     "INFO: arrival does not have absolute timing, ignoring observation in misfit calculation: %s %s %s",
                     arrival[nobs].label, arrival[nobs].phase, arrival[nobs].inst);
             arrival[nobs].flag_ignore = 1;
-            CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
+            NLL_CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
             nll_putmsg(2, MsgStr);
             goto IgnoreArrival;
         }
@@ -2012,7 +2242,7 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
                     "INFO: method is EDT_BOX but arrival does not have error type BOX, ignoring observation in misfit calculation: %s %s %s",
                     arrival[nobs].label, arrival[nobs].phase, arrival[nobs].inst);
             arrival[nobs].flag_ignore = 1;
-            CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
+            NLL_CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
             nll_putmsg(2, MsgStr);
             goto IgnoreArrival;
         }
@@ -2024,7 +2254,7 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
             nll_putmsg(2,
                     "WARNING: maximum number of arrivals for location exceeded, \n\tignoring observation in misfit calculation.");
             arrival[nobs].flag_ignore = 1;
-            CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
+            NLL_CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
             goto IgnoreArrival;
         }
 
@@ -2038,44 +2268,46 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
 
         /** prepare time grids access in memory or on disk */
 
-        /* construct dual-sheet description
-        (2D grids for all search types,
-        and 3D grids for grid-search) */
+        /* set sub-grid containing search volume for 3D grid to be read into memory (LOCGRIDROI) */
+
+        // 20261016 agent - added
+        // 20261017 agent - bug fix, sub-grid was set from LocGrid[0] only, now union of all location grids (see SetLocGridROI())
+        if (iLocGridROI && (SearchType == SEARCH_MET || SearchType == SEARCH_OCTTREE)
+                && arrival[nobs].gdesc.type == GRID_TIME && MaxNum3DGridMemory != 0) {
+            long num_nodes_file = (long) arrival[nobs].gdesc.numx * (long) arrival[nobs].gdesc.numy * (long) arrival[nobs].gdesc.numz;
+            if (setSubGrid(&(arrival[nobs].gdesc),
+                    LocGridROIMin[0], LocGridROIMax[0], LocGridROIMin[1], LocGridROIMax[1], LocGridROIMin[2], LocGridROIMax[2])
+                    && message_flag >= 3) {
+                sprintf(MsgStr, "INFO: sub-grid %dx%dx%d (%.1f%% of grid nodes) will be read: %s",
+                        arrival[nobs].gdesc.numx, arrival[nobs].gdesc.numy, arrival[nobs].gdesc.numz,
+                        100.0 * (double) arrival[nobs].gdesc.numx * (double) arrival[nobs].gdesc.numy * (double) arrival[nobs].gdesc.numz / (double) num_nodes_file,
+                        arrival[nobs].gdesc.title);
+                nll_putmsg(3, MsgStr);
+            }
+        }
 
-        if (SearchType == SEARCH_GRID
-                || (read_2d_sheets && arrival[nobs].gdesc.type == GRID_TIME_2D)) {
+        /* set tiled layout for 3D grid to be read into memory (LOCGRIDLAYOUT TILED) */
 
-            arrival[nobs].sheetdesc = arrival[nobs].gdesc;
-            //INGV ??
-            //if (arrival[nobs].gdesc.numx > 1)
-            arrival[nobs].sheetdesc.numx = 2;
-            /* allocate grid */
-            arrival[nobs].sheetdesc.buffer =
-                    AllocateGrid(&(arrival[nobs].sheetdesc));
-            if (arrival[nobs].sheetdesc.buffer == NULL) {
-                nll_puterr(
-                        "ERROR: allocating memory for arrival sheet buffer.");
-                goto RejectArrival;
-                //return(EXIT_ERROR_MEMORY);
-            }
-            /* create array access pointers */
-            arrival[nobs].sheetdesc.array =
-                    CreateGridArray(&(arrival[nobs].sheetdesc));
-            if (arrival[nobs].sheetdesc.array == NULL) {
-                nll_puterr(
-                        "ERROR: creating array for accessing arrival sheet buffer.");
-                goto RejectArrival;
-                //return(EXIT_ERROR_MEMORY);
-            }
-            arrival[nobs].sheetdesc.origx = VERY_LARGE_DOUBLE;
+        // 20261016 agent - added
+        if (iTiledGridsInMemory && (SearchType == SEARCH_MET || SearchType == SEARCH_OCTTREE)
+                && arrival[nobs].gdesc.type == GRID_TIME && MaxNum3DGridMemory != 0)
+            setTiledGrid(&(arrival[nobs].gdesc), 1);
 
+        /* load 3D grid into grid memory list for later location (look-ahead grid prefetch) */
+
+        // 20261016 agent - added, no grids are allocated, read or mapped for this arrival
+        if (iPrefetchGridsOnInput) {
+            if ((SearchType == SEARCH_MET || SearchType == SEARCH_OCTTREE)
+                    && arrival[nobs].gdesc.type == GRID_TIME && MaxNum3DGridMemory != 0)
+                NLL_PrefetchGrid(&(arrival[nobs].gdesc), arrival[nobs].fpgrid, PrefetchGridsMinLastUsed);
+            goto AcceptArrival;
         }
 
 
-        /* read 3D grid into memory (3D grids for Metropolis or Octtree search) */
+        /* read 3D grid into memory (3D grids for Metropolis, Octtree or grid search) */
 
         //int XX_last = NumAllocations;
-        if ((SearchType == SEARCH_MET || SearchType == SEARCH_OCTTREE)
+        if ((SearchType == SEARCH_MET || SearchType == SEARCH_OCTTREE || SearchType == SEARCH_GRID) // 20261016 agent - added grid search
                 && arrival[nobs].gdesc.type == GRID_TIME
                 && (MaxNum3DGridMemory < 0 || Num3DGridReadToMemory < MaxNum3DGridMemory)) {
 
@@ -2101,18 +2333,85 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
                     goto RejectArrival;
                     //return(EXIT_ERROR_MEMORY);
                 }
-                CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
+                NLL_CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
                 Num3DGridReadToMemory++;
             }
         }
+        // 20261016 agent - added, grid not in memory has regular layout and all grid nodes
+        if (arrival[nobs].gdesc.buffer == NULL) {
+            setTiledGrid(&(arrival[nobs].gdesc), 0);
+            unsetSubGrid(&(arrival[nobs].gdesc));
+        }
         //printf("XXX: NLLoc try put in memory: NumAllocations %d->%d\n", XX_last, NumAllocations);
 
 
+        /* map 3D grid file into memory (3D grids not read to memory) */
+
+        // 20261016 agent - added, grid values are then read through array access instead of a disk read for each value
+        if (iMapGridsOnInput && arrival[nobs].gdesc.type == GRID_TIME
+                && arrival[nobs].gdesc.buffer == NULL && arrival[nobs].fpgrid != NULL) {
+            if (arrival[nobs].gdesc.iSwapBytes) {
+                if (message_flag >= 3) {
+                    sprintf(MsgStr, "INFO: grid bytes must be swapped, cannot map grid file, grid will be read from disk: %s", arrival[nobs].gdesc.title);
+                    nll_putmsg(3, MsgStr);
+                }
+            } else if (isCompressedGrid(&(arrival[nobs].gdesc))) {
+                if (message_flag >= 3) {
+                    sprintf(MsgStr, "INFO: grid is compressed, cannot map grid file, grid will be read from disk: %s", arrival[nobs].gdesc.title);
+                    nll_putmsg(3, MsgStr);
+                }
+            } else if (MapGrid3dBuf(&(arrival[nobs].gdesc), arrival[nobs].fpgrid) != NULL) {
+                /* create array access pointers */
+                if ((arrival[nobs].gdesc.array = CreateGridArray(&(arrival[nobs].gdesc))) == NULL) {
+                    nll_puterr(
+                            "ERROR: creating array for accessing arrival time grid buffer.");
+                    goto RejectArrival;
+                }
+                NLL_CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
+            }
+        }
+
+
+        /* construct dual-sheet description
+        (2D grids for all search types,
+        and 3D grids not in memory for grid-search) */
+
+        // 20261016 agent - added, 3D grids in memory for grid-search
+        if ((SearchType == SEARCH_GRID && arrival[nobs].gdesc.buffer == NULL)
+                || (read_2d_sheets && arrival[nobs].gdesc.type == GRID_TIME_2D)) {
+
+            arrival[nobs].sheetdesc = arrival[nobs].gdesc;
+            //INGV ??
+            //if (arrival[nobs].gdesc.numx > 1)
+            arrival[nobs].sheetdesc.numx = 2;
+            /* allocate grid */
+            arrival[nobs].sheetdesc.buffer =
+                    AllocateGrid(&(arrival[nobs].sheetdesc));
+            if (arrival[nobs].sheetdesc.buffer == NULL) {
+                nll_puterr(
+                        "ERROR: allocating memory for arrival sheet buffer.");
+                goto RejectArrival;
+                //return(EXIT_ERROR_MEMORY);
+            }
+            /* create array access pointers */
+            arrival[nobs].sheetdesc.array =
+                    CreateGridArray(&(arrival[nobs].sheetdesc));
+            if (arrival[nobs].sheetdesc.array == NULL) {
+                nll_puterr(
+                        "ERROR: creating array for accessing arrival sheet buffer.");
+                goto RejectArrival;
+                //return(EXIT_ERROR_MEMORY);
+            }
+            arrival[nobs].sheetdesc.origx = VERY_LARGE_DOUBLE;
+
+        }
+
+
         /* read time grid and close file (2D grids)*/
 
         if (read_2d_sheets && arrival[nobs].gdesc.type == GRID_TIME_2D) {
             istat = ReadArrivalSheets(1, &(arrival[nobs]), 0.0);
-            CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
+            NLL_CloseGrid3dFile(&(Arrival[nobs].gdesc), &(Arrival[nobs].fpgrid), &(arrival[nobs].fphdr));
             if (istat < 0) {
                 sprintf(MsgStr,
                         "ERROR: reading arrival travel time sheets (2D grid), rejecting observation: %s %s",
@@ -2158,6 +2457,9 @@ RejectArrival:
     }
 
 
+    LocPerf_Stage(PERF_GRID, time_perf); // 20261016 agent - added
+
+
     /* avoid returning 0 if arrivals were read, return 0 indicates end of file */
     if (nLocate + *pnignore == 0 && nobs_read > 0) {
         sprintf(MsgStr,
@@ -2668,12 +2970,11 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
 
     int ioff;
 
-    static char line[MAXLINE_LONG];
+    // reader state kept between calls, 20261016 agent - moved from static variables to location run context
+    ObsReaderState *rs = &(pNLLocContext->obsReader);
+    char *line = rs->line;
 
-    static int date_saved, year_save, month_save, day_save;
-    static int check_for_S_arrival;
 
-    static int in_hypocenter_event;
 
     int ifound;
 
@@ -2685,18 +2986,13 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
     double vpvs;
 
     // NEIC / ISC format
-    static char last_label[10];
     char cmonth[4];
     char* pchr;
-    static int origin_hour = 0;
 
     // ISC format
     char isc_time_str[10];
 
     // DD
-    static int hypo_cc_flag;
-    static long int dd_event_id_1, dd_event_id_2;
-    static double dd_otime_corr;
     double tt_sta1, tt_sta2;
 
     // HYPOINVERSE_Y2000_ARC
@@ -2709,15 +3005,15 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
 
     /* if no obs read for this event, set date saved flag to 0 */
     if (nfirst) {
-        date_saved = 0;
-        check_for_S_arrival = 0;
-        in_hypocenter_event = 0;
+        rs->date_saved = 0;
+        rs->check_for_S_arrival = 0;
+        rs->in_hypocenter_event = 0;
     }
 
 
     /* check for special control instructions */
     iloop = 1;
-    while (iloop && !check_for_S_arrival) {
+    while (iloop && !rs->check_for_S_arrival) {
         iloop = 0;
         if ((chr = fgetc(fp_obs)) == '!'/* || chr == '#'*/) {
             ungetc(chr, fp_obs);
@@ -2824,14 +3120,14 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
 
         istat = ReadArrival(line, arrival, IO_ARRIVAL_OBS);
         if (istat < 1) {
-            if (in_hypocenter_event) {
+            if (rs->in_hypocenter_event) {
                 return (OBS_FILE_END_OF_EVENT);
             } else {
                 return (OBS_FILE_SKIP_INPUT_LINE);
             }
         }
 
-        in_hypocenter_event = 1;
+        rs->in_hypocenter_event = 1;
 
         /* convert error to quality */
         if ((arrival->quality = Err2Qual(arrival)) < 0)
@@ -2977,7 +3273,7 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
             strcmp(ftype_obs, "HYPO71_S_QUAL_PLUS_1") == 0 ||
             strcmp(ftype_obs, "HYPOELLIPSE") == 0) {
 
-        if (check_for_S_arrival) {
+        if (rs->check_for_S_arrival) {
             /* check for S phase input in last input line read */
 
             /* set S read offset to allow correction of incorrect hypo71 format */
@@ -3038,7 +3334,7 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
         }
 
         /* check for S arrival input found */
-        if (check_for_S_arrival && istat == 10
+        if (rs->check_for_S_arrival && istat == 10
                 && IsPhaseID(arrival->phase, "S")
                 && IsGoodDate(arrival->year,
                 arrival->month, arrival->day)) {
@@ -3061,10 +3357,10 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
             }
 
             line[0] = '\0';
-            check_for_S_arrival = 0;
+            rs->check_for_S_arrival = 0;
             return (istat);
-        } else if (check_for_S_arrival) {
-            check_for_S_arrival = 0;
+        } else if (rs->check_for_S_arrival) {
+            rs->check_for_S_arrival = 0;
             return (OBS_FILE_SKIP_INPUT_LINE);
         }
 
@@ -3133,15 +3429,15 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
         istat += ReadFortranReal(line, 71, 5, &arrival->coda_dur);
 
 
-        check_for_S_arrival = 1;
+        rs->check_for_S_arrival = 1;
         /* check for valid phase code */
         //		if (IsPhaseID(arrival->phase, "P")) {
         //strcpy(arrival->phase, "P");
-        check_for_S_arrival = 1;
+        rs->check_for_S_arrival = 1;
 
         //		} else if (IsPhaseID(arrival->phase, "S")) {
         //strcpy(arrival->phase, "S");
-        //			check_for_S_arrival = 0;
+        //			rs->check_for_S_arrival = 0;
         //		} else
         //			return(OBS_FILE_END_OF_EVENT);
 
@@ -3246,7 +3542,7 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
 
          */
 
-        if (check_for_S_arrival) {
+        if (rs->check_for_S_arrival) {
             /* check for S phase input in last input line read */
 
             // check for zero or blank S phase time and remark
@@ -3349,10 +3645,10 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
                 // convert quality to error
                 Qual2Err(arrival);
                 line[0] = '\0';
-                check_for_S_arrival = 0;
+                rs->check_for_S_arrival = 0;
                 return (istat);
             } else { // not found
-                check_for_S_arrival = 0;
+                rs->check_for_S_arrival = 0;
                 return (OBS_FILE_SKIP_INPUT_LINE);
             }
 
@@ -3393,7 +3689,7 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
         ReadFortranInt(line, 17, 1, &itest2);
         // if dummy P-phase, skip reading and try read S-phase
         if (itest == 9999 && itest2 == 4) {
-            check_for_S_arrival = 1;
+            rs->check_for_S_arrival = 1;
             return (OBS_FILE_SKIP_INPUT_LINE);
         } else {
             // read formatted P arrival input
@@ -3463,11 +3759,11 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
             /* check for valid phase code */
             //		if (IsPhaseID(arrival->phase, "P")) {
             //strcpy(arrival->phase, "P");
-            check_for_S_arrival = 1;
+            rs->check_for_S_arrival = 1;
 
             //		} else if (IsPhaseID(arrival->phase, "S")) {
             //strcpy(arrival->phase, "S");
-            //			check_for_S_arrival = 0;
+            //			rs->check_for_S_arrival = 0;
             //		} else
             //			return(OBS_FILE_END_OF_EVENT);
 
@@ -3491,12 +3787,12 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
                         VMG 1016   EZPG  04132514 EZSG  133068                             56
                         ZCCA1016   EZPG  04132655                                          47
          */
-        if (check_for_S_arrival > 0) {
+        if (rs->check_for_S_arrival > 0) {
             /* check for additional phase input in last input line read */
 
             ioff = 0;
             if (strcmp(ftype_obs, "INGV_ARCH") == 0)
-                ioff = 13 * (check_for_S_arrival - 1);
+                ioff = 13 * (rs->check_for_S_arrival - 1);
             /* check for zero or blank S phase time */
             istat = ReadFortranString(line, 33 + ioff, 6, chrtmp);
             if (istat > 0
@@ -3532,7 +3828,7 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
         }
 
         /* check for S arrival input found */
-        if (check_for_S_arrival > 0 && istat == 10
+        if (rs->check_for_S_arrival > 0 && istat == 10
                 //				&& IsPhaseID(arrival->phase, "S")
                 && IsGoodDate(arrival->year,
                 arrival->month, arrival->day)) {
@@ -3552,15 +3848,15 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
             }
 
             // increment additional arrival count
-            if (strcmp(ftype_obs, "INGV_ARCH") == 0 && check_for_S_arrival < 3) {
-                check_for_S_arrival++;
+            if (strcmp(ftype_obs, "INGV_ARCH") == 0 && rs->check_for_S_arrival < 3) {
+                rs->check_for_S_arrival++;
             } else {
-                check_for_S_arrival = 0;
+                rs->check_for_S_arrival = 0;
                 line[0] = '\0';
             }
             return (istat);
-        } else if (check_for_S_arrival > 0) {
-            check_for_S_arrival = 0;
+        } else if (rs->check_for_S_arrival > 0) {
+            rs->check_for_S_arrival = 0;
             return (OBS_FILE_SKIP_INPUT_LINE);
         }
 
@@ -3638,15 +3934,15 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
         //istat += ReadFortranReal(line, 71, 5, &arrival->coda_dur);
 
 
-        check_for_S_arrival = 1;
+        rs->check_for_S_arrival = 1;
         /* check for valid phase code */
         //		if (IsPhaseID(arrival->phase, "P")) {
         //strcpy(arrival->phase, "P");
-        //			check_for_S_arrival = 1;
+        //			rs->check_for_S_arrival = 1;
 
         //		} else if (IsPhaseID(arrival->phase, "S")) {
         //strcpy(arrival->phase, "S");
-        //			check_for_S_arrival = 0;
+        //			rs->check_for_S_arrival = 0;
         //		} else
         //			return(OBS_FILE_END_OF_EVENT);
 
@@ -3664,7 +3960,7 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
         return (istat);
     } else if (strcmp(ftype_obs, "NCSN_Y2K_5") == 0) {
 
-        if (check_for_S_arrival) {
+        if (rs->check_for_S_arrival) {
             /* check for S phase input in last input line read */
 
             /* check for zero or blank S phase time */
@@ -3705,7 +4001,7 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
         }
 
         /* check for S arrival input found */
-        if (check_for_S_arrival && istat == 11
+        if (rs->check_for_S_arrival && istat == 11
                 && IsPhaseID(arrival->phase, "S")
                 && IsGoodDate(arrival->year, arrival->month, arrival->day)) {
 
@@ -3719,7 +4015,7 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
             }
 
             line[0] = '\0';
-            check_for_S_arrival = 0;
+            rs->check_for_S_arrival = 0;
 
             // AJL 20070608 - this format may have muliple entries for each phase, need to reject
             // earlier phases with large error so that later entries will be used
@@ -3727,8 +4023,8 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
                 return (OBS_FILE_SKIP_INPUT_LINE);
 
             return (istat);
-        } else if (check_for_S_arrival) {
-            check_for_S_arrival = 0;
+        } else if (rs->check_for_S_arrival) {
+            rs->check_for_S_arrival = 0;
             return (OBS_FILE_SKIP_INPUT_LINE);
         }
 
@@ -3798,11 +4094,11 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
         /* check for valid phase code */
         if (IsPhaseID(arrival->phase, "P")) {
             //strcpy(arrival->phase, "P");
-            check_for_S_arrival = 1;
+            rs->check_for_S_arrival = 1;
 
         } else if (IsPhaseID(arrival->phase, "S")) {
             //strcpy(arrival->phase, "S");
-            check_for_S_arrival = 0;
+            rs->check_for_S_arrival = 0;
         } else
             return (OBS_FILE_SKIP_INPUT_LINE);
 
@@ -4014,8 +4310,8 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
         char *cptr;
 
         //*DEBUG*/printf("TP 00");
-        if (check_for_S_arrival) {
-            check_for_S_arrival = 0;
+        if (rs->check_for_S_arrival) {
+            rs->check_for_S_arrival = 0;
             // check for S phase input in last input line read
             // KO.SVRC,2023-02-01T07:02:12.920000Z,2023-02-01T07:02:21.690000Z,4.4354171239049296e-07,42808.9
             // replace ',' with ' '
@@ -4044,12 +4340,12 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
         //*DEBUG*/printf(" 01");
         // check for end of event or event hypocenter line (assumes no blanks after last phase)
         chr = fgetc(fp_obs);
-        //*DEBUG*/printf("chr %c %d %d\n", chr, isdigit(chr), in_hypocenter_event);
+        //*DEBUG*/printf("chr %c %d %d\n", chr, isdigit(chr), rs->in_hypocenter_event);
         ungetc(chr, fp_obs);
         if (chr != EOF && isdigit(chr)) {
-            if (in_hypocenter_event) {
+            if (rs->in_hypocenter_event) {
                 // end of event
-                in_hypocenter_event = 0;
+                rs->in_hypocenter_event = 0;
                 return (OBS_FILE_END_OF_EVENT);
             } else {
                 // read hypocenter line
@@ -4066,8 +4362,8 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
                 if (istat != 10) {
                     return (OBS_FILE_END_OF_EVENT);
                 }
-                in_hypocenter_event = 1;
-                check_for_S_arrival = 0;
+                rs->in_hypocenter_event = 1;
+                rs->check_for_S_arrival = 0;
             }
         } else {
             if (chr == EOF)
@@ -4105,7 +4401,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
         // convert quality to error
         Qual2Err(arrival);
 
-        check_for_S_arrival = 1;
+        rs->check_for_S_arrival = 1;
 
         //*DEBUG*/printf(" 99\n");
         return (istat);
@@ -4155,7 +4451,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
         strcpy(eth_line_key, "$@GARBAGE");
 
         // read event hypocenter line
-        if (!in_hypocenter_event) {
+        if (!rs->in_hypocenter_event) {
             // find origin time line
             ifound = 0;
             while ((istat = ReadFortranString(line, 55, 4, eth_line_key)) > 0) {
@@ -4206,7 +4502,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
             if (istat == 4 || istat == 6) {
                 if (istat == 4)
                     EventTime.ev_nr = 0; /* no event number */
-                in_hypocenter_event = 1;
+                rs->in_hypocenter_event = 1;
                 // read until phase line reached
                 while ((istat = ReadFortranString(line, 55, 4, eth_line_key)) > 0
                         && strcmp(line, "    ") != 0
@@ -4353,7 +4649,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
 
 
         // read event hypocenter line
-        if (!in_hypocenter_event) {
+        if (!rs->in_hypocenter_event) {
             // find origin time line
             ifound = 0;
             while ((istat = ReadFortranString(line, 55, 4, eth_line_key)) > 0) {
@@ -4392,7 +4688,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
             /* SH 03/05/2004  added event number  */
             istat += ReadFortranInt(line, 71, 8, &EventTime.ev_nr);
             if (istat == 6) {
-                in_hypocenter_event = 1;
+                rs->in_hypocenter_event = 1;
                 // read until phase line reached
                 while ((istat = ReadFortranString(line, 55, 4, eth_line_key)) > 0
                         && strcmp(line, "    ") != 0) {
@@ -4518,7 +4814,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
 
 
         // read event hypocenter line
-        if (!in_hypocenter_event) {
+        if (!rs->in_hypocenter_event) {
             // find origin time line
             ifound = 0;
             while ((istat = ReadFortranString(line, 55, 4, eth_line_key)) > 0) {
@@ -4547,7 +4843,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
             //EventTime.year, EventTime.month, EventTime.day,
             //EventTime.hour, EventTime.min);
             if (istat == 5) {
-                in_hypocenter_event = 1;
+                rs->in_hypocenter_event = 1;
                 // read until phase line reached
                 while ((istat = ReadFortranString(line, 55, 4, eth_line_key)) > 0
                         && strcmp(line, "    ") != 0) {
@@ -4665,7 +4961,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
 
 
         /* read event hypocenter line */
-        if (!in_hypocenter_event) {
+        if (!rs->in_hypocenter_event) {
             //(">>event hypocenter line --- %s\n", line);
             /* read hypocenter time */
             //     20 JUN 2003  (171)
@@ -4673,14 +4969,14 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
             istat += ReadFortranString(line, 9, 3, cmonth);
             istat += ReadFortranInt(line, 6, 2, &EventTime.day);
             if (istat == 3 && EventTime.year > 0 && EventTime.year < 2199 && EventTime.day > 0 && EventTime.day < 32 && strlen(cmonth) == 3) {
-                in_hypocenter_event = 1;
+                rs->in_hypocenter_event = 1;
                 EventTime.month = Month2Int(cmonth);
-                origin_hour = 0;
+                rs->origin_hour = 0;
                 // find phs line
                 while (strncmp(line, " sta", 4) != 0) {
                     // check for and get origin hour
                     if (strstr(line, "ot  =") != NULL) {
-                        ReadFortranInt(line, 12, 2, &origin_hour);
+                        ReadFortranInt(line, 12, 2, &rs->origin_hour);
                     }
                     // read next line
                     cstat = fgets(line, MAXLINE_LONG, fp_obs);
@@ -4711,11 +5007,11 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
          */
         istat = ReadFortranString(line, 2, 4, arrival->label);
         if (strncmp(arrival->label, "    ", 4) == 0)
-            strcpy(arrival->label, last_label);
+            strcpy(arrival->label, rs->last_label);
         else
-            strcpy(last_label, arrival->label);
+            strcpy(rs->last_label, arrival->label);
         TrimString(arrival->label);
-        TrimString(last_label);
+        TrimString(rs->last_label);
         istat += ReadFortranString(line, 7, 1, arrival->onset);
         istat += ReadFortranString(line, 8, 6, arrival->phase);
         TrimString(arrival->phase);
@@ -4747,10 +5043,10 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
         }
         istat += ReadFortranInt(line, 15, 2, &arrival->hour);
         // check for day jump
-        //printf("   arrival->hour %d  origin_hour %d\n", arrival->hour, origin_hour);
-        if (arrival->hour < origin_hour)
+        //printf("   arrival->hour %d  rs->origin_hour %d\n", arrival->hour, rs->origin_hour);
+        if (arrival->hour < rs->origin_hour)
             arrival->hour += 24;
-        //printf(">>>   arrival->hour %d  origin_hour %d\n", arrival->hour, origin_hour);
+        //printf(">>>   arrival->hour %d  rs->origin_hour %d\n", arrival->hour, rs->origin_hour);
         istat += ReadFortranInt(line, 18, 2, &arrival->min);
         istat += ReadFortranReal(line, 21, 5, &arrival->sec);
 
@@ -4796,7 +5092,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
         }
 
 
-        if (0 && !in_hypocenter_event) {
+        if (0 && !rs->in_hypocenter_event) {
             // find phase line
             while (strncmp(line, "Channel", 7) != 0) {
                 // read next line
@@ -4805,7 +5101,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
                 if (cstat == NULL)
                     return (OBS_FILE_END_OF_INPUT);
             }
-            in_hypocenter_event = 1;
+            rs->in_hypocenter_event = 1;
         }
 
 
@@ -4863,7 +5159,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
             return (OBS_FILE_END_OF_EVENT);
         }
 
-        if (!in_hypocenter_event) {
+        if (!rs->in_hypocenter_event) {
             // find phase line
             while (strstr(line, "Pphase") == NULL) {
                 // read next line
@@ -4872,7 +5168,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
                 if (cstat == NULL)
                     return (OBS_FILE_END_OF_INPUT);
             }
-            in_hypocenter_event = 1;
+            rs->in_hypocenter_event = 1;
             cstat = fgets(line, MAXLINE_LONG, fp_obs);
         }
 
@@ -4964,7 +5260,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
                 return (OBS_FILE_END_OF_INPUT);
         } while (LineIsBlank(line));
         // check for end of event (assumes Event or STOP at end of event or following DATA_TYPE)
-        if ((in_hypocenter_event && strncmp(line, "Event", 5) == 0)) {
+        if ((rs->in_hypocenter_event && strncmp(line, "Event", 5) == 0)) {
             /* end of event */
             fseek(fp_obs, file_pos, SEEK_SET);
             return (OBS_FILE_END_OF_EVENT);
@@ -4981,7 +5277,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
 
 
         /* not yet in event, find and read event hypocenter line */
-        if (!in_hypocenter_event) {
+        if (!rs->in_hypocenter_event) {
             // assume may already be in "Event" block
             strcpy(phypo->public_id, "-1"); // 20191209 AJL - added
             // find date
@@ -5014,7 +5310,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
             istat += ReadFortranInt(line, 9, 2, &EventTime.day);
             istat += ReadFortranInt(line, 12, 2, &EventTime.hour);
             if (istat == 4) {
-                in_hypocenter_event = 1;
+                rs->in_hypocenter_event = 1;
                 int in_magnitude = 0;
                 double amp_mag = -9.9;
                 int num_amp_mag = -1;
@@ -5130,11 +5426,11 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
         // read phase time reading
         istat = ReadFortranString(line, 1, 5, arrival->label);
         if (strncmp(arrival->label, "     ", 5) == 0)
-            strcpy(arrival->label, last_label);
+            strcpy(arrival->label, rs->last_label);
         else
-            strcpy(last_label, arrival->label);
+            strcpy(rs->last_label, arrival->label);
         TrimString(arrival->label);
-        TrimString(last_label);
+        TrimString(rs->last_label);
         istat += ReadFortranString(line, 20, 8, arrival->phase);
         TrimString(arrival->phase);
 
@@ -5244,7 +5540,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
         if (cstat == NULL)
             return (OBS_FILE_END_OF_INPUT);
         /* check for end of event (assumes Event or STOP at end of event) */
-        if ((in_hypocenter_event && strncmp(line, "EVENT", 5) == 0)
+        if ((rs->in_hypocenter_event && strncmp(line, "EVENT", 5) == 0)
                 || strncmp(line, "STOP", 4) == 0) {
             /* end of event */
             return (OBS_FILE_END_OF_EVENT);
@@ -5252,7 +5548,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
 
 
         /* not yet in event, find and read event hypocenter line */
-        if (!in_hypocenter_event) {
+        if (!rs->in_hypocenter_event) {
             // assume may alredy be in "Event" block
             // find phases lines
             // following works for CSEM:
@@ -5270,7 +5566,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
             //printf("5 %s", line);
             if (cstat == NULL)
                 return (OBS_FILE_END_OF_INPUT);
-            in_hypocenter_event = 1;
+            rs->in_hypocenter_event = 1;
         }
 
 
@@ -5298,11 +5594,11 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
         // read phase time reading
         istat = ReadFortranString(line, 1, 5, arrival->label);
         if (strncmp(arrival->label, "     ", 5) == 0)
-            strcpy(arrival->label, last_label);
+            strcpy(arrival->label, rs->last_label);
         else
-            strcpy(last_label, arrival->label);
+            strcpy(rs->last_label, arrival->label);
         TrimString(arrival->label);
-        TrimString(last_label);
+        TrimString(rs->last_label);
         istat += ReadFortranString(line, 24, 8, arrival->phase);
         TrimString(arrival->phase);
         istat += ReadFortranInt(line, 32, 4, &arrival->year);
@@ -5364,7 +5660,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
         }
 
 
-        if (!in_hypocenter_event) {
+        if (!rs->in_hypocenter_event) {
             // find phase line
             while (strncmp(line, "Sta       Phase", 15) != 0) {
                 // read next line
@@ -5376,7 +5672,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
             cstat = fgets(line, MAXLINE_LONG, fp_obs);
             if (cstat == NULL)
                 return (OBS_FILE_END_OF_INPUT);
-            in_hypocenter_event = 1;
+            rs->in_hypocenter_event = 1;
         }
 
 
@@ -5499,7 +5795,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
         //printf("1 %s", line);
         if (cstat == NULL)
             return (OBS_FILE_END_OF_INPUT);
-        if (in_hypocenter_event) {
+        if (rs->in_hypocenter_event) {
             if (strncmp(line, "Event:", 6) == 0) {
                 // end of event
                 return (OBS_FILE_END_OF_EVENT);
@@ -5508,7 +5804,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
 
 
         // not yet in event, find and read event hypocenter line
-        if (!in_hypocenter_event) {
+        if (!rs->in_hypocenter_event) {
             // assume may already be in "Event" block
             // find date
             while (strstr(line, "Public ID") == NULL) {
@@ -5542,7 +5838,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
             istat = sscanf(line, " Date %d-%d-%d", &EventTime.year, &EventTime.month, &EventTime.day);
 
             if (istat == 3) {
-                in_hypocenter_event = 1;
+                rs->in_hypocenter_event = 1;
 
                 // find time line
                 //     Time                   23:59:32.064
@@ -5864,7 +6160,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
 
 
         /* read event hypocenter line */
-        if (!in_hypocenter_event) {
+        if (!rs->in_hypocenter_event) {
             /* read hypocenter time */
             istat = ReadFortranInt(line, 1, 5, &EventTime.year);
             istat += ReadFortranInt(line, 7, 2, &EventTime.month);
@@ -5873,7 +6169,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
                 if (EventTime.year < 2000)
                     EventTime.year += 1900;
                 /* !! assume any 2 digit year is 1900-1999 */
-                in_hypocenter_event = 1;
+                rs->in_hypocenter_event = 1;
                 /* read next line */
                 cstat = fgets(line, MAXLINE_LONG, fp_obs);
                 if (cstat == NULL)
@@ -5927,7 +6223,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
                         NCJMG       6.240   0.200   P
          */
 
-        if (in_hypocenter_event) {
+        if (rs->in_hypocenter_event) {
             /* check for end of event (assumes no blanks after last phase) */
             chr = fgetc(fp_obs);
             if (chr == EOF) {
@@ -5948,13 +6244,13 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
 
 
         /* read event hypocenter line */
-        if (!in_hypocenter_event) {
+        if (!rs->in_hypocenter_event) {
             /* read hypocenter time */
             istat = sscanf(line, "# %d %d %d %d %d %lf %*f %*f %*f %*f %*f %*f %*f %ld",
                     &EventTime.year, &EventTime.month, &EventTime.day,
                     &EventTime.hour, &EventTime.min, &EventTime.sec, &EventID);
             if (istat == 7) {
-                in_hypocenter_event = 1;
+                rs->in_hypocenter_event = 1;
                 /* read next line */
                 cstat = fgets(line, MAXLINE_LONG, fp_obs);
                 if (cstat == NULL)
@@ -6039,16 +6335,16 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
 
         /* read events line */
         if (line[0] == '#') {
-            hypo_cc_flag = 1;
+            rs->hypo_cc_flag = 1;
             istat = sscanf(line, "# %ld %ld %lf",
-                    &dd_event_id_1, &dd_event_id_2, &dd_otime_corr);
-            if (dd_event_id_1 == dd_event_id_2)
-                printf("ERROR: dd_event_id_1 == &dd_event_id_2  %ld %ld\n", dd_event_id_1, dd_event_id_2);
+                    &rs->dd_event_id_1, &rs->dd_event_id_2, &rs->dd_otime_corr);
+            if (rs->dd_event_id_1 == rs->dd_event_id_2)
+                printf("ERROR: rs->dd_event_id_1 == &rs->dd_event_id_2  %ld %ld\n", rs->dd_event_id_1, rs->dd_event_id_2);
             if (istat == 2)
-                hypo_cc_flag = 0;
+                rs->hypo_cc_flag = 0;
 
             if (istat >= 2) {
-                in_hypocenter_event = 1;
+                rs->in_hypocenter_event = 1;
                 /* read next line */
                 cstat = fgets(line, MAXLINE_LONG, fp_obs);
                 if (cstat == NULL)
@@ -6062,9 +6358,9 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
 
         // read phase arrival input
 
-        arrival->xcorr_flag = hypo_cc_flag;
+        arrival->xcorr_flag = rs->hypo_cc_flag;
 
-        if (hypo_cc_flag) { // HYPODD_CC
+        if (rs->hypo_cc_flag) { // HYPODD_CC
 
             istat = sscanf(line, "%s %lf %lf %s",
                     arrival->label, &arrival->dd_dtime, &arrival->weight, arrival->phase);
@@ -6074,10 +6370,10 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
                 return (OBS_FILE_FORMAT_ERROR);
             }
 
-            arrival->dd_event_id_1 = dd_event_id_1;
-            arrival->dd_event_id_2 = dd_event_id_2;
+            arrival->dd_event_id_1 = rs->dd_event_id_1;
+            arrival->dd_event_id_2 = rs->dd_event_id_2;
             // incorporate OTC into dd_dtime when reading dt file
-            arrival->dd_dtime -= dd_otime_corr;
+            arrival->dd_dtime -= rs->dd_otime_corr;
             arrival->error = 0.0;
             strcpy(arrival->error_type, "XCC");
 
@@ -6091,8 +6387,8 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
                 return (OBS_FILE_FORMAT_ERROR);
             }
 
-            arrival->dd_event_id_1 = dd_event_id_1;
-            arrival->dd_event_id_2 = dd_event_id_2;
+            arrival->dd_event_id_1 = rs->dd_event_id_1;
+            arrival->dd_event_id_2 = rs->dd_event_id_2;
             arrival->dd_dtime = tt_sta1 - tt_sta2;
             arrival->error = 0.0;
             strcpy(arrival->error_type, "CAT");
@@ -6187,22 +6483,22 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
 
 
         // check for date info
-        if (!date_saved) {
+        if (!rs->date_saved) {
             // Check whether it is a hypocenter line
             // 2023 0220 1219 05.0 L  37.359  37.066  5.3  AFD  6 0.1 1.6LAFD                1
             if (line[79] != '1') {
                 nll_puterr2("ERROR: bad SEISAN hypocentre line", line);
                 return (OBS_FILE_FORMAT_ERROR);
             }
-            istat = ReadFortranInt(line, 2, 4, &year_save);
+            istat = ReadFortranInt(line, 2, 4, &rs->year_save);
             /* in SEISAN data the year is always fully specified. The correction below is susceptiple to millenium bug */
-            /* if (year_save < 500) */
-            /* 	year_save += 1900; */
-            istat += ReadFortranInt(line, 7, 2, &month_save);
-            istat += ReadFortranInt(line, 9, 2, &day_save);
-            //printf("SEISAN_DATE Read: istat %d   -  %d %d %d\n", istat, year_save, month_save, day_save);
-            if (istat == 3 && IsGoodDate(year_save, month_save, day_save)) {
-                date_saved = 1;
+            /* if (rs->year_save < 500) */
+            /* 	rs->year_save += 1900; */
+            istat += ReadFortranInt(line, 7, 2, &rs->month_save);
+            istat += ReadFortranInt(line, 9, 2, &rs->day_save);
+            //printf("SEISAN_DATE Read: istat %d   -  %d %d %d\n", istat, rs->year_save, rs->month_save, rs->day_save);
+            if (istat == 3 && IsGoodDate(rs->year_save, rs->month_save, rs->day_save)) {
+                rs->date_saved = 1;
                 // read magnitude
                 istat += ReadFortranReal(line, 57, 3, &phypo->amp_mag);
                 phypo->num_amp_mag = 1;
@@ -6265,10 +6561,10 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
         istat += ReadFortranReal(line, 30, 4, &arrival->coda_dur);
         istat += ReadFortranReal(line, 34, 7, &arrival->amplitude);
         istat += ReadFortranReal(line, 42, 4, &arrival->period);
-        if (date_saved) {
-            arrival->year = year_save;
-            arrival->month = month_save;
-            arrival->day = day_save;
+        if (rs->date_saved) {
+            arrival->year = rs->year_save;
+            arrival->month = rs->month_save;
+            arrival->day = rs->day_save;
         } else {
             arrival->year = 1900;
             arrival->month = 01;
@@ -6597,7 +6893,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
          */
 
 
-        if (!in_hypocenter_event) {
+        if (!rs->in_hypocenter_event) {
             // find phase line
             while (strncmp(line, "  -----", 7) != 0) {
                 // read next line
@@ -6606,7 +6902,7 @@ KO.SVRC,2023-02-01T03:38:53.860000Z,2023-02-01T03:38:54.960000Z,1.10811060369646
                 if (cstat == NULL)
                     return (OBS_FILE_END_OF_INPUT);
             }
-            in_hypocenter_event = 1;
+            rs->in_hypocenter_event = 1;
         }
 
         /* read line */
@@ -6925,200 +7221,533 @@ int FindDuplicateTimeGrid(ArrivalDesc *arrival, int num_arrivals, int ntest) {
 
 }
 
-/** function to perform grid search location */
-
-int LocGridSearch(int ngrid, int num_arr_total, int num_arr_loc,
-        ArrivalDesc *arrival,
-        GridDesc* ptgrid, GaussLocParams* gauss_par, HypoDesc * phypo) {
+/*------------------------------------------------------------/ */
+/** exhaustive grid search
+ *
+ * The nodes of the search grid are evaluated by x-slabs (y-z sheets of nodes).  Travel times of a z-column of nodes
+ * are interpolated in one pass for each arrival with a 3D time grid in memory (see TTColumn_Set()).  The results of
+ * the nodes of a slab are kept in a slab buffer, and the grid sum, probabilistic residuals and best node are
+ * accumulated from the slab buffers in node order, so results do not depend on which thread evaluated a slab.
+ * When all travel time grids are in memory the slabs are evaluated in parallel by the oct-tree thread pool
+ * (LOCPARALLEL ... NumOctThreads).
+ */
 
-    int istat;
-    int ix = -1, iy = -1, iz = -1, narr;
+// 20261016 agent - added
+
+/* results of the nodes of one x-slab of the search grid */
+typedef struct {
+    int ix;
+    double xval;
+    int *nreject; // number of arrivals without valid travel time at each node, -1 = above topography
+    double *value; // solution quality at each node
+    double *cent_resid; // centered residuals at each node for probabilistic residuals, [node * num_arr_loc + narr]
+    // first node with minimum misfit in slab
+    int inode_best;
+    int iy_best, iz_best;
+    double y_best, z_best;
+    double misfit_min, misfit_max;
+    double *pred_travel_time_best;
+    long perf_num_nodes; // LOCPERF counters of slab, added to counters of locating thread
+    long perf_num_interp;
+    int evaluated; // =1 if slab was evaluated
+    int error;
+} GridSearchSlab;
+
+/* grid search of an event */
+typedef struct {
+    GridDesc *ptgrid;
+    int num_arr_loc;
     int iGridType;
-    int nReject, numGridReject = 0, numStaReject = 0;
-    double xval, yval, zval;
-    /*double travel_time;*/
-    double value;
-    double misfit;
-    double misfit_min = VERY_LARGE_DOUBLE, misfit_max = -VERY_LARGE_DOUBLE;
-    double dlike;
+    double *zval; // z of nodes of each z-column
+    GridSearchSlab *slab;
+    int num_slabs;
+    ArrivalDesc *arrival; // event data of locating thread
+    GaussLocParams *gauss_par;
+    void *pevent; // OctEvalEvent of locating thread, for helper threads
+    // accumulated over slabs
+    double misfit_min, misfit_max;
+    int numGridReject, numStaReject;
+} GridSearchJob;
+
+static int GridSearch_Begin(int ngrid, int num_arr_total, int num_arr_loc, ArrivalDesc *arrival, GaussLocParams* gauss_par,
+        int iGridType);
+static void GridSearch_Run(GridSearchJob *pjob, int num_slabs, ArrivalDesc *arrival, GaussLocParams* gauss_par);
+static int TTColumn_Set(ArrivalDesc *arrival, int num_arr_loc, double xval, double yval, double *zval, int numz);
+static void TTColumn_Node(int iz);
+static void TTColumn_Detach();
+
+/** function to allocate slab buffers, returns < 0 on error */
+
+static int GridSearch_AllocSlabs(GridSearchJob *pjob, int num_slabs) {
+
+    int nslab;
+    int num_nodes = pjob->ptgrid->numy * pjob->ptgrid->numz;
+    GridSearchSlab *pslab;
+
+    if ((pjob->slab = (GridSearchSlab *) calloc(num_slabs, sizeof (GridSearchSlab))) == NULL)
+        return (-1);
+    pjob->num_slabs = num_slabs;
+    for (nslab = 0; nslab < num_slabs; nslab++) {
+        pslab = pjob->slab + nslab;
+        if ((pslab->nreject = (int *) malloc(num_nodes * sizeof (int))) == NULL
+                || (pslab->value = (double *) malloc(num_nodes * sizeof (double))) == NULL
+                || (pslab->pred_travel_time_best = (double *) malloc((pjob->num_arr_loc + 1) * sizeof (double))) == NULL)
+            return (-1);
+        if (pjob->iGridType == GRID_PROB_DENSITY
+                && (pslab->cent_resid = (double *) malloc(((long) num_nodes * pjob->num_arr_loc + 1) * sizeof (double))) == NULL)
+            return (-1);
+    }
+
+    return (0);
 
+}
 
+/** function to free slab buffers */
 
-    /* get solution quality at each grid point */
+static void GridSearch_FreeSlabs(GridSearchJob *pjob) {
 
-    if (message_flag >= 4) {
-        nll_putmsg(4, "");
-        nll_putmsg(4, "Calculating solution over grid...");
+    int nslab;
+
+    if (pjob->slab == NULL)
+        return;
+    for (nslab = 0; nslab < pjob->num_slabs; nslab++) {
+        free(pjob->slab[nslab].nreject);
+        free(pjob->slab[nslab].value);
+        free(pjob->slab[nslab].cent_resid);
+        free(pjob->slab[nslab].pred_travel_time_best);
     }
+    free(pjob->slab);
+    pjob->slab = NULL;
+    pjob->num_slabs = 0;
+
+}
 
-    iGridType = ptgrid->type;
+/** function to evaluate the nodes of an x-slab of the search grid, with the arrivals of the evaluating thread */
 
-    xval = ptgrid->origx;
+static void GridSearch_EvaluateSlab(GridSearchJob *pjob, GridSearchSlab *pslab, ArrivalDesc *arrival, GaussLocParams *gauss_par) {
 
-    /* loop over grid points */
+    int iy, iz, inode, narr;
+    int nReject;
+    int num_arr_loc = pjob->num_arr_loc;
+    int iGridType = pjob->iGridType;
+    GridDesc *ptgrid = pjob->ptgrid;
+    double xval, yval, zval;
+    double value, misfit, log_prior;
+    long num_nodes = LocPerfEvent.num_nodes;
+    long num_interp = LocPerfEvent.num_interp;
 
-    for (ix = 0; ix < ptgrid->numx; ix++) {
+    pslab->inode_best = -1;
+    pslab->misfit_min = VERY_LARGE_DOUBLE;
+    pslab->misfit_max = -VERY_LARGE_DOUBLE;
+    pslab->error = 0;
 
-        /* read y-z sheets for arrival travel-times (3D grids) */
-        if ((istat = ReadArrivalSheets(num_arr_loc, arrival, xval)) < 0)
-            nll_puterr("ERROR: reading arrival travel time sheets.");
+    xval = pslab->xval;
+    yval = ptgrid->origy;
+    inode = 0;
+    for (iy = 0; iy < ptgrid->numy; iy++) {
 
-        yval = ptgrid->origy;
-        for (iy = 0; iy < ptgrid->numy; iy++) {
-            zval = ptgrid->origz;
-            for (iz = 0; iz < ptgrid->numz; iz++) {
+        // get travel times for observed arrivals at all nodes of z-column
+        if (TTColumn_Set(arrival, num_arr_loc, xval, yval, pjob->zval, ptgrid->numz) < 0)
+            pslab->error = 1;
 
+        for (iz = 0; iz < ptgrid->numz; iz++, inode++) {
 
-                // get travel times for observed arrivals
+            zval = pjob->zval[iz];
+            TTColumn_Node(iz);
 
-                if (isAboveTopo(xval, yval, zval)) {
+            if (isAboveTopo(xval, yval, zval)) {
+
+                pslab->nreject[inode] = -1;
+                value = 0.0;
+                if (iGridType == GRID_MISFIT)
+                    value = -1.0;
+                else if (iGridType == GRID_PROB_DENSITY)
+                    value = -LARGE_FLOAT;
+                ((GRID_FLOAT_TYPE ***) ptgrid->array)[pslab->ix][iy][iz] = value;
+
+            } else {
+
+                nReject = getTravelTimes(pNLLocContext, arrival, num_arr_loc, xval, yval, zval);
+                pslab->nreject[inode] = nReject;
+
+                if (nReject) {
 
-                    misfit = -1.0;
                     value = 0.0;
                     if (iGridType == GRID_MISFIT)
                         value = -1.0;
                     else if (iGridType == GRID_PROB_DENSITY)
                         value = -LARGE_FLOAT;
-                    ((GRID_FLOAT_TYPE ***) ptgrid->array)[ix][iy][iz] = value;
+                    ((GRID_FLOAT_TYPE ***) ptgrid->array)[pslab->ix][iy][iz] = value;
 
                 } else {
 
-                    nReject = getTravelTimes(arrival, num_arr_loc, xval, yval, zval);
-
-                    if (nReject) {
-
-                        numGridReject++;
-                        numStaReject += nReject;
-                        misfit = -1.0;
-                        value = 0.0;
-                        if (iGridType == GRID_MISFIT)
-                            value = -1.0;
-                        else if (iGridType == GRID_PROB_DENSITY)
-                            value = -LARGE_FLOAT;
-                        ((GRID_FLOAT_TYPE ***) ptgrid->array)[ix][iy][iz] = value;
-
-                    } else {
+                    /* calc misfit or prob density */
 
-                        /* calc misfit or prob density */
-
-                        double log_prior;
-                        value = CalcSolutionQuality(xval, yval, zval, NULL, num_arr_loc,
-                                arrival, gauss_par,
-                                iGridType, &misfit, NULL, NULL, 0.0, 0.0, 0.0, NULL, NULL, &log_prior);
-                        if (iGridType == GRID_MISFIT) {
-                            ptgrid->sum += value;
-                        } else if (iGridType == GRID_PROB_DENSITY) {
-                            value += log_prior; // 20190513 AJL
-                            dlike = exp(value);
-                            ptgrid->sum += dlike;
-                            /* update  probabilistic residuals */
-                            UpdateProbabilisticResiduals(num_arr_loc, arrival, dlike);
-                        }
-                        ((GRID_FLOAT_TYPE ***) ptgrid->array)[ix][iy][iz] = value;
-
-                        /* check for minimum misfit */
-                        if (misfit < misfit_min) {
-                            misfit_min = misfit;
-                            phypo->misfit = misfit;
-                            phypo->ix = ix;
-                            phypo->iy = iy;
-                            phypo->iz = iz;
-                            phypo->x = xval;
-                            phypo->y = yval;
-                            phypo->z = zval;
-                            for (narr = 0; narr < num_arr_loc; narr++)
-                                arrival[narr].pred_travel_time_best =
-                                    arrival[narr].pred_travel_time;
-                        }
-                        if (misfit > misfit_max)
-                            misfit_max = misfit;
+                    value = CalcSolutionQuality(pNLLocContext, xval, yval, zval, NULL, num_arr_loc,
+                            arrival, gauss_par,
+                            iGridType, &misfit, NULL, NULL, 0.0, 0.0, 0.0, NULL, NULL, &log_prior);
+                    if (iGridType == GRID_PROB_DENSITY) {
+                        value += log_prior; // 20190513 AJL
+                        for (narr = 0; narr < num_arr_loc; narr++)
+                            pslab->cent_resid[(long) inode * num_arr_loc + narr] = arrival[narr].cent_resid;
+                    }
+                    pslab->value[inode] = value;
+                    ((GRID_FLOAT_TYPE ***) ptgrid->array)[pslab->ix][iy][iz] = value;
 
+                    /* check for minimum misfit */
+                    if (misfit < pslab->misfit_min) {
+                        pslab->misfit_min = misfit;
+                        pslab->inode_best = inode;
+                        pslab->iy_best = iy;
+                        pslab->iz_best = iz;
+                        pslab->y_best = yval;
+                        pslab->z_best = zval;
+                        for (narr = 0; narr < num_arr_loc; narr++)
+                            pslab->pred_travel_time_best[narr] = arrival[narr].pred_travel_time;
                     }
-                }
+                    if (misfit > pslab->misfit_max)
+                        pslab->misfit_max = misfit;
 
-                zval += ptgrid->dz;
+                }
             }
-            yval += ptgrid->dy;
         }
-        xval += ptgrid->dx;
+        yval += ptgrid->dy;
     }
+    TTColumn_Detach();
 
+    // counters of evaluating thread are restored, counters of slab are added to locating thread in GridSearch_AddSlab()
+    pslab->perf_num_nodes = LocPerfEvent.num_nodes - num_nodes;
+    pslab->perf_num_interp = LocPerfEvent.num_interp - num_interp;
+    LocPerfEvent.num_nodes = num_nodes;
+    LocPerfEvent.num_interp = num_interp;
+    pslab->evaluated = 1;
 
-    /* give warning if grid points rejected */
-
-    if (numGridReject > 0) {
-        sprintf(MsgStr, "WARNING: %d grid locations rejected; travel times for an average of %.2lf arrival observations were not valid.",
-                numGridReject, (double) numStaReject / numGridReject);
-        nll_putmsg(1, MsgStr);
-    }
+}
 
+/** function to accumulate the results of an x-slab, slabs must be added in x order */
 
-    /* construct search information string */
-    sprintf(phypo->searchInfo, "GRID nPts %d%c", ix * iy *iz, '\0');
-    /* write message */
-    /*nll_putmsg(2, phypo->searchInfo);*/
+static void GridSearch_AddSlab(GridSearchJob *pjob, GridSearchSlab *pslab, ArrivalDesc *arrival, HypoDesc * phypo) {
 
+    int inode, narr;
+    int num_nodes = pjob->ptgrid->numy * pjob->ptgrid->numz;
+    int num_arr_loc = pjob->num_arr_loc;
+    double value, dlike;
+    double *cent_resid;
 
-    /* re-calculate solution and arrival statistics for best location */
+    for (inode = 0; inode < num_nodes; inode++) {
+        if (pslab->nreject[inode] < 0)
+            continue;
+        if (pslab->nreject[inode] > 0) {
+            pjob->numGridReject++;
+            pjob->numStaReject += pslab->nreject[inode];
+            continue;
+        }
+        value = pslab->value[inode];
+        if (pjob->iGridType == GRID_MISFIT) {
+            pjob->ptgrid->sum += value;
+        } else if (pjob->iGridType == GRID_PROB_DENSITY) {
+            dlike = exp(value);
+            pjob->ptgrid->sum += dlike;
+            /* update  probabilistic residuals, as UpdateProbabilisticResiduals() */
+            cent_resid = pslab->cent_resid + (long) inode * num_arr_loc;
+            for (narr = 0; narr < num_arr_loc; narr++) {
+                arrival[narr].pdf_residual_sum += dlike * cent_resid[narr];
+                arrival[narr].pdf_weight_sum += dlike;
+            }
+        }
+    }
 
-    double cell_diagonal_time_var_best = 0.0; // TODO: add to Grid Search ?
-    double cell_diagonal_best = 0.0; // TODO: add to Grid Search ?
-    double cell_volume_best = 0.0; // TODO: add to Grid Search ?
-    SaveBestLocation(NULL, num_arr_total, num_arr_loc, arrival, ptgrid, gauss_par, phypo, misfit_max,
-            iGridType, 0, cell_diagonal_time_var_best, cell_diagonal_best, cell_volume_best);
+    /* check for minimum misfit */
+    if (pslab->inode_best >= 0 && pslab->misfit_min < pjob->misfit_min) {
+        pjob->misfit_min = pslab->misfit_min;
+        phypo->misfit = pslab->misfit_min;
+        phypo->ix = pslab->ix;
+        phypo->iy = pslab->iy_best;
+        phypo->iz = pslab->iz_best;
+        phypo->x = pslab->xval;
+        phypo->y = pslab->y_best;
+        phypo->z = pslab->z_best;
+        for (narr = 0; narr < num_arr_loc; narr++)
+            arrival[narr].pred_travel_time_best = pslab->pred_travel_time_best[narr];
+    }
+    if (pslab->misfit_max > pjob->misfit_max)
+        pjob->misfit_max = pslab->misfit_max;
 
-    return (0);
+    LocPerfEvent.num_nodes += pslab->perf_num_nodes;
+    LocPerfEvent.num_interp += pslab->perf_num_interp;
 
 }
 
+/** end of exhaustive grid search */
+/*------------------------------------------------------------/ */
 
 
-/** function to perform Metropolis location */
 
-#define MAX_NUM_MET_TRIES 1000
+/** function to perform grid search location */
 
-int LocMetropolis(int ngrid, int num_arr_total, int num_arr_loc,
+int LocGridSearch(int ngrid, int num_arr_total, int num_arr_loc,
         ArrivalDesc *arrival,
-        GridDesc* ptgrid, GaussLocParams* gauss_par, HypoDesc* phypo,
-        WalkParams* pMetrop, float* fdata) {
+        GridDesc* ptgrid, GaussLocParams* gauss_par, HypoDesc * phypo) {
 
     int istat;
-    int ntry, nSamples, nSampStat, narr, ipos;
-    long int ngenerated;
-    int maxNumTries;
-    int writeMessage = 0;
-    int iGridType;
-    int nReject, numClipped = 0, numGridReject = 0, numStaReject = 0;
-    int iAbort = 0, iReject = 0;
-    int iBoundary = 0;
-    int iAccept, numAcceptDeepMinima = 0;
-    double xval, yval, zval;
-    double currentMetStepFact;
+    int ix, iz, nslab;
+    int num_threads, num_slabs;
+    double xval, zval;
+    GridSearchJob job;
 
-    double value, dlike, dlike_max = -VERY_LARGE_DOUBLE;
 
-    double misfit;
-    double misfit_min = VERY_LARGE_DOUBLE, misfit_max = -VERY_LARGE_DOUBLE;
+    /* get solution quality at each grid point */
 
-    double xmin, xmax, ymin, ymax, zmin, zmax;
-    double dx_init, dx_test;
+    if (message_flag >= 4) {
+        nll_putmsg(4, "");
+        nll_putmsg(4, "Calculating solution over grid...");
+    }
 
-    int nScatterSaved;
+    job.ptgrid = ptgrid;
+    job.num_arr_loc = num_arr_loc;
+    job.iGridType = ptgrid->type;
+    job.slab = NULL;
+    job.num_slabs = 0;
+    job.misfit_min = VERY_LARGE_DOUBLE;
+    job.misfit_max = -VERY_LARGE_DOUBLE;
+    job.numGridReject = 0;
+    job.numStaReject = 0;
+
+    // 20261016 agent - added, x-slabs evaluated in parallel if possible (LOCPARALLEL NumOctThreads)
+    if ((num_threads = GridSearch_Begin(ngrid, num_arr_total, num_arr_loc, arrival, gauss_par, job.iGridType)) < 0) {
+        nll_puterr("ERROR: allocating memory for grid search.");
+        return (-1);
+    }
+    num_slabs = num_threads > 1 ? 2 * num_threads : 1;
+    if (num_slabs > ptgrid->numx)
+        num_slabs = ptgrid->numx;
+    if ((job.zval = (double *) malloc(ptgrid->numz * sizeof (double))) == NULL
+            || GridSearch_AllocSlabs(&job, num_slabs) < 0) {
+        nll_puterr("ERROR: allocating memory for grid search.");
+        GridSearch_FreeSlabs(&job);
+        free(job.zval);
+        return (-1);
+    }
+    zval = ptgrid->origz;
+    for (iz = 0; iz < ptgrid->numz; iz++) {
+        job.zval[iz] = zval;
+        zval += ptgrid->dz;
+    }
 
-    double xmean_sum = 0.0, ymean_sum = 0.0, zmean_sum = 0.0;
-    double xvar_sum = 0.0, yvar_sum = 0.0, zvar_sum = 0.0;
-    double xvar = 0.0, yvar = 0.0, zvar = 0.0;
-    double dsamp = 0.0, dsamp2;
+    /* loop over grid points */
 
+    xval = ptgrid->origx;
+    for (ix = 0; ix < ptgrid->numx; ix += num_slabs) {
 
+        for (nslab = 0; nslab < num_slabs && ix + nslab < ptgrid->numx; nslab++) {
+            job.slab[nslab].ix = ix + nslab;
+            job.slab[nslab].xval = xval;
+            job.slab[nslab].evaluated = 0;
+            xval += ptgrid->dx;
+        }
 
-    /* get solution quality at each sample on random walk */
+        if (num_threads > 1) {
+            GridSearch_Run(&job, nslab, arrival, gauss_par);
+        } else {
+            /* read y-z sheets for arrival travel-times (3D grids) */
+            if ((istat = ReadArrivalSheets(num_arr_loc, arrival, job.slab[0].xval)) < 0)
+                nll_puterr("ERROR: reading arrival travel time sheets.");
+            GridSearch_EvaluateSlab(&job, job.slab, arrival, gauss_par);
+        }
 
-    if (message_flag >= 4) {
-        nll_putmsg(4, "");
-        nll_putmsg(4, "Calculating solution along Metropolis walk...");
+        for (nslab = 0; nslab < num_slabs && ix + nslab < ptgrid->numx; nslab++) {
+            if (job.slab[nslab].error)
+                nll_puterr("ERROR: allocating memory for grid search travel times, travel times interpolated by node.");
+            GridSearch_AddSlab(&job, job.slab + nslab, arrival, phypo);
+        }
+
+    }
+
+    GridSearch_FreeSlabs(&job);
+    free(job.zval);
+
+
+    /* give warning if grid points rejected */
+
+    if (job.numGridReject > 0) {
+        sprintf(MsgStr, "WARNING: %d grid locations rejected; travel times for an average of %.2lf arrival observations were not valid.",
+                job.numGridReject, (double) job.numStaReject / job.numGridReject);
+        nll_putmsg(1, MsgStr);
     }
 
+
+    /* construct search information string */
+    sprintf(phypo->searchInfo, "GRID nPts %d%c", ptgrid->numx * ptgrid->numy * ptgrid->numz, '\0');
+    /* write message */
+    /*nll_putmsg(2, phypo->searchInfo);*/
+
+
+    /* re-calculate solution and arrival statistics for best location */
+
+    double cell_diagonal_time_var_best = 0.0; // TODO: add to Grid Search ?
+    double cell_diagonal_best = 0.0; // TODO: add to Grid Search ?
+    double cell_volume_best = 0.0; // TODO: add to Grid Search ?
+    SaveBestLocation(NULL, num_arr_total, num_arr_loc, arrival, ptgrid, gauss_par, phypo, job.misfit_max,
+            job.iGridType, 0, cell_diagonal_time_var_best, cell_diagonal_best, cell_volume_best);
+
+    return (0);
+
+}
+
+
+
+/*------------------------------------------------------------/ */
+/** Metropolis chains
+ *
+ * The random walk of LocMetropolis() is done by one or more chains (LOCSEARCH MET ... numChains).
+ * A single chain walks on the event arrivals with the random number generator of the locating thread, as the
+ * original serial walk.  With numChains > 1 each chain walks on its own copy of the arrivals and Gauss parameters
+ * with its own random number stream, split in chain order from the stream of the locating thread.  The first chain
+ * starts at the initial walk location, the other chains at points drawn uniformly in the search grid from their own
+ * streams (overdispersed starts, as assumed by the Gelman-Rubin statistic).  The chains are advanced together in rounds, by the oct-tree thread pool if
+ * available (LOCPARALLEL ... NumOctThreads), so the results do not depend on the number of threads.  The scatter
+ * samples of the chains are combined, and the walk may stop when the Gelman-Rubin statistic of the chains falls
+ * below LOCSEARCH MET ... maxRhat.
+ */
+
+// 20261016 agent - added
+
+#define MAX_NUM_MET_TRIES 1000
+#define MET_CHAIN_NUM_CHECKS 20 // number of convergence checks over the samples after startSave
+#define MET_CHAIN_LIKE_RATIO_MIN 1.0e-3 // samples of chain not used if max likelihood < this fraction of max likelihood of chains
+
+/* state of one Metropolis chain */
+typedef struct {
+    int nchain;
+    char label[32]; // chain label for messages, empty for single chain
+    WalkParams walk;
+    ArrivalDesc *arrival; // arrivals of walk, event arrivals for single chain
+    GaussLocParams *gauss_par;
+    ArrivalDesc *arrival_copy; // copies of event data for multiple chains
+    int num_arrival_alloc;
+    GaussLocParams gauss_copy;
+    MatrixDouble edt_mtx;
+    int edt_mtx_size;
+    RandStream rand_stream; // random number stream of chain, for multiple chains
+    float *fdata; // scatter samples of chain
+    int num_samples; // number of accepted samples of complete walk
+    int num_use; // number of accepted samples after startSave of complete walk
+    // walk state
+    int ntry, nSamples, nSampStat, ipos, nScatterSaved;
+    long ngenerated;
+    int numClipped, numGridReject, numStaReject, numAcceptDeepMinima;
+    double currentMetStepFact;
+    double dlike_max, misfit_min, misfit_max;
+    double xmean_sum, ymean_sum, zmean_sum;
+    double xvar_sum, yvar_sum, zvar_sum;
+    double xvar, yvar, zvar, dsamp;
+    double x_best, y_best, z_best;
+    // sums of accepted samples after startSave, for convergence statistic
+    long nconv;
+    double conv_sum[3];
+    double conv_sum2[3];
+    int iAbort;
+    char abort_comm[2 * MAXLINE];
+    int iStuck; // =1 if max likelihood of chain negligible relative to other chains
+    int done; // =1 if walk completed or aborted
+    int used; // =1 if samples of chain are used
+    long perf_num_nodes; // LOCPERF counters of chain, added to counters of locating thread
+    long perf_num_interp;
+} MetChain;
+
+static NLL_THREAD_LOCAL MetChain *MetChains = NULL;
+static NLL_THREAD_LOCAL int MetChainsAlloc = 0;
+
+static void MetChain_Run(MetChain *chain, int num_chains, int num_arr_total, int num_arr_loc, GridDesc* ptgrid, int num_samples_stop);
+
+/** function to get number of samples after startSave walked by each chain */
+
+static int MetChain_NumUse() {
+
+    int num_chains = MetNumChains > 1 ? MetNumChains : 1;
+
+    if (MetUse <= 0 || num_chains == 1)
+        return (MetUse);
+
+    return ((MetUse + num_chains - 1) / num_chains);
+
+}
+
+/** function to get maximum number of scatter samples saved by all chains */
+
+static int MetChain_NumScatterMax() {
+
+    return ((MetNumChains > 1 ? MetNumChains : 1) * (1 + MetChain_NumUse() / MetSkip));
+
+}
+
+/** function to initialize chain walk state */
+
+static void MetChain_Init(MetChain *pchain, int nchain, WalkParams *pwalk, float *fdata, int num_samples, int num_use) {
+
+    pchain->nchain = nchain;
+    pchain->label[0] = '\0';
+    pchain->walk = *pwalk;
+    pchain->fdata = fdata;
+    pchain->num_samples = num_samples;
+    pchain->num_use = num_use;
+    pchain->ntry = 0;
+    pchain->nSamples = 0;
+    pchain->nSampStat = 0;
+    pchain->ipos = 0;
+    pchain->nScatterSaved = 0;
+    pchain->ngenerated = 0;
+    pchain->numClipped = 0;
+    pchain->numGridReject = 0;
+    pchain->numStaReject = 0;
+    pchain->numAcceptDeepMinima = 0;
+    pchain->currentMetStepFact = MetStepFact;
+    pchain->dlike_max = -VERY_LARGE_DOUBLE;
+    pchain->misfit_min = VERY_LARGE_DOUBLE;
+    pchain->misfit_max = -VERY_LARGE_DOUBLE;
+    pchain->xmean_sum = pchain->ymean_sum = pchain->zmean_sum = 0.0;
+    pchain->xvar_sum = pchain->yvar_sum = pchain->zvar_sum = 0.0;
+    pchain->xvar = pchain->yvar = pchain->zvar = 0.0;
+    pchain->dsamp = 0.0;
+    pchain->nconv = 0;
+    pchain->conv_sum[0] = pchain->conv_sum[1] = pchain->conv_sum[2] = 0.0;
+    pchain->conv_sum2[0] = pchain->conv_sum2[1] = pchain->conv_sum2[2] = 0.0;
+    pchain->iAbort = 0;
+    pchain->iStuck = 0;
+    pchain->abort_comm[0] = '\0';
+    pchain->done = 0;
+    pchain->perf_num_nodes = 0;
+    pchain->perf_num_interp = 0;
+
+}
+
+/** function to advance the walk of a chain until num_samples_stop samples are accepted or the walk ends */
+
+static void MetChain_Walk(MetChain *pchain, int num_arr_loc, GridDesc* ptgrid, int num_samples_stop) {
+
+    int istat;
+    int narr;
+    int maxNumTries;
+    int writeMessage = 0;
+    int iGridType;
+    int nReject;
+    int iAccept;
+    double xval, yval, zval;
+    double value, dlike, misfit;
+    double xmin, xmax, ymin, ymax, zmin, zmax;
+    double dx_test, dsamp2;
+
+    WalkParams *pMetrop = &(pchain->walk);
+    ArrivalDesc *arrival = pchain->arrival;
+    GaussLocParams *gauss_par = pchain->gauss_par;
+    float *fdata = pchain->fdata;
+
+    int ntry = pchain->ntry, nSamples = pchain->nSamples, nSampStat = pchain->nSampStat, ipos = pchain->ipos;
+    double xmean_sum = pchain->xmean_sum, ymean_sum = pchain->ymean_sum, zmean_sum = pchain->zmean_sum;
+    double xvar_sum = pchain->xvar_sum, yvar_sum = pchain->yvar_sum, zvar_sum = pchain->zvar_sum;
+    double xvar = pchain->xvar, yvar = pchain->yvar, zvar = pchain->zvar, dsamp = pchain->dsamp;
+
+
     iGridType = GRID_PROB_DENSITY;
 
     /* set walk limits equal to grid limits */
@@ -7129,30 +7758,20 @@ int LocMetropolis(int ngrid, int num_arr_total, int num_arr_loc,
     zmin = ptgrid->origz;
     zmax = zmin + (double) (ptgrid->numz - 1) * ptgrid->dz;
 
-    /* save intiial values */
-    currentMetStepFact = MetStepFact;
-    dx_init = pMetrop->dx;
-
 
     /* loop over walk samples */
 
-    nSamples = 0;
-    nSampStat = 0;
-    nScatterSaved = 0;
-    ipos = 0;
-    ntry = 0;
-    ngenerated = 0;
     maxNumTries = MAX_NUM_MET_TRIES;
-    while (nSamples < MetNumSamples
+    while (nSamples < pchain->num_samples && nSamples < num_samples_stop
             && (nSamples <= MetLearn || ntry < maxNumTries)) {
 
         ntry++;
-        ngenerated++;
+        pchain->ngenerated++;
         istat = GetNextMetropolisSample(pMetrop,
                 xmin, xmax, ymin, ymax,
                 zmin, zmax, &xval, &yval, &zval);
         if (nSamples > MetEquil && istat > 0)
-            numClipped += istat;
+            pchain->numClipped += istat;
 
         /* get travel times for observed arrivals */
 
@@ -7163,18 +7782,18 @@ int LocMetropolis(int ngrid, int num_arr_total, int num_arr_loc,
 
         } else {
 
-            nReject = getTravelTimes(arrival, num_arr_loc, xval, yval, zval);
+            nReject = getTravelTimes(pNLLocContext, arrival, num_arr_loc, xval, yval, zval);
 
             if (nReject) {
-                numGridReject++;
-                numStaReject += nReject;
+                pchain->numGridReject++;
+                pchain->numStaReject += nReject;
                 misfit = -1.0;
                 dlike = 0.0;
             } else {
 
                 /* calc misfit or prob density */
                 double log_prior;
-                value = CalcSolutionQuality(xval, yval, zval, NULL, num_arr_loc, arrival, gauss_par,
+                value = CalcSolutionQuality(pNLLocContext, xval, yval, zval, NULL, num_arr_loc, arrival, gauss_par,
                         iGridType, &misfit, NULL, NULL, 0.0, 0.0, 0.0, NULL, NULL, &log_prior);
                 value += log_prior; // 20190513 AJL
                 dlike = gauss_par->WtMtrxSum * exp(value);
@@ -7186,12 +7805,12 @@ int LocMetropolis(int ngrid, int num_arr_total, int num_arr_loc,
                 if (!iAccept && ntry == maxNumTries) {
                     /* if not learning, accept anyway since
                     may be stuck in a deep minima */
-                    if (nSamples >= MetLearn && numAcceptDeepMinima++ < 5) {
+                    if (nSamples >= MetLearn && pchain->numAcceptDeepMinima++ < 5) {
                         iAccept = 1;
                         //printf("Max Num Tries: accept deep minima\n");
 
                         /* try reducing step size */
-                        currentMetStepFact /= 2.0;
+                        pchain->currentMetStepFact /= 2.0;
                         ntry = 0;
                         //printf("            +: step ch: was %lf\n", pMetrop->dx);
 
@@ -7216,19 +7835,18 @@ int LocMetropolis(int ngrid, int num_arr_total, int num_arr_loc,
                     nSamples++;
 
                     /* check for minimum misfit */
-                    if (misfit < misfit_min) {
-                        misfit_min = misfit;
-                        dlike_max = dlike;
-                        phypo->misfit = misfit;
-                        phypo->x = xval;
-                        phypo->y = yval;
-                        phypo->z = zval;
+                    if (misfit < pchain->misfit_min) {
+                        pchain->misfit_min = misfit;
+                        pchain->dlike_max = dlike;
+                        pchain->x_best = xval;
+                        pchain->y_best = yval;
+                        pchain->z_best = zval;
                         for (narr = 0; narr < num_arr_loc; narr++)
                             arrival[narr].pred_travel_time_best =
                                 arrival[narr].pred_travel_time;
                     }
-                    if (misfit > misfit_max)
-                        misfit_max = misfit;
+                    if (misfit > pchain->misfit_max)
+                        pchain->misfit_max = misfit;
 
                     /* update sample location */
                     pMetrop->x = xval;
@@ -7261,9 +7879,9 @@ int LocMetropolis(int ngrid, int num_arr_total, int num_arr_loc,
                                 ymean_sum * ymean_sum / dsamp2;
                         zvar = zvar_sum / dsamp -
                                 zmean_sum * zmean_sum / dsamp2;
-                        dx_test = currentMetStepFact * pow(
+                        dx_test = pchain->currentMetStepFact * pow(
                                 sqrt(xvar) * sqrt(yvar) * sqrt(zvar)
-                                / (double) MetUse, 1.0 / 3.0);
+                                / (double) pchain->num_use, 1.0 / 3.0);
                         /*/ (double) (MetUse / MetSkip),*/
                         //if (pMetrop->dx != dx_test) printf("equil step ch: %lf -> %lf\n", pMetrop->dx, dx_test);
 
@@ -7273,6 +7891,17 @@ int LocMetropolis(int ngrid, int num_arr_total, int num_arr_loc,
                             pMetrop->dx = MetStepMin;
                     }
 
+                    /* if after burn-in, update convergence statistic sums */
+                    if (nSamples > MetStartSave) {
+                        pchain->nconv++;
+                        pchain->conv_sum[0] += xval;
+                        pchain->conv_sum[1] += yval;
+                        pchain->conv_sum[2] += zval;
+                        pchain->conv_sum2[0] += xval * xval;
+                        pchain->conv_sum2[1] += yval * yval;
+                        pchain->conv_sum2[2] += zval * zval;
+                    }
+
                     /* if saving samples */
                     if (nSamples > MetStartSave
                             && nSamples % MetSkip == 0) {
@@ -7289,7 +7918,7 @@ int LocMetropolis(int ngrid, int num_arr_total, int num_arr_loc,
                                 num_arr_loc, arrival, 1.0);
 
 
-                        nScatterSaved++;
+                        pchain->nScatterSaved++;
                     }
 
                     if (nSamples % 1000 == 1
@@ -7302,7 +7931,7 @@ int LocMetropolis(int ngrid, int num_arr_total, int num_arr_loc,
                 if (writeMessage || ntry == maxNumTries - 1) {
                     if (message_flag >= 4) {
                         sprintf(MsgStr,
-                                "Metropolis: n %d x %.2lf y %.2lf z %.2lf  xm %.2lf ym %.2lf zm %.2lf  xdv %.2lf ydv %.2lf zdv %.2lf  dx %.2lf  li %.2le", nSamples, pMetrop->x, pMetrop->y, pMetrop->z, xmean_sum / dsamp, ymean_sum / dsamp, zmean_sum / dsamp, sqrt(xvar), sqrt(yvar), sqrt(zvar), pMetrop->dx, pMetrop->likelihood);
+                                "Metropolis: %sn %d x %.2lf y %.2lf z %.2lf  xm %.2lf ym %.2lf zm %.2lf  xdv %.2lf ydv %.2lf zdv %.2lf  dx %.2lf  li %.2le", pchain->label, nSamples, pMetrop->x, pMetrop->y, pMetrop->z, xmean_sum / dsamp, ymean_sum / dsamp, zmean_sum / dsamp, sqrt(xvar), sqrt(yvar), sqrt(zvar), pMetrop->dx, pMetrop->likelihood);
                         nll_putmsg(4, MsgStr);
                     }
                     writeMessage = 0;
@@ -7317,26 +7946,412 @@ int LocMetropolis(int ngrid, int num_arr_total, int num_arr_loc,
         /* failure to accept sample after maxNumTries */
         if (nSamples > MetLearn && ntry >= maxNumTries) {
             sprintf(MsgStr,
-                    "ERROR: failed to accept new Metropolis sample after %d tries, aborting location.", ntry);
+                    "ERROR: %sfailed to accept new Metropolis sample after %d tries, aborting location.", pchain->label, ntry);
             nll_puterr(MsgStr);
-            snprintf(phypo->locStatComm, sizeof (phypo->locStatComm), "%s", MsgStr);
-            iAbort = 1;
+            snprintf(pchain->abort_comm, sizeof (pchain->abort_comm), "%s", MsgStr);
+            pchain->iAbort = 1;
             break;
         }
 
         /* maximum likelihood too low after learning stage */
-        if (nSamples == MetLearn && dlike_max < MetProbMin) {
+        if (nSamples == MetLearn && pchain->dlike_max < MetProbMin) {
             sprintf(MsgStr,
-                    "ERROR: after learning stage (%d samples), best probability = %.2le is less than ProbMin = %.2le, aborting location.",
-                    MetLearn, dlike_max, MetProbMin);
+                    "ERROR: %safter learning stage (%d samples), best probability = %.2le is less than ProbMin = %.2le, aborting location.",
+                    pchain->label, MetLearn, pchain->dlike_max, MetProbMin);
             nll_puterr(MsgStr);
-            snprintf(phypo->locStatComm, sizeof (phypo->locStatComm), "%s", MsgStr);
-            iAbort = 1;
+            snprintf(pchain->abort_comm, sizeof (pchain->abort_comm), "%s", MsgStr);
+            pchain->iAbort = 1;
             break;
         }
 
     }
 
+    if (pchain->iAbort || nSamples >= pchain->num_samples || !(nSamples <= MetLearn || ntry < maxNumTries))
+        pchain->done = 1;
+
+    /* save walk state */
+    pchain->ntry = ntry;
+    pchain->nSamples = nSamples;
+    pchain->nSampStat = nSampStat;
+    pchain->ipos = ipos;
+    pchain->xmean_sum = xmean_sum;
+    pchain->ymean_sum = ymean_sum;
+    pchain->zmean_sum = zmean_sum;
+    pchain->xvar_sum = xvar_sum;
+    pchain->yvar_sum = yvar_sum;
+    pchain->zvar_sum = zvar_sum;
+    pchain->xvar = xvar;
+    pchain->yvar = yvar;
+    pchain->zvar = zvar;
+    pchain->dsamp = dsamp;
+
+}
+
+/** function to advance one chain of a multiple chain walk, may be called by any thread */
+
+static void MetChain_Advance(MetChain *pchain, int num_arr_total, int num_arr_loc, GridDesc* ptgrid, int num_samples_stop) {
+
+    RandStream rand_stream_thread;
+    long num_nodes = LocPerfEvent.num_nodes;
+    long num_interp = LocPerfEvent.num_interp;
+
+    if (pchain->done)
+        return;
+
+    // chain arrivals may be at same address as other arrivals previously used by this thread
+    if (ArrivalHot_Build(pchain->arrival, num_arr_total) < 0) {
+        snprintf(pchain->abort_comm, sizeof (pchain->abort_comm), "ERROR: %sbuilding hot arrival table.", pchain->label);
+        nll_puterr(pchain->abort_comm);
+        pchain->iAbort = 1;
+        pchain->done = 1;
+        return;
+    }
+
+    // walk with random number stream of chain, restore stream of thread
+    rand_stream_get(&rand_stream_thread);
+    rand_stream_set(&(pchain->rand_stream));
+    MetChain_Walk(pchain, num_arr_loc, ptgrid, num_samples_stop);
+    rand_stream_get(&(pchain->rand_stream));
+    rand_stream_set(&rand_stream_thread);
+
+    // counters of walking thread are restored, counters of chain are added to locating thread in MetChain_Run()
+    pchain->perf_num_nodes += LocPerfEvent.num_nodes - num_nodes;
+    pchain->perf_num_interp += LocPerfEvent.num_interp - num_interp;
+    LocPerfEvent.num_nodes = num_nodes;
+    LocPerfEvent.num_interp = num_interp;
+
+}
+
+/** function to set up the chains of a multiple chain walk
+ *
+ * returns < 0 on error
+ */
+
+static int MetChain_Setup(int num_chains, int num_arr_total, int num_arr_loc, ArrivalDesc *arrival,
+        GaussLocParams* gauss_par, WalkParams* pMetrop, float* fdata, GridDesc* ptgrid) {
+
+    int nchain, narr, ntry;
+    double xval, yval, zval;
+    int num_use, max_scatter;
+    MetChain *pchain;
+
+    num_use = MetChain_NumUse();
+    max_scatter = 1 + num_use / MetSkip;
+
+    for (nchain = 0; nchain < num_chains; nchain++) {
+        pchain = MetChains + nchain;
+        MetChain_Init(pchain, nchain, pMetrop, fdata + 4 * nchain * max_scatter,
+                MetUse > 0 ? MetStartSave + num_use : MetNumSamples, num_use);
+        sprintf(pchain->label, "chain %d: ", nchain);
+        // event data
+        if (num_arr_total > pchain->num_arrival_alloc) {
+            free(pchain->arrival_copy);
+            if ((pchain->arrival_copy = (ArrivalDesc *) malloc(num_arr_total * sizeof (ArrivalDesc))) == NULL) {
+                pchain->num_arrival_alloc = 0;
+                return (-1);
+            }
+            pchain->num_arrival_alloc = num_arr_total;
+        }
+        memcpy(pchain->arrival_copy, arrival, num_arr_total * sizeof (ArrivalDesc));
+        pchain->arrival = pchain->arrival_copy;
+        pchain->gauss_copy = *gauss_par;
+        if (iUseGauss2) {
+            if (num_arr_loc > pchain->edt_mtx_size) {
+                free_matrix_double(pchain->edt_mtx, pchain->edt_mtx_size, pchain->edt_mtx_size);
+                pchain->edt_mtx_size = 0;
+                if ((pchain->edt_mtx = matrix_double(num_arr_loc, num_arr_loc)) == NULL)
+                    return (-1);
+                pchain->edt_mtx_size = num_arr_loc;
+            }
+            for (narr = 0; narr < num_arr_loc; narr++)
+                memcpy(pchain->edt_mtx[narr], gauss_par->EDTMtrx[narr], num_arr_loc * sizeof (double));
+            pchain->gauss_copy.EDTMtrx = pchain->edt_mtx;
+        }
+        pchain->gauss_par = &(pchain->gauss_copy);
+        // random number stream split in chain order from the stream of the locating thread
+        rand_stream_split(&(pchain->rand_stream), nchain);
+        // 20261017 agent - added, chains after first start at random point in search grid below topography
+        for (ntry = 0; nchain > 0 && ntry < MAX_NUM_MET_TRIES; ntry++) {
+            xval = rand_stream_double(&(pchain->rand_stream), ptgrid->origx, ptgrid->origx + (double) (ptgrid->numx - 1) * ptgrid->dx);
+            yval = rand_stream_double(&(pchain->rand_stream), ptgrid->origy, ptgrid->origy + (double) (ptgrid->numy - 1) * ptgrid->dy);
+            zval = rand_stream_double(&(pchain->rand_stream), ptgrid->origz, ptgrid->origz + (double) (ptgrid->numz - 1) * ptgrid->dz);
+            if (!isAboveTopo(xval, yval, zval)) {
+                pchain->walk.x = xval;
+                pchain->walk.y = yval;
+                pchain->walk.z = zval;
+                break;
+            }
+        }
+    }
+
+    return (0);
+
+}
+
+/** function to calculate the Gelman-Rubin potential scale reduction factor of the chains
+ *
+ * returns maximum of x, y and z factors, < 0.0 if not available
+ */
+
+static double MetChain_Rhat(MetChain *chain, int num_chains) {
+
+    int nchain, ncomp, num_used = 0;
+    double mean[MET_MAX_NUM_CHAINS];
+    double dn, n_mean, w, mean_mean, b_n, var_plus, rhat, rhat_max = -1.0;
+
+    for (nchain = 0; nchain < num_chains; nchain++) {
+        if (!chain[nchain].iAbort && chain[nchain].nconv < 2)
+            return (-1.0);
+        if (!chain[nchain].iAbort)
+            num_used++;
+    }
+    if (num_used < 2)
+        return (-1.0);
+
+    for (ncomp = 0; ncomp < 3; ncomp++) {
+        w = 0.0;
+        n_mean = 0.0;
+        mean_mean = 0.0;
+        for (nchain = 0; nchain < num_chains; nchain++) {
+            if (chain[nchain].iAbort)
+                continue;
+            dn = (double) chain[nchain].nconv;
+            mean[nchain] = chain[nchain].conv_sum[ncomp] / dn;
+            // within-chain variance
+            w += (chain[nchain].conv_sum2[ncomp] - dn * mean[nchain] * mean[nchain]) / (dn - 1.0);
+            n_mean += dn;
+            mean_mean += mean[nchain];
+        }
+        w /= (double) num_used;
+        n_mean /= (double) num_used;
+        mean_mean /= (double) num_used;
+        // between-chain variance / n
+        b_n = 0.0;
+        for (nchain = 0; nchain < num_chains; nchain++) {
+            if (!chain[nchain].iAbort)
+                b_n += (mean[nchain] - mean_mean) * (mean[nchain] - mean_mean);
+        }
+        b_n /= (double) (num_used - 1);
+        var_plus = (n_mean - 1.0) / n_mean * w + b_n;
+        if (w > SMALL_DOUBLE)
+            rhat = sqrt(var_plus / w);
+        else
+            rhat = b_n > SMALL_DOUBLE ? VERY_LARGE_DOUBLE : 1.0;
+        if (rhat > rhat_max)
+            rhat_max = rhat;
+    }
+
+    return (rhat_max);
+
+}
+
+/** function to free chain memory */
+
+static void MetChain_Free() {
+
+    int nchain;
+
+    for (nchain = 0; nchain < MetChainsAlloc; nchain++) {
+        free(MetChains[nchain].arrival_copy);
+        free_matrix_double(MetChains[nchain].edt_mtx, MetChains[nchain].edt_mtx_size, MetChains[nchain].edt_mtx_size);
+    }
+    free(MetChains);
+    MetChains = NULL;
+    MetChainsAlloc = 0;
+
+}
+
+/** end of Metropolis chains */
+/*------------------------------------------------------------/ */
+
+
+
+/** function to perform Metropolis location */
+
+int LocMetropolis(int ngrid, int num_arr_total, int num_arr_loc,
+        ArrivalDesc *arrival,
+        GridDesc* ptgrid, GaussLocParams* gauss_par, HypoDesc* phypo,
+        WalkParams* pMetrop, float* fdata) {
+
+    int narr, nchain, num_chains, num_used, nround;
+    int nSamples = 0, nScatterSaved = 0, numClipped = 0, numGridReject = 0, numStaReject = 0;
+    long int ngenerated = 0;
+    int iAbort = 0, iReject = 0;
+    int iBoundary = 0;
+    int iGridType;
+    int num_check, num_samples_stop, iConverged = 0;
+    double rhat = -1.0;
+    double dx_init;
+    double misfit_max = -VERY_LARGE_DOUBLE;
+    double dlike_max;
+    MetChain *pchain, *pchain_best;
+
+
+
+    /* get solution quality at each sample on random walk */
+
+    if (message_flag >= 4) {
+        nll_putmsg(4, "");
+        nll_putmsg(4, "Calculating solution along Metropolis walk...");
+    }
+
+    iGridType = GRID_PROB_DENSITY;
+
+    /* save intiial values */
+    dx_init = pMetrop->dx;
+
+    num_chains = MetNumChains > 1 ? MetNumChains : 1;
+    if (num_chains > MetChainsAlloc) {
+        MetChain_Free();
+        if ((MetChains = (MetChain *) calloc(num_chains, sizeof (MetChain))) == NULL) {
+            nll_puterr("ERROR: allocating memory for Metropolis chains.");
+            return (-1);
+        }
+        MetChainsAlloc = num_chains;
+    }
+
+
+    if (num_chains == 1) {
+
+        /* single walk on event arrivals */
+
+        pchain = MetChains;
+        MetChain_Init(pchain, 0, pMetrop, fdata, MetNumSamples, MetUse);
+        pchain->arrival = arrival;
+        pchain->gauss_par = gauss_par;
+        MetChain_Walk(pchain, num_arr_loc, ptgrid, MetNumSamples);
+
+    } else {
+
+        /* multiple chains */
+
+        if (MetChain_Setup(num_chains, num_arr_total, num_arr_loc, arrival, gauss_par, pMetrop, fdata, ptgrid) < 0) {
+            nll_puterr("ERROR: allocating memory for Metropolis chains.");
+            return (-1);
+        }
+
+        // advance chains in rounds, check convergence after each round after burn-in
+        num_check = MetChain_NumUse() / MET_CHAIN_NUM_CHECKS;
+        if (MetChainRhatMax <= 1.0 || num_check < 1)
+            num_check = MetChains[0].num_samples;
+        num_samples_stop = MetStartSave + num_check;
+        for (nround = 0; ; nround++) {
+            MetChain_Run(MetChains, num_chains, num_arr_total, num_arr_loc, ptgrid, num_samples_stop);
+            for (nchain = 0; nchain < num_chains && MetChains[nchain].done; nchain++)
+                ;
+            if (nchain == num_chains)
+                break;
+            if (MetChainRhatMax > 1.0 && nround > 0) {
+                rhat = MetChain_Rhat(MetChains, num_chains);
+                if (message_flag >= 3) {
+                    sprintf(MsgStr, "Metropolis: chains: nAcc/chain %d  Rhat %.4lf", num_samples_stop, rhat);
+                    nll_putmsg(3, MsgStr);
+                }
+                if (rhat > 0.0 && rhat < MetChainRhatMax) {
+                    iConverged = 1;
+                    break;
+                }
+            }
+            num_samples_stop += num_check;
+        }
+        rhat = MetChain_Rhat(MetChains, num_chains);
+        if (iConverged) {
+            sprintf(MsgStr, "Metropolis: chains converged after %d accepted samples per chain, Rhat %.4lf < maxRhat %.4lf.",
+                    num_samples_stop, rhat, MetChainRhatMax);
+            nll_putmsg(2, MsgStr);
+        }
+
+        // hot arrival table was built for chain arrivals
+        if (ArrivalHot_Build(arrival, num_arr_total) < 0)
+            return (-1);
+
+    }
+
+
+    /* combine chains, aborted chains are not used if other chains completed */
+
+    num_used = 0;
+    dlike_max = 0.0;
+    for (nchain = 0; nchain < num_chains; nchain++) {
+        if (!MetChains[nchain].iAbort) {
+            num_used++;
+            if (MetChains[nchain].dlike_max > dlike_max)
+                dlike_max = MetChains[nchain].dlike_max;
+        }
+    }
+    if (num_used == 0)
+        iAbort = 1;
+    // 20261017 agent - added, chains started away from the max likelihood that did not reach it are not used
+    for (nchain = 0; nchain < num_chains && !iAbort; nchain++) {
+        pchain = MetChains + nchain;
+        pchain->iStuck = !pchain->iAbort && pchain->dlike_max < MET_CHAIN_LIKE_RATIO_MIN * dlike_max;
+        if (pchain->iStuck)
+            num_used--;
+    }
+    pchain_best = NULL;
+    for (nchain = 0; nchain < num_chains; nchain++) {
+        pchain = MetChains + nchain;
+        ngenerated += pchain->ngenerated;
+        nSamples += pchain->nSamples;
+        numClipped += pchain->numClipped;
+        numGridReject += pchain->numGridReject;
+        numStaReject += pchain->numStaReject;
+        if (iAbort && nchain == 0)
+            snprintf(phypo->locStatComm, sizeof (phypo->locStatComm), "%s", pchain->abort_comm);
+        pchain->used = iAbort || (!pchain->iAbort && !pchain->iStuck);
+        if (!pchain->used) {
+            if (pchain->iAbort)
+                sprintf(MsgStr, "WARNING: Metropolis %saborted, samples of chain not used.", pchain->label);
+            else
+                sprintf(MsgStr, "WARNING: Metropolis %smax likelihood %.3le < %.1le * max likelihood of chains %.3le, samples of chain not used.",
+                    pchain->label, pchain->dlike_max, MET_CHAIN_LIKE_RATIO_MIN, dlike_max);
+            nll_putmsg(1, MsgStr);
+            continue;
+        }
+        // best chain has highest likelihood at its minimum misfit sample
+        if (pchain_best == NULL || pchain->dlike_max > pchain_best->dlike_max)
+            pchain_best = pchain;
+        if (pchain->misfit_max > misfit_max)
+            misfit_max = pchain->misfit_max;
+        // scatter samples of chains are stored consecutively
+        if (num_chains > 1)
+            memmove(fdata + 4 * nScatterSaved, pchain->fdata, 4 * pchain->nScatterSaved * sizeof (float));
+        nScatterSaved += pchain->nScatterSaved;
+    }
+
+    /* probabilistic residuals, sums of chains started from event arrival sums */
+    if (num_chains > 1) {
+        for (narr = 0; narr < num_arr_loc; narr++) {
+            double pdf_residual_sum = arrival[narr].pdf_residual_sum;
+            double pdf_weight_sum = arrival[narr].pdf_weight_sum;
+            for (nchain = 0; nchain < num_chains; nchain++) {
+                if (!MetChains[nchain].used)
+                    continue;
+                arrival[narr].pdf_residual_sum += MetChains[nchain].arrival[narr].pdf_residual_sum - pdf_residual_sum;
+                arrival[narr].pdf_weight_sum += MetChains[nchain].arrival[narr].pdf_weight_sum - pdf_weight_sum;
+            }
+        }
+    }
+
+    /* best location */
+    if (pchain_best->misfit_min < VERY_LARGE_DOUBLE) {
+        phypo->misfit = pchain_best->misfit_min;
+        phypo->x = pchain_best->x_best;
+        phypo->y = pchain_best->y_best;
+        phypo->z = pchain_best->z_best;
+        if (num_chains > 1) {
+            for (narr = 0; narr < num_arr_loc; narr++)
+                arrival[narr].pred_travel_time_best = pchain_best->arrival[narr].pred_travel_time_best;
+        }
+    }
+    *pMetrop = pchain_best->walk;
+    if (num_chains > 1) {
+        for (nchain = 0; nchain < num_chains; nchain++) {
+            LocPerfEvent.num_nodes += MetChains[nchain].perf_num_nodes;
+            LocPerfEvent.num_interp += MetChains[nchain].perf_num_interp;
+        }
+    }
+
 
     /* give warning if sample points clipped */
 
@@ -7368,9 +8383,16 @@ int LocMetropolis(int ngrid, int num_arr_total, int num_arr_loc,
     }
 
     /* construct search information string */
-    sprintf(phypo->searchInfo,
-            "METROPOLIS nSamp %ld nAcc %d nSave %d nClip %d Dstep0 %lf Dstep %lf%c",
-            ngenerated, nSamples, nScatterSaved, numClipped, dx_init, pMetrop->dx, '\0');
+    if (num_chains == 1) {
+        sprintf(phypo->searchInfo,
+                "METROPOLIS nSamp %ld nAcc %d nSave %d nClip %d Dstep0 %lf Dstep %lf%c",
+                ngenerated, nSamples, nScatterSaved, numClipped, dx_init, pMetrop->dx, '\0');
+    } else {
+        sprintf(phypo->searchInfo,
+                "METROPOLIS nSamp %ld nAcc %d nSave %d nClip %d Dstep0 %lf Dstep %lf nChain %d nChainUsed %d Rhat %lf%s%c",
+                ngenerated, nSamples, nScatterSaved, numClipped, dx_init, pMetrop->dx, num_chains, num_used, rhat,
+                iConverged ? " CONVERGED" : "", '\0');
+    }
     /* write message */
     nll_putmsg(2, phypo->searchInfo);
 
@@ -7576,7 +8598,7 @@ int SaveBestLocation(OctNode* poct_node, int num_arr_total, int num_arr_loc, Arr
             // save station information (will be overwritten in OpenGrid3dFile()
             station = arrival[narr].station;
             sprintf(filename, "%s.time", arrival[narr].fileroot);
-            if ((istat = OpenGrid3dFile(filename,
+            if ((istat = NLL_OpenGrid3dFile(filename,
                     &(arrival[narr].fpgrid),
                     &(arrival[narr].fphdr),
                     &(arrival[narr].gdesc), "time",
@@ -7617,7 +8639,7 @@ int SaveBestLocation(OctNode* poct_node, int num_arr_total, int num_arr_loc, Arr
                 if (arrival[narr].pred_travel_time > 0.0) // ignore arrivals with no pred tt
                     arrival[narr].pred_travel_time += arrival[narr].elev_corr;
             }
-            CloseGrid3dFile(&(arrival[narr].gdesc), &(arrival[narr].fpgrid), &(arrival[narr].fphdr));
+            NLL_CloseGrid3dFile(&(arrival[narr].gdesc), &(arrival[narr].fpgrid), &(arrival[narr].fphdr));
 
         }
 
@@ -7661,11 +8683,14 @@ int SaveBestLocation(OctNode* poct_node, int num_arr_total, int num_arr_loc, Arr
 
     }
 
+    // 20261016 agent - added, best travel times set directly in ArrivalDesc
+    ArrivalHot_LoadPred(arrival, num_arr_total);
+
     /* calc misfit or prob density */
     double value, misfit, otime, otime_var, effective_cell_size, ot_variance_factor;
     otime_var = -1.0;
     double log_prior;
-    value = CalcSolutionQuality(phypo->x, phypo->y, phypo->z, poct_node, num_arr_loc, arrival, gauss_par, iGridType, &misfit, &otime, &otime_var,
+    value = CalcSolutionQuality(pNLLocContext, phypo->x, phypo->y, phypo->z, poct_node, num_arr_loc, arrival, gauss_par, iGridType, &misfit, &otime, &otime_var,
             cell_diagonal_time_var_best, cell_diagonal_best, cell_volume_best, &effective_cell_size, &ot_variance_factor, &log_prior);
     value += log_prior; // 20190513 AJL
 
@@ -7711,6 +8736,11 @@ int ReadArrivalSheets(int num_arrivals, ArrivalDesc *arrival, double xsheet) {
         if (arrival[narr].n_companion >= 0)
             continue;
 
+        /* skip sheet read for 3D grid in memory */
+        // 20261016 agent - added
+        if (arrival[narr].gdesc.type == GRID_TIME && arrival[narr].gdesc.buffer != NULL)
+            continue;
+
         /* skip sheet read or set xsheet to zero for 2D grid */
         if (arrival[narr].gdesc.type == GRID_TIME_2D) {
             if (arrival[narr].sheetdesc.origx < LARGE_DOUBLE)
@@ -7803,7 +8833,7 @@ int ReadArrivalSheets(int num_arrivals, ArrivalDesc *arrival, double xsheet) {
 
 /** function to construct weight matrix (inverse of covariance matrix) */
 
-int ConstWeightMatrix(int num_arrivals, ArrivalDesc *arrival, GaussLocParams * gauss_par) {
+int ConstWeightMatrix(NLLocContext *pcontext, int num_arrivals, ArrivalDesc *arrival, GaussLocParams * gauss_par) {
 
     //printf("DEBUG: ConstWeightMatrix: num_arrivals %d\n", num_arrivals);
 
@@ -8161,27 +9191,86 @@ void CalcCenteredTimesPred(int num_arrivals, ArrivalDesc *arrival, GaussLocParam
 
 }
 
-//static double maxvalue = -1.0;
+/** function to calculate weighted mean of predicted travel times, hot arrival table version of CalcCenteredTimesPred() */
 
-#define STACK_POSTERIOR
-// various test to satisfy Reviewer #1
-//#define TEST_TARGET_PRODUCT_POSTERIOR
-//#define TEST_FULL_PRODUCT_POSTERIOR
+// 20261016 agent - added
 
-#ifdef STACK_POSTERIOR
+static void CalcCenteredTimesPred_Hot(int num_arrivals, ArrivalHotTable *hot, GaussLocParams * gauss_par) {
 
-// stack over all other events and target event with coherence weights
+    int nrow, ncol, narr;
+    double sum, weighted_mean, pred_time_row;
+    MatrixDouble wtmtx;
+    double *wtmtxrow, wt_sum;
+    double *pred_travel_time = hot->pred_travel_time;
+    int *abs_time = hot->abs_time;
 
-double getLogPdfValue(SearchPdfGridDesc *searchPdfGrid, double hypo_x, double hypo_y, double hypo_z) {
 
-    double log_pdf_value = 0.0;
+    if (!FixOriginTimeFlag) {
 
-    if (searchPdfGrid->gridType == PDF_GRID_GRID) {
-        double pdf_value = (double) ReadAbsInterpGrid3d(NULL, &searchPdfGrid->grid, hypo_x, hypo_y, hypo_z, 1);
-        if (pdf_value < searchPdfGrid->default_value) {
-            pdf_value = searchPdfGrid->default_value;
+        wtmtx = gauss_par->WtMtrx;
+        sum = 0.0;
+        wt_sum = 0.0;
+
+        for (nrow = 0; nrow < num_arrivals; nrow++) {
+            if (pred_travel_time[nrow] <= 0.0 || !abs_time[nrow])
+                continue; // ignore obs without predicted times or without absolute timing
+            wtmtxrow = wtmtx[nrow];
+            pred_time_row = pred_travel_time[nrow];
+            for (ncol = 0; ncol < num_arrivals; ncol++) {
+                if (pred_travel_time[ncol] <= 0.0 || !abs_time[ncol])
+                    continue;
+                sum += (double) *(wtmtxrow + ncol) * pred_time_row;
+                wt_sum += (double) *(wtmtxrow + ncol);
+            }
         }
-        if (pdf_value > FLT_MIN) {
+
+        if (wt_sum > 0.0)
+            weighted_mean = sum / wt_sum;
+        else
+            weighted_mean = (long double) pred_travel_time[0];
+
+    } else {
+
+        // for fixed origin time use travel time directly
+        weighted_mean = 0.0;
+
+    }
+
+
+    /* set centered predicted times */
+
+    for (narr = 0; narr < num_arrivals; narr++) {
+        if (pred_travel_time[narr] <= 0.0)
+            continue; // ignore obs without predicted times
+        hot->pred_centered[narr] = pred_travel_time[narr] - weighted_mean;
+    }
+
+
+    gauss_par->meanPred = (double) weighted_mean;
+
+}
+
+//static double maxvalue = -1.0;
+
+#define STACK_POSTERIOR
+// various test to satisfy Reviewer #1
+//#define TEST_TARGET_PRODUCT_POSTERIOR
+//#define TEST_FULL_PRODUCT_POSTERIOR
+
+#ifdef STACK_POSTERIOR
+
+// stack over all other events and target event with coherence weights
+
+double getLogPdfValue(SearchPdfGridDesc *searchPdfGrid, double hypo_x, double hypo_y, double hypo_z) {
+
+    double log_pdf_value = 0.0;
+
+    if (searchPdfGrid->gridType == PDF_GRID_GRID) {
+        double pdf_value = (double) ReadAbsInterpGrid3d(NULL, &searchPdfGrid->grid, hypo_x, hypo_y, hypo_z, 1);
+        if (pdf_value < searchPdfGrid->default_value) {
+            pdf_value = searchPdfGrid->default_value;
+        }
+        if (pdf_value > FLT_MIN) {
             log_pdf_value = log(pdf_value);
         }
     } else if (searchPdfGrid->gridType == PDF_GRID_OCT_TREE) {
@@ -8367,7 +9456,7 @@ double getLogPdfValue(SearchPdfGridDesc *searchPdfGrid, double hypo_x, double hy
 
 /** function to calculate probability density */
 
-double CalcSolutionQuality(double hypo_x, double hypo_y, double hypo_z, OctNode* poct_node, int num_arrivals, ArrivalDesc *arrival,
+double CalcSolutionQuality(NLLocContext *pcontext, double hypo_x, double hypo_y, double hypo_z, OctNode* poct_node, int num_arrivals, ArrivalDesc *arrival,
         GaussLocParams* gauss_par, int itype, double* pmisfit, double* potime, double* potime_var,
         double cell_half_diagonal_time_range, double cell_diagonal, double cell_volume,
         double* peffective_cell_size, double *pot_variance_factor, double *log_prior) {
@@ -8387,23 +9476,23 @@ double CalcSolutionQuality(double hypo_x, double hypo_y, double hypo_z, OctNode*
     //printf("DEBUG: hypo_x %f, hypo_y %f, hypo_z %f\n, ", hypo_x, hypo_y, hypo_z);
     double value;
     if (LocMethod == METH_GAU_ANALYTIC) {
-        value = CalcSolutionQuality_GAU_ANALYTIC(num_arrivals, arrival, gauss_par, itype, pmisfit, potime);
+        value = CalcSolutionQuality_GAU_ANALYTIC(pcontext, num_arrivals, arrival, gauss_par, itype, pmisfit, potime);
     } else if (LocMethod == METH_GAU_TEST) {
-        value = CalcSolutionQuality_GAU_TEST(num_arrivals, arrival, gauss_par, itype, pmisfit, potime);
+        value = CalcSolutionQuality_GAU_TEST(pcontext, num_arrivals, arrival, gauss_par, itype, pmisfit, potime);
     } else if (LocMethod == METH_L1_NORM) {
-        value = CalcSolutionQuality_L1_NORM(num_arrivals, arrival, gauss_par, itype, pmisfit, potime);
+        value = CalcSolutionQuality_L1_NORM(pcontext, num_arrivals, arrival, gauss_par, itype, pmisfit, potime);
     } else if (LocMethod == METH_OT_STACK) {
-        value = CalcSolutionQuality_OT_STACK(poct_node, num_arrivals, arrival,
+        value = CalcSolutionQuality_OT_STACK(pcontext, poct_node, num_arrivals, arrival,
                 gauss_par, itype, pmisfit, potime, potime_var, cell_half_diagonal_time_range, cell_diagonal, cell_volume, peffective_cell_size, pot_variance_factor);
         return (value);
     } else if (LocMethod == METH_ML_OT) {
-        value = CalcSolutionQuality_ML_OT(num_arrivals, arrival,
+        value = CalcSolutionQuality_ML_OT(pcontext, num_arrivals, arrival,
                 gauss_par, itype, pmisfit, potime, potime_var, cell_half_diagonal_time_range, 0);
     } else if (LocMethod == METH_EDT) {
-        value = CalcSolutionQuality_EDT(num_arrivals, arrival,
+        value = CalcSolutionQuality_EDT(pcontext, num_arrivals, arrival,
                 gauss_par, itype, pmisfit, potime, potime_var, cell_half_diagonal_time_range, 0);
     } else if (LocMethod == METH_EDT_BOX) {
-        value = CalcSolutionQuality_EDT(num_arrivals, arrival,
+        value = CalcSolutionQuality_EDT(pcontext, num_arrivals, arrival,
                 gauss_par, itype, pmisfit, potime, potime_var, cell_half_diagonal_time_range, 1);
     } else {
         return (-1.0);
@@ -8426,13 +9515,144 @@ double CalcSolutionQuality(double hypo_x, double hypo_y, double hypo_z, OctNode*
 
 
 
+/*------------------------------------------------------------*/
+/** EDT double kernel */
+
+// 20261016 agent - added
+//    Alternative to the long double EDT pair sum in CalcSolutionQuality_EDT() (LOCMETH ... EDTKernel = DOUBLE).
+//    The pair loop runs in double over the hot arrival table with EDT_KERNEL_NLANES independent lanes, each with
+//    compensated (Kahan) summation of the EDT probabilities; exp() is replaced by edt_exp_neg() so the lanes vectorize.
+//    The lane arithmetic does not depend on the vector width, so the generic, AVX2 and AVX-512 versions give
+//    identical results.  Results differ from the long double kernel only by rounding (see CHANGE_NOTES.txt).
+// 20261017 agent - pair loop moved to edt_kernel.c, which alone is compiled with the FP options needed to vectorize it
+
+/** function to calculate EDT pair sums in double over the hot arrival table
+ *
+ *  sets per-arrival values and returns pair sums needed by CalcSolutionQuality_EDT(), same as the long double pair loop
+ */
+
+static int CalcSolutionQuality_EDT_Double(int num_arrivals, ArrivalDesc *arrival, ArrivalHotTable *hot, MatrixDouble edtmtx,
+        int icalc_otime, int icalc_otime_default, double cell_diagonal_time_var, int method_box,
+        double *pedt_sum, double *pedt_weight, double *pot_sum, double *pot_2_sum, double *pot_weight,
+        double *pot_error_2, int *pnum_otime_error) {
+
+    int narr;
+    double tt_error, ot_row, y, t;
+    double ot_sum = 0.0, ot_sum_comp = 0.0, ot_2_sum = 0.0, ot_2_sum_comp = 0.0, ot_weight = 0.0, ot_error_2 = 0.0;
+    int num_otime_error = 0;
+    EDTKernelData kd;
+
+    // check size of work arrays
+    if (isize_edt_work < num_arrivals) {
+        isize_edt_work = num_arrivals;
+        free(edt_work);
+        if ((edt_work = (double *) calloc(6 * isize_edt_work, sizeof (double))) == NULL) {
+            nll_puterr("ERROR: allocating double storage array for EDT_KERNEL_DOUBLE edt_work.");
+            isize_edt_work = 0;
+            return (-1);
+        }
+    }
+
+    kd.num_arrivals = num_arrivals;
+    kd.arrival = arrival;
+    kd.abs_time = hot->abs_time;
+    kd.obs_centered = hot->obs_centered;
+    kd.pred_centered = hot->pred_centered;
+    kd.amplitude = hot->amplitude;
+    kd.valid = edt_work;
+    kd.sigma2 = edt_work + isize_edt_work;
+    kd.sw = edt_work + 2 * isize_edt_work;
+    kd.ap = edt_work + 3 * isize_edt_work;
+    kd.row_prob = edt_work + 4 * isize_edt_work;
+    kd.col_prob = edt_work + 5 * isize_edt_work;
+    kd.edtmtx = edtmtx;
+    kd.cell_diagonal_time_var = cell_diagonal_time_var;
+    kd.method_box = method_box;
+
+    // per-arrival values
+    for (narr = 0; narr < num_arrivals; narr++) {
+        if (hot->pred_travel_time[narr] <= 0.0) {
+            kd.valid[narr] = 0.0;
+            kd.sigma2[narr] = 1.0;
+        } else {
+            kd.valid[narr] = 1.0;
+            if (iUseGauss2) {
+                tt_error = hot->pred_travel_time[narr] * Gauss2.SigmaTfraction;
+                if (tt_error < Gauss2.SigmaTmin)
+                    tt_error = Gauss2.SigmaTmin;
+                if (tt_error > Gauss2.SigmaTmax)
+                    tt_error = Gauss2.SigmaTmax;
+                if (icalc_otime)
+                    arrival[narr].tt_error = tt_error;
+                edtmtx[narr][narr] = hot->error[narr] * hot->error[narr] + tt_error * tt_error;
+            }
+            kd.sigma2[narr] = edtmtx[narr][narr];
+        }
+        kd.sw[narr] = iSetStationDistributionWeights ? sqrt(hot->station_weight[narr]) : 1.0;
+        if (iUseArrivalPriorWeights && hot->apriori_weight[narr] >= -VERY_SMALL_DOUBLE)
+            kd.ap[narr] = hot->apriori_weight[narr] > 0.0 ? sqrt(hot->apriori_weight[narr]) : 0.0;
+        else
+            kd.ap[narr] = -1.0;
+    }
+
+    // pair sums
+    edt_pair_sums(&kd);
+
+    // per-arrival results
+    for (narr = 0; narr < num_arrivals; narr++) {
+        if (kd.valid[narr] <= 0.0) {
+            if (EDT_use_otime_weight == 2 || icalc_otime_default)
+                ot_ml_arrival_edt_sum[narr] = -1.0;
+            continue;
+        }
+        if (icalc_otime)
+            hot->weight[narr] = kd.row_prob[narr] + kd.col_prob[narr];
+        if (EDT_use_otime_weight == 2 || icalc_otime_default) { // EDT_OT_WT_ML or otime
+            ot_ml_arrival[narr] = hot->obs_time[narr] - (long double) hot->pred_travel_time[narr];
+            ot_ml_arrival_edt_sum[narr] = kd.row_prob[narr] + kd.col_prob[narr];
+            ot_error_2 += kd.sigma2[narr] + cell_diagonal_time_var;
+            num_otime_error++;
+        } else if (EDT_use_otime_weight == 1) { // EDT_OT_WT
+            ot_row = (double) (hot->obs_time[narr] - (long double) hot->pred_travel_time[narr]);
+            ot_error_2 += kd.sigma2[narr] + cell_diagonal_time_var;
+            num_otime_error++;
+            // compensated sums
+            y = kd.row_prob[narr] * ot_row - ot_sum_comp;
+            t = ot_sum + y;
+            ot_sum_comp = (t - ot_sum) - y;
+            ot_sum = t;
+            y = kd.row_prob[narr] * ot_row * ot_row - ot_2_sum_comp;
+            t = ot_2_sum + y;
+            ot_2_sum_comp = (t - ot_2_sum) - y;
+            ot_2_sum = t;
+            ot_weight += kd.row_prob[narr];
+        }
+    }
+
+    *pedt_sum = kd.edt_sum;
+    *pedt_weight = kd.edt_weight;
+    *pot_sum = ot_sum;
+    *pot_2_sum = ot_2_sum;
+    *pot_weight = ot_weight;
+    *pot_error_2 = ot_error_2;
+    *pnum_otime_error = num_otime_error;
+
+    return (0);
+
+}
+
+/** end of EDT double kernel */
+/*------------------------------------------------------------*/
+
+
+
 /** function to calculate probability density */
 
 /*	EDT - sum of probabilities of difference of obs - difference of travel times
                 for all pairs of obs
  */
 
-double CalcSolutionQuality_EDT(int num_arrivals, ArrivalDesc *arrival,
+double CalcSolutionQuality_EDT(NLLocContext *pcontext, int num_arrivals, ArrivalDesc *arrival,
         GaussLocParams* gauss_par, int itype, double* pmisfit, double* potime,
         double* potime_var, double cell_half_diagonal_time_range, int method_box) {
 
@@ -8471,6 +9691,16 @@ double CalcSolutionQuality_EDT(int num_arrivals, ArrivalDesc *arrival,
     //double error_row;
     double amp_row, unc_limit;
 
+    // 20261016 agent - added, inner loops read the SoA hot arrival table
+    ArrivalHotTable *hot = ArrivalHot_Get(arrival, num_arrivals);
+    if (hot == NULL)
+        return (-1.0);
+    double *pred_travel_time = hot->pred_travel_time;
+    double *pred_centered = hot->pred_centered;
+    double *obs_centered = hot->obs_centered;
+    double *arr_weight = hot->weight;
+    int *abs_time = hot->abs_time;
+
     // search pdf different from true
     int iuse_cell_diagonal_time_var;
     //double sigma2_row_search = 0.0;
@@ -8515,13 +9745,13 @@ double CalcSolutionQuality_EDT(int num_arrivals, ArrivalDesc *arrival,
 
     if (icalc_otime) {
         for (nrow = 0; nrow < num_arrivals; nrow++)
-            arrival[nrow].weight = 0.0;
+            arr_weight[nrow] = 0.0;
     }
 
 
     /* calculate weighted mean of predicted travel times  */
     /*		(TV82, eq. A-38) */
-    CalcCenteredTimesPred(num_arrivals, arrival, gauss_par); // not used for EDT
+    CalcCenteredTimesPred_Hot(num_arrivals, hot, gauss_par); // not used for EDT
 
 
     /* calculate EDT prop sum */
@@ -8542,150 +9772,174 @@ double CalcSolutionQuality_EDT(int num_arrivals, ArrivalDesc *arrival,
 #ifdef TEST_COUNT_ONLY_USED_ARRIVALS
     int num_arrivals_used = 0;
 #endif
-    for (nrow = 0; nrow < num_arrivals; nrow++) {
+    if (EDT_kernel == EDT_KERNEL_DOUBLE) {
+        // 20261016 agent - added, double kernel
+        double edt_sum_d, ot_sum_d, ot_2_sum_d, ot_weight_d, ot_error_2_d;
+        if (CalcSolutionQuality_EDT_Double(num_arrivals, arrival, hot, edtmtx, icalc_otime, icalc_otime_default,
+                iuse_cell_diagonal_time_var ? cell_diagonal_time_var : 0.0, method_box,
+                &edt_sum_d, &edt_weight, &ot_sum_d, &ot_2_sum_d, &ot_weight_d, &ot_error_2_d, &num_otime_error) < 0)
+            return (-1.0);
+        edt_sum = edt_sum_d;
+        ot_sum = ot_sum_d;
+        ot_2_sum = ot_2_sum_d;
+        ot_weight = ot_weight_d;
+        ot_error_2 = ot_error_2_d;
+    } else {
+        for (nrow = 0; nrow < num_arrivals; nrow++) {
 
-        //printf("DEBUG: arrival[%d].pred_travel_time %f\n", nrow, arrival[nrow].pred_travel_time);
+            //printf("DEBUG: arrival[%d].pred_travel_time %f\n", nrow, arrival[nrow].pred_travel_time);
 
-        // AJL 20041115 bug fix!
-        if (arrival[nrow].pred_travel_time <= 0.0) {
-            // iniitalize EDT_OT_WT_ML values
-            if (EDT_use_otime_weight == 2 || icalc_otime_default) {
-                ot_ml_arrival_edt_sum[nrow] = -1.0;
+            // AJL 20041115 bug fix!
+            if (pred_travel_time[nrow] <= 0.0) {
+                // iniitalize EDT_OT_WT_ML values
+                if (EDT_use_otime_weight == 2 || icalc_otime_default) {
+                    ot_ml_arrival_edt_sum[nrow] = -1.0;
+                }
+                continue; // ignore obs without predicted times
             }
-            continue; // ignore obs without predicted times
-        }
-        // END
+            // END
 
 #ifdef TEST_COUNT_ONLY_USED_ARRIVALS
-        num_arrivals_used++;
+            num_arrivals_used++;
 #endif
-        // set error
-        //printf("iUseGauss2 %d\n", iUseGauss2);
-        if (iUseGauss2) {
-            tt_error = arrival[nrow].pred_travel_time * Gauss2.SigmaTfraction;
-            if (tt_error < Gauss2.SigmaTmin)
-                tt_error = Gauss2.SigmaTmin;
-            if (tt_error > Gauss2.SigmaTmax)
-                tt_error = Gauss2.SigmaTmax;
-            if (icalc_otime) {
-                arrival[nrow].tt_error = tt_error;
-                //printf("DEBUG: arrival[nrow].pred_travel_time %f\t  tt_error %f, arrival[nrow].error %f\n", arrival[nrow].pred_travel_time, tt_error, arrival[nrow].error);
-            }
-            tt_error *= tt_error;
-            edtmtx[nrow][nrow] = arrival[nrow].error * arrival[nrow].error + tt_error;
-            sigma2_row = edtmtx[nrow][nrow];
-        }
-        sigma2_row = edtmtx[nrow][nrow];
-
-        if (iuse_cell_diagonal_time_var)
-            sigma2_row += cell_diagonal_time_var;
-        /*if (iuse_cell_diagonal_time_var) {
-        sigma2_row_search = edtmtx[nrow][nrow] + cell_diagonal_time_var;
-}*/
-        //error_row = arrival[nrow].error;
-        amp_row = arrival[nrow].amplitude;
-        obs_minus_pred = arrival[nrow].obs_centered - arrival[nrow].pred_centered;
-        no_abs_time_row = !arrival[nrow].abs_time;
-        if (EDT_use_otime_weight == 2 || icalc_otime_default) { // EDT_OT_WT_ML or otime
-            ot_ml_arrival[nrow] = arrival[nrow].obs_time - (long double) arrival[nrow].pred_travel_time;
-            //ot_ml_arrival_edt_sum[nrow] = 0.0;
-            ot_error_2 += sigma2_row;
-            num_otime_error++;
-        } else if (EDT_use_otime_weight == 1 || icalc_otime_force_ml) { // EDT_OT_WT or EDT
-            ot_prob = 0.0;
-            ot_row = arrival[nrow].obs_time - (long double) arrival[nrow].pred_travel_time;
-            ot_row_2 = ot_row * ot_row;
-            ot_error_2 += sigma2_row;
-            num_otime_error++;
-        }
-        for (ncol = nrow + 1; ncol < num_arrivals; ncol++) {
-            // AJL 20041115 bug fix!
-            if (arrival[ncol].pred_travel_time <= 0.0)
-                continue; // ignore obs without predicted times
-            // END
-            // check absolute timing
-            if (no_abs_time_row) {
-                if (arrival[ncol].abs_time) // cannot be same station/inst
-                    continue;
-                if (strcmp(arrival[nrow].label, arrival[ncol].label) != 0
-                        || strcmp(arrival[nrow].inst, arrival[ncol].inst) != 0)
-                    continue; // not same sta/inst
-            }
-            // calculate EDT misfit:  (obs1 - obs2) - (pred1 - pred2)
-            edt_misfit = (double) (obs_minus_pred + arrival[ncol].pred_centered - arrival[ncol].obs_centered);
             // set error
+            //printf("iUseGauss2 %d\n", iUseGauss2);
             if (iUseGauss2) {
-                tt_error = arrival[ncol].pred_travel_time * Gauss2.SigmaTfraction;
+                tt_error = pred_travel_time[nrow] * Gauss2.SigmaTfraction;
                 if (tt_error < Gauss2.SigmaTmin)
                     tt_error = Gauss2.SigmaTmin;
                 if (tt_error > Gauss2.SigmaTmax)
                     tt_error = Gauss2.SigmaTmax;
+                if (icalc_otime) {
+                    arrival[nrow].tt_error = tt_error;
+                    //printf("DEBUG: arrival[nrow].pred_travel_time %f\t  tt_error %f, arrival[nrow].error %f\n", arrival[nrow].pred_travel_time, tt_error, arrival[nrow].error);
+                }
                 tt_error *= tt_error;
-                edtmtx[ncol][ncol] = arrival[ncol].error * arrival[ncol].error + tt_error;
-            }
-            // calculate probability
-            if (method_box) {
-                unc_limit = amp_row + arrival[ncol].amplitude; // sum of mean pick unc for each box
-                //unc_limit = error_row + arrival[ncol].error;	// sum of box widths
-                prob = fabs(edt_misfit) <= unc_limit ? 1.0 : 0.0;
-                weight = amp_row * arrival[ncol].amplitude; // product of mean pick unc for each box
-                weight *= (1.0 - edtmtx[nrow][ncol]); // correlation coeff
-            } else {
-                if (iuse_cell_diagonal_time_var)
-                    weight2 = 1.0 / (sigma2_row + edtmtx[ncol][ncol] + cell_diagonal_time_var); // sum of errors**2
-                else
-                    weight2 = 1.0 / (sigma2_row + edtmtx[ncol][ncol]); // sum of errors**2
-                prob = exp(-0.5 * edt_misfit * edt_misfit * weight2);
-                weight = sqrt(weight2); // errors factor
-                weight *= (1.0 - edtmtx[nrow][ncol]); // correlation coeff
-                /*if (iuse_cell_diagonal_time_var) {	// duplicate above 4 lines
-                weight2_search = 1.0 / (sigma2_row_search + edtmtx[ncol][ncol] + cell_diagonal_time_var);	// sum of errors**2
-                prob_search = exp(-0.5 * edt_misfit * edt_misfit * weight2_search);
-                weight_search = sqrt(weight2_search);		// errors factor
-                weight_search *= (1.0 - edtmtx[nrow][ncol]);		// correlation coeff
-        }*/
+                edtmtx[nrow][nrow] = hot->error[nrow] * hot->error[nrow] + tt_error;
+                sigma2_row = edtmtx[nrow][nrow];
             }
-            // 20130627 AJL - change weighing from sum to product
-            //if (iSetStationDistributionWeights)
-            //    weight *= (arrival[nrow].station_weight + arrival[ncol].station_weight) / 2.0;
-            if (iSetStationDistributionWeights)
-                weight *= sqrt(arrival[nrow].station_weight * arrival[ncol].station_weight);
-            // 20130627 AJL - add prior weighting as product
-            if (iUseArrivalPriorWeights && arrival[nrow].apriori_weight >= -VERY_SMALL_DOUBLE && arrival[ncol].apriori_weight >= -VERY_SMALL_DOUBLE)
-                weight *= sqrt(arrival[nrow].apriori_weight * arrival[ncol].apriori_weight);
-            prob *= weight;
-            edt_sum += prob;
-            edt_weight += weight;
-            /*if (iuse_cell_diagonal_time_var) {	// duplicate above 5 lines
-            if (iSetStationDistributionWeights)
-            weight_search *= (arrival[nrow].station_weight + arrival[ncol].station_weight) / 2.0;
-            prob_search *= weight_search;
-            edt_sum_search += prob_search;
-            edt_weight_search += weight_search;
+            sigma2_row = edtmtx[nrow][nrow];
+
+            if (iuse_cell_diagonal_time_var)
+                sigma2_row += cell_diagonal_time_var;
+            /*if (iuse_cell_diagonal_time_var) {
+            sigma2_row_search = edtmtx[nrow][nrow] + cell_diagonal_time_var;
     }*/
-            // accumulate EDT weights
-            if (icalc_otime) {
-                //arrival[ncol].weight += weight;
-                //arrival[nrow].weight += weight;
-                arrival[ncol].weight += prob;
-                arrival[nrow].weight += prob;
-            }
-            // otime
+            //error_row = arrival[nrow].error;
+            amp_row = hot->amplitude[nrow];
+            obs_minus_pred = obs_centered[nrow] - pred_centered[nrow];
+            no_abs_time_row = !abs_time[nrow];
             if (EDT_use_otime_weight == 2 || icalc_otime_default) { // EDT_OT_WT_ML or otime
-                /*if (iuse_cell_diagonal_time_var)	// ???? TEST
-                ot_ml_arrival_edt_sum[nrow] += prob_search;
-                else*/
-                ot_ml_arrival_edt_sum[ncol] += prob;
-                // AJL 20070326 bug fix!
-                ot_ml_arrival_edt_sum[nrow] += prob;
+                ot_ml_arrival[nrow] = hot->obs_time[nrow] - (long double) pred_travel_time[nrow];
+                //ot_ml_arrival_edt_sum[nrow] = 0.0;
+                ot_error_2 += sigma2_row;
+                num_otime_error++;
             } else if (EDT_use_otime_weight == 1 || icalc_otime_force_ml) { // EDT_OT_WT or EDT
-                ot_prob += prob;
+                ot_prob = 0.0;
+                ot_row = hot->obs_time[nrow] - (long double) pred_travel_time[nrow];
+                ot_row_2 = ot_row * ot_row;
+                ot_error_2 += sigma2_row;
+                num_otime_error++;
+            }
+            for (ncol = nrow + 1; ncol < num_arrivals; ncol++) {
+                // AJL 20041115 bug fix!
+                if (pred_travel_time[ncol] <= 0.0)
+                    continue; // ignore obs without predicted times
+                // END
+                // check absolute timing
+                if (no_abs_time_row) {
+                    if (abs_time[ncol]) // cannot be same station/inst
+                        continue;
+                    if (strcmp(arrival[nrow].label, arrival[ncol].label) != 0
+                            || strcmp(arrival[nrow].inst, arrival[ncol].inst) != 0)
+                        continue; // not same sta/inst
+                }
+                // calculate EDT misfit:  (obs1 - obs2) - (pred1 - pred2)
+                edt_misfit = (double) (obs_minus_pred + pred_centered[ncol] - obs_centered[ncol]);
+                // set error
+                if (iUseGauss2) {
+                    tt_error = pred_travel_time[ncol] * Gauss2.SigmaTfraction;
+                    if (tt_error < Gauss2.SigmaTmin)
+                        tt_error = Gauss2.SigmaTmin;
+                    if (tt_error > Gauss2.SigmaTmax)
+                        tt_error = Gauss2.SigmaTmax;
+                    tt_error *= tt_error;
+                    edtmtx[ncol][ncol] = hot->error[ncol] * hot->error[ncol] + tt_error;
+                }
+                // calculate probability
+                if (method_box) {
+                    unc_limit = amp_row + hot->amplitude[ncol]; // sum of mean pick unc for each box
+                    //unc_limit = error_row + arrival[ncol].error;	// sum of box widths
+                    prob = fabs(edt_misfit) <= unc_limit ? 1.0 : 0.0;
+                    weight = amp_row * hot->amplitude[ncol]; // product of mean pick unc for each box
+                    weight *= (1.0 - edtmtx[nrow][ncol]); // correlation coeff
+                } else {
+                    if (iuse_cell_diagonal_time_var)
+                        weight2 = 1.0 / (sigma2_row + edtmtx[ncol][ncol] + cell_diagonal_time_var); // sum of errors**2
+                    else
+                        weight2 = 1.0 / (sigma2_row + edtmtx[ncol][ncol]); // sum of errors**2
+                    prob = exp(-0.5 * edt_misfit * edt_misfit * weight2);
+                    weight = sqrt(weight2); // errors factor
+                    weight *= (1.0 - edtmtx[nrow][ncol]); // correlation coeff
+                    /*if (iuse_cell_diagonal_time_var) {	// duplicate above 4 lines
+                    weight2_search = 1.0 / (sigma2_row_search + edtmtx[ncol][ncol] + cell_diagonal_time_var);	// sum of errors**2
+                    prob_search = exp(-0.5 * edt_misfit * edt_misfit * weight2_search);
+                    weight_search = sqrt(weight2_search);		// errors factor
+                    weight_search *= (1.0 - edtmtx[nrow][ncol]);		// correlation coeff
+            }*/
+                }
+                // 20130627 AJL - change weighing from sum to product
+                //if (iSetStationDistributionWeights)
+                //    weight *= (arrival[nrow].station_weight + arrival[ncol].station_weight) / 2.0;
+                if (iSetStationDistributionWeights)
+                    weight *= sqrt(hot->station_weight[nrow] * hot->station_weight[ncol]);
+                // 20130627 AJL - add prior weighting as product
+                if (iUseArrivalPriorWeights && hot->apriori_weight[nrow] >= -VERY_SMALL_DOUBLE && hot->apriori_weight[ncol] >= -VERY_SMALL_DOUBLE)
+                    weight *= sqrt(hot->apriori_weight[nrow] * hot->apriori_weight[ncol]);
+                prob *= weight;
+                edt_sum += prob;
+                edt_weight += weight;
+                /*if (iuse_cell_diagonal_time_var) {	// duplicate above 5 lines
+                if (iSetStationDistributionWeights)
+                weight_search *= (arrival[nrow].station_weight + arrival[ncol].station_weight) / 2.0;
+                prob_search *= weight_search;
+                edt_sum_search += prob_search;
+                edt_weight_search += weight_search;
+        }*/
+                // accumulate EDT weights
+                if (icalc_otime) {
+                    //arrival[ncol].weight += weight;
+                    //arrival[nrow].weight += weight;
+                    arr_weight[ncol] += prob;
+                    arr_weight[nrow] += prob;
+                }
+                // otime
+                if (EDT_use_otime_weight == 2 || icalc_otime_default) { // EDT_OT_WT_ML or otime
+                    /*if (iuse_cell_diagonal_time_var)	// ???? TEST
+                    ot_ml_arrival_edt_sum[nrow] += prob_search;
+                    else*/
+                    ot_ml_arrival_edt_sum[ncol] += prob;
+                    // AJL 20070326 bug fix!
+                    ot_ml_arrival_edt_sum[nrow] += prob;
+                } else if (EDT_use_otime_weight == 1 || icalc_otime_force_ml) { // EDT_OT_WT or EDT
+                    ot_prob += prob;
+                }
+            }
+            if (EDT_use_otime_weight == 1) { // EDT_OT_WT or EDT
+                ot_sum += ot_prob * ot_row;
+                ot_2_sum += ot_prob * ot_row_2;
+                ot_weight += ot_prob;
             }
         }
-        if (EDT_use_otime_weight == 1) { // EDT_OT_WT or EDT
-            ot_sum += ot_prob * ot_row;
-            ot_2_sum += ot_prob * ot_row_2;
-            ot_weight += ot_prob;
+    }
+
+    // write EDT weights and centered predicted times back to arrivals
+    // 20261016 agent - added
+    if (icalc_otime) {
+        for (nrow = 0; nrow < num_arrivals; nrow++) {
+            arrival[nrow].weight = arr_weight[nrow];
+            if (pred_travel_time[nrow] > 0.0)
+                arrival[nrow].pred_centered = pred_centered[nrow];
         }
     }
 
@@ -8817,7 +10071,7 @@ double CalcSolutionQuality_EDT(int num_arrivals, ArrivalDesc *arrival,
 /*	OT_STACK - maximum of stack of otime estimates
  */
 
-double CalcSolutionQuality_OT_STACK(OctNode* poct_node, int num_arrivals, ArrivalDesc *arrival,
+double CalcSolutionQuality_OT_STACK(NLLocContext *pcontext, OctNode* poct_node, int num_arrivals, ArrivalDesc *arrival,
         GaussLocParams* gauss_par, int itype, double* pmisfit, double* potime, double* potime_var,
         double cell_half_diagonal_time_range, double cell_diagonal, double cell_volume, double* peffective_cell_size, double *pot_variance_factor) {
 
@@ -9152,7 +10406,7 @@ double calc_maximum_likelihood_ot_sort(
 
 #define ML_OT_WT_FLOOR log(0.00001)
 
-double CalcSolutionQuality_ML_OT(int num_arrivals, ArrivalDesc *arrival,
+double CalcSolutionQuality_ML_OT(NLLocContext *pcontext, int num_arrivals, ArrivalDesc *arrival,
         GaussLocParams* gauss_par, int itype, double* pmisfit, double* potime,
         double* potime_var, double cell_half_diagonal_time_range, int method_box) {
 
@@ -9652,7 +10906,7 @@ int NormalizeWeights(int num_arrivals, ArrivalDesc * arrival) {
 
 // 20150323 AJL - added
 
-double CalcSolutionQuality_L1_NORM(int num_arrivals, ArrivalDesc *arrival,
+double CalcSolutionQuality_L1_NORM(NLLocContext *pcontext, int num_arrivals, ArrivalDesc *arrival,
         GaussLocParams* gauss_par, int itype, double* pmisfit, double* potime) {
 
     int nrow, ncol, narr;
@@ -9758,7 +11012,7 @@ double CalcSolutionQuality_L1_NORM(int num_arrivals, ArrivalDesc *arrival,
 
 /*	sum of individual L2 residual probablities */
 
-double CalcSolutionQuality_GAU_TEST(int num_arrivals, ArrivalDesc *arrival,
+double CalcSolutionQuality_GAU_TEST(NLLocContext *pcontext, int num_arrivals, ArrivalDesc *arrival,
         GaussLocParams* gauss_par, int itype, double* pmisfit, double* potime) {
 
     int nrow, ncol, narr;
@@ -9887,7 +11141,7 @@ double CalcSolutionQuality_GAU_TEST(int num_arrivals, ArrivalDesc *arrival,
 
 /*		(MEN92, eq. 14) */
 
-double CalcSolutionQuality_GAU_ANALYTIC(int num_arrivals, ArrivalDesc *arrival,
+double CalcSolutionQuality_GAU_ANALYTIC(NLLocContext *pcontext, int num_arrivals, ArrivalDesc *arrival,
         GaussLocParams* gauss_par, int itype, double* pmisfit, double* potime) {
 
     int nrow, ncol, narr;
@@ -10167,7 +11421,7 @@ int is_nll_control_json(FILE* fp_input) {
 
 // AJL 20071217 - added char** passing of parameters
 
-int ReadNLLoc_Input(FILE* fp_input, char** param_line_array, int n_param_lines) {
+static int read_nlloc_input(FILE* fp_input, char** param_line_array, int n_param_lines) {
     int istat, iscan;
     char param[MAXLINE] = "\0", *pchr;
     char line_buf[MAXLINE_LONG];
@@ -10368,6 +11622,56 @@ patch below fixes this problem.
         }
 
 
+        /* read parallel location parameters */
+        // 20261016 agent - added
+
+        if (strcmp(param, "LOCPARALLEL") == 0) {
+            if ((istat = GetNLLoc_Parallel(strchr(line, ' '))) < 0)
+                nll_puterr("ERROR: reading NLLoc parallel location params.");
+        }
+
+
+        /* read look-ahead grid prefetch params */
+        // 20261016 agent - added
+
+        if (strcmp(param, "LOCPREFETCH") == 0) {
+            if ((istat = GetNLLoc_Prefetch(strchr(line, ' '))) < 0)
+                nll_puterr("ERROR: reading NLLoc look-ahead grid prefetch params.");
+        }
+
+        /* read per-stage timing and run statistics params */
+        // 20261016 agent - added
+
+        if (strcmp(param, "LOCPERF") == 0) {
+            if ((istat = GetNLLoc_Perf(strchr(line, ' '))) < 0)
+                nll_puterr("ERROR: reading NLLoc timing and run statistics params.");
+        }
+
+        /* read 3D time grid memory layout */
+        // 20261016 agent - added
+
+        if (strcmp(param, "LOCGRIDLAYOUT") == 0) {
+            if ((istat = GetNLLoc_GridLayout(strchr(line, ' '))) < 0)
+                nll_puterr("ERROR: reading NLLoc grid memory layout params.");
+        }
+
+        /* read 3D time grid region of interest */
+        // 20261016 agent - added
+
+        if (strcmp(param, "LOCGRIDROI") == 0) {
+            if ((istat = GetNLLoc_GridROI(strchr(line, ' '))) < 0)
+                nll_puterr("ERROR: reading NLLoc grid region of interest params.");
+        }
+
+        /* read grid memory byte budget */
+        // 20261016 agent - added
+
+        if (strcmp(param, "LOCMEM_BYTES") == 0) {
+            if ((istat = GetNLLoc_MemBytes(strchr(line, ' '))) < 0)
+                nll_puterr("ERROR: reading NLLoc grid memory byte budget.");
+        }
+
+
         /* read fixed origin time parameters */
 
         if (strcmp(param, "LOCFIXOTIME") == 0) {
@@ -10601,6 +11905,10 @@ patch below fixes this problem.
         }
     }
 
+    // 20261017 agent - added, sub-grid of 3D time grids to read to memory (LOCGRIDROI)
+    if (iLocGridROI)
+        SetLocGridROI();
+
     /* check for missing required input */
 
     if (!flag_control)
@@ -10750,6 +12058,31 @@ patch below fixes this problem.
             flag_method * flag_gauss * flag_qual2err * flag_trans - 1);
 }
 
+/** function to read input control file, one reader at a time
+ *
+ * 20261016 agent - added, control file reading sets process wide GridLib parameters and uses static parser state,
+ *    so it is serialized between concurrent NLLoc() runs and LOCPARALLEL threads.
+ */
+
+static pthread_mutex_t ReadNLLocInputMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// 20261017 agent - added, observation file names of LOCFILES are only set by the first reading of the control
+//    file for a location run context, other threads of the run (LOCPARALLEL) do not modify the shared list
+static NLL_THREAD_LOCAL int ReadObsFileNames = 1;
+
+int ReadNLLoc_Input(FILE* fp_input, char** param_line_array, int n_param_lines) {
+
+    int istat;
+
+    pthread_mutex_lock(&ReadNLLocInputMutex);
+    ReadObsFileNames = fn_loc_obs == NULL;
+    istat = read_nlloc_input(fp_input, param_line_array, n_param_lines);
+    pthread_mutex_unlock(&ReadNLLocInputMutex);
+
+    return (istat);
+
+}
+
 /** function to read output file name
  *
  * NOTE: if the format of this control statement is changed, also update in Loc2ssst.c->GetNLLoc_Files()
@@ -10759,22 +12092,37 @@ patch below fixes this problem.
 int GetNLLoc_Files(char* line1) {
     int istat, nObsFile;
     char fnobs[FILENAME_MAX];
+    char grid_access[MAXLINE];
 
-    istat = sscanf(line1, "%s %s %s %s %d", fnobs, ftype_obs, fn_loc_grids,
-            fn_path_output, &iSwapBytesOnInput);
+    istat = sscanf(line1, "%s %s %s %s %d %s", fnobs, ftype_obs, fn_loc_grids,
+            fn_path_output, &iSwapBytesOnInput, grid_access);
     if (istat < 5)
         iSwapBytesOnInput = 0;
+    // 20261016 agent - added optional grid access mode: READ (default) or MMAP
+    iMapGridsOnInput = 0;
+    if (istat >= 6) {
+        if (strcmp(grid_access, "MMAP") == 0) {
+            iMapGridsOnInput = 1;
+        } else if (strcmp(grid_access, "READ") != 0) {
+            nll_puterr2("ERROR: LOCFILES: unrecognized grid access mode, using READ", grid_access);
+        }
+    }
 
     //printf("TEST!!! --> line1: %s\n", line1);
     //printf("TEST!!! --> fn_path_output: %s\n", fn_path_output);
 
     /* check for wildcards in observation file name */
-    NumObsFiles = ExpandWildCards(fnobs, fn_loc_obs, MAX_NUM_OBS_FILES);
+    // 20261017 agent - list allocated for the files found, read once for threads sharing the location run context
+    if (ReadObsFileNames) {
+        free(fn_loc_obs);
+        fn_loc_obs = NULL;
+        NumObsFiles = ExpandWildCardsAlloc(fnobs, &fn_loc_obs, MAX_NUM_OBS_FILES);
+    }
 
     if (message_flag >= 3) {
         sprintf(MsgStr,
-                "LOCFILES:  ObsType: %s  InGrids: %s.*  OutPut: %s.* iSwapBytesOnInput: %d",
-                ftype_obs, fn_loc_grids, fn_path_output, iSwapBytesOnInput);
+                "LOCFILES:  ObsType: %s  InGrids: %s.*  OutPut: %s.* iSwapBytesOnInput: %d  GridAccess: %s",
+                ftype_obs, fn_loc_grids, fn_path_output, iSwapBytesOnInput, iMapGridsOnInput ? "MMAP" : "READ");
         nll_putmsg(3, MsgStr);
         for (nObsFile = 0; nObsFile < NumObsFiles; nObsFile++) {
             snprintf(MsgStr, sizeof (MsgStr), "   Obs File: %3d  %s", nObsFile, fn_loc_obs[nObsFile]);
@@ -10785,6 +12133,10 @@ int GetNLLoc_Files(char* line1) {
     if (NumObsFiles == MAX_NUM_OBS_FILES)
         nll_putmsg(1, "LOCFILES: WARNING: maximum number of files/events reached");
 
+    // 20261016 agent - added, grids are read from grid bundle <grid root>.bundle if it exists
+    if (GridBundle_Open(fn_loc_grids) < 0)
+        nll_puterr2("ERROR: LOCFILES: opening grid bundle, will use grid files", fn_loc_grids);
+
     return (0);
 }
 
@@ -10815,17 +12167,21 @@ int GetNLLoc_SearchType(char* line1) {
     } else if (strcmp(search_type, "MET") == 0) {
 
         SearchType = SEARCH_MET;
-        istat = sscanf(line1, "%s %d %d %d %d %d %lf %lf %lf %lf",
+        MetNumChains = 1;
+        MetChainRhatMax = 0.0;
+        istat = sscanf(line1, "%s %d %d %d %d %d %lf %lf %lf %lf %d %lf",
                 search_type, &MetNumSamples, &MetLearn, &MetEquil,
                 &MetStartSave, &MetSkip,
-                &MetStepInit, &MetStepMin, &MetStepFact, &MetProbMin);
+                &MetStepInit, &MetStepMin, &MetStepFact, &MetProbMin,
+                &MetNumChains, &MetChainRhatMax);
         ierr = 0;
 
         sprintf(MsgStr,
-                "LOCSEARCH:  Type: %s  numSamples %d  numLearn %d  numEquilibrate %d  startSave %d  numSkip %d  stepInit %lf  stepMin %lf  stepFact %lf  probMin %lf",
+                "LOCSEARCH:  Type: %s  numSamples %d  numLearn %d  numEquilibrate %d  startSave %d  numSkip %d  stepInit %lf  stepMin %lf  stepFact %lf  probMin %lf  numChains %d  maxRhat %lf",
                 search_type, MetNumSamples, MetLearn, MetEquil,
                 MetStartSave, MetSkip,
-                MetStepInit, MetStepMin, MetStepFact, MetProbMin);
+                MetStepInit, MetStepMin, MetStepFact, MetProbMin,
+                MetNumChains, MetChainRhatMax);
         nll_putmsg(3, MsgStr);
 
         if (checkRangeInt("LOCSEARCH", "numSamples", MetNumSamples, 1, 0, 0, 0) != 0)
@@ -10840,9 +12196,11 @@ int GetNLLoc_SearchType(char* line1) {
             ierr = -1;
         if (checkRangeDouble("LOCSEARCH", "stepMin", MetStepMin, 1, 0.0, 0, 0.0) != 0)
             ierr = -1;
+        if (checkRangeInt("LOCSEARCH", "numChains", MetNumChains, 1, 1, 1, MET_MAX_NUM_CHAINS) != 0)
+            ierr = -1;
         if (ierr < 0)
             return (-1);
-        if (istat != 10)
+        if (istat < 10)
             return (-1);
 
         //?? AJL 17JAN2000 MetUse = MetNumSamples - MetEquil;
@@ -10858,13 +12216,16 @@ int GetNLLoc_SearchType(char* line1) {
     } else if (strcmp(search_type, "OCT") == 0) {
 
         SearchType = SEARCH_OCTTREE;
-        istat = sscanf(line1, "%s %d %d %d %lf %d %d %d %d %lf",
+        istat = sscanf(line1, "%s %d %d %d %lf %d %d %d %d %lf %d %lf %lf %lf %d",
                 search_type, &octtreeParams.init_num_cells_x,
                 &octtreeParams.init_num_cells_y, &octtreeParams.init_num_cells_z,
                 &octtreeParams.min_node_size, &octtreeParams.max_num_nodes,
                 &octtreeParams.num_scatter, &octtreeParams.use_stations_density,
                 &octtreeParams.stop_on_min_node_size,
-                &octtreeParams.mean_cell_velocity);
+                &octtreeParams.mean_cell_velocity,
+                &octtreeParams.conv_num_subdiv, &octtreeParams.conv_tol_integral,
+                &octtreeParams.conv_tol_dist,
+                &octtreeParams.refine_tol_step, &octtreeParams.refine_max_iter);
 
         if (istat < 8)
             octtreeParams.use_stations_density = 0;
@@ -10877,6 +12238,19 @@ int GetNLLoc_SearchType(char* line1) {
         if (istat < 10)
             octtreeParams.mean_cell_velocity = -1.0;
 
+        // 20261016 agent - added, convergence early stop
+        if (istat < 11)
+            octtreeParams.conv_num_subdiv = 0;
+        if (istat < 12)
+            octtreeParams.conv_tol_integral = 0.01;
+        if (istat < 13 || octtreeParams.conv_tol_dist < 0.0)
+            octtreeParams.conv_tol_dist = octtreeParams.min_node_size;
+        // 20261016 agent - added, local refinement of maximum likelihood location
+        if (istat < 14)
+            octtreeParams.refine_tol_step = 0.0;
+        if (istat < 15)
+            octtreeParams.refine_max_iter = 10;
+
 
         sprintf(MsgStr,
                 "LOCSEARCH:  Type: %s  init_num_cells_x %d  init_num_cells_y %d  init_num_cells_z %d  min_node_size %f  max_num_nodes %d  num_scatter %d  use_stations_density %d  stop_on_min_node_size %d  octtreeParams.mean_cell_velocity %f",
@@ -10886,6 +12260,16 @@ int GetNLLoc_SearchType(char* line1) {
                 octtreeParams.num_scatter, octtreeParams.use_stations_density,
                 octtreeParams.stop_on_min_node_size, octtreeParams.mean_cell_velocity);
         nll_putmsg(3, MsgStr);
+        if (octtreeParams.conv_num_subdiv > 0) {
+            sprintf(MsgStr, "LOCSEARCH:  conv_num_subdiv %d  conv_tol_integral %f  conv_tol_dist %f",
+                    octtreeParams.conv_num_subdiv, octtreeParams.conv_tol_integral, octtreeParams.conv_tol_dist);
+            nll_putmsg(3, MsgStr);
+        }
+        if (octtreeParams.refine_tol_step > 0.0) {
+            sprintf(MsgStr, "LOCSEARCH:  refine_tol_step %f  refine_max_iter %d",
+                    octtreeParams.refine_tol_step, octtreeParams.refine_max_iter);
+            nll_putmsg(3, MsgStr);
+        }
 
 
         // check for valid input values
@@ -10908,6 +12292,15 @@ int GetNLLoc_SearchType(char* line1) {
         if (checkRangeInt("LOCSEARCH", "num_scatter",
                 octtreeParams.num_scatter, 1, 0, 0, 0) != 0)
             ierr = -1;
+        if (checkRangeInt("LOCSEARCH", "convNumSubdiv",
+                octtreeParams.conv_num_subdiv, 1, 0, 0, 0) != 0)
+            ierr = -1;
+        if (checkRangeDouble("LOCSEARCH", "convTolIntegral",
+                octtreeParams.conv_tol_integral, 1, 0.0, 0, 0.0) != 0)
+            ierr = -1;
+        if (checkRangeInt("LOCSEARCH", "refineMaxIter",
+                octtreeParams.refine_max_iter, 1, 0, 0, 0) != 0)
+            ierr = -1;
 
         // check for valid OctTree values
         int init_n_cells = octtreeParams.init_num_cells_x * octtreeParams.init_num_cells_y * octtreeParams.init_num_cells_z;
@@ -11383,21 +12776,27 @@ int GetNLLoc_Method(char* line1) {
     int istat, ierr;
 
     char loc_method[MAXLINE];
+    char edt_kernel[MAXLINE];
 
 
-    istat = sscanf(line1, "%s %lf %d %d %d %lf %d %lf %d", loc_method,
+    istat = sscanf(line1, "%s %lf %d %d %d %lf %d %lf %d %s", loc_method,
             &DistStaGridMax, &MinNumArrLoc, &MaxNumArrLoc, &MinNumSArrLoc,
-            &VpVsRatio, &MaxNum3DGridMemory, &DistStaGridMin, &iRejectDuplicateArrivals);
+            &VpVsRatio, &MaxNum3DGridMemory, &DistStaGridMin, &iRejectDuplicateArrivals, edt_kernel);
     if (istat < 8)
         DistStaGridMin = -1.0;
     if (istat < 9)
         iRejectDuplicateArrivals = 1;
+    // 20261016 agent - added EDT kernel option
+    if (istat < 10)
+        strcpy(edt_kernel, "LONG_DOUBLE");
 
     sprintf(MsgStr,
             "LOCMETH:  method: %s  minDistStaGrid: %lf  maxDistStaGrid: %lf  minNumberPhases: %d  maxNumberPhases: %d  minNumberSphases: %d  VpVsRatio: %lf  max3DGridMemory: %d  DistStaGridMin: %f  iRejectDuplicateArrivals: %d",
             loc_method, DistStaGridMin, DistStaGridMax, MinNumArrLoc, MaxNumArrLoc,
             MinNumSArrLoc, VpVsRatio, MaxNum3DGridMemory, DistStaGridMin, iRejectDuplicateArrivals);
     nll_putmsg(3, MsgStr);
+    sprintf(MsgStr, "LOCMETH:  EDTKernel: %s", edt_kernel);
+    nll_putmsg(3, MsgStr);
 
     /* 20220107 AJL - Revert Bug fix: faster to put grids in memory, maybe too much disk I/O otherwise
     // 20211026 AJL - Bug fix: do not put 3D grids in memory: LOCMETH maximum_number_3D_grids, not needed and can use much memory
@@ -11449,6 +12848,15 @@ int GetNLLoc_Method(char* line1) {
         return (EXIT_ERROR_LOCATE);
     }
 
+    if (strcmp(edt_kernel, "LONG_DOUBLE") == 0) {
+        EDT_kernel = EDT_KERNEL_LONG_DOUBLE;
+    } else if (strcmp(edt_kernel, "DOUBLE") == 0) {
+        EDT_kernel = EDT_KERNEL_DOUBLE;
+    } else {
+        nll_puterr2("ERROR: unrecognized EDT kernel:", edt_kernel);
+        return (EXIT_ERROR_LOCATE);
+    }
+
     if (MaxNumArrLoc < 1)
         MaxNumArrLoc = MAX_NUM_ARRIVALS;
 
@@ -11487,38 +12895,531 @@ int GetNLLoc_FixOriginTime(char* line1) {
     return (0);
 }
 
-/** function to read grid params */
+/** function to read parallel location parameters ***/
+// 20261016 agent - added
 
-int GetNLLoc_Grid(char* input_line) {
+int GetNLLoc_Parallel(char* line1) {
     int istat;
-    char str_save[20];
 
-    istat = sscanf(input_line, "%d %d %d %lf %lf %lf %lf %lf %lf %s %s",
-            &(grid_in.numx), &(grid_in.numy), &(grid_in.numz),
-            &(grid_in.origx), &(grid_in.origy), &(grid_in.origz),
-            &(grid_in.dx), &(grid_in.dy), &(grid_in.dz), grid_in.chr_type,
-            str_save);
 
-    convert_grid_type(&grid_in, 1);
-    if (message_flag >= 2)
-        display_grid_param(&grid_in);
-    sprintf(MsgStr, "LOCGRID: Save: %s", str_save);
+    // 20261016 agent - added optional NumOctThreads
+    LocOctParallelNumThreads = 0;
+    istat = sscanf(line1, "%d %d", &LocParallelNumThreads, &LocOctParallelNumThreads);
+
+    sprintf(MsgStr, "LOCPARALLEL:  NumThreads: %d  NumOctThreads: %d", LocParallelNumThreads, LocOctParallelNumThreads);
     nll_putmsg(3, MsgStr);
 
-    if (istat != 11)
+    if (istat < 1 || LocParallelNumThreads < 0 || LocOctParallelNumThreads < 0) {
+        LocParallelNumThreads = 0;
+        LocOctParallelNumThreads = 0;
         return (-1);
+    }
+    if (LocParallelNumThreads > MAX_NUM_LOC_PARALLEL_THREADS) {
+        sprintf(MsgStr, "WARNING: LOCPARALLEL: NumThreads %d > maximum, reset to %d", LocParallelNumThreads, MAX_NUM_LOC_PARALLEL_THREADS);
+        nll_putmsg(1, MsgStr);
+        LocParallelNumThreads = MAX_NUM_LOC_PARALLEL_THREADS;
+    }
+    if (LocOctParallelNumThreads > MAX_NUM_LOC_PARALLEL_THREADS) {
+        sprintf(MsgStr, "WARNING: LOCPARALLEL: NumOctThreads %d > maximum, reset to %d", LocOctParallelNumThreads, MAX_NUM_LOC_PARALLEL_THREADS);
+        nll_putmsg(1, MsgStr);
+        LocOctParallelNumThreads = MAX_NUM_LOC_PARALLEL_THREADS;
+    }
 
-    if (NumLocGrids < MAX_NUM_LOCATION_GRIDS) {
-        LocGrid[NumLocGrids] = grid_in;
-        LocGrid[NumLocGrids].autox = 0;
-        LocGrid[NumLocGrids].autoy = 0;
-        LocGrid[NumLocGrids].autoz = 0;
-        if (LocGrid[NumLocGrids].origx < -LARGE_DOUBLE)
-            LocGrid[NumLocGrids].autox = 1;
-        if (LocGrid[NumLocGrids].origy < -LARGE_DOUBLE)
-            LocGrid[NumLocGrids].autoy = 1;
-        if (LocGrid[NumLocGrids].origz < -LARGE_DOUBLE)
-            LocGrid[NumLocGrids].autoz = 1;
+    return (0);
+}
+
+
+/** function to read look-ahead grid prefetch parameters ***/
+// 20261016 agent - added
+
+int GetNLLoc_Prefetch(char* line1) {
+    int istat;
+
+
+    istat = sscanf(line1, "%d", &LocPrefetchNumEvents);
+
+    sprintf(MsgStr, "LOCPREFETCH:  NumEvents: %d", LocPrefetchNumEvents);
+    nll_putmsg(3, MsgStr);
+
+    if (istat < 1 || LocPrefetchNumEvents < 0) {
+        LocPrefetchNumEvents = 0;
+        return (-1);
+    }
+
+    return (0);
+}
+
+
+/** function to read 3D time grid memory layout ***/
+// 20261016 agent - added
+
+int GetNLLoc_GridLayout(char* line1) {
+    int istat;
+    char layout[MAXLINE];
+
+
+    istat = sscanf(line1, "%s", layout);
+
+    if (istat < 1) {
+        nll_puterr2("ERROR: LOCGRIDLAYOUT: missing layout:", line1);
+        return (-1);
+    }
+    if (strcmp(layout, "TILED") == 0) {
+        iTiledGridsInMemory = 1;
+    } else if (strcmp(layout, "LINEAR") == 0) {
+        iTiledGridsInMemory = 0;
+    } else {
+        nll_puterr2("ERROR: LOCGRIDLAYOUT: unrecognized layout (must be LINEAR or TILED):", layout);
+        return (-1);
+    }
+
+    sprintf(MsgStr, "LOCGRIDLAYOUT:  %s", iTiledGridsInMemory ? "TILED" : "LINEAR");
+    nll_putmsg(3, MsgStr);
+
+    return (0);
+}
+
+
+/** function to read 3D time grid region of interest ***/
+// 20261016 agent - added
+
+/** function to set sub-grid of 3D time grids to read to memory (LOCGRIDROI)
+ *
+ * 20261017 agent - added
+ * The sub-grid contains all location grids, which contain the OCT and MET search volumes of each grid, plus margin.
+ *    Location grids with automatic origin (LOCGRID ... MISSING) may be anywhere, then complete grids are read.
+ */
+
+void SetLocGridROI() {
+
+    int ngrid;
+    GridDesc *pgrid;
+
+    for (ngrid = 0; ngrid < NumLocGrids; ngrid++) {
+        pgrid = LocGrid + ngrid;
+        if (pgrid->autox || pgrid->autoy || pgrid->autoz) {
+            iLocGridROI = 0;
+            sprintf(MsgStr, "LOCGRIDROI:  location grid %d has automatic origin, complete grids read", ngrid);
+            nll_putmsg(2, MsgStr);
+            return;
+        }
+        if (ngrid == 0 || pgrid->origx < LocGridROIMin[0])
+            LocGridROIMin[0] = pgrid->origx;
+        if (ngrid == 0 || pgrid->origy < LocGridROIMin[1])
+            LocGridROIMin[1] = pgrid->origy;
+        if (ngrid == 0 || pgrid->origz < LocGridROIMin[2])
+            LocGridROIMin[2] = pgrid->origz;
+        if (ngrid == 0 || pgrid->origx + (double) (pgrid->numx - 1) * pgrid->dx > LocGridROIMax[0])
+            LocGridROIMax[0] = pgrid->origx + (double) (pgrid->numx - 1) * pgrid->dx;
+        if (ngrid == 0 || pgrid->origy + (double) (pgrid->numy - 1) * pgrid->dy > LocGridROIMax[1])
+            LocGridROIMax[1] = pgrid->origy + (double) (pgrid->numy - 1) * pgrid->dy;
+        if (ngrid == 0 || pgrid->origz + (double) (pgrid->numz - 1) * pgrid->dz > LocGridROIMax[2])
+            LocGridROIMax[2] = pgrid->origz + (double) (pgrid->numz - 1) * pgrid->dz;
+    }
+    for (int n = 0; n < 3; n++) {
+        LocGridROIMin[n] -= LocGridROIMargin;
+        LocGridROIMax[n] += LocGridROIMargin;
+    }
+
+    sprintf(MsgStr, "LOCGRIDROI:  sub-grid x %f -> %f  y %f -> %f  z %f -> %f",
+            LocGridROIMin[0], LocGridROIMax[0], LocGridROIMin[1], LocGridROIMax[1], LocGridROIMin[2], LocGridROIMax[2]);
+    nll_putmsg(3, MsgStr);
+
+}
+
+int GetNLLoc_GridROI(char* line1) {
+    int istat;
+
+
+    iLocGridROI = 0;
+    istat = sscanf(line1, "%lf", &LocGridROIMargin);
+
+    if (istat < 1) {
+        nll_puterr2("ERROR: LOCGRIDROI: missing margin:", line1);
+        return (-1);
+    }
+    iLocGridROI = LocGridROIMargin >= 0.0;
+
+    sprintf(MsgStr, "LOCGRIDROI:  Margin: %f%s", LocGridROIMargin, iLocGridROI ? "" : " (complete grids read)");
+    nll_putmsg(3, MsgStr);
+
+    return (0);
+}
+
+
+/** function to read per-stage timing and run statistics params ***/
+// 20261016 agent - added
+
+int GetNLLoc_Perf(char* line1) {
+    int istat;
+
+
+    istat = sscanf(line1, "%d", &LocPerfMode);
+
+    if (istat < 1 || LocPerfMode < LOC_PERF_OFF || LocPerfMode > LOC_PERF_HYP) {
+        LocPerfMode = LOC_PERF_OFF;
+        nll_puterr2("ERROR: LOCPERF: invalid mode (must be 0, 1 or 2):", line1);
+        return (-1);
+    }
+
+    sprintf(MsgStr, "LOCPERF:  Mode: %d%s", LocPerfMode,
+            LocPerfMode == LOC_PERF_OFF ? " (off)" : LocPerfMode == LOC_PERF_FILE ? " (.perf file)" : " (.perf file and hypocenter PERF line)");
+    nll_putmsg(3, MsgStr);
+
+    return (0);
+}
+
+
+/** function to read grid memory byte budget ***/
+// 20261016 agent - added
+
+int GetNLLoc_MemBytes(char* line1) {
+    int istat;
+    double num_bytes;
+    char unit[MAXLINE] = "";
+
+
+    istat = sscanf(line1, "%lf%1s", &num_bytes, unit);
+
+    if (istat < 1 || num_bytes < 0.0) {
+        nll_puterr2("ERROR: LOCMEM_BYTES: invalid byte budget:", line1);
+        return (-1);
+    }
+    if (istat == 2) {
+        if (toupper(unit[0]) == 'K')
+            num_bytes *= 1024.0;
+        else if (toupper(unit[0]) == 'M')
+            num_bytes *= 1024.0 * 1024.0;
+        else if (toupper(unit[0]) == 'G')
+            num_bytes *= 1024.0 * 1024.0 * 1024.0;
+        else if (toupper(unit[0]) == 'T')
+            num_bytes *= 1024.0 * 1024.0 * 1024.0 * 1024.0;
+        else {
+            nll_puterr2("ERROR: LOCMEM_BYTES: invalid unit (must be K, M, G or T):", line1);
+            return (-1);
+        }
+    }
+
+    // grid memory list is process wide
+    MaxBytes3DGridMemory = (size_t) num_bytes;
+
+    sprintf(MsgStr, "LOCMEM_BYTES:  %.1f MB", (double) MaxBytes3DGridMemory / (1024.0 * 1024.0));
+    nll_putmsg(3, MsgStr);
+
+    return (0);
+}
+
+
+/*------------------------------------------------------------/ */
+/** parallel location (LOCPARALLEL) commit ordering
+ *
+ * Each event read is assigned a ticket in input order.  Events are located concurrently, but
+ * the saving of locations to summary files, the location list and station statistics,
+ * and the run counters are updated by each thread only on its commit turn, in ticket order,
+ * so that output is independent of the number of threads.
+ * The commit turn is held in the location run context shared by the threads of an NLLoc() run.
+ */
+
+static NLL_THREAD_LOCAL long LocParallelTicket = -1; // < 0 for serial location
+static NLL_THREAD_LOCAL int LocParallelHasTurn = 0;
+
+/** reset commit ordering before starting location threads */
+
+void LocParallel_Reset() {
+
+    pthread_mutex_lock(&(pNLLocContext->commit_mutex));
+    pNLLocContext->next_commit = 0;
+    pthread_mutex_unlock(&(pNLLocContext->commit_mutex));
+
+}
+
+/** set commit ticket for the event to be located by this thread */
+
+void LocParallel_SetTicket(long ticket) {
+
+    LocParallelTicket = ticket;
+    LocParallelHasTurn = 0;
+
+}
+
+/** wait for commit turn of this thread, does nothing for serial location or if turn already held */
+
+void LocParallel_BeginCommit() {
+
+    if (LocParallelTicket < 0 || LocParallelHasTurn)
+        return;
+
+    pthread_mutex_lock(&(pNLLocContext->commit_mutex));
+    while (pNLLocContext->next_commit != LocParallelTicket)
+        pthread_cond_wait(&(pNLLocContext->commit_cond), &(pNLLocContext->commit_mutex));
+    pthread_mutex_unlock(&(pNLLocContext->commit_mutex));
+    LocParallelHasTurn = 1;
+
+}
+
+/** release commit turn of this thread to the next ticket */
+
+void LocParallel_EndCommit() {
+
+    if (LocParallelTicket < 0)
+        return;
+
+    LocParallel_BeginCommit();
+
+    pthread_mutex_lock(&(pNLLocContext->commit_mutex));
+    pNLLocContext->next_commit++;
+    pthread_cond_broadcast(&(pNLLocContext->commit_cond));
+    pthread_mutex_unlock(&(pNLLocContext->commit_mutex));
+    LocParallelTicket = -1;
+    LocParallelHasTurn = 0;
+
+}
+
+/** end of parallel location commit ordering */
+/*------------------------------------------------------------/ */
+
+/*------------------------------------------------------------/ */
+/** per-stage timing and run statistics (LOCPERF)
+ *
+ * The elapsed time of the stages of location of an event (see PERF_OBS, ...) and counters of work done
+ * are accumulated in LocPerfEvent by the thread reading and locating the event; search nodes evaluated
+ * by oct-tree threads are added to the locating thread (see OctEval_Run()).
+ * The event statistics are written to the .perf file and added to the run statistics of the location run
+ * context on the commit turn of the event, so the .perf file is in event input order for LOCPARALLEL.
+ * Timing is always done, it is a few clock readings per event; output only if LocPerfMode != LOC_PERF_OFF.
+ */
+
+static NLL_THREAD_LOCAL double LocPerfEventStart;
+static NLL_THREAD_LOCAL size_t LocPerfBytesReadStart;
+static NLL_THREAD_LOCAL long LocPerfGridHitsStart;
+static NLL_THREAD_LOCAL long LocPerfGridMissesStart;
+
+/** returns monotonic clock time in sec */
+
+double LocPerf_Time() {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double) ts.tv_sec + (double) ts.tv_nsec / 1.0e9);
+
+}
+
+/** adds time since time_start to stage of current event, returns current time */
+
+double LocPerf_Stage(int stage, double time_start) {
+
+    double time_now = LocPerf_Time();
+
+    LocPerfEvent.time[stage] += time_now - time_start;
+
+    return (time_now);
+
+}
+
+/** starts statistics for next event, called before reading observations of event */
+
+void LocPerf_BeginEvent() {
+
+    memset(&LocPerfEvent, 0, sizeof (LocPerfStats));
+    LocPerfEventStart = LocPerf_Time();
+    LocPerfBytesReadStart = NumGridBytesRead;
+    LocPerfGridHitsStart = GridMemThreadNumHits;
+    LocPerfGridMissesStart = GridMemThreadNumMisses;
+
+}
+
+/** updates total time and grid counters of current event */
+
+static void LocPerf_UpdateEvent() {
+
+    LocPerfEvent.time_total = LocPerf_Time() - LocPerfEventStart;
+    LocPerfEvent.bytes_read = NumGridBytesRead - LocPerfBytesReadStart;
+    LocPerfEvent.grid_hits = GridMemThreadNumHits - LocPerfGridHitsStart;
+    LocPerfEvent.grid_misses = GridMemThreadNumMisses - LocPerfGridMissesStart;
+
+}
+
+/** formats stage times and counters */
+
+static void LocPerf_Format(char *line, size_t size, LocPerfStats *pperf) {
+
+    snprintf(line, size,
+            "obs %.6f  grid %.6f  weight %.6f  search %.6f  stats %.6f  output %.6f  total %.6f"
+            "  nodes %ld  interp %ld  gridHits %ld  gridMisses %ld  bytesRead %lu",
+            pperf->time[PERF_OBS], pperf->time[PERF_GRID], pperf->time[PERF_WEIGHT], pperf->time[PERF_SEARCH],
+            pperf->time[PERF_STATS], pperf->time[PERF_OUTPUT], pperf->time_total,
+            pperf->num_nodes, pperf->num_interp, pperf->grid_hits, pperf->grid_misses, (unsigned long) pperf->bytes_read);
+
+}
+
+/** sets PERF line written to NLLoc hypocenter output by SaveLocation(), output stage is not complete */
+
+void LocPerf_SetHypoLine() {
+
+    char line[MAXLINE_LONG];
+
+    HypoPerfLine[0] = '\0';
+    if (LocPerfMode < LOC_PERF_HYP)
+        return;
+
+    LocPerf_UpdateEvent();
+    LocPerf_Format(line, sizeof (line), &LocPerfEvent);
+    snprintf(HypoPerfLine, sizeof (HypoPerfLine), "PERF  %s", line);
+
+}
+
+/** ends statistics of current event, must be called on commit turn of event */
+
+void LocPerf_EndEvent(char *fn_root_out, int iLocated) {
+
+    int n;
+    char line[MAXLINE_LONG];
+    LocPerfStats *prun = &(pNLLocContext->perf_run);
+
+
+    if (LocPerfMode == LOC_PERF_OFF)
+        return;
+
+    LocPerf_UpdateEvent();
+    LocPerfEvent.num_events = 1;
+
+    for (n = 0; n < PERF_NUM_STAGES; n++)
+        prun->time[n] += LocPerfEvent.time[n];
+    prun->time_total += LocPerfEvent.time_total;
+    prun->num_nodes += LocPerfEvent.num_nodes;
+    prun->num_interp += LocPerfEvent.num_interp;
+    prun->grid_hits += LocPerfEvent.grid_hits;
+    prun->grid_misses += LocPerfEvent.grid_misses;
+    prun->bytes_read += LocPerfEvent.bytes_read;
+    prun->num_events++;
+
+    if (pNLLocContext->fp_perf != NULL) {
+        LocPerf_Format(line, sizeof (line), &LocPerfEvent);
+        fprintf(pNLLocContext->fp_perf, "EVENT  %s  %s  %s\n", fn_root_out, iLocated ? "LOCATED" : "NOT_LOCATED", line);
+    }
+
+}
+
+/** starts run statistics and opens run statistics file <fn_root>.sum.perf, no file if fn_root is NULL
+ *
+ * returns < 0 on error
+ */
+
+int LocPerf_OpenRun(char *fn_root) {
+
+    char fname[FILENAME_MAX];
+
+
+    memset(&(pNLLocContext->perf_run), 0, sizeof (LocPerfStats));
+    pNLLocContext->perf_run_start = LocPerf_Time();
+    pNLLocContext->fp_perf = NULL;
+
+    if (LocPerfMode == LOC_PERF_OFF || fn_root == NULL)
+        return (0);
+
+    snprintf(fname, sizeof (fname), "%s.sum.perf", fn_root);
+    if ((pNLLocContext->fp_perf = fopen(fname, "w")) == NULL) {
+        nll_puterr2("ERROR: opening run statistics output file", fname);
+        return (-1);
+    }
+    fprintf(pNLLocContext->fp_perf,
+            "# NLLoc run statistics: elapsed time (sec) of location stages and counters for each event, totals and means for run\n");
+
+    return (0);
+
+}
+
+/** writes run statistics and closes run statistics file */
+
+void LocPerf_CloseRun() {
+
+    int n;
+    char line[MAXLINE_LONG];
+    LocPerfStats mean;
+    LocPerfStats *prun = &(pNLLocContext->perf_run);
+
+
+    if (LocPerfMode == LOC_PERF_OFF || pNLLocContext->perf_run_start <= 0.0) // run statistics not started
+        return;
+
+    double time_wall = LocPerf_Time() - pNLLocContext->perf_run_start;
+
+    // 20261016 agent - added peak resident set size of process (kilobytes on Linux, bytes on macOS)
+    struct rusage usage;
+    long max_rss = getrusage(RUSAGE_SELF, &usage) == 0 ? (long) usage.ru_maxrss : -1;
+
+    LocPerf_Format(line, sizeof (line), prun);
+    if (pNLLocContext->fp_perf != NULL)
+        fprintf(pNLLocContext->fp_perf, "RUN  events %ld  wall %.6f  %s  maxRSS %ld\n", prun->num_events, time_wall, line, max_rss);
+
+    if (prun->num_events > 0) {
+        mean = *prun;
+        for (n = 0; n < PERF_NUM_STAGES; n++)
+            mean.time[n] /= (double) prun->num_events;
+        mean.time_total /= (double) prun->num_events;
+        mean.num_nodes /= prun->num_events;
+        mean.num_interp /= prun->num_events;
+        mean.grid_hits /= prun->num_events;
+        mean.grid_misses /= prun->num_events;
+        mean.bytes_read /= (size_t) prun->num_events;
+        LocPerf_Format(line, sizeof (line), &mean);
+        if (pNLLocContext->fp_perf != NULL)
+            fprintf(pNLLocContext->fp_perf, "MEAN  %s\n", line);
+    }
+
+    sprintf(MsgStr, "LOCPERF: %ld events  wall %.3fs  obs %.3fs  grid %.3fs  weight %.3fs  search %.3fs  stats %.3fs  output %.3fs  nodes %ld  interp %ld  gridHits %ld  gridMisses %ld  MBRead %.1f",
+            prun->num_events, time_wall, prun->time[PERF_OBS], prun->time[PERF_GRID], prun->time[PERF_WEIGHT], prun->time[PERF_SEARCH],
+            prun->time[PERF_STATS], prun->time[PERF_OUTPUT], prun->num_nodes, prun->num_interp, prun->grid_hits, prun->grid_misses,
+            (double) prun->bytes_read / (1024.0 * 1024.0));
+    nll_putmsg(1, MsgStr);
+    sprintf(MsgStr, "LOCPERF: maxRSS %ld", max_rss);
+    nll_putmsg(1, MsgStr);
+
+    if (pNLLocContext->fp_perf != NULL) {
+        fclose(pNLLocContext->fp_perf);
+        pNLLocContext->fp_perf = NULL;
+    }
+
+}
+
+/** end of per-stage timing and run statistics */
+/*------------------------------------------------------------/ */
+
+
+
+/** function to read grid params */
+
+int GetNLLoc_Grid(char* input_line) {
+    int istat;
+    char str_save[20];
+
+    istat = sscanf(input_line, "%d %d %d %lf %lf %lf %lf %lf %lf %s %s",
+            &(grid_in.numx), &(grid_in.numy), &(grid_in.numz),
+            &(grid_in.origx), &(grid_in.origy), &(grid_in.origz),
+            &(grid_in.dx), &(grid_in.dy), &(grid_in.dz), grid_in.chr_type,
+            str_save);
+
+    convert_grid_type(&grid_in, 1);
+    if (message_flag >= 2)
+        display_grid_param(&grid_in);
+    sprintf(MsgStr, "LOCGRID: Save: %s", str_save);
+    nll_putmsg(3, MsgStr);
+
+    if (istat != 11)
+        return (-1);
+
+    if (NumLocGrids < MAX_NUM_LOCATION_GRIDS) {
+        LocGrid[NumLocGrids] = grid_in;
+        LocGrid[NumLocGrids].autox = 0;
+        LocGrid[NumLocGrids].autoy = 0;
+        LocGrid[NumLocGrids].autoz = 0;
+        if (LocGrid[NumLocGrids].origx < -LARGE_DOUBLE)
+            LocGrid[NumLocGrids].autox = 1;
+        if (LocGrid[NumLocGrids].origy < -LARGE_DOUBLE)
+            LocGrid[NumLocGrids].autoy = 1;
+        if (LocGrid[NumLocGrids].origz < -LARGE_DOUBLE)
+            LocGrid[NumLocGrids].autoz = 1;
         if (strcmp(str_save, "SAVE") == 0)
             LocGridSave[NumLocGrids] = 1;
         else
@@ -13211,7 +15112,7 @@ int WriteHypoInverseArchive(FILE *fpio, HypoDesc *phypo, ArrivalDesc *parrivals,
  *
  */
 
-double* azimuths = NULL;
+NLL_THREAD_LOCAL double* azimuths = NULL;
 
 double CalcAzimuthGap(ArrivalDesc *arrival, int num_arrivals, double *pgap_secondary) {
 
@@ -14081,20 +15982,318 @@ int setStationDistributionWeights(SourceDesc *stations, int numStations, Arrival
 
 }
 
-/** function to get travel times for all observed arrivals */
+/*------------------------------------------------------------/ */
+/** travel time cache at initial oct-tree nodes */
 
-int getTravelTimes(ArrivalDesc *arrival, int num_arr_loc, double xval, double yval, double zval) {
+// 20261016 agent - added
 
-    int nReject;
-    int narr, n_compan;
-    FILE* fp_grid;
-    double yval_grid = 0.0;
-    GridDesc* ptgrid;
+static NLL_THREAD_LOCAL TTCache* TTCacheGrid[MAX_NUM_LOCATION_GRIDS];
+static NLL_THREAD_LOCAL size_t TTCacheBytes; // size of node value arrays in all caches of thread
+// cache entry of each arrival for current event, NULL if travel times for arrival are not cached
+static NLL_THREAD_LOCAL TTCacheEntry* TTCacheArrival[X_MAX_NUM_ARRIVALS];
+static NLL_THREAD_LOCAL ArrivalDesc* TTCacheArrivalDesc;
+static NLL_THREAD_LOCAL int TTCacheNumArrivals;
 
-    // 20101005 AJL - added calculation of mean slowness
-    double slowness_P = -1.0;
-    double slowness_S = -1.0;
-    if (LocMethod == METH_OT_STACK) {
+/** funtion to form hash value from time grid title */
+
+static unsigned TTCache_hash(char* title) {
+
+    unsigned hashval;
+
+    for (hashval = 0; *title != '\0'; title++)
+        hashval = (unsigned char) *title + 31 * hashval;
+
+    return (hashval % TT_CACHE_HASHSIZE);
+}
+
+/** function to free all entries of a travel time cache */
+
+static void TTCache_Clear(TTCache *pcache) {
+
+    int n;
+    TTCacheEntry *pentry, *pnext;
+
+    for (n = 0; n < TT_CACHE_HASHSIZE; n++) {
+        for (pentry = pcache->entry[n]; pentry != NULL; pentry = pnext) {
+            pnext = pentry->next;
+            free(pentry->value);
+            free(pentry->isset);
+            free(pentry);
+            TTCacheBytes -= (size_t) pcache->num_nodes * (sizeof (double) + sizeof (char));
+        }
+        pcache->entry[n] = NULL;
+    }
+
+}
+
+/** function to lookup or install time grid of an arrival in a travel time cache
+ *
+ * returns NULL if arrival does not have a cacheable time grid or if cache is full
+ */
+
+static TTCacheEntry* TTCache_Lookup(TTCache *pcache, ArrivalDesc *parrival) {
+
+    TTCacheEntry *pentry;
+    unsigned hashval;
+    size_t entry_bytes;
+
+    if (parrival->n_companion >= 0 || parrival->gdesc.title[0] == '\0')
+        return (NULL);
+
+    hashval = TTCache_hash(parrival->gdesc.title);
+    for (pentry = pcache->entry[hashval]; pentry != NULL; pentry = pentry->next)
+        if (pentry->station_x == parrival->station.x && pentry->station_y == parrival->station.y
+                && strcmp(pentry->title, parrival->gdesc.title) == 0)
+            return (pentry); /* found */
+
+    /* not found, create new entry */
+    entry_bytes = (size_t) pcache->num_nodes * (sizeof (double) + sizeof (char));
+    if (TTCacheBytes + entry_bytes > TT_CACHE_MAX_BYTES)
+        return (NULL);
+    if ((pentry = (TTCacheEntry *) malloc(sizeof (TTCacheEntry))) == NULL)
+        return (NULL);
+    pentry->value = (double *) malloc((size_t) pcache->num_nodes * sizeof (double));
+    pentry->isset = (char *) calloc((size_t) pcache->num_nodes, sizeof (char));
+    if (pentry->value == NULL || pentry->isset == NULL) {
+        free(pentry->value);
+        free(pentry->isset);
+        free(pentry);
+        return (NULL);
+    }
+    strcpy(pentry->title, parrival->gdesc.title);
+    pentry->station_x = parrival->station.x;
+    pentry->station_y = parrival->station.y;
+    pentry->next = pcache->entry[hashval];
+    pcache->entry[hashval] = pentry;
+    TTCacheBytes += entry_bytes;
+
+    return (pentry);
+
+}
+
+/** function to attach travel time cache of a LOCGRID to the arrivals of an event
+ *
+ *    after this call getTravelTimesNode() reads and stores raw time grid values at initial nodes (n_init_node >= 0) in the cache
+ *
+ * returns number of arrivals with cached travel times, -1 on error
+ */
+
+int TTCache_Attach(int ngrid, Tree3D* tree, ArrivalDesc *arrival, int num_arrivals) {
+
+    int narr, num_cached = 0;
+    TTCache *pcache;
+
+    TTCache_Detach();
+
+    if (ngrid < 0 || ngrid >= MAX_NUM_LOCATION_GRIDS || num_arrivals > X_MAX_NUM_ARRIVALS)
+        return (-1);
+
+    if ((pcache = TTCacheGrid[ngrid]) == NULL) {
+        if ((pcache = (TTCache *) calloc(1, sizeof (TTCache))) == NULL)
+            return (-1);
+        TTCacheGrid[ngrid] = pcache;
+    }
+
+    // clear cache if initial oct-tree nodes changed
+    if (pcache->numx != tree->numx || pcache->numy != tree->numy || pcache->numz != tree->numz
+            || pcache->orig.x != tree->orig.x || pcache->orig.y != tree->orig.y || pcache->orig.z != tree->orig.z
+            || pcache->ds.x != tree->ds.x || pcache->ds.y != tree->ds.y || pcache->ds.z != tree->ds.z
+            || pcache->isSpherical != tree->isSpherical) {
+        TTCache_Clear(pcache);
+        pcache->numx = tree->numx;
+        pcache->numy = tree->numy;
+        pcache->numz = tree->numz;
+        pcache->orig = tree->orig;
+        pcache->ds = tree->ds;
+        pcache->isSpherical = tree->isSpherical;
+        pcache->num_nodes = tree->numx * tree->numy * tree->numz;
+    }
+
+    for (narr = 0; narr < num_arrivals; narr++) {
+        if ((TTCacheArrival[narr] = TTCache_Lookup(pcache, arrival + narr)) != NULL)
+            num_cached++;
+    }
+    TTCacheArrivalDesc = arrival;
+    TTCacheNumArrivals = num_arrivals;
+
+    return (num_cached);
+
+}
+
+/** function to detach travel time cache from the arrivals of an event */
+
+void TTCache_Detach() {
+
+    TTCacheArrivalDesc = NULL;
+    TTCacheNumArrivals = 0;
+
+}
+
+/** function to free all travel time caches of thread */
+
+void TTCache_Free() {
+
+    int ngrid;
+
+    TTCache_Detach();
+    for (ngrid = 0; ngrid < MAX_NUM_LOCATION_GRIDS; ngrid++) {
+        if (TTCacheGrid[ngrid] != NULL) {
+            TTCache_Clear(TTCacheGrid[ngrid]);
+            free(TTCacheGrid[ngrid]);
+            TTCacheGrid[ngrid] = NULL;
+        }
+    }
+    TTCacheBytes = 0;
+    TTColumn_Free(); // 20261016 agent - added
+
+}
+
+/** end of travel time cache at initial oct-tree nodes */
+/*------------------------------------------------------------/ */
+
+
+
+/*------------------------------------------------------------/ */
+/** travel times along grid search z-columns
+ *
+ * LocGridSearch() interpolates the travel times at all nodes of a z-column of the search grid in one pass
+ * for each arrival with a regular 3D time grid in memory (ReadAbsInterpGrid3dColumn()), getTravelTimesNode()
+ * then takes the travel times of the current node of the column.
+ */
+
+// 20261016 agent - added
+
+typedef struct {
+    ArrivalDesc *arrival; // arrivals of column, NULL if no column set
+    int num_arrivals;
+    int numz;
+    int iz; // current node of column
+    char isset[X_MAX_NUM_ARRIVALS]; // =1 if travel times of arrival are set for column
+    GRID_FLOAT_TYPE *value; // travel times of column nodes, [narr * numz + iz]
+    int num_value_alloc;
+} TTColumnDesc;
+
+static NLL_THREAD_LOCAL TTColumnDesc TTColumn;
+
+/** function to interpolate travel times at the nodes of a z-column
+ *
+ *    zval - z of column nodes, numz values
+ *
+ * returns < 0 on error
+ */
+
+static int TTColumn_Set(ArrivalDesc *arrival, int num_arr_loc, double xval, double yval, double *zval, int numz) {
+
+    int narr;
+
+    TTColumn.arrival = NULL;
+
+    if (num_arr_loc * numz > TTColumn.num_value_alloc) {
+        free(TTColumn.value);
+        if ((TTColumn.value = (GRID_FLOAT_TYPE *) malloc(num_arr_loc * numz * sizeof (GRID_FLOAT_TYPE))) == NULL) {
+            TTColumn.num_value_alloc = 0;
+            return (-1);
+        }
+        TTColumn.num_value_alloc = num_arr_loc * numz;
+    }
+
+    for (narr = 0; narr < num_arr_loc && narr < X_MAX_NUM_ARRIVALS; narr++) {
+        TTColumn.isset[narr] = arrival[narr].n_companion < 0 && arrival[narr].gdesc.type == GRID_TIME
+                && arrival[narr].gdesc.buffer != NULL && !isCascadingGrid(&(arrival[narr].gdesc));
+        if (TTColumn.isset[narr]) {
+            ReadAbsInterpGrid3dColumn(&(arrival[narr].gdesc), xval, yval, zval, numz, TTColumn.value + narr * numz);
+            LocPerfEvent.num_interp += numz;
+        }
+    }
+
+    TTColumn.arrival = arrival;
+    TTColumn.num_arrivals = narr;
+    TTColumn.numz = numz;
+    TTColumn.iz = 0;
+
+    return (0);
+
+}
+
+/** function to set current node of z-column */
+
+static void TTColumn_Node(int iz) {
+
+    TTColumn.iz = iz;
+
+}
+
+/** function to stop use of z-column travel times */
+
+static void TTColumn_Detach() {
+
+    TTColumn.arrival = NULL;
+    TTColumn.num_arrivals = 0;
+
+}
+
+/** function to free z-column travel times of thread */
+
+static void TTColumn_Free() {
+
+    TTColumn_Detach();
+    free(TTColumn.value);
+    TTColumn.value = NULL;
+    TTColumn.num_value_alloc = 0;
+
+}
+
+/** end of travel times along grid search z-columns */
+/*------------------------------------------------------------/ */
+
+/** function to get travel times for all observed arrivals */
+
+int getTravelTimes(NLLocContext *pcontext, ArrivalDesc *arrival, int num_arr_loc, double xval, double yval, double zval) {
+
+    return (getTravelTimesNode(arrival, num_arr_loc, xval, yval, zval, -1));
+
+}
+
+/** function to get travel times for all observed arrivals at a node
+ *
+ *    n_init_node - index of initial oct-tree node (ix * numy * numz + iy * numz + iz) for travel time cache, -1 if not an initial node
+ */
+
+// 20261016 agent - added, 3D time grids in memory interpolated together with ReadAbsInterpGrid3dBatch()
+static NLL_THREAD_LOCAL GridDesc* TravelTimeBatchGrid[X_MAX_NUM_ARRIVALS];
+static NLL_THREAD_LOCAL int TravelTimeBatchIndex[X_MAX_NUM_ARRIVALS];
+static NLL_THREAD_LOCAL GRID_FLOAT_TYPE TravelTimeBatchValue[X_MAX_NUM_ARRIVALS];
+
+int getTravelTimesNode(ArrivalDesc *arrival, int num_arr_loc, double xval, double yval, double zval, int n_init_node) {
+
+    int nReject;
+    int narr, n_compan;
+    FILE* fp_grid;
+    double yval_grid = 0.0;
+    GridDesc* ptgrid;
+    int nbatch, ibatch;
+    double tt_grid;
+
+    // 20261016 agent - added, travel time cache at initial oct-tree nodes
+    TTCacheEntry **tt_cache = NULL;
+    TTCacheEntry *pentry;
+    if (n_init_node >= 0 && TTCacheArrivalDesc == arrival && TTCacheNumArrivals >= num_arr_loc)
+        tt_cache = TTCacheArrival;
+
+    // 20261016 agent - added, travel times of current node of grid search z-column
+    TTColumnDesc *tt_column = NULL;
+    if (TTColumn.arrival == arrival && TTColumn.num_arrivals >= num_arr_loc)
+        tt_column = &TTColumn;
+
+    // 20261016 agent - added, predicted travel times are also stored in the hot arrival table
+    ArrivalHotTable *hot = NULL;
+    if (ArrivalHot.arrival == arrival && ArrivalHot.num_arrivals >= num_arr_loc)
+        hot = &ArrivalHot;
+
+    // 20101005 AJL - added calculation of mean slowness
+    double slowness_P = -1.0;
+    double slowness_S = -1.0;
+    if (LocMethod == METH_OT_STACK) {
         if (fp_model_grid_P != NULL) {
             if (model_grid_P.numx > 2) {
                 // 3D grid
@@ -14133,191 +16332,1267 @@ int getTravelTimes(ArrivalDesc *arrival, int num_arr_loc, double xval, double yv
         }*/
     }
 
-    /* loop over observed arrivals */
+    /* interpolate travel times for all arrivals with regular 3D time grids in memory */
+
+    nbatch = 0;
+    for (narr = 0; narr < num_arr_loc && narr < X_MAX_NUM_ARRIVALS; narr++) {
+        if (arrival[narr].n_companion < 0 && arrival[narr].gdesc.type == GRID_TIME
+                && arrival[narr].gdesc.buffer != NULL && !isCascadingGrid(&(arrival[narr].gdesc))
+                && !(tt_cache != NULL && tt_cache[narr] != NULL && tt_cache[narr]->isset[n_init_node])
+                && !(tt_column != NULL && tt_column->isset[narr])) {
+            TravelTimeBatchGrid[nbatch] = &(arrival[narr].gdesc);
+            TravelTimeBatchIndex[nbatch] = narr;
+            nbatch++;
+        }
+    }
+    ReadAbsInterpGrid3dBatch(TravelTimeBatchGrid, nbatch, xval, yval, zval, TravelTimeBatchValue);
+    LocPerfEvent.num_nodes++; // 20261016 agent - added
+    LocPerfEvent.num_interp += nbatch;
+
+    /* loop over observed arrivals */
+
+    nReject = 0;
+    ibatch = 0;
+    for (narr = 0; narr < num_arr_loc; narr++) {
+        /* check for companion */
+        if ((n_compan = arrival[narr].n_companion) >= 0) {
+            if ((arrival[narr].pred_travel_time = arrival[n_compan].pred_travel_time) < 0.0)
+                nReject++;
+            arrival[narr].pred_travel_time *= arrival[narr].tfact;
+            /* else check grid type */
+        } else {
+            pentry = tt_cache != NULL ? tt_cache[narr] : NULL;
+            if (tt_column != NULL && tt_column->isset[narr]) {
+                /* 3D grid, already interpolated for z-column */
+                tt_grid = (double) tt_column->value[narr * tt_column->numz + tt_column->iz];
+            } else if (ibatch < nbatch && TravelTimeBatchIndex[ibatch] == narr) {
+                /* 3D grid, already interpolated */
+                tt_grid = (double) TravelTimeBatchValue[ibatch];
+                ibatch++;
+            } else if (arrival[narr].gdesc.type == GRID_TIME) {
+                /* 3D grid */
+                if (pentry != NULL && pentry->isset[n_init_node]) {
+                    /* cached */
+                    tt_grid = pentry->value[n_init_node];
+                } else {
+                    if (arrival[narr].gdesc.buffer == NULL) {
+                        /* read time grid from disk */
+                        fp_grid = arrival[narr].fpgrid;
+                    } else {
+                        /* read time grid from memory buffer */
+                        fp_grid = NULL;
+                    }
+                    tt_grid = (double) ReadAbsInterpGrid3d(fp_grid, &(arrival[narr].gdesc), xval, yval, zval, 0);
+                    LocPerfEvent.num_interp++;
+                }
+            } else {
+                /* 2D grid (1D model) */
+                yval_grid = GetEpiDist(&(arrival[narr].station), xval, yval);
+                if (GeometryMode == MODE_GLOBAL)
+                    yval_grid *= KM2DEG;
+                if (pentry != NULL && pentry->isset[n_init_node]) {
+                    /* cached */
+                    tt_grid = pentry->value[n_init_node];
+                } else {
+                    if (arrival[narr].sheetdesc.buffer == NULL) {
+                        /* read time grid from disk */
+                        fp_grid = arrival[narr].fpgrid;
+                        ptgrid = &(arrival[narr].gdesc);
+                    } else {
+                        /* read time grid from memory buffer */
+                        fp_grid = NULL;
+                        ptgrid = &(arrival[narr].sheetdesc);
+                    }
+                    tt_grid = ReadAbsInterpGrid2d(fp_grid, ptgrid, yval_grid, zval);
+                    LocPerfEvent.num_interp++;
+                }
+                //printf("DEBUG: getTT:  xval %lf yval %lf yval_grid %lf zval %lf t %lf \n", xval, yval, yval_grid, zval, tt_grid);
+                //display_grid_param(&(arrival[narr].sheetdesc));
+            }
+            if (pentry != NULL && !pentry->isset[n_init_node]) {
+                pentry->value[n_init_node] = tt_grid;
+                pentry->isset[n_init_node] = 1;
+            }
+            if ((arrival[narr].pred_travel_time = tt_grid) < 0.0)
+                nReject++;
+            arrival[narr].pred_travel_time *= arrival[narr].tfact;
+            // apply crustal correction
+            if (ApplyCrustElevCorrFlag && GeometryMode == MODE_GLOBAL
+                    && arrival[narr].pred_travel_time > 0.0) {
+                //printf("arrival[narr].pred_travel_time before: %f", arrival[narr].pred_travel_time);
+                if (yval_grid > MinDistCrustElevCorr)
+                    arrival[narr].pred_travel_time += applyCrustElevCorrection(arrival + narr, xval, yval, zval);
+                //printf(" -> after: %f\n", arrival[narr].pred_travel_time);
+            } else if (ApplyElevCorrFlag) {
+
+                if (arrival[narr].pred_travel_time > 0.0) // ignore arrivals with no pred tt
+                    arrival[narr].pred_travel_time += arrival[narr].elev_corr;
+            }
+        }
+        if (hot != NULL)
+            hot->pred_travel_time[narr] = arrival[narr].pred_travel_time;
+
+        // set slowness
+        if (arrival[narr].isS)
+            arrival[narr].slowness = slowness_S;
+
+        else
+            arrival[narr].slowness = slowness_P;
+
+    }
+
+
+    return (nReject);
+
+}
+
+
+
+/** function to apply crustal correction and elevation correction */
+
+// assumes vertical ray (dtdd = 0.0) !!!
+
+double applyCrustElevCorrection(ArrivalDesc* parrival, double xval, double yval, double zval) {
+
+    double correction = 0.0;
+    double dtdd = 0.0;
+    char cphase;
+
+    if (IsPhaseID(parrival->phase, "P"))
+        cphase = 'P';
+    else if (IsPhaseID(parrival->phase, "S"))
+        cphase = 'S';
+    else
+        return (0.0);
+
+
+    // source
+    correction = calc_crust_corr(cphase, yval, xval, zval, VERY_LARGE_DOUBLE, dtdd);
+    // receiver
+    correction +=
+            calc_crust_corr(cphase, parrival->station.dlat,
+            parrival->station.dlong, 0.0, -1000.0 * parrival->station.depth, dtdd);
+
+    return (correction);
+
+}
+
+/** function to check if xyz location is above topography */
+
+int isAboveTopo(double xval, double yval, double zval) {
+
+    double xlon, ylat, elev;
+    double topo_elev;
+
+    // check topo if available
+    if (topo_surface_index >= 0) {
+        if (model_surface[topo_surface_index].is_latlon) {
+            // convert xyz to lat/long/elev
+            rect2latlon(0, xval, yval, &ylat, &xlon);
+        } else {
+            xlon = xval;
+            ylat = yval;
+        }
+        if (map_itype[0] != MAP_TRANS_NONE) // 20110105 AJL
+            elev = -zval * 1000.0; // elevation in meters
+        else
+            elev = -zval; // 20110105 AJL
+        // get elevation of topo at location
+        topo_elev = get_surface_z(topo_surface_index, xlon, ylat);
+        int iabove = elev > topo_elev;
+
+        /*
+                                                                                if (iabove) {
+                                                                                    printf("xyz %f %f %f  lon/lat/elev %f %f %f  topo_elev %f  above %d\n", xval, yval, zval, ylat, xlon, elev, topo_elev, iabove);
+                                                                                }//*/
+
+        return (iabove);
+    }
+
+    return (0);
+
+}
+
+
+
+
+
+/*------------------------------------------------------------/ */
+/** Octtree search routines */
+
+/** function to initialize Octtree search */
+
+Tree3D * InitializeOcttree(GridDesc* ptgrid, OcttreeParams * pParams, int use_arena) {
+
+    double dx, dy, dz;
+    Tree3D* newTree;
+    void *pdata = NULL;
+    double integral;
+
+    // set up oct-tree x, y, z grid
+    dx = ptgrid->dx * (double) (ptgrid->numx - 1) / (double) (pParams->init_num_cells_x);
+    dy = ptgrid->dy * (double) (ptgrid->numy - 1) / (double) (pParams->init_num_cells_y);
+    //dz = ptgrid->dz * (double) (ptgrid->numz - 1) / (double) (pParams->init_num_cells_z);
+    // 20101004 AJL - Fixed bug: Oct-tree search was not initialized to bottom of LOCSEARCH grid, bottom LOCSEARCH grid layer was lost.
+    //dz = ptgrid->dz * (double) ptgrid->numz / (double) (pParams->init_num_cells_z);
+    // 20200302 AJL - Un-Fixed bug: Seems that Oct-tree search was initialized to bottom of LOCSEARCH grid.
+    dz = ptgrid->dz * (double) (ptgrid->numz - 1) / (double) (pParams->init_num_cells_z);
+
+    integral = 0.0;
+    // 20160927 AJL   if (LocMethod == METH_OT_STACK && GeometryMode == MODE_GLOBAL) {
+    //if (GeometryMode == MODE_GLOBAL && !iSaveNLLocOctree) { // 20160927 AJL - bug fix?  octtree.c->writeTree3D() (called if iSaveNLLocOctree) does not yet support spherical trees
+    if (GeometryMode == MODE_GLOBAL) { // 20190508 AJL - bug fix?  octtree.c->writeTree3D() now handles spherical trees issues
+        newTree = newTree3D_spherical(ptgrid->type, pParams->init_num_cells_x,
+                pParams->init_num_cells_y, pParams->init_num_cells_z,
+                ptgrid->origx, ptgrid->origy, ptgrid->origz,
+                dx, dy, dz, OCTREE_UNDEF_VALUE, integral, pdata);
+    } else {
+
+        newTree = newTree3D(ptgrid->type, pParams->init_num_cells_x,
+                pParams->init_num_cells_y, pParams->init_num_cells_z,
+                ptgrid->origx, ptgrid->origy, ptgrid->origz,
+                dx, dy, dz, OCTREE_UNDEF_VALUE, integral, pdata);
+    }
+
+    // 20261016 agent - added
+    // release nodes of previous event in O(1), octArena is created once per thread and its blocks are re-used for each event.
+    // results tree nodes are always allocated from octArena, octtree child nodes only if use_arena
+    // (tree is freed before next event, otherwise nodes are allocated individually).
+    // nodes are allocated individually if octArena cannot be created.
+    if (octArena == NULL)
+        octArena = newOctArena(OCT_ARENA_BLOCK_SIZE);
+    else
+        resetOctArena(octArena);
+    if (newTree != NULL && use_arena)
+        newTree->arena = octArena;
+
+    return (newTree);
+}
+
+/*------------------------------------------------------------/ */
+/** parallel evaluation of oct-tree cells of an event (LOCPARALLEL NumOctThreads)
+ *
+ * The cells evaluated in each step of LocOctree() (the initial cells, then the children of the
+ * subdivided cells) are evaluated as a batch of tasks.  With an oct-tree thread pool the tasks of a
+ * batch are shared by the locating thread and NumOctThreads - 1 helper threads, each helper works on
+ * its own copy of the event arrivals and Gauss parameters, and the results are put in the results tree
+ * by the locating thread in task order, so the search is identical for any number of threads.
+ * Helper threads read the control file when the pool is created, like LOCPARALLEL location threads.
+ * Cells are evaluated serially if travel time grids are not all in memory (reading of shared grid files)
+ * or for LOCMETH OT_STACK (velocity model grid files).
+ */
+
+// 20261016 agent - added
+
+static long double LocOctree_eval(int ngrid, double xval, double yval, double zval,
+        int num_arr_loc, ArrivalDesc *arrival,
+        OctNode* poct_node, int n_init_node,
+        int icalc_cell_diagonal_time_var, double *volume_min,
+        double *pdiagonal, double *cell_half_diagonal_time_range,
+        OcttreeParams* pParams, GaussLocParams* gauss_par, int iGridType,
+        double *misfit, double logWtMtrxSum, double *plog_value_volume, double *pvolume);
+
+#define OCT_EVAL_MAX_CHILD_TASKS (7 * 8)  // subdivided cell and 6 neighbors, 8 children each
+
+/* evaluation of one oct-tree cell */
+typedef struct {
+    OctNode* poct_node;
+    int n_init_node; // index of initial node for travel time cache, -1 if not an initial node
+    // results
+    long double value;
+    double log_value_volume;
+    double volume;
+    double misfit;
+    double volume_min;
+    double diagonal;
+    double cell_half_diagonal_time_range;
+    double *pred_travel_time; // predicted travel times at cell, NULL if not needed
+    long perf_num_nodes; // LOCPERF counters of evaluation, added to counters of locating thread
+    long perf_num_interp;
+    int evaluated; // =1 if task was evaluated
+} OctEvalTask;
+
+/* batch of cell evaluations of an event */
+typedef struct {
+    long id; // event id, helper threads copy event data when this changes
+    int parallel; // =1 if tasks are evaluated by oct-tree thread pool
+    // event data
+    int ngrid;
+    int num_arr_total;
+    int num_arr_loc;
+    ArrivalDesc *arrival; // copy of event arrivals at start of search, for helper threads
+    int num_arrival_alloc;
+    GaussLocParams gauss_par; // copy of event Gauss parameters at start of search, for helper threads
+    MatrixDouble edt_mtx; // copy of EDT matrix at start of search with Gauss2, for helper threads
+    int edt_mtx_size;
+    GridDesc loc_grid; // LocGrid[ngrid]
+    SourceDesc *station_phase_list; // StationPhaseList of locating thread, for station density weighting
+    int num_station_phases;
+    TTCacheEntry *tt_cache[X_MAX_NUM_ARRIVALS]; // travel time cache entries of arrivals, for helper threads
+    int tt_cache_active;
+    OcttreeParams *pParams;
+    int icalc_cell_diagonal_time_var;
+    int iGridType;
+    double logWtMtrxSum;
+    // values carried from one evaluation to the next for serial evaluation, initial values for parallel evaluation
+    double misfit;
+    double volume_min;
+    double diagonal;
+    double cell_half_diagonal_time_range;
+    // tasks
+    OctEvalTask *task;
+    int num_tasks;
+    int num_task_alloc;
+    double *pred_travel_time; // storage for pred_travel_time of child tasks
+    int num_pred_alloc;
+} OctEvalEvent;
+
+/* oct-tree thread pool */
+typedef struct {
+    int num_helpers;
+    pthread_t *threads;
+    pthread_mutex_t mutex;
+    pthread_cond_t work_cond; // new batch or shutdown
+    pthread_cond_t done_cond; // batch done or helper initialized
+    int shutdown;
+    long next_event_id;
+    // current batch
+    OctEvalEvent *pevent;
+    void (*job_func)(void *job, int ntask); // other parallel job if pevent is NULL (e.g. Metropolis chains)
+    void *job;
+    int next_task;
+    int num_tasks;
+    int num_completed;
+    // helper initialization
+    int (*init_thread)(void *arg);
+    void (*cleanup_thread)();
+    void *init_arg;
+    int num_initialized;
+    int init_error;
+    NLLocContext *pcontext;
+} OctParallelPool;
+
+static NLL_THREAD_LOCAL OctParallelPool *octParallelPool = NULL; // pool of locating thread
+static NLL_THREAD_LOCAL OctEvalEvent OctEval; // batch of locating thread
+// event data of helper thread
+static NLL_THREAD_LOCAL long OctEvalHelperEventId = -1;
+static NLL_THREAD_LOCAL ArrivalDesc *OctEvalHelperArrival = NULL;
+static NLL_THREAD_LOCAL int OctEvalHelperArrivalAlloc = 0;
+static NLL_THREAD_LOCAL GaussLocParams OctEvalHelperGauss;
+static NLL_THREAD_LOCAL MatrixDouble OctEvalHelperEDTMtrx = NULL; // EDT matrix diagonal is set for each cell with Gauss2
+static NLL_THREAD_LOCAL int OctEvalHelperEDTMtrxSize = 0;
+
+/** function to evaluate one oct-tree cell task */
+
+static void OctEval_EvaluateTask(OctEvalEvent *pevent, OctEvalTask *ptask, ArrivalDesc *arrival, GaussLocParams *gauss_par) {
+
+    int narr;
+    OctNode *poct_node = ptask->poct_node;
+    long num_nodes = LocPerfEvent.num_nodes;
+    long num_interp = LocPerfEvent.num_interp;
+
+    ptask->misfit = pevent->misfit;
+    ptask->volume_min = pevent->volume_min;
+    ptask->diagonal = pevent->diagonal;
+    ptask->cell_half_diagonal_time_range = pevent->cell_half_diagonal_time_range;
+
+    // predicted times of cells above topography are not set, do not depend on previous cell of thread
+    if (pevent->parallel && ptask->pred_travel_time != NULL) {
+        for (narr = 0; narr < pevent->num_arr_loc; narr++)
+            arrival[narr].pred_travel_time = -1.0;
+    }
+
+    ptask->value = LocOctree_eval(pevent->ngrid, poct_node->center.x, poct_node->center.y, poct_node->center.z,
+            pevent->num_arr_loc, arrival, poct_node, ptask->n_init_node,
+            pevent->icalc_cell_diagonal_time_var, &(ptask->volume_min), &(ptask->diagonal),
+            &(ptask->cell_half_diagonal_time_range), pevent->pParams, gauss_par, pevent->iGridType,
+            &(ptask->misfit), pevent->logWtMtrxSum, &(ptask->log_value_volume), &(ptask->volume));
+
+    if (ptask->pred_travel_time != NULL) {
+        for (narr = 0; narr < pevent->num_arr_loc; narr++)
+            ptask->pred_travel_time[narr] = arrival[narr].pred_travel_time;
+    }
+    // counters of evaluating thread are restored, counters of task are added to locating thread in OctEval_Run()
+    ptask->perf_num_nodes = LocPerfEvent.num_nodes - num_nodes;
+    ptask->perf_num_interp = LocPerfEvent.num_interp - num_interp;
+    LocPerfEvent.num_nodes = num_nodes;
+    LocPerfEvent.num_interp = num_interp;
+    ptask->evaluated = 1;
+
+}
+
+/** function to set up event data of helper thread */
+
+static int OctEval_HelperSetEvent(OctEvalEvent *pevent) {
+
+    int narr;
+
+    if (pevent->num_arr_total > OctEvalHelperArrivalAlloc) {
+        free(OctEvalHelperArrival);
+        if ((OctEvalHelperArrival = (ArrivalDesc *) malloc(pevent->num_arr_total * sizeof (ArrivalDesc))) == NULL) {
+            OctEvalHelperArrivalAlloc = 0;
+            return (-1);
+        }
+        OctEvalHelperArrivalAlloc = pevent->num_arr_total;
+    }
+    memcpy(OctEvalHelperArrival, pevent->arrival, pevent->num_arr_total * sizeof (ArrivalDesc));
+    OctEvalHelperGauss = pevent->gauss_par;
+    if (iUseGauss2) {
+        if (pevent->num_arr_loc > OctEvalHelperEDTMtrxSize) {
+            free_matrix_double(OctEvalHelperEDTMtrx, OctEvalHelperEDTMtrxSize, OctEvalHelperEDTMtrxSize);
+            OctEvalHelperEDTMtrxSize = 0;
+            if ((OctEvalHelperEDTMtrx = matrix_double(pevent->num_arr_loc, pevent->num_arr_loc)) == NULL)
+                return (-1);
+            OctEvalHelperEDTMtrxSize = pevent->num_arr_loc;
+        }
+        for (narr = 0; narr < pevent->num_arr_loc; narr++)
+            memcpy(OctEvalHelperEDTMtrx[narr], pevent->edt_mtx[narr], pevent->num_arr_loc * sizeof (double));
+        OctEvalHelperGauss.EDTMtrx = OctEvalHelperEDTMtrx;
+    }
+    LocGrid[pevent->ngrid] = pevent->loc_grid;
+    if (pevent->pParams != NULL && pevent->pParams->use_stations_density > 0) {
+        for (narr = 0; narr < pevent->num_station_phases; narr++)
+            StationPhaseList[narr] = pevent->station_phase_list[narr];
+        NumStationPhases = pevent->num_station_phases;
+    }
+    if (ArrivalHot_Build(OctEvalHelperArrival, pevent->num_arr_total) < 0)
+        return (-1);
+    TTCache_Detach();
+    if (pevent->tt_cache_active) {
+        for (narr = 0; narr < pevent->num_arr_loc; narr++)
+            TTCacheArrival[narr] = pevent->tt_cache[narr];
+        TTCacheArrivalDesc = OctEvalHelperArrival;
+        TTCacheNumArrivals = pevent->num_arr_loc;
+    }
+    EDT_otime_weight_active = 0;
+    OctEvalHelperEventId = pevent->id;
+
+    return (0);
+
+}
+
+/** oct-tree helper thread */
+
+static void* OctParallel_HelperThread(void *arg) {
+
+    OctParallelPool *pool = (OctParallelPool *) arg;
+    OctEvalEvent *pevent;
+    void (*job_func)(void *job, int ntask);
+    void *job;
+    int ntask, istat;
+
+    // use location run context of the locating thread
+    pNLLocContext = pool->pcontext;
+
+    /* initialize thread copy of control parameters */
+
+    istat = (*pool->init_thread)(pool->init_arg);
+
+    pthread_mutex_lock(&pool->mutex);
+    if (istat < 0)
+        pool->init_error = 1;
+    pool->num_initialized++;
+    pthread_cond_broadcast(&pool->done_cond);
+
+    /* evaluate tasks */
+
+    while (istat >= 0) {
+        while (!pool->shutdown && ((pool->pevent == NULL && pool->job == NULL) || pool->next_task >= pool->num_tasks))
+            pthread_cond_wait(&pool->work_cond, &pool->mutex);
+        if (pool->shutdown)
+            break;
+        pevent = pool->pevent;
+        job_func = pool->job_func;
+        job = pool->job;
+        ntask = pool->next_task++;
+        pthread_mutex_unlock(&pool->mutex);
+        // oct-tree task not evaluated if event data cannot be set, task is then evaluated by locating thread
+        if (pevent == NULL)
+            (*job_func)(job, ntask);
+        else if (OctEvalHelperEventId == pevent->id || OctEval_HelperSetEvent(pevent) == 0)
+            OctEval_EvaluateTask(pevent, pevent->task + ntask, OctEvalHelperArrival, &OctEvalHelperGauss);
+        pthread_mutex_lock(&pool->mutex);
+        if (++pool->num_completed == pool->num_tasks)
+            pthread_cond_broadcast(&pool->done_cond);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    /* clean up thread */
+
+    if (pool->cleanup_thread != NULL)
+        (*pool->cleanup_thread)();
+    clean_memory(0);
+    TTCache_Free();
+    free(OctEvalHelperArrival);
+    OctEvalHelperArrival = NULL;
+    OctEvalHelperArrivalAlloc = 0;
+    free_matrix_double(OctEvalHelperEDTMtrx, OctEvalHelperEDTMtrxSize, OctEvalHelperEDTMtrxSize);
+    OctEvalHelperEDTMtrx = NULL;
+    OctEvalHelperEDTMtrxSize = 0;
+    OctEvalHelperEventId = -1;
+
+    return (NULL);
+
+}
+
+/** function to create the oct-tree thread pool of the calling (locating) thread
+ *
+ *    num_threads - total number of threads evaluating cells, including the calling thread
+ *    init_thread - function called by each helper thread to initialize its control parameters, returns < 0 on error
+ *    cleanup_thread - function called by each helper thread before exit, may be NULL
+ *
+ *    helper threads are initialized one at a time, this function returns after all are initialized
+ *
+ * returns number of helper threads, < 0 on error
+ */
+
+int OctParallel_Init(int num_threads, int (*init_thread)(void *arg), void (*cleanup_thread)(), void *init_arg) {
+
+    int n;
+    OctParallelPool *pool;
+
+
+    OctParallel_Free();
+
+    if (num_threads < 2)
+        return (0);
+
+    if ((pool = (OctParallelPool *) calloc(1, sizeof (OctParallelPool))) == NULL
+            || (pool->threads = (pthread_t *) malloc((num_threads - 1) * sizeof (pthread_t))) == NULL) {
+        free(pool);
+        nll_puterr("ERROR: allocating memory for oct-tree thread pool.");
+        return (-1);
+    }
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+    pool->init_thread = init_thread;
+    pool->cleanup_thread = cleanup_thread;
+    pool->init_arg = init_arg;
+    pool->pcontext = pNLLocContext;
+
+    pthread_mutex_lock(&pool->mutex);
+    for (n = 0; n < num_threads - 1; n++) {
+        if (pthread_create(pool->threads + n, NULL, OctParallel_HelperThread, pool) != 0)
+            break;
+        pool->num_helpers++;
+        // control file reading sets process wide grid memory parameters, initialize helpers one at a time
+        while (pool->num_initialized < pool->num_helpers)
+            pthread_cond_wait(&pool->done_cond, &pool->mutex);
+        if (pool->init_error)
+            break;
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    octParallelPool = pool;
+
+    if (pool->init_error || pool->num_helpers == 0) {
+        nll_puterr("ERROR: starting oct-tree helper threads, oct-tree cells will be evaluated serially.");
+        OctParallel_Free();
+        return (-1);
+    }
+
+    sprintf(MsgStr, "Evaluating oct-tree cells with %d threads (LOCPARALLEL NumOctThreads) ...", pool->num_helpers + 1);
+    nll_putmsg(2, MsgStr);
+
+    return (pool->num_helpers);
+
+}
+
+/** function to stop and free the oct-tree thread pool of the calling thread */
+
+void OctParallel_Free() {
+
+    int n;
+    OctParallelPool *pool = octParallelPool;
+
+    if (pool == NULL)
+        return;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->mutex);
+    for (n = 0; n < pool->num_helpers; n++)
+        pthread_join(pool->threads[n], NULL);
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_cond_destroy(&pool->done_cond);
+    free(pool->threads);
+    free(pool);
+    octParallelPool = NULL;
+
+}
+
+/** function to check if all travel time grids of an event are in memory */
+
+static int OctEval_GridsInMemory(ArrivalDesc *arrival, int num_arrivals) {
+
+    int narr;
+
+    for (narr = 0; narr < num_arrivals; narr++) {
+        if (arrival[narr].n_companion >= 0)
+            continue;
+        if (arrival[narr].gdesc.type == GRID_TIME) {
+            if (arrival[narr].gdesc.buffer == NULL)
+                return (0);
+        } else if (arrival[narr].sheetdesc.buffer == NULL) {
+            return (0);
+        }
+    }
+
+    return (1);
+
+}
+
+/** function to start cell evaluation for an event
+ *
+ * returns < 0 on error
+ */
+
+static int OctEval_Begin(OctEvalEvent *pevent, int ngrid, int num_arr_total, int num_arr_loc, ArrivalDesc *arrival,
+        GaussLocParams* gauss_par, OcttreeParams* pParams, int num_tasks_max,
+        int icalc_cell_diagonal_time_var, int iGridType, double logWtMtrxSum) {
+
+    int narr;
+
+    pevent->ngrid = ngrid;
+    pevent->num_arr_total = num_arr_total;
+    pevent->num_arr_loc = num_arr_loc;
+    pevent->pParams = pParams;
+    pevent->icalc_cell_diagonal_time_var = icalc_cell_diagonal_time_var;
+    pevent->iGridType = iGridType;
+    pevent->logWtMtrxSum = logWtMtrxSum;
+    pevent->misfit = -1.0;
+    pevent->volume_min = VERY_LARGE_DOUBLE;
+    pevent->diagonal = 0.0;
+    pevent->cell_half_diagonal_time_range = 0.0;
+    pevent->num_tasks = 0;
+
+    if (num_tasks_max < OCT_EVAL_MAX_CHILD_TASKS)
+        num_tasks_max = OCT_EVAL_MAX_CHILD_TASKS;
+    if (num_tasks_max > pevent->num_task_alloc) {
+        free(pevent->task);
+        if ((pevent->task = (OctEvalTask *) malloc(num_tasks_max * sizeof (OctEvalTask))) == NULL) {
+            pevent->num_task_alloc = 0;
+            return (-1);
+        }
+        pevent->num_task_alloc = num_tasks_max;
+    }
+    if (OCT_EVAL_MAX_CHILD_TASKS * num_arr_loc > pevent->num_pred_alloc) {
+        free(pevent->pred_travel_time);
+        if ((pevent->pred_travel_time = (double *) malloc(OCT_EVAL_MAX_CHILD_TASKS * num_arr_loc * sizeof (double))) == NULL) {
+            pevent->num_pred_alloc = 0;
+            return (-1);
+        }
+        pevent->num_pred_alloc = OCT_EVAL_MAX_CHILD_TASKS * num_arr_loc;
+    }
+
+    // parallel evaluation
+    pevent->parallel = 0;
+    if (octParallelPool != NULL && LocMethod != METH_OT_STACK) {
+        if (!OctEval_GridsInMemory(arrival, num_arr_loc)) {
+            nll_putmsg(2, pParams != NULL ? "INFO: travel time grids not all in memory, oct-tree cells evaluated serially."
+                    : "INFO: travel time grids not all in memory, grid search nodes evaluated serially.");
+        } else {
+            if (num_arr_total > pevent->num_arrival_alloc) {
+                free(pevent->arrival);
+                if ((pevent->arrival = (ArrivalDesc *) malloc(num_arr_total * sizeof (ArrivalDesc))) == NULL) {
+                    pevent->num_arrival_alloc = 0;
+                    return (-1);
+                }
+                pevent->num_arrival_alloc = num_arr_total;
+            }
+            memcpy(pevent->arrival, arrival, num_arr_total * sizeof (ArrivalDesc));
+            pevent->gauss_par = *gauss_par;
+            if (iUseGauss2) {
+                if (num_arr_loc > pevent->edt_mtx_size) {
+                    free_matrix_double(pevent->edt_mtx, pevent->edt_mtx_size, pevent->edt_mtx_size);
+                    pevent->edt_mtx_size = 0;
+                    if ((pevent->edt_mtx = matrix_double(num_arr_loc, num_arr_loc)) == NULL)
+                        return (-1);
+                    pevent->edt_mtx_size = num_arr_loc;
+                }
+                for (narr = 0; narr < num_arr_loc; narr++)
+                    memcpy(pevent->edt_mtx[narr], gauss_par->EDTMtrx[narr], num_arr_loc * sizeof (double));
+            }
+            pevent->loc_grid = LocGrid[ngrid];
+            pevent->station_phase_list = StationPhaseList;
+            pevent->num_station_phases = NumStationPhases;
+            pevent->tt_cache_active = TTCacheArrivalDesc == arrival && TTCacheNumArrivals >= num_arr_loc;
+            if (pevent->tt_cache_active) {
+                for (narr = 0; narr < num_arr_loc; narr++)
+                    pevent->tt_cache[narr] = TTCacheArrival[narr];
+            }
+            pevent->id = octParallelPool->next_event_id++;
+            pevent->parallel = 1;
+        }
+    }
+
+    return (0);
+
+}
+
+/** function to add a cell evaluation task */
+
+static OctEvalTask* OctEval_AddTask(OctEvalEvent *pevent, OctNode* poct_node, int n_init_node) {
+
+    OctEvalTask *ptask = pevent->task + pevent->num_tasks;
+
+    ptask->poct_node = poct_node;
+    ptask->n_init_node = n_init_node;
+    ptask->pred_travel_time = NULL;
+    if (n_init_node < 0 && pevent->num_tasks < OCT_EVAL_MAX_CHILD_TASKS)
+        ptask->pred_travel_time = pevent->pred_travel_time + pevent->num_tasks * pevent->num_arr_loc;
+    ptask->evaluated = 0;
+    pevent->num_tasks++;
+
+    return (ptask);
+
+}
+
+/** function to evaluate all cell tasks, returns after all tasks are evaluated */
+
+static void OctEval_Run(OctEvalEvent *pevent, ArrivalDesc *arrival, GaussLocParams* gauss_par) {
+
+    int ntask;
+    OctEvalTask *ptask;
+    OctParallelPool *pool = octParallelPool;
+
+    if (pevent->parallel && pool != NULL && pevent->num_tasks > 1) {
+        pthread_mutex_lock(&pool->mutex);
+        pool->pevent = pevent;
+        pool->next_task = 0;
+        pool->num_tasks = pevent->num_tasks;
+        pool->num_completed = 0;
+        pthread_cond_broadcast(&pool->work_cond);
+        // locating thread also evaluates tasks
+        while (pool->next_task < pool->num_tasks) {
+            ntask = pool->next_task++;
+            pthread_mutex_unlock(&pool->mutex);
+            OctEval_EvaluateTask(pevent, pevent->task + ntask, arrival, gauss_par);
+            pthread_mutex_lock(&pool->mutex);
+            pool->num_completed++;
+        }
+        while (pool->num_completed < pool->num_tasks)
+            pthread_cond_wait(&pool->done_cond, &pool->mutex);
+        pool->pevent = NULL;
+        pool->num_tasks = 0;
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    // serial evaluation, values carried from one evaluation to the next as in LocOctree_core() loop
+    for (ntask = 0; ntask < pevent->num_tasks; ntask++) {
+        ptask = pevent->task + ntask;
+        if (ptask->evaluated)
+            continue;
+        OctEval_EvaluateTask(pevent, ptask, arrival, gauss_par);
+        if (!pevent->parallel) {
+            pevent->misfit = ptask->misfit;
+            pevent->volume_min = ptask->volume_min;
+            pevent->diagonal = ptask->diagonal;
+            pevent->cell_half_diagonal_time_range = ptask->cell_half_diagonal_time_range;
+        }
+    }
+
+    for (ntask = 0; ntask < pevent->num_tasks; ntask++) {
+        LocPerfEvent.num_nodes += pevent->task[ntask].perf_num_nodes;
+        LocPerfEvent.num_interp += pevent->task[ntask].perf_num_interp;
+    }
+
+}
+
+/** function to free cell evaluation memory of calling thread */
+
+static void OctEval_Free() {
+
+    free(OctEval.task);
+    OctEval.task = NULL;
+    OctEval.num_task_alloc = 0;
+    free(OctEval.pred_travel_time);
+    OctEval.pred_travel_time = NULL;
+    OctEval.num_pred_alloc = 0;
+    free(OctEval.arrival);
+    OctEval.arrival = NULL;
+    OctEval.num_arrival_alloc = 0;
+    free_matrix_double(OctEval.edt_mtx, OctEval.edt_mtx_size, OctEval.edt_mtx_size);
+    OctEval.edt_mtx = NULL;
+    OctEval.edt_mtx_size = 0;
+
+}
+
+/** function to run num_tasks tasks of a job with the oct-tree thread pool, returns after all tasks are done
+ *
+ *    job_func - function called for each task, by the calling thread or a helper thread
+ */
+
+static void OctParallel_RunJob(void (*job_func)(void *job, int ntask), void *job, int num_tasks) {
+
+    int ntask;
+    OctParallelPool *pool = octParallelPool;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->job_func = job_func;
+    pool->job = job;
+    pool->next_task = 0;
+    pool->num_tasks = num_tasks;
+    pool->num_completed = 0;
+    pthread_cond_broadcast(&pool->work_cond);
+    // calling thread also runs tasks
+    while (pool->next_task < pool->num_tasks) {
+        ntask = pool->next_task++;
+        pthread_mutex_unlock(&pool->mutex);
+        (*job_func)(job, ntask);
+        pthread_mutex_lock(&pool->mutex);
+        pool->num_completed++;
+    }
+    while (pool->num_completed < pool->num_tasks)
+        pthread_cond_wait(&pool->done_cond, &pool->mutex);
+    pool->job_func = NULL;
+    pool->job = NULL;
+    pool->num_tasks = 0;
+    pthread_mutex_unlock(&pool->mutex);
+
+}
+
+/* round of Metropolis chains */
+typedef struct {
+    MetChain *chain;
+    int num_arr_total;
+    int num_arr_loc;
+    GridDesc *ptgrid;
+    int num_samples_stop;
+} MetChainJob;
+
+static void MetChain_JobTask(void *job, int ntask) {
+
+    MetChainJob *pjob = (MetChainJob *) job;
+
+    MetChain_Advance(pjob->chain + ntask, pjob->num_arr_total, pjob->num_arr_loc, pjob->ptgrid, pjob->num_samples_stop);
+
+}
+
+/** function to advance Metropolis chains until num_samples_stop samples are accepted or the walks end
+ *
+ * chains are advanced by the oct-tree thread pool if all travel time grids are in memory
+ */
+
+static void MetChain_Run(MetChain *chain, int num_chains, int num_arr_total, int num_arr_loc, GridDesc* ptgrid, int num_samples_stop) {
+
+    int nchain;
+    MetChainJob job;
+
+    if (octParallelPool != NULL && OctEval_GridsInMemory(chain[0].arrival, num_arr_loc)) {
+        job.chain = chain;
+        job.num_arr_total = num_arr_total;
+        job.num_arr_loc = num_arr_loc;
+        job.ptgrid = ptgrid;
+        job.num_samples_stop = num_samples_stop;
+        OctParallel_RunJob(MetChain_JobTask, &job, num_chains);
+    } else {
+        for (nchain = 0; nchain < num_chains; nchain++)
+            MetChain_Advance(chain + nchain, num_arr_total, num_arr_loc, ptgrid, num_samples_stop);
+    }
+
+}
+
+/** function to start grid search of an event, event data is copied for helper threads if slabs are evaluated in parallel
+ *
+ * returns number of threads evaluating x-slabs, < 0 on error
+ */
+
+static int GridSearch_Begin(int ngrid, int num_arr_total, int num_arr_loc, ArrivalDesc *arrival, GaussLocParams* gauss_par,
+        int iGridType) {
+
+    if (octParallelPool == NULL)
+        return (1);
+
+    if (OctEval_Begin(&OctEval, ngrid, num_arr_total, num_arr_loc, arrival, gauss_par, NULL, 0, 0, iGridType, 0.0) < 0)
+        return (-1);
+    if (!OctEval.parallel)
+        return (1);
+
+    return (octParallelPool->num_helpers + 1);
+
+}
+
+static void GridSearch_JobTask(void *job, int ntask) {
+
+    GridSearchJob *pjob = (GridSearchJob *) job;
+    OctEvalEvent *pevent = (OctEvalEvent *) pjob->pevent;
+
+    // locating thread (owner of pool) evaluates with event data, helper threads with their copy of event data
+    if (octParallelPool != NULL)
+        GridSearch_EvaluateSlab(pjob, pjob->slab + ntask, pjob->arrival, pjob->gauss_par);
+    else if (OctEvalHelperEventId == pevent->id || OctEval_HelperSetEvent(pevent) == 0)
+        GridSearch_EvaluateSlab(pjob, pjob->slab + ntask, OctEvalHelperArrival, &OctEvalHelperGauss);
+
+}
+
+/** function to evaluate num_slabs x-slabs of grid search with the oct-tree thread pool, returns after all slabs are evaluated */
+
+static void GridSearch_Run(GridSearchJob *pjob, int num_slabs, ArrivalDesc *arrival, GaussLocParams* gauss_par) {
+
+    int nslab;
+
+    pjob->arrival = arrival;
+    pjob->gauss_par = gauss_par;
+    pjob->pevent = &OctEval;
+    OctParallel_RunJob(GridSearch_JobTask, pjob, num_slabs);
+
+    // slabs not evaluated if event data cannot be set for helper thread
+    for (nslab = 0; nslab < num_slabs; nslab++) {
+        if (!pjob->slab[nslab].evaluated)
+            GridSearch_EvaluateSlab(pjob, pjob->slab + nslab, arrival, gauss_par);
+    }
+
+}
 
-    nReject = 0;
-    for (narr = 0; narr < num_arr_loc; narr++) {
-        /* check for companion */
-        if ((n_compan = arrival[narr].n_companion) >= 0) {
-            if ((arrival[narr].pred_travel_time = arrival[n_compan].pred_travel_time) < 0.0)
-                nReject++;
-            arrival[narr].pred_travel_time *= arrival[narr].tfact;
-            /* else check grid type */
-        } else {
-            if (arrival[narr].gdesc.type == GRID_TIME) {
-                /* 3D grid */
-                if (arrival[narr].gdesc.buffer == NULL) {
-                    /* read time grid from disk */
-                    fp_grid = arrival[narr].fpgrid;
-                } else {
-                    /* read time grid from memory buffer */
-                    fp_grid = NULL;
-                }
-                if ((arrival[narr].pred_travel_time = (double) ReadAbsInterpGrid3d(fp_grid, &(arrival[narr].gdesc),
-                        xval, yval, zval, 0)) < 0.0)
-                    nReject++;
-            } else {
-                /* 2D grid (1D model) */
-                yval_grid = GetEpiDist(&(arrival[narr].station), xval, yval);
-                if (GeometryMode == MODE_GLOBAL)
-                    yval_grid *= KM2DEG;
-                if (arrival[narr].sheetdesc.buffer == NULL) {
-                    /* read time grid from disk */
-                    fp_grid = arrival[narr].fpgrid;
-                    ptgrid = &(arrival[narr].gdesc);
-                } else {
-                    /* read time grid from memory buffer */
-                    fp_grid = NULL;
-                    ptgrid = &(arrival[narr].sheetdesc);
-                }
-                if ((arrival[narr].pred_travel_time = ReadAbsInterpGrid2d(fp_grid, ptgrid, yval_grid, zval)) < 0.0)
-                    nReject++;
-                //printf("DEBUG: getTT:  xval %lf yval %lf yval_grid %lf zval %lf t %lf \n", xval, yval, yval_grid, zval, arrival[narr].pred_travel_time);
-                //display_grid_param(&(arrival[narr].sheetdesc));
-            }
-            arrival[narr].pred_travel_time *= arrival[narr].tfact;
-            // apply crustal correction
-            if (ApplyCrustElevCorrFlag && GeometryMode == MODE_GLOBAL
-                    && arrival[narr].pred_travel_time > 0.0) {
-                //printf("arrival[narr].pred_travel_time before: %f", arrival[narr].pred_travel_time);
-                if (yval_grid > MinDistCrustElevCorr)
-                    arrival[narr].pred_travel_time += applyCrustElevCorrection(arrival + narr, xval, yval, zval);
-                //printf(" -> after: %f\n", arrival[narr].pred_travel_time);
-            } else if (ApplyElevCorrFlag) {
+/** end of parallel evaluation of oct-tree cells */
+/*------------------------------------------------------------/ */
 
-                if (arrival[narr].pred_travel_time > 0.0) // ignore arrivals with no pred tt
-                    arrival[narr].pred_travel_time += arrival[narr].elev_corr;
-            }
-        }
 
-        // set slowness
-        if (arrival[narr].isS)
-            arrival[narr].slowness = slowness_S;
 
-        else
-            arrival[narr].slowness = slowness_P;
+/** convergence of oct-tree search
+ *
+ * With LOCSEARCH OCT ... convNumSubdiv > 0 the search is checked every convNumSubdiv subdivisions, and stops when the
+ * integral of the probability over the oct-tree leaf nodes (integrateResultTree()) changed by a relative amount less than
+ * convTolIntegral and the maximum likelihood node moved less than convTolDist km since the previous check.
+ */
+
+// 20261016 agent - added
+
+typedef struct {
+    int num_checks;
+    double log_integral; // log of integral of probability at last check
+    double x, y, z; // maximum likelihood location at last check
+    double rel_change_integral; // changes between last two checks
+    double dist;
+} OctConvergence;
+
+/** function to initialize convergence check */
+
+static void LocOctree_InitConvergence(OctConvergence *pconv) {
+
+    pconv->num_checks = 0;
+    pconv->log_integral = 0.0;
+    pconv->x = pconv->y = pconv->z = 0.0;
+    pconv->rel_change_integral = -1.0;
+    pconv->dist = -1.0;
+
+}
+
+/** function to check convergence of oct-tree search
+ *
+ *    oct_node_value_max - log probability density of maximum likelihood node, reference for integration
+ *
+ * returns 1 if search converged since previous check, 0 otherwise
+ */
+
+static int LocOctree_CheckConvergence(OctConvergence *pconv, OcttreeParams* pParams, double oct_node_value_max, HypoDesc* phypo) {
 
+    int converged = 0;
+    double integral, log_integral;
+    double dx, dy, dz;
+
+    integral = integrateResultTree(resultTreeRoot, VALUE_IS_LOG_PROB_DENSITY_IN_NODE, 0.0, oct_node_value_max);
+    if (!(integral > 0.0) || !isfinite(integral)) {
+        pconv->num_checks = 0;
+        return (0);
+    }
+    log_integral = log(integral) + oct_node_value_max;
+
+    if (pconv->num_checks > 0) {
+        pconv->rel_change_integral = fabs(expm1(log_integral - pconv->log_integral));
+        dx = phypo->x - pconv->x;
+        dy = phypo->y - pconv->y;
+        dz = phypo->z - pconv->z;
+        if (GeometryMode == MODE_GLOBAL) {
+            dx *= DEG2KM;
+            dy *= DEG2KM;
+        }
+        pconv->dist = sqrt(dx * dx + dy * dy + dz * dz);
+        converged = pconv->rel_change_integral < pParams->conv_tol_integral && pconv->dist < pParams->conv_tol_dist;
     }
 
+    pconv->num_checks++;
+    pconv->log_integral = log_integral;
+    pconv->x = phypo->x;
+    pconv->y = phypo->y;
+    pconv->z = phypo->z;
 
-    return (nReject);
+    return (converged);
 
 }
 
+/** end of convergence of oct-tree search */
+/*------------------------------------------------------------/ */
 
 
-/** function to apply crustal correction and elevation correction */
 
-// assumes vertical ray (dtdd = 0.0) !!!
+/*------------------------------------------------------------/ */
+/** local refinement of oct-tree maximum likelihood location
+ *
+ * The oct-tree maximum likelihood location is the center of the best leaf cell.  With LOCSEARCH OCT ... refineTolStep > 0
+ * the location is refined within this cell by damped Newton (Levenberg-Marquardt) steps on the negative log probability
+ * density, with the gradient and Hessian from finite differences over a quarter of the cell side.  A step is accepted
+ * only if it increases the probability density, otherwise the damping is increased.  Iterations stop when the step is
+ * smaller than refineTolStep km, when no step increases the probability density, or after refineMaxIter iterations.
+ */
 
-double applyCrustElevCorrection(ArrivalDesc* parrival, double xval, double yval, double zval) {
+// 20261016 agent - added
 
-    double correction = 0.0;
-    double dtdd = 0.0;
-    char cphase;
+#define OCT_REFINE_MAX_TRY 8 // maximum number of damping increases per iteration
 
-    if (IsPhaseID(parrival->phase, "P"))
-        cphase = 'P';
-    else if (IsPhaseID(parrival->phase, "S"))
-        cphase = 'S';
-    else
-        return (0.0);
+typedef struct {
+    int num_iter;
+    int num_eval;
+    double step; // last accepted step (km)
+    double shift; // distance of refined location from center of leaf cell (km)
+} OctRefine;
 
+/** function to initialize refinement statistics */
 
-    // source
-    correction = calc_crust_corr(cphase, yval, xval, zval, VERY_LARGE_DOUBLE, dtdd);
-    // receiver
-    correction +=
-            calc_crust_corr(cphase, parrival->station.dlat,
-            parrival->station.dlong, 0.0, -1000.0 * parrival->station.depth, dtdd);
+static void LocOctree_InitRefine(OctRefine *prefine) {
 
-    return (correction);
+    prefine->num_iter = 0;
+    prefine->num_eval = 0;
+    prefine->step = -1.0;
+    prefine->shift = 0.0;
 
 }
 
-/** function to check if xyz location is above topography */
+/** function to evaluate log probability density at a point
+ *
+ * returns -VERY_LARGE_DOUBLE if point is above topography or outside of a travel time grid
+ */
 
-int isAboveTopo(double xval, double yval, double zval) {
+static double LocOctree_RefineEval(double xval, double yval, double zval, int num_arr_loc, ArrivalDesc *arrival,
+        GaussLocParams* gauss_par, int iGridType, double *pmisfit, OctRefine *prefine) {
 
-    double xlon, ylat, elev;
-    double topo_elev;
+    double value, log_prior;
 
-    // check topo if available
-    if (topo_surface_index >= 0) {
-        if (model_surface[topo_surface_index].is_latlon) {
-            // convert xyz to lat/long/elev
-            rect2latlon(0, xval, yval, &ylat, &xlon);
-        } else {
-            xlon = xval;
-            ylat = yval;
-        }
-        if (map_itype[0] != MAP_TRANS_NONE) // 20110105 AJL
-            elev = -zval * 1000.0; // elevation in meters
-        else
-            elev = -zval; // 20110105 AJL
-        // get elevation of topo at location
-        topo_elev = get_surface_z(topo_surface_index, xlon, ylat);
-        int iabove = elev > topo_elev;
+    prefine->num_eval++;
+    *pmisfit = -1.0;
 
-        /*
-                                                                                if (iabove) {
-                                                                                    printf("xyz %f %f %f  lon/lat/elev %f %f %f  topo_elev %f  above %d\n", xval, yval, zval, ylat, xlon, elev, topo_elev, iabove);
-                                                                                }//*/
+    if (isAboveTopo(xval, yval, zval))
+        return (-VERY_LARGE_DOUBLE);
+    if (getTravelTimes(pNLLocContext, arrival, num_arr_loc, xval, yval, zval))
+        return (-VERY_LARGE_DOUBLE);
 
-        return (iabove);
+    value = CalcSolutionQuality(pNLLocContext, xval, yval, zval, NULL, num_arr_loc, arrival, gauss_par,
+            iGridType, pmisfit, NULL, NULL, 0.0, 0.0, 0.0, NULL, NULL, &log_prior);
+    value += log_prior;
+    if (!isfinite(value))
+        return (-VERY_LARGE_DOUBLE);
+
+    return (value);
+
+}
+
+/** function to solve symmetric 3x3 system a x = b by Cholesky decomposition
+ *
+ * returns 0 on success, -1 if a is not positive definite
+ */
+
+static int LocOctree_RefineSolve(double a[3][3], double b[3], double x[3]) {
+
+    int i, j, k;
+    double l[3][3], sum;
+
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j <= i; j++) {
+            sum = a[i][j];
+            for (k = 0; k < j; k++)
+                sum -= l[i][k] * l[j][k];
+            if (i == j) {
+                if (sum <= 0.0)
+                    return (-1);
+                l[i][i] = sqrt(sum);
+            } else {
+                l[i][j] = sum / l[j][j];
+            }
+        }
+    }
+    for (i = 0; i < 3; i++) {
+        sum = b[i];
+        for (k = 0; k < i; k++)
+            sum -= l[i][k] * x[k];
+        x[i] = sum / l[i][i];
+    }
+    for (i = 2; i >= 0; i--) {
+        sum = x[i];
+        for (k = i + 1; k < 3; k++)
+            sum -= l[k][i] * x[k];
+        x[i] = sum / l[i][i];
     }
 
     return (0);
 
 }
 
+/** function to refine maximum likelihood location within best oct-tree leaf cell
+ *
+ * on return phypo->x/y/z and phypo->misfit are set to the refined location and arrival[].pred_travel_time_best to the
+ * travel times at this location if the location was improved
+ *
+ * returns 1 if location was improved, 0 otherwise
+ */
 
+static int LocOctree_Refine(OctNode* poct_node, int num_arr_loc, ArrivalDesc *arrival, GaussLocParams* gauss_par,
+        int iGridType, OcttreeParams* pParams, HypoDesc* phypo, OctRefine *prefine) {
 
+    int i, j, narr, iter, ntry, iaccept;
+    double center[3], scale[3], half[3], u[3], u_try[3], du[3];
+    double grad[3], hess[3][3], amtx[3][3], fplus[3], fminus[3], fpp;
+    double value, value_try, misfit, misfit_try;
+    double h, lambda, mu, step;
 
+    center[0] = poct_node->center.x;
+    center[1] = poct_node->center.y;
+    center[2] = poct_node->center.z;
+    // work in km offsets from cell center
+    scale[0] = scale[1] = scale[2] = 1.0;
+    if (GeometryMode == MODE_GLOBAL) {
+        scale[0] = DEG2KM * cos(DE2RA * center[1]);
+        scale[1] = DEG2KM;
+    }
+    half[0] = 0.5 * poct_node->ds.x * scale[0];
+    half[1] = 0.5 * poct_node->ds.y * scale[1];
+    half[2] = 0.5 * poct_node->ds.z * scale[2];
+    h = 0.5 * half[0];
+    for (i = 1; i < 3; i++)
+        if (0.5 * half[i] < h)
+            h = 0.5 * half[i];
+    if (!(h > 0.0))
+        return (0);
 
-/*------------------------------------------------------------/ */
-/** Octtree search routines */
-
-/** function to initialize Octtree search */
+#define OCT_REFINE_EVAL(v, misfit) \
+    LocOctree_RefineEval(center[0] + (v)[0] / scale[0], center[1] + (v)[1] / scale[1], center[2] + (v)[2] / scale[2], \
+    num_arr_loc, arrival, gauss_par, iGridType, &(misfit), prefine)
 
-Tree3D * InitializeOcttree(GridDesc* ptgrid, OcttreeParams * pParams) {
+    u[0] = u[1] = u[2] = 0.0;
+    value = OCT_REFINE_EVAL(u, misfit);
+    if (value <= -VERY_LARGE_DOUBLE)
+        return (0);
 
-    double dx, dy, dz;
-    Tree3D* newTree;
-    void *pdata = NULL;
-    double integral;
+    lambda = 1.0e-3;
+    for (iter = 0; iter < pParams->refine_max_iter; iter++) {
+
+        prefine->num_iter++;
+
+        // finite difference gradient and Hessian of log probability density
+        for (i = 0; i < 3; i++) {
+            u_try[0] = u[0];
+            u_try[1] = u[1];
+            u_try[2] = u[2];
+            u_try[i] = u[i] + h;
+            fplus[i] = OCT_REFINE_EVAL(u_try, misfit_try);
+            u_try[i] = u[i] - h;
+            fminus[i] = OCT_REFINE_EVAL(u_try, misfit_try);
+            if (fplus[i] <= -VERY_LARGE_DOUBLE || fminus[i] <= -VERY_LARGE_DOUBLE)
+                goto refine_end;
+            grad[i] = (fplus[i] - fminus[i]) / (2.0 * h);
+            hess[i][i] = (fplus[i] - 2.0 * value + fminus[i]) / (h * h);
+        }
+        for (i = 0; i < 3; i++) {
+            for (j = i + 1; j < 3; j++) {
+                u_try[0] = u[0];
+                u_try[1] = u[1];
+                u_try[2] = u[2];
+                u_try[i] += h;
+                u_try[j] += h;
+                fpp = OCT_REFINE_EVAL(u_try, misfit_try);
+                if (fpp <= -VERY_LARGE_DOUBLE)
+                    goto refine_end;
+                hess[i][j] = hess[j][i] = (fpp - fplus[i] - fplus[j] + value) / (h * h);
+            }
+        }
+        // damping scaled by mean curvature
+        mu = (fabs(hess[0][0]) + fabs(hess[1][1]) + fabs(hess[2][2])) / 3.0;
+        if (!(mu > 0.0) || !isfinite(mu))
+            break;
 
-    // set up oct-tree x, y, z grid
-    dx = ptgrid->dx * (double) (ptgrid->numx - 1) / (double) (pParams->init_num_cells_x);
-    dy = ptgrid->dy * (double) (ptgrid->numy - 1) / (double) (pParams->init_num_cells_y);
-    //dz = ptgrid->dz * (double) (ptgrid->numz - 1) / (double) (pParams->init_num_cells_z);
-    // 20101004 AJL - Fixed bug: Oct-tree search was not initialized to bottom of LOCSEARCH grid, bottom LOCSEARCH grid layer was lost.
-    //dz = ptgrid->dz * (double) ptgrid->numz / (double) (pParams->init_num_cells_z);
-    // 20200302 AJL - Un-Fixed bug: Seems that Oct-tree search was initialized to bottom of LOCSEARCH grid.
-    dz = ptgrid->dz * (double) (ptgrid->numz - 1) / (double) (pParams->init_num_cells_z);
+        // damped Newton step on negative log probability density, increase damping until step accepted
+        iaccept = 0;
+        step = 0.0;
+        for (ntry = 0; ntry < OCT_REFINE_MAX_TRY; ntry++) {
+            for (i = 0; i < 3; i++) {
+                for (j = 0; j < 3; j++)
+                    amtx[i][j] = -hess[i][j];
+                amtx[i][i] += lambda * mu;
+            }
+            if (LocOctree_RefineSolve(amtx, grad, du) < 0) {
+                lambda *= 10.0;
+                continue;
+            }
+            // bound to leaf cell
+            step = 0.0;
+            for (i = 0; i < 3; i++) {
+                u_try[i] = u[i] + du[i];
+                if (u_try[i] > half[i])
+                    u_try[i] = half[i];
+                else if (u_try[i] < -half[i])
+                    u_try[i] = -half[i];
+                step += (u_try[i] - u[i]) * (u_try[i] - u[i]);
+            }
+            step = sqrt(step);
+            if (step < pParams->refine_tol_step)
+                break;
+            value_try = OCT_REFINE_EVAL(u_try, misfit_try);
+            if (value_try > value) {
+                iaccept = 1;
+                break;
+            }
+            lambda *= 10.0;
+        }
+        if (!iaccept)
+            break;
 
-    integral = 0.0;
-    // 20160927 AJL   if (LocMethod == METH_OT_STACK && GeometryMode == MODE_GLOBAL) {
-    //if (GeometryMode == MODE_GLOBAL && !iSaveNLLocOctree) { // 20160927 AJL - bug fix?  octtree.c->writeTree3D() (called if iSaveNLLocOctree) does not yet support spherical trees
-    if (GeometryMode == MODE_GLOBAL) { // 20190508 AJL - bug fix?  octtree.c->writeTree3D() now handles spherical trees issues
-        newTree = newTree3D_spherical(ptgrid->type, pParams->init_num_cells_x,
-                pParams->init_num_cells_y, pParams->init_num_cells_z,
-                ptgrid->origx, ptgrid->origy, ptgrid->origz,
-                dx, dy, dz, OCTREE_UNDEF_VALUE, integral, pdata);
-    } else {
+        u[0] = u_try[0];
+        u[1] = u_try[1];
+        u[2] = u_try[2];
+        value = value_try;
+        misfit = misfit_try;
+        prefine->step = step;
+        lambda /= 10.0;
+        if (lambda < 1.0e-6)
+            lambda = 1.0e-6;
+        if (step < pParams->refine_tol_step)
+            break;
 
-        newTree = newTree3D(ptgrid->type, pParams->init_num_cells_x,
-                pParams->init_num_cells_y, pParams->init_num_cells_z,
-                ptgrid->origx, ptgrid->origy, ptgrid->origz,
-                dx, dy, dz, OCTREE_UNDEF_VALUE, integral, pdata);
     }
 
-    return (newTree);
+refine_end:
+
+    if (u[0] == 0.0 && u[1] == 0.0 && u[2] == 0.0)
+        return (0);
+
+    // set refined location and travel times
+    phypo->x = center[0] + u[0] / scale[0];
+    phypo->y = center[1] + u[1] / scale[1];
+    phypo->z = center[2] + u[2] / scale[2];
+    phypo->misfit = misfit;
+    prefine->shift = sqrt(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]);
+    OCT_REFINE_EVAL(u, misfit_try);
+    for (narr = 0; narr < num_arr_loc; narr++)
+        arrival[narr].pred_travel_time_best = arrival[narr].pred_travel_time;
+
+#undef OCT_REFINE_EVAL
+
+    return (1);
+
 }
 
+/** end of local refinement of oct-tree maximum likelihood location */
+/*------------------------------------------------------------/ */
+
+
+
 /** function to perform Octree location */
 
-int LocOctree(int ngrid, int num_arr_total, int num_arr_loc,
+int LocOctree(NLLocContext *pcontext, int ngrid, int num_arr_total, int num_arr_loc,
         ArrivalDesc *arrival,
         GridDesc* ptgrid, GaussLocParams* gauss_par, HypoDesc* phypo,
         OcttreeParams* pParams, Tree3D* pOctTree, float* fdata,
@@ -14347,7 +17622,9 @@ int LocOctree(int ngrid, int num_arr_total, int num_arr_loc,
     double logWtMtrxSum;
     //double volume, log_value_volume;
     int icalc_cell_diagonal_time_var = 0;
-    double diagonal, cell_half_diagonal_time_range, volume_min;
+    //double diagonal, cell_half_diagonal_time_range, volume_min; // 20261016 agent - carried in OctEval (OctEval_Begin())
+    int ntask;
+    OctEvalTask *ptask;
     //double dsx, dsy, dsz;
     //double dsx_global, dsy_global, depth_corr;
     ResultTreeNode* presult_node;
@@ -14366,15 +17643,22 @@ int LocOctree(int ngrid, int num_arr_total, int num_arr_loc,
 
     //double stationDensityWeight = 0.0;
 
+    // 20261016 agent - added, convergence early stop
+    int nSubdiv = 0;
+    char *stop_reason = "MAX_NUM_NODES";
+    OctConvergence conv;
+    LocOctree_InitConvergence(&conv);
+    // 20261016 agent - added, local refinement of maximum likelihood location
+    OctRefine refine;
+    LocOctree_InitRefine(&refine);
+
 
 
     // reset EDT_otime_weight_active flag
     EDT_otime_weight_active = 0;
 
-    // cell diagonal variance defaults to null - i.e. no effect
-    diagonal = cell_half_diagonal_time_range = 0.0;
+    // cell diagonal variance defaults to null - i.e. no effect (see OctEval_Begin())
     icalc_cell_diagonal_time_var = pParams->mean_cell_velocity > 0.0;
-    volume_min = VERY_LARGE_DOUBLE;
 
 
     iGridType = GRID_PROB_DENSITY;
@@ -14400,37 +17684,52 @@ int LocOctree(int ngrid, int num_arr_total, int num_arr_loc,
 
     nSamples = 0;
     resultTreeRoot = NULL;
+    freeResultQueue(resultQueue);
+    if ((resultQueue = newResultQueue()) == NULL)
+        return (-1);
+    // 20261016 agent - added, travel times at initial nodes are kept between events
+    TTCache_Attach(ngrid, pOctTree, arrival, num_arr_loc);
+    // 20261016 agent - added, cells evaluated as batches of tasks, possibly in parallel (LOCPARALLEL NumOctThreads)
+    if (OctEval_Begin(&OctEval, ngrid, num_arr_total, num_arr_loc, arrival, gauss_par, pParams,
+            pOctTree->numx * pOctTree->numy * pOctTree->numz,
+            icalc_cell_diagonal_time_var, iGridType, logWtMtrxSum) < 0) {
+        nll_puterr("ERROR: allocating memory for oct-tree cell evaluation.");
+        TTCache_Detach();
+        return (-1);
+    }
     for (ix = 0; ix < pOctTree->numx; ix++) {
         for (iy = 0; iy < pOctTree->numy; iy++) {
             for (iz = 0; iz < pOctTree->numz; iz++) {
                 poct_node = pOctTree->nodeArray[ix][iy][iz];
                 if (poct_node == NULL) // case of Tree3D_spherical
                     continue;
-                // $$$ NOTE: this block must be identical to block $$$ below
-                xval = poct_node->center.x;
-                yval = poct_node->center.y;
-                zval = poct_node->center.z;
-                value = LocOctree_core(ngrid, xval, yval, zval, num_arr_loc, arrival, poct_node,
-                        icalc_cell_diagonal_time_var, &volume_min, &diagonal,
-                        &cell_half_diagonal_time_range, pParams, gauss_par, iGridType, &misfit, logWtMtrxSum);
-                nSamples++;
-                // END - this block must be identical to block $$$ below
-
-                // save node size
-                smallest_node_size_x = poct_node->ds.x;
-                smallest_node_size_y = poct_node->ds.y;
-                smallest_node_size_z = poct_node->ds.z;
-
-                if (message_flag >= 1 && nSamples % 5000 == 0) {
-                    fprintf(stdout,
-                            "OctTree num samples = %d / %d\r", nSamples, pParams->max_num_nodes);
-                    fflush(stdout);
-                }
-
+                OctEval_AddTask(&OctEval, poct_node, (ix * pOctTree->numy + iy) * pOctTree->numz + iz);
             }
         }
     }
+    OctEval_Run(&OctEval, arrival, gauss_par);
+    for (ntask = 0; ntask < OctEval.num_tasks; ntask++) {
+        ptask = OctEval.task + ntask;
+        poct_node = ptask->poct_node;
+        // $$$ NOTE: this block must be identical to block $$$ below
+        addResultQueue(resultQueue, addResultNode(&resultTreeRoot, ptask->log_value_volume, ptask->volume, poct_node, octArena));
+        nSamples++;
+        // END - this block must be identical to block $$$ below
+
+        // save node size
+        smallest_node_size_x = poct_node->ds.x;
+        smallest_node_size_y = poct_node->ds.y;
+        smallest_node_size_z = poct_node->ds.z;
+
+        if (message_flag >= 1 && nSamples % 5000 == 0) {
+            fprintf(stdout,
+                    "OctTree num samples = %d / %d\r", nSamples, pParams->max_num_nodes);
+            fflush(stdout);
+        }
+
+    }
     nInitial = nSamples;
+    TTCache_Detach();
 
 
     /* loop over oct-tree nodes */
@@ -14441,14 +17740,15 @@ int LocOctree(int ngrid, int num_arr_total, int num_arr_loc,
     while (nSamples < pParams->max_num_nodes) {
 
         if (pParams->stop_on_min_node_size)
-            presult_node = getHighestLeafValue(resultTreeRoot);
+            presult_node = getHighestLeafValueQueue(resultQueue);
         else
-            presult_node = getHighestLeafValueMinSize(resultTreeRoot,
+            presult_node = getHighestLeafValueMinSizeQueue(resultQueue,
                 min_node_size_x, min_node_size_y, min_node_size_z);
         // check if null node
         if (presult_node == NULL) {
             if (message_flag >= 1)
                 fprintf(stdout, "\nINFO: No more nodes larger than min_node_size, terminating Octree search.");
+            stop_reason = "NO_NODES";
             break;
         }
 
@@ -14463,6 +17763,8 @@ int LocOctree(int ngrid, int num_arr_total, int num_arr_loc,
 
         // subdivide all HighestLeafValue neighbors
 
+        OctEval.num_tasks = 0;
+
         int n_neigh_max = 7;
         if (LocMethod == METH_OT_STACK) // this is in warning monitor for speed and efficiency in convergence, with the risk of less thorough search
             n_neigh_max = 1;
@@ -14512,8 +17814,8 @@ int LocOctree(int ngrid, int num_arr_total, int num_arr_loc,
             }
 
 
-            // subdivide node and evaluate solution at each child
-            subdivide(neighbor_node, OCTREE_UNDEF_VALUE, NULL);
+            // subdivide node and add evaluation of each child
+            subdivideArena(neighbor_node, OCTREE_UNDEF_VALUE, NULL, pOctTree->arena);
 
             for (ix = 0; ix < 2; ix++) {
                 for (iy = 0; iy < 2; iy++) {
@@ -14532,79 +17834,90 @@ int LocOctree(int ngrid, int num_arr_total, int num_arr_loc,
                         if (poct_node->ds.z < smallest_node_size_z)
                             smallest_node_size_z = poct_node->ds.z;
 
-                        // $$$ NOTE: this block must be identical to block $$$ above
-                        xval = poct_node->center.x;
-                        yval = poct_node->center.y;
-                        zval = poct_node->center.z;
-                        value = LocOctree_core(ngrid, xval, yval, zval, num_arr_loc, arrival, poct_node,
-                                icalc_cell_diagonal_time_var, &volume_min, &diagonal,
-                                &cell_half_diagonal_time_range, pParams, gauss_par, iGridType, &misfit, logWtMtrxSum);
-                        nSamples++;
-                        // END - this block must be identical to block $$$ above
-
-                        if (message_flag >= 1 && nSamples % 5000 == 0) {
-                            fprintf(stdout,
-                                    "OctTree num samples = %d / %d\r", nSamples, pParams->max_num_nodes);
-                            fflush(stdout);
-                        }
+                        OctEval_AddTask(&OctEval, poct_node, -1);
 
-                        // check value
-                        /*if (value < -LARGE_FLOAT) {
-                            sprintf(MsgStr, "ERROR: log(prob_density) at (%lf,%lf,%lf) is too small %lg.", xval, yval, zval, (double) value);
-                            nll_puterr(MsgStr);
-                        }*/
-                        /*if (isnan(value)) {
-                            sprintf(MsgStr, "WARNNG: log(prob_density) at (%lf,%lf,%lf) is NaN (%lg), reset to %g.", xval, yval, zval, (double) value, -VERY_LARGE_DOUBLE);
-                            nll_puterr(MsgStr);
-                            value = -VERY_LARGE_DOUBLE;
-                        }*/
-
-                        /* check for maximum likelihood */
-                        //printf("value=%lg, value_max=%lg, diagonal=%f\r", (double) value, (double) value_max, diagonal);
-                        if (value >= value_max) {
-                            //printf(">>>>>>>>>>>>>>>>> value=%lg > value_max=%lg!!, diagonal=%f, xyz= %f %g %g\n", (double) value, (double) value_max, diagonal, xval, yval, zval);
-                            value_max = value;
-                            //misfit_min = misfit;
-                            phypo->misfit = misfit;
-                            phypo->x = xval;
-                            phypo->y = yval;
-                            phypo->z = zval;
-                            hypo_dx = poct_node->ds.x;
-                            hypo_dz = poct_node->ds.z;
-                            for (narr = 0; narr < num_arr_loc; narr++)
-                                arrival[narr].pred_travel_time_best = arrival[narr].pred_travel_time;
-                            poct_node_best = poct_node;
-                            *poct_node_value_max = poct_node->value;
-                            cell_diagonal_time_var_best = cell_half_diagonal_time_range * cell_half_diagonal_time_range;
-                            cell_diagonal_best = diagonal;
-                            cell_volume_best = volume_min;
-                        }
-                        if (misfit > 0.0 && misfit > misfit_max) // misfit < 0 for topo masking
-                            misfit_max = misfit;
+                    } // end triple loop over node children
+                }
+            }
 
+        } // end loop over HighestLeafValue neighbors
 
-                        /* set to TRUE to save all samples, REMEMBER to set OCT num_scatter high enough in control file */
-                        if (0) {
-                            /* save sample to scatter file */
-                            fdata[ipos++] = xval;
-                            fdata[ipos++] = yval;
-                            fdata[ipos++] = zval;
-                            dlike = (long double) gauss_par->WtMtrxSum * (long double) exp(value);
-                            fdata[ipos++] = dlike;
+        // evaluate solution at each child, then process children in order
+        OctEval_Run(&OctEval, arrival, gauss_par);
 
-                            /* update  probabilitic residuals */
-                            if (1)
-                                UpdateProbabilisticResiduals(num_arr_loc, arrival, 1.0);
+        for (ntask = 0; ntask < OctEval.num_tasks; ntask++) {
 
-                            nScatterSaved++;
-                        }
+            ptask = OctEval.task + ntask;
+            poct_node = ptask->poct_node;
+            value = ptask->value;
+            misfit = ptask->misfit;
+            xval = poct_node->center.x;
+            yval = poct_node->center.y;
+            zval = poct_node->center.z;
 
+            // $$$ NOTE: this block must be identical to block $$$ above
+            addResultQueue(resultQueue, addResultNode(&resultTreeRoot, ptask->log_value_volume, ptask->volume, poct_node, octArena));
+            nSamples++;
+            // END - this block must be identical to block $$$ above
 
-                    } // end triple loop over node children
-                }
+            if (message_flag >= 1 && nSamples % 5000 == 0) {
+                fprintf(stdout,
+                        "OctTree num samples = %d / %d\r", nSamples, pParams->max_num_nodes);
+                fflush(stdout);
             }
 
-        } // end loop over HighestLeafValue neighbors
+            // check value
+            /*if (value < -LARGE_FLOAT) {
+                sprintf(MsgStr, "ERROR: log(prob_density) at (%lf,%lf,%lf) is too small %lg.", xval, yval, zval, (double) value);
+                nll_puterr(MsgStr);
+            }*/
+            /*if (isnan(value)) {
+                sprintf(MsgStr, "WARNNG: log(prob_density) at (%lf,%lf,%lf) is NaN (%lg), reset to %g.", xval, yval, zval, (double) value, -VERY_LARGE_DOUBLE);
+                nll_puterr(MsgStr);
+                value = -VERY_LARGE_DOUBLE;
+            }*/
+
+            /* check for maximum likelihood */
+            //printf("value=%lg, value_max=%lg, diagonal=%f\r", (double) value, (double) value_max, diagonal);
+            if (value >= value_max) {
+                //printf(">>>>>>>>>>>>>>>>> value=%lg > value_max=%lg!!, diagonal=%f, xyz= %f %g %g\n", (double) value, (double) value_max, diagonal, xval, yval, zval);
+                value_max = value;
+                //misfit_min = misfit;
+                phypo->misfit = misfit;
+                phypo->x = xval;
+                phypo->y = yval;
+                phypo->z = zval;
+                hypo_dx = poct_node->ds.x;
+                hypo_dz = poct_node->ds.z;
+                for (narr = 0; narr < num_arr_loc; narr++)
+                    arrival[narr].pred_travel_time_best = ptask->pred_travel_time[narr];
+                poct_node_best = poct_node;
+                *poct_node_value_max = poct_node->value;
+                cell_diagonal_time_var_best = ptask->cell_half_diagonal_time_range * ptask->cell_half_diagonal_time_range;
+                cell_diagonal_best = ptask->diagonal;
+                cell_volume_best = ptask->volume_min;
+            }
+            if (misfit > 0.0 && misfit > misfit_max) // misfit < 0 for topo masking
+                misfit_max = misfit;
+
+
+            /* set to TRUE to save all samples, REMEMBER to set OCT num_scatter high enough in control file */
+            if (0) {
+                /* save sample to scatter file */
+                fdata[ipos++] = xval;
+                fdata[ipos++] = yval;
+                fdata[ipos++] = zval;
+                dlike = (long double) gauss_par->WtMtrxSum * (long double) exp(value);
+                fdata[ipos++] = dlike;
+
+                /* update  probabilitic residuals */
+                if (1)
+                    UpdateProbabilisticResiduals(num_arr_loc, arrival, 1.0);
+
+                nScatterSaved++;
+            }
+
+        } // end loop over evaluated children
 
         // check if minimum node size reached
         if (pParams->stop_on_min_node_size && (smallest_node_size_x < min_node_size_x
@@ -14612,6 +17925,17 @@ int LocOctree(int ngrid, int num_arr_total, int num_arr_loc,
                 || smallest_node_size_z < min_node_size_z)) {
             if (message_flag >= 1)
                 fprintf(stdout, "\nINFO: Min node size reached, terminating Octree search.");
+            stop_reason = "MIN_NODE_SIZE";
+            break;
+        }
+
+        // 20261016 agent - added, check for convergence of integrated probability and maximum likelihood location
+        nSubdiv++;
+        if (pParams->conv_num_subdiv > 0 && nSubdiv % pParams->conv_num_subdiv == 0 && poct_node_best != NULL
+                && LocOctree_CheckConvergence(&conv, pParams, *poct_node_value_max, phypo)) {
+            if (message_flag >= 1)
+                fprintf(stdout, "\nINFO: Integrated probability and maximum likelihood location converged, terminating Octree search.");
+            stop_reason = "CONVERGED";
             break;
         }
 
@@ -14647,6 +17971,11 @@ int LocOctree(int ngrid, int num_arr_total, int num_arr_loc,
 
 
 
+    // 20261016 agent - added, refine maximum likelihood location within best leaf cell
+    if (pParams->refine_tol_step > 0.0 && LocMethod != METH_OT_STACK && poct_node_best != NULL)
+        LocOctree_Refine(poct_node_best, num_arr_loc, arrival, gauss_par, iGridType, pParams, phypo, &refine);
+
+
     /* check reject location conditions */
 
     /* maximum like hypo on edge of grid */
@@ -14673,6 +18002,16 @@ int LocOctree(int ngrid, int num_arr_total, int num_arr_loc,
     }
     sprintf(phypo->searchInfo, "OCTREE nInitial %d nEvaluated %d smallestNodeSide %lf/%lf/%lf oct_tree_integral %le",
             nInitial, nSamples, smallest_node_size_x, smallest_node_size_y, smallest_node_size_z, *poct_tree_integral);
+    if (pParams->conv_num_subdiv > 0) { // 20261016 agent - added
+        sprintf(MsgStr, " stop %s nSubdiv %d convRelIntegral %le convDist %lf",
+                stop_reason, nSubdiv, conv.rel_change_integral, conv.dist);
+        strcat(phypo->searchInfo, MsgStr);
+    }
+    if (pParams->refine_tol_step > 0.0) { // 20261016 agent - added
+        sprintf(MsgStr, " refine nIter %d nEval %d step %lf shift %lf",
+                refine.num_iter, refine.num_eval, refine.step, refine.shift);
+        strcat(phypo->searchInfo, MsgStr);
+    }
     /* write message */
     nll_putmsg(2, phypo->searchInfo);
 
@@ -14698,12 +18037,41 @@ int LocOctree(int ngrid, int num_arr_total, int num_arr_loc,
 
 long double LocOctree_core(int ngrid, double xval, double yval, double zval,
         int num_arr_loc, ArrivalDesc *arrival,
-        OctNode* poct_node,
+        OctNode* poct_node, int n_init_node,
         int icalc_cell_diagonal_time_var, double *volume_min,
         double *pdiagonal, double *cell_half_diagonal_time_range,
         OcttreeParams* pParams, GaussLocParams* gauss_par, int iGridType,
         double *misfit, double logWtMtrxSum) {
 
+    long double value;
+    double volume, log_value_volume;
+
+    value = LocOctree_eval(ngrid, xval, yval, zval, num_arr_loc, arrival, poct_node, n_init_node,
+            icalc_cell_diagonal_time_var, volume_min, pdiagonal, cell_half_diagonal_time_range,
+            pParams, gauss_par, iGridType, misfit, logWtMtrxSum, &log_value_volume, &volume);
+
+    // 20261016 agent - node also put in search priority queue
+    addResultQueue(resultQueue, addResultNode(&resultTreeRoot, log_value_volume, volume, poct_node, octArena));
+
+    return (value);
+
+}
+
+/** function to evaluate solution at an Octree node, sets node value, does not put node in results tree
+ *
+ *    plog_value_volume, pvolume - returned log(prob density * cell volume) and cell volume for results tree
+ */
+
+// 20261016 agent - added, split from LocOctree_core() so that nodes can be evaluated concurrently (LOCPARALLEL NumOctThreads)
+
+static long double LocOctree_eval(int ngrid, double xval, double yval, double zval,
+        int num_arr_loc, ArrivalDesc *arrival,
+        OctNode* poct_node, int n_init_node,
+        int icalc_cell_diagonal_time_var, double *volume_min,
+        double *pdiagonal, double *cell_half_diagonal_time_range,
+        OcttreeParams* pParams, GaussLocParams* gauss_par, int iGridType,
+        double *misfit, double logWtMtrxSum, double *plog_value_volume, double *pvolume) {
+
     long double value;
 
     int iAboveTopo;
@@ -14716,7 +18084,7 @@ long double LocOctree_core(int ngrid, double xval, double yval, double zval,
     /* get travel times for observed arrivals */
     iAboveTopo = isAboveTopo(xval, yval, zval);
     if (!iAboveTopo) {
-        nReject = getTravelTimes(arrival, num_arr_loc, xval, yval, zval);
+        nReject = getTravelTimesNode(arrival, num_arr_loc, xval, yval, zval, n_init_node);
         if (message_flag > 3 && nReject && GeometryMode != MODE_GLOBAL) {
             sprintf(MsgStr,
                     "WARNING: oct-tree sample at (%lf,%lf,%lf) is outside of %d travel time grids.",
@@ -14765,7 +18133,7 @@ long double LocOctree_core(int ngrid, double xval, double yval, double zval,
     double ot_variance_factor = 0.0;
     if (!iAboveTopo) { // not above topo
         double log_prior;
-        value = CalcSolutionQuality(xval, yval, zval, poct_node, num_arr_loc, arrival, gauss_par, iGridType, misfit, NULL, NULL,
+        value = CalcSolutionQuality(pNLLocContext, xval, yval, zval, poct_node, num_arr_loc, arrival, gauss_par, iGridType, misfit, NULL, NULL,
                 *cell_half_diagonal_time_range, *pdiagonal, volume, &effective_cell_size, &ot_variance_factor, &log_prior);
         /*        if (LocMethod == METH_OT_STACK) {
                     if (poct_node->parent != NULL) {
@@ -14795,7 +18163,8 @@ long double LocOctree_core(int ngrid, double xval, double yval, double zval,
     log_value_volume += logStationDensityWeight;
     poct_node->value += logStationDensityWeight;
 
-    resultTreeRoot = addResult(resultTreeRoot, log_value_volume, volume, poct_node);
+    *plog_value_volume = log_value_volume;
+    *pvolume = volume;
 
     /*static int icount_value = 0;
                                                                                                                                                             if (icount_value < 10 && poct_node->value < -1.0e50) {
@@ -14937,7 +18306,7 @@ double getOctTreeStationDensityWeight(OctNode* poct_node, SourceDesc *stations,
     double x_node_cent, y_node_cent, z_node_cent, mean_node_horiz_ds;
     OctNode* pnode;
 
-    static double mean_root_node_horiz_ds = -VERY_LARGE_DOUBLE;
+    static NLL_THREAD_LOCAL double mean_root_node_horiz_ds = -VERY_LARGE_DOUBLE;
     // !!! shoud be initialized for each event????
 
 
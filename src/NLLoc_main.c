@@ -53,6 +53,12 @@ tel: +33(0)493752502  e-mail: anthony@alomax.net  web: http://www.alomax.net
 #define PNAME  "NLLoc"
 #endif
 
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
 #include "GridLib.h"
 #include "ran1/ran1.h"
 #include "velmod.h"
@@ -61,6 +67,7 @@ tel: +33(0)493752502  e-mail: anthony@alomax.net  web: http://www.alomax.net
 #include "phaseloclist.h"
 #include "otime_limit.h"
 #include "NLLocLib.h"
+#include "json_io.h"
 
 #ifdef CUSTOM_ETH
 #include "custom_eth/eth_functions.h"
@@ -69,6 +76,8 @@ tel: +33(0)493752502  e-mail: anthony@alomax.net  web: http://www.alomax.net
 
 // function declarations
 
+static int NLLoc_Serve(char *pid_main, char *fn_control_main, char *socket_path, int output_json);
+
 
 /** program to perform global search event locations */
 
@@ -77,7 +86,7 @@ tel: +33(0)493752502  e-mail: anthony@alomax.net  web: http://www.alomax.net
 #define ARG_DESC "<control file> <snap_pid> <snap_param_file>"
 #else
 #define NARGS_MIN 2
-#define ARG_DESC "<control file>"
+#define ARG_DESC "<control file>\n       NLLoc --serve <control file> [<socket path>|-] [HYP|JSON]"
 #endif
 
 int main(int argc, char *argv[])
@@ -98,6 +107,19 @@ int main(int argc, char *argv[])
 		return(EXIT_ERROR_USAGE);
 	}
 
+	// 20261016 agent - added, daemon mode
+	if (strcmp(argv[1], "--serve") == 0) {
+		if (argc < 3) {
+			disp_usage(prog_name, ARG_DESC);
+			return(EXIT_ERROR_USAGE);
+		}
+		strcpy(pid_main, "000");
+		istat = NLLoc_Serve(pid_main, argv[2], argc > 3 && strcmp(argv[3], "-") != 0 ? argv[3] : NULL,
+				argc > 4 && strcmp(argv[4], "JSON") == 0);
+		GridBundle_CloseAll();
+		return(istat);
+	}
+
 	// set control file
 	strcpy(fn_control_main, argv[1]);
 
@@ -118,6 +140,7 @@ int main(int argc, char *argv[])
 
 	// run NLLoc
 	istat = NLLoc(pid_main, fn_control_main, NULL, -1, NULL, -1, 0, 0, 0, NULL);
+	GridBundle_CloseAll();	// 20261016 agent - added
 
 	return(istat);
 
@@ -125,4 +148,400 @@ int main(int argc, char *argv[])
 
 
 
+/*------------------------------------------------------------/ */
+/** daemon mode: locate events read from a stream, with control statements and grids loaded once
+ *
+ * 20261016 agent - added
+ *
+ *  NLLoc --serve <control file> [<socket path>|-] [HYP|JSON]
+ *
+ *  Observations are read from stdin (no socket path or "-") or from clients connecting one at a time to a local UNIX
+ *  socket, in the observation file format given in the LOCFILES statement of the control file (e.g. NLLOC_OBS);
+ *  each event ends with a line END_EVENT or at end of input.  Each event is located through a call to NLLoc_LocateObs()
+ *  and the locations are written back immediately as NLLoc Hypocenter-Phase (HYP, default) or JSON text, followed by
+ *  a line:
+ *      END_EVENT <event number> <NLLoc_LocateObs() return value> <number of locations> wait_ms <t> locate_ms <t> latency_ms <t> queue <n>
+ *  with the time from end of event input to start of location, the location time, the time from end of event input
+ *  to end of output, and the number of events received and waiting for location.  An input line STATS returns a
+ *  line of cumulative statistics, an input line SHUTDOWN stops the daemon.
+ *
+ *  The control file is read and the location run opened once with NLLoc_Open() at startup, so grids, summary files
+ *  and cumulative station statistics are kept between events and only per-event state is reset (e.g. use
+ *  LOCHYPOUT NONE to disable disk output); the run is closed with NLLoc_Close() at shutdown.  Events are located one
+ *  at a time by the main thread, LOCPARALLEL NumThreads is not used.  When reading stdin, program messages are written
+ *  to stderr.
+ */
+
+#define SERVE_EVENT 0
+#define SERVE_STATS 1
+#define SERVE_SHUTDOWN 2
+#define SERVE_EVENT_END_TAG "END_EVENT"
+
+typedef struct serve_item {
+	int type;		// SERVE_EVENT, SERVE_STATS or SERVE_SHUTDOWN
+	char **obs_line_array;	// event observation lines
+	int n_obs_lines;
+	int n_lines_alloc;
+	int n_data_lines;	// number of non blank lines
+	double t_received;	// time of end of event input (ms)
+	struct serve_item *next;
+} ServeItem;
+
+typedef struct {
+	FILE *fp_in;
+	ServeItem *head, *tail;	// events received and waiting for location
+	int depth;
+	int max_depth;
+	int end_of_input;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+} ServeQueue;
+
+// cumulative statistics
+static long ServeNumEvents = 0;
+static long ServeNumErrors = 0;
+static double ServeSumLatency = 0.0;
+static double ServeMaxLatency = 0.0;
+static double ServeSumLocate = 0.0;
+static int ServeMaxQueueDepth = 0;
+
+
+/** function to return monotonic time in ms */
+
+static double serve_time_ms() {
+
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (1000.0 * (double) ts.tv_sec + (double) ts.tv_nsec / 1.0e6);
+
+}
+
+/** function to free queue item */
+
+static void serve_free_item(ServeItem *item) {
+
+	for (int n = 0; n < item->n_obs_lines; n++)
+		free(item->obs_line_array[n]);
+	free(item->obs_line_array);
+	free(item);
+
+}
+
+/** function to add item to end of queue */
+
+static void serve_push(ServeQueue *queue, ServeItem *item) {
+
+	item->t_received = serve_time_ms();
+	item->next = NULL;
+	pthread_mutex_lock(&queue->mutex);
+	if (queue->tail != NULL)
+		queue->tail->next = item;
+	else
+		queue->head = item;
+	queue->tail = item;
+	queue->depth++;
+	if (queue->depth > queue->max_depth)
+		queue->max_depth = queue->depth;
+	pthread_cond_signal(&queue->cond);
+	pthread_mutex_unlock(&queue->mutex);
+
+}
+
+/** function to remove item from start of queue, waits for input
+ *
+ * returns NULL at end of input
+ */
+
+static ServeItem *serve_pop(ServeQueue *queue, int *pdepth) {
+
+	ServeItem *item;
+
+	pthread_mutex_lock(&queue->mutex);
+	while (queue->head == NULL && !queue->end_of_input)
+		pthread_cond_wait(&queue->cond, &queue->mutex);
+	if ((item = queue->head) != NULL) {
+		queue->head = item->next;
+		if (queue->head == NULL)
+			queue->tail = NULL;
+		queue->depth--;
+	}
+	*pdepth = queue->depth;
+	pthread_mutex_unlock(&queue->mutex);
+
+	return (item);
+
+}
+
+/** thread function to read events from input stream into queue */
+
+static void *serve_reader(void *arg) {
+
+	ServeQueue *queue = (ServeQueue *) arg;
+	char line[4 * MAXLINE];
+	char tag[4 * MAXLINE];
+	ServeItem *item = NULL;
+
+	while (fgets(line, 4 * MAXLINE, queue->fp_in) != NULL) {
+		int ntag = sscanf(line, "%s", tag);
+		// control lines
+		if (ntag == 1 && (strcmp(tag, SERVE_EVENT_END_TAG) == 0 || strcmp(tag, "STATS") == 0 || strcmp(tag, "SHUTDOWN") == 0)) {
+			if (item != NULL && item->n_data_lines > 0)
+				serve_push(queue, item);
+			else if (item != NULL)
+				serve_free_item(item);
+			item = NULL;
+			if (strcmp(tag, SERVE_EVENT_END_TAG) == 0)
+				continue;
+			ServeItem *cmd = (ServeItem *) calloc(1, sizeof (ServeItem));
+			cmd->type = strcmp(tag, "STATS") == 0 ? SERVE_STATS : SERVE_SHUTDOWN;
+			serve_push(queue, cmd);
+			if (cmd->type == SERVE_SHUTDOWN)
+				break;
+			continue;
+		}
+		// observation lines
+		if (item == NULL)
+			item = (ServeItem *) calloc(1, sizeof (ServeItem));
+		if (item->n_obs_lines >= item->n_lines_alloc) {
+			item->n_lines_alloc = item->n_lines_alloc > 0 ? 2 * item->n_lines_alloc : 256;
+			item->obs_line_array = (char **) realloc(item->obs_line_array, item->n_lines_alloc * sizeof (char *));
+		}
+		item->obs_line_array[item->n_obs_lines++] = strdup(line);
+		if (ntag == 1)
+			item->n_data_lines++;
+	}
+	if (item != NULL && item->n_data_lines > 0)
+		serve_push(queue, item);
+	else if (item != NULL)
+		serve_free_item(item);
+
+	pthread_mutex_lock(&queue->mutex);
+	queue->end_of_input = 1;
+	pthread_cond_signal(&queue->cond);
+	pthread_mutex_unlock(&queue->mutex);
+
+	return (NULL);
+
+}
+
+/** function to write locations returned by NLLoc_LocateObs() to output stream
+ *
+ * returns number of locations written
+ */
+
+static int serve_write_locations(LocNode *loc_list_head, FILE *fp_out, int output_json) {
+
+	LocNode *locNode;
+	int nloc = 0;
+
+	// location ids count events located in the location run, circular list is sorted by id
+	if ((locNode = loc_list_head) != NULL) do {
+		Location *ploc = locNode->plocation;
+		if (!output_json) {
+			if (WriteLocation(fp_out, ploc->phypo, ploc->parrivals, ploc->narrivals, NULL, 1, 1, 0, ploc->pgrid, 0) < 0)
+				nll_puterr("ERROR: writing location to output stream.");
+		} else {
+#ifdef NLL_MEMSTREAM
+			char *bp_memory_stream = NULL;
+			size_t memory_stream_size;
+			FILE *fp_memory_stream = open_memstream(&bp_memory_stream, &memory_stream_size);
+			if (fp_memory_stream == NULL) {
+				nll_puterr("ERROR: opening memory stream, cannot write location as JSON.");
+			} else {
+				int istat = WriteLocation(fp_memory_stream, ploc->phypo, ploc->parrivals, ploc->narrivals, NULL, 1, 1, 0, ploc->pgrid, 0);
+				fclose(fp_memory_stream);
+				if (istat < 0)
+					nll_puterr("ERROR: writing location to memory stream, cannot write location as JSON.");
+				else if (json_write_NLL_location(bp_memory_stream, memory_stream_size, fp_out) == 0)
+					fprintf(fp_out, "\n");
+				free(bp_memory_stream);
+			}
+#else
+			nll_puterr("ERROR: cannot write location as JSON: C library memory streams needed (function open_memstream(); see compiler define _GNU_SOURCE).");
+#endif
+		}
+		nloc++;
+	} while ((locNode = locNode->next) != loc_list_head);
+
+	return (nloc);
+
+}
+
+/** function to locate events read from one input stream and write locations to output stream
+ *
+ * returns 1 if SHUTDOWN received, 0 otherwise
+ */
+
+static int serve_stream(NLLocRun *prun, FILE *fp_in, FILE *fp_out, int output_json) {
+
+	ServeQueue queue;
+	pthread_t reader_thread;
+	ServeItem *item;
+	int depth;
+	int shutdown = 0;
+
+	memset(&queue, 0, sizeof (ServeQueue));
+	queue.fp_in = fp_in;
+	pthread_mutex_init(&queue.mutex, NULL);
+	pthread_cond_init(&queue.cond, NULL);
+	if (pthread_create(&reader_thread, NULL, serve_reader, &queue) != 0) {
+		nll_puterr("ERROR: starting input reader thread.");
+		return (0);
+	}
+
+	while ((item = serve_pop(&queue, &depth)) != NULL) {
+
+		if (item->type == SERVE_SHUTDOWN) {
+			shutdown = 1;
+			serve_free_item(item);
+			continue;	// locate events received before SHUTDOWN
+		}
+
+		if (item->type == SERVE_STATS) {
+			pthread_mutex_lock(&queue.mutex);
+			if (queue.max_depth > ServeMaxQueueDepth)
+				ServeMaxQueueDepth = queue.max_depth;
+			pthread_mutex_unlock(&queue.mutex);
+			fprintf(fp_out, "STATS events %ld errors %ld latency_ms_mean %.3f latency_ms_max %.3f locate_ms_mean %.3f queue %d queue_max %d\n",
+					ServeNumEvents, ServeNumErrors,
+					ServeNumEvents > 0 ? ServeSumLatency / (double) ServeNumEvents : 0.0, ServeMaxLatency,
+					ServeNumEvents > 0 ? ServeSumLocate / (double) ServeNumEvents : 0.0, depth, ServeMaxQueueDepth);
+			fflush(fp_out);
+			serve_free_item(item);
+			continue;
+		}
+
+		// locate event
+		LocNode *loc_list_head = NULL;
+		double t_start = serve_time_ms();
+		int istat = NLLoc_LocateObs(prun, item->obs_line_array, item->n_obs_lines, 1, 0, 0, &loc_list_head);
+		double t_located = serve_time_ms();
+		int nloc = serve_write_locations(loc_list_head, fp_out, output_json);
+		freeLocList(loc_list_head, 1);
+		double t_end = serve_time_ms();
+
+		ServeNumEvents++;
+		if (istat != EXIT_NORMAL)
+			ServeNumErrors++;
+		ServeSumLatency += t_end - item->t_received;
+		if (t_end - item->t_received > ServeMaxLatency)
+			ServeMaxLatency = t_end - item->t_received;
+		ServeSumLocate += t_located - t_start;
+		fprintf(fp_out, "%s %ld %d %d wait_ms %.3f locate_ms %.3f latency_ms %.3f queue %d\n", SERVE_EVENT_END_TAG,
+				ServeNumEvents, istat, nloc, t_start - item->t_received, t_located - t_start, t_end - item->t_received, depth);
+		fflush(fp_out);
+		serve_free_item(item);
+
+	}
+
+	pthread_join(reader_thread, NULL);
+	if (queue.max_depth > ServeMaxQueueDepth)
+		ServeMaxQueueDepth = queue.max_depth;
+	pthread_mutex_destroy(&queue.mutex);
+	pthread_cond_destroy(&queue.cond);
+
+	return (shutdown);
+
+}
+
+/** function to run NLLoc as daemon
+ *
+ * returns < 0 on error
+ */
+
+static int NLLoc_Serve(char *pid_main, char *fn_control_main, char *socket_path, int output_json) {
+
+	NLLocRun *prun;
+	FILE *fp_out = NULL;
+	int istat = EXIT_NORMAL;
+
+
+#ifndef NLL_MEMSTREAM
+	nll_puterr("FATAL ERROR: NLLoc --serve needs C library memory streams to pass observations to NLLoc (function open_memstream(); see compiler define _GNU_SOURCE).");
+	return (EXIT_ERROR_MEMORY);
+#endif
+
+	if (socket_path == NULL) {
+		// read stdin, write locations to stdout, other output (also when opening location run) to stderr
+		int fd_out = dup(STDOUT_FILENO);
+		if (fd_out < 0 || (fp_out = fdopen(fd_out, "w")) == NULL) {
+			nll_puterr("FATAL ERROR: opening output stream.");
+			return (EXIT_ERROR_IO);
+		}
+		fflush(stdout);
+		dup2(STDERR_FILENO, STDOUT_FILENO);
+	}
+
+	// read control file and open location run once, events are located by this thread
+	if ((prun = NLLoc_Open(pid_main, fn_control_main, NULL, 0, 1, &istat)) == NULL) {
+		nll_puterr2("FATAL ERROR: opening location run for control file", fn_control_main);
+		if (fp_out != NULL)
+			fclose(fp_out);
+		return (istat);
+	}
+
+	signal(SIGPIPE, SIG_IGN);	// client closing socket must not stop daemon
+
+	if (socket_path == NULL) {
+
+		serve_stream(prun, stdin, fp_out, output_json);
+		fclose(fp_out);
+
+	} else {
+
+		// listen on local UNIX socket, one client at a time
+		struct sockaddr_un addr;
+		int fd_listen;
+		memset(&addr, 0, sizeof (addr));
+		addr.sun_family = AF_UNIX;
+		if (strlen(socket_path) >= sizeof (addr.sun_path)) {
+			nll_puterr2("FATAL ERROR: socket path too long", socket_path);
+			istat = EXIT_ERROR_USAGE;
+		} else if ((fd_listen = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+			nll_puterr("FATAL ERROR: creating socket.");
+			istat = EXIT_ERROR_IO;
+		} else {
+			strcpy(addr.sun_path, socket_path);
+			unlink(socket_path);
+			if (bind(fd_listen, (struct sockaddr *) &addr, sizeof (addr)) != 0 || listen(fd_listen, 8) != 0) {
+				nll_puterr2("FATAL ERROR: binding or listening on socket", socket_path);
+				istat = EXIT_ERROR_IO;
+			} else {
+				sprintf(MsgStr, "NLLoc --serve: listening on socket: %s", socket_path);
+				nll_putmsg(0, MsgStr);
+				int shutdown = 0;
+				while (!shutdown) {
+					int fd_conn = accept(fd_listen, NULL, NULL);
+					if (fd_conn < 0)
+						continue;
+					int fd_conn_out = dup(fd_conn);
+					FILE *fp_in = fdopen(fd_conn, "r");
+					FILE *fp_out = fd_conn_out >= 0 ? fdopen(fd_conn_out, "w") : NULL;
+					if (fp_in != NULL && fp_out != NULL)
+						shutdown = serve_stream(prun, fp_in, fp_out, output_json);
+					if (fp_in != NULL)
+						fclose(fp_in);
+					else
+						close(fd_conn);
+					if (fp_out != NULL)
+						fclose(fp_out);
+					else if (fd_conn_out >= 0)
+						close(fd_conn_out);
+				}
+				unlink(socket_path);
+			}
+			close(fd_listen);
+		}
+
+	}
+
+	// write cumulative run statistics, close location run
+	int istat_close = NLLoc_Close(prun);
+	if (istat == EXIT_NORMAL)
+		istat = istat_close;
+
+	return (istat);
+
+}
 
@@ -844,6 +844,8 @@ int GetTime2EQ_Event(char* in_line) {
     int istat;
 
 
+    if (AllocSources() < 0) // 20261017 agent - added
+        return (-1);
     Event = Source + NumSources;
     NumSources++;
 
@@ -21,7 +21,7 @@
 #define EPSILON_BIG  (1.0e-3)   // 20100617 AJL (pred analy)
 #define EPSILON  FLT_MIN
 
-static char error_message[4096];
+static NLL_THREAD_LOCAL char error_message[4096];
 
 /** function to print error and return last error message */
 char *get_matrix_error_mesage() {
@@ -5,6 +5,11 @@
  *
  */
 
+// work storage is private to each thread
+#ifndef NLL_THREAD_LOCAL
+#define NLL_THREAD_LOCAL __thread
+#endif
+
 typedef double**  MatrixDouble;
 typedef double*  VectorDouble;
 
@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+
+ * You should have received a copy of the GNU Lesser Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+/*   edt_kernel.c
+
+        EDT double kernel pair loop (LOCMETH ... EDTKernel = DOUBLE), see CalcSolutionQuality_EDT_Double() in NLLocLib.c
+
+        This file is compiled with -fno-math-errno -fno-trapping-math -ffp-contract=off (see CMakeLists.txt and Makefile-NLLoc):
+        allows vectorization of sqrt and of selects in the lanes, no FMA contraction so the generic, AVX2 and AVX-512
+        versions give identical results.  Keep other code out of this file so the FP behavior of the library is unchanged.
+
+ */
+
+
+/*
+        history:
+
+        ver 01    20261017  agent  Original version, moved from NLLocLib.c
+
+
+.........1.........2.........3.........4.........5.........6.........7.........8
+
+ */
+
+
+
+#include <stdint.h>
+
+#include "GridLib.h"
+#include "edt_kernel.h"
+
+
+
+/** exp(x) for x <= 0, polynomial on reduced argument with exact power of 2 scaling, inlines and vectorizes */
+
+static inline double edt_exp_neg(double x) {
+
+    const double shift = 6755399441055744.0; // 2^52 + 2^51, rounds to integer
+    double xc, t, kd, r, p, scale;
+    int64_t k;
+
+    xc = x < -708.0 ? -708.0 : x;
+    t = xc * 1.4426950408889634 + shift;
+    kd = t - shift;
+    r = xc - kd * 6.93147180369123816490e-01; // ln2 hi
+    r = r - kd * 1.90821492927058770002e-10; // ln2 lo
+    p = 2.08767569878680989792e-09; // 1/12!
+    p = p * r + 2.50521083854417187751e-08;
+    p = p * r + 2.75573192239858906526e-07;
+    p = p * r + 2.75573192239858906526e-06;
+    p = p * r + 2.48015873015873015873e-05;
+    p = p * r + 1.98412698412698412698e-04;
+    p = p * r + 1.38888888888888888889e-03;
+    p = p * r + 8.33333333333333333333e-03;
+    p = p * r + 4.16666666666666666667e-02;
+    p = p * r + 1.66666666666666666667e-01;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+    memcpy(&k, &t, sizeof (k));
+    k = (int64_t) ((uint64_t) (k - 0x4338000000000000LL + 1023) << 52);
+    memcpy(&scale, &k, sizeof (scale));
+
+    return (x < -708.0 ? 0.0 : p * scale);
+
+}
+
+/** EDT prob and weight of one pair */
+
+#define EDT_PAIR_DOUBLE(ncol, prob, weight) \
+    do { \
+        double edt_misfit, weight2; \
+        edt_misfit = obs_minus_pred + pred_centered[ncol] - obs_centered[ncol]; \
+        edt_misfit = valid[ncol] > 0.0 ? edt_misfit : 0.0; \
+        if (method_box) { \
+            prob = fabs(edt_misfit) <= amp_row + amplitude[ncol] ? 1.0 : 0.0; \
+            weight = amp_row * amplitude[ncol]; \
+        } else { \
+            weight2 = 1.0 / (sigma2_row + sigma2[ncol]); \
+            prob = edt_exp_neg(-0.5 * edt_misfit * edt_misfit * weight2); \
+            weight = sqrt(weight2); \
+        } \
+        weight *= (1.0 - corr_row[ncol]); \
+        weight *= sw_row * sw[ncol]; \
+        weight *= ((ap_row >= 0.0) & (ap[ncol] >= 0.0)) ? ap_row * ap[ncol] : 1.0; \
+        weight *= valid[ncol]; \
+        prob *= weight; \
+    } while (0)
+
+/* compensated sum of prob and sums of weight and prob in lane */
+#define EDT_LANE_ACCUMULATE(lane, prob, weight) \
+    do { \
+        double y, t; \
+        y = prob - lane_comp[lane]; \
+        t = lane_sum[lane] + y; \
+        lane_comp[lane] = (t - lane_sum[lane]) - y; \
+        lane_sum[lane] = t; \
+        lane_weight[lane] += weight; \
+        lane_row[lane] += prob; \
+    } while (0)
+
+/** EDT pair sums over all pairs of arrivals */
+
+static inline __attribute__((always_inline)) void edt_pair_sums_body(EDTKernelData *kd, const int method_box) {
+
+    int nrow, ncol, lane;
+    const int num_arrivals = kd->num_arrivals;
+    const int *restrict abs_time = kd->abs_time;
+    const double *restrict obs_centered = kd->obs_centered;
+    const double *restrict pred_centered = kd->pred_centered;
+    const double *restrict valid = kd->valid;
+    const double *restrict sigma2 = kd->sigma2;
+    const double *restrict amplitude = kd->amplitude;
+    const double *restrict sw = kd->sw;
+    const double *restrict ap = kd->ap;
+    double *restrict row_prob = kd->row_prob;
+    double *restrict col_prob = kd->col_prob;
+    const double cell_diagonal_time_var_2 = 2.0 * kd->cell_diagonal_time_var;
+    double lane_sum[EDT_KERNEL_NLANES], lane_comp[EDT_KERNEL_NLANES], lane_weight[EDT_KERNEL_NLANES];
+    double lane_row[EDT_KERNEL_NLANES];
+    double lane_prob[EDT_KERNEL_NLANES], lane_wt[EDT_KERNEL_NLANES];
+    double obs_minus_pred, sigma2_row, amp_row, sw_row, ap_row;
+    const double *restrict corr_row;
+    double prob, weight, row_sum;
+
+    for (lane = 0; lane < EDT_KERNEL_NLANES; lane++) {
+        lane_sum[lane] = 0.0;
+        lane_comp[lane] = 0.0;
+        lane_weight[lane] = 0.0;
+    }
+    for (ncol = 0; ncol < num_arrivals; ncol++)
+        col_prob[ncol] = 0.0;
+
+    for (nrow = 0; nrow < num_arrivals; nrow++) {
+        row_prob[nrow] = 0.0;
+        if (valid[nrow] <= 0.0)
+            continue; // ignore obs without predicted times
+        obs_minus_pred = obs_centered[nrow] - pred_centered[nrow];
+        sigma2_row = sigma2[nrow] + cell_diagonal_time_var_2;
+        amp_row = amplitude[nrow];
+        sw_row = sw[nrow];
+        ap_row = ap[nrow];
+        corr_row = kd->edtmtx[nrow];
+        for (lane = 0; lane < EDT_KERNEL_NLANES; lane++)
+            lane_row[lane] = 0.0;
+        if (!abs_time[nrow]) {
+            // no absolute timing, pair only with same sta/inst without absolute timing
+            for (ncol = nrow + 1; ncol < num_arrivals; ncol++) {
+                if (valid[ncol] <= 0.0 || abs_time[ncol])
+                    continue;
+                if (strcmp(kd->arrival[nrow].label, kd->arrival[ncol].label) != 0
+                        || strcmp(kd->arrival[nrow].inst, kd->arrival[ncol].inst) != 0)
+                    continue;
+                EDT_PAIR_DOUBLE(ncol, prob, weight);
+                EDT_LANE_ACCUMULATE(0, prob, weight);
+                col_prob[ncol] += prob;
+            }
+        } else {
+            // full blocks of lanes
+            for (ncol = nrow + 1; ncol + EDT_KERNEL_NLANES <= num_arrivals; ncol += EDT_KERNEL_NLANES) {
+                for (lane = 0; lane < EDT_KERNEL_NLANES; lane++)
+                    EDT_PAIR_DOUBLE(ncol + lane, lane_prob[lane], lane_wt[lane]);
+                for (lane = 0; lane < EDT_KERNEL_NLANES; lane++) {
+                    EDT_LANE_ACCUMULATE(lane, lane_prob[lane], lane_wt[lane]);
+                    col_prob[ncol + lane] += lane_prob[lane];
+                }
+            }
+            // remainder
+            for (lane = 0; ncol < num_arrivals; ncol++, lane++) {
+                EDT_PAIR_DOUBLE(ncol, prob, weight);
+                EDT_LANE_ACCUMULATE(lane, prob, weight);
+                col_prob[ncol] += prob;
+            }
+        }
+        row_sum = 0.0;
+        for (lane = 0; lane < EDT_KERNEL_NLANES; lane++)
+            row_sum += lane_row[lane];
+        row_prob[nrow] = row_sum;
+    }
+
+    // combine lanes, pairwise
+    int nstep;
+    for (nstep = EDT_KERNEL_NLANES / 2; nstep > 0; nstep /= 2) {
+        for (lane = 0; lane < nstep; lane++) {
+            lane_sum[lane] += lane_sum[lane + nstep];
+            lane_comp[lane] += lane_comp[lane + nstep];
+            lane_weight[lane] += lane_weight[lane + nstep];
+        }
+    }
+    kd->edt_sum = lane_sum[0] - lane_comp[0];
+    kd->edt_weight = lane_weight[0];
+
+}
+
+#undef EDT_PAIR_DOUBLE
+#undef EDT_LANE_ACCUMULATE
+
+static void edt_pair_sums_generic(EDTKernelData *kd) {
+    if (kd->method_box)
+        edt_pair_sums_body(kd, 1);
+    else
+        edt_pair_sums_body(kd, 0);
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+
+__attribute__((target("avx2")))
+static void edt_pair_sums_avx2(EDTKernelData *kd) {
+    if (kd->method_box)
+        edt_pair_sums_body(kd, 1);
+    else
+        edt_pair_sums_body(kd, 0);
+}
+
+__attribute__((target("avx512f")))
+static void edt_pair_sums_avx512(EDTKernelData *kd) {
+    if (kd->method_box)
+        edt_pair_sums_body(kd, 1);
+    else
+        edt_pair_sums_body(kd, 0);
+}
+
+#endif
+
+
+/** function to calculate EDT pair sums over all pairs of arrivals, selects kernel version for the cpu */
+
+void edt_pair_sums(EDTKernelData *kd) {
+
+    static NLL_THREAD_LOCAL int use_simd = -1;
+    if (use_simd < 0) {
+        use_simd = 0;
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+        if (__builtin_cpu_supports("avx512f"))
+            use_simd = 2;
+        else if (__builtin_cpu_supports("avx2"))
+            use_simd = 1;
+#endif
+    }
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    if (use_simd == 2)
+        edt_pair_sums_avx512(kd);
+    else if (use_simd == 1)
+        edt_pair_sums_avx2(kd);
+    else
+#endif
+        edt_pair_sums_generic(kd);
+
+}
@@ -258,6 +258,77 @@ typedef struct {
 }
 GridDesc_Cascading;
 
+/** compressed grid description
+ *
+ *  Grid values are stored in the grid buffer file as bricks of brick_size^3 nodes, each brick quantized to an integer
+ *  number of steps above the brick minimum value, with the step chosen so that the absolute error of decoded values is
+ *  at most max_error.  Bricks that cannot be quantized to this error are stored raw.
+ *
+ * 20261016 agent - added
+ */
+#define IS_NOT_COMPRESSED 0
+#define IS_COMPRESSED -243310897   // want value that is extremely unlikely to be in uninitialized int
+#define COMPRESSED_GRID_BRICK_SIZE_DEFAULT 8
+#define COMPRESSED_GRID_BRICK_SIZE_MAX 64
+#define COMPRESSED_GRID_MAX_ERROR_DEFAULT 0.0001 // 0.1 ms for time grids
+
+typedef struct {
+    int brick_size; // number of grid nodes along each side of a brick
+    double max_error; // maximum absolute error of decoded grid values (grid value units, e.g. sec for time grids)
+}
+GridDesc_Compressed;
+
+/** tiled grid memory layout
+ *
+ *  The grid buffer in memory holds tiles of GRID_TILE_SIZE^3 nodes in x, y, z tile order, with the nodes of each tile in
+ *  x, y, z order, so that the 8 corner nodes of an interpolation cell are usually in the same tile.  Grid files are always
+ *  in the regular layout, grids are converted to the tiled layout when read into memory (ReadGrid3dBuf).
+ *  Tiled grids in memory are accessed through GridDesc.buffer (see GridLib.c TiledGridOffset()), not through GridDesc.array.
+ *
+ * 20261016 agent - added
+ */
+#define IS_NOT_TILED 0
+#define IS_TILED -243310896   // want value that is extremely unlikely to be in uninitialized int
+#define GRID_TILE_SHIFT 2
+#define GRID_TILE_SIZE (1 << GRID_TILE_SHIFT)
+#define GRID_TILE_MASK (GRID_TILE_SIZE - 1)
+#define GRID_TILE_ALIGN 64   // alignment in bytes of tiled grid buffer, one x row of a tile fills a cache line
+
+/** sub-grid (region of interest) of a grid file
+ *
+ *  Only the nodes of the grid file inside a box (e.g. the location search volume) are read into memory.  The GridDesc
+ *  geometry (orig, num) is that of the sub-grid, so grid values are accessed as for a complete grid; the geometry of
+ *  the grid file is kept in GridDesc_SubGrid and restored with unsetSubGrid().
+ *
+ * 20261016 agent - added
+ */
+#define IS_NOT_SUBGRID 0
+#define IS_SUBGRID -243310895   // want value that is extremely unlikely to be in uninitialized int
+
+typedef struct {
+    int ix0, iy0, iz0; // indices in grid file of first node of sub-grid
+    int numx, numy, numz; // number of nodes of grid file
+    double origx, origy, origz; // origin of grid file
+}
+GridDesc_SubGrid;
+
+/** grid bundle
+ *
+ *  A single file <root>.bundle holding the header and buffer files of many grids with file root <root>.<name>, e.g. the
+ *  time grids <root>.P.STA.time of all stations of a network.  The file has a GridBundleHeader at offset 0, the grid
+ *  header and buffer file contents, each aligned to GRID_BUNDLE_ALIGN bytes, and an index at the end of the file with
+ *  one GridBundleEntry (name -> offsets and sizes) for each grid.  Registered bundles (GridBundle_Open()) are memory
+ *  mapped and OpenGrid3dFile() resolves grid file roots through them before looking for individual grid files.
+ *
+ * 20261016 agent - added
+ */
+#define GRID_BUNDLE_EXT "bundle"
+#define GRID_BUNDLE_MAGIC "NLLBUNDL"
+#define GRID_BUNDLE_VERSION 1
+#define GRID_BUNDLE_NAME_LEN 256
+#define GRID_BUNDLE_ALIGN 64
+#define MAX_NUM_GRID_BUNDLES 16
+
 /* grid  description */
 
 typedef struct {
@@ -279,6 +350,19 @@ typedef struct {
     GridDesc_Cascading gridDesc_Cascading; // GridDesc_Cascading description, initialized if this grid is a cascading grid (flagGridCascading==IS_CASCADING)
     // 20161021 AJL - added
     char mapProjStr[2 * MAXLINE]; // holds map projection description string from grid hdr if present
+    // 20261016 agent - added
+    int buffer_mapped; // 1 if buffer is a read-only memory mapping of the grid buffer file (see MapGrid3dBuf()), 2 if buffer is in a mapped grid bundle, 0 if allocated
+    // 20261016 agent - added compressed grid description
+    int flagGridCompressed; // set to IS_COMPRESSED to flag that this is a compressed grid
+    GridDesc_Compressed gridDesc_Compressed; // GridDesc_Compressed description, initialized if this grid is a compressed grid (flagGridCompressed==IS_COMPRESSED)
+    // 20261016 agent - added
+    int flagGridTiled; // set to IS_TILED to flag that the grid buffer in memory has the tiled layout
+    // 20261016 agent - added sub-grid description
+    int flagGridSubGrid; // set to IS_SUBGRID to flag that only a sub-grid of the grid file is read into memory
+    GridDesc_SubGrid gridDesc_SubGrid; // GridDesc_SubGrid description, initialized if this grid is a sub-grid (flagGridSubGrid==IS_SUBGRID)
+    // 20261016 agent - added
+    char *bundle_buffer; // grid buffer file contents in a mapped grid bundle, NULL if grid was not opened from a bundle (set in OpenGrid3dFile())
+    size_t bundle_buffer_size; // size in bytes of bundle_buffer
 }
 GridDesc;
 
@@ -633,8 +717,8 @@ PhaseIdent;
 /* phase identification */
 // 20161004 AJL - moved here from NLLocLib.c
 #define MAX_NUM_PHASE_ID 50
-extern PhaseIdent PhaseID[MAX_NUM_PHASE_ID];
-extern int NumPhaseID;
+extern NLL_THREAD_LOCAL PhaseIdent PhaseID[MAX_NUM_PHASE_ID];
+extern NLL_THREAD_LOCAL int NumPhaseID;
 
 
 
@@ -648,15 +732,17 @@ extern int NumPhaseID;
 /* globals  */
 /*------------------------------------------------------------/ */
 
-extern char fn_control[MAXLINE]; /* control file name */
-extern FILE *fp_control; /* control file pointer */
-extern char fn_output[MAXLINE]; /* output file name */
+extern NLL_THREAD_LOCAL char fn_control[MAXLINE]; /* control file name */
+extern NLL_THREAD_LOCAL FILE *fp_control; /* control file pointer */
+extern NLL_THREAD_LOCAL char fn_output[MAXLINE]; /* output file name */
 
 /* miscellaneous */
-extern int RandomNumSeed;
-extern int NumFilesOpen;
-extern int NumGridBufFilesOpen, NumGridHdrFilesOpen;
-extern int NumAllocations;
+extern NLL_THREAD_LOCAL int RandomNumSeed;
+extern NLL_THREAD_LOCAL int NumFilesOpen;
+extern NLL_THREAD_LOCAL int NumGridBufFilesOpen, NumGridHdrFilesOpen;
+extern NLL_THREAD_LOCAL int NumAllocations;
+extern NLL_THREAD_LOCAL size_t NumGridBytesRead; // 20261016 agent - added, bytes read from grid files by this thread
+extern NLL_THREAD_LOCAL char HypoPerfLine[MAXLINE_LONG]; // 20261016 agent - added, PERF line written to NLLoc hypocenter output if not empty (LOCPERF)
 
 /* algorithm constants */
 extern int prog_mode_3d;
@@ -665,15 +751,15 @@ extern int prog_mode_2dto3d;
 // mode
 #define MODE_RECT   0 // rectangular cartesian x(km),y(km),z:depth(km)
 #define MODE_GLOBAL   1 // spherical x:longitdue(deg),y:latittude(deg),z:depth(km)
-extern int GeometryMode;
+extern NLL_THREAD_LOCAL int GeometryMode;
 
 /* 3D grid description */
 extern int grid_type; /* grid type (VELOCITY, SLOWNESS, SLOW2, etc) */
 extern GridDesc grid_in;
 
 /* source */
-extern int NumSources;
-extern SourceDesc Source[MAX_NUM_SOURCES];
+extern NLL_THREAD_LOCAL int NumSources;
+extern NLL_THREAD_LOCAL SourceDesc *Source;
 
 /* stations */
 //extern int NumStations;
@@ -683,11 +769,11 @@ extern StationDesc Station[MAX_NUM_SOURCES];
 extern int PhaseFormat;
 extern int MAX_NUM_STATIONS;
 extern int MAX_NUM_ARRIVALS;
-extern int NumArrivals;
-extern ArrivalDesc* Arrival;
+extern NLL_THREAD_LOCAL int NumArrivals;
+extern NLL_THREAD_LOCAL ArrivalDesc* Arrival;
 
 /* hypocenter */
-extern HypoDesc Hypocenter;
+extern NLL_THREAD_LOCAL HypoDesc Hypocenter;
 
 /* geographic transformations (lat/long <=> x/y) */
 #define NUM_PROJ_MAX   10
@@ -699,18 +785,18 @@ extern HypoDesc Hypocenter;
 #define MAP_TRANS_TM     4
 #define MAP_TRANS_AZ_EQUID     5
 #define MAP_TRANS_SDC   6
-extern char map_trans_type[NUM_PROJ_MAX][MAXLINE]; /* name of projection */
-extern int map_itype[NUM_PROJ_MAX]; /* int id of projection */
-extern char MapProjStr[NUM_PROJ_MAX][2 * MAXLINE]; /* string description of proj params */
-extern char map_ref_ellipsoid[NUM_PROJ_MAX][MAXLINE]; /* name of reference ellipsoid */
+extern NLL_THREAD_LOCAL char map_trans_type[NUM_PROJ_MAX][MAXLINE]; /* name of projection */
+extern NLL_THREAD_LOCAL int map_itype[NUM_PROJ_MAX]; /* int id of projection */
+extern NLL_THREAD_LOCAL char MapProjStr[NUM_PROJ_MAX][2 * MAXLINE]; /* string description of proj params */
+extern NLL_THREAD_LOCAL char map_ref_ellipsoid[NUM_PROJ_MAX][MAXLINE]; /* name of reference ellipsoid */
 /* general map parameters */
-extern double map_orig_lat[NUM_PROJ_MAX], map_orig_long[NUM_PROJ_MAX], map_rot[NUM_PROJ_MAX], map_scale_factor[NUM_PROJ_MAX];
-extern long map_false_easting[NUM_PROJ_MAX];
-extern double map_cosang[NUM_PROJ_MAX], map_sinang[NUM_PROJ_MAX]; /* rotation */
+extern NLL_THREAD_LOCAL double map_orig_lat[NUM_PROJ_MAX], map_orig_long[NUM_PROJ_MAX], map_rot[NUM_PROJ_MAX], map_scale_factor[NUM_PROJ_MAX];
+extern NLL_THREAD_LOCAL long map_false_easting[NUM_PROJ_MAX];
+extern NLL_THREAD_LOCAL double map_cosang[NUM_PROJ_MAX], map_sinang[NUM_PROJ_MAX]; /* rotation */
 /* LAMBERT projection parameters */
-extern double map_lambert_1st_std_paral[NUM_PROJ_MAX], map_lambert_2nd_std_paral[NUM_PROJ_MAX];
+extern NLL_THREAD_LOCAL double map_lambert_1st_std_paral[NUM_PROJ_MAX], map_lambert_2nd_std_paral[NUM_PROJ_MAX];
 /* SDC Short Distance Coversion projection parameters */
-extern double map_sdc_xltkm[NUM_PROJ_MAX], map_sdc_xlnkm[NUM_PROJ_MAX];
+extern NLL_THREAD_LOCAL double map_sdc_xltkm[NUM_PROJ_MAX], map_sdc_xlnkm[NUM_PROJ_MAX];
 #define MAP_TRANS_SDC_DRLT 0.99330647
 
 /* constants */
@@ -719,23 +805,23 @@ extern double cRPD;
 extern double c111;
 
 /* include file */
-extern char fn_include[FILENAME_MAX];
-extern FILE* fp_include;
-extern FILE* fp_input_save;
+extern NLL_THREAD_LOCAL char fn_include[FILENAME_MAX];
+extern NLL_THREAD_LOCAL FILE* fp_include;
+extern NLL_THREAD_LOCAL FILE* fp_input_save;
 
 /* take-off angle */
 extern TakeOffAngles AnglesNULL;
 
 /* quality to error mapping (hypo71, etc) */
 #define MAX_NUM_QUALITY_LEVELS 50
-extern double Quality2Error[MAX_NUM_QUALITY_LEVELS];
-extern int NumQuality2ErrorLevels;
+extern NLL_THREAD_LOCAL double Quality2Error[MAX_NUM_QUALITY_LEVELS];
+extern NLL_THREAD_LOCAL int NumQuality2ErrorLevels;
 
 /* model coordinates */
 #define COORDS_RECT 0
 #define COORDS_LATLON 1
 // int ModelCoordsMode;  // 20200608 AJL - bug fix (e-mail 07/06/2020 03:11 陈俊磊)
-extern int ModelCoordsMode;
+extern NLL_THREAD_LOCAL int ModelCoordsMode;
 
 /* */
 /*------------------------------------------------------------/ */
@@ -759,6 +845,8 @@ int convert_grid_type(GridDesc*, int);
 int display_grid_param(GridDesc*);
 int get_mcsyn(char*);
 int get_path_method(char*);
+int AllocSources();
+void FreeSources();
 int GetNextSource(char*);
 int GetSource(char*, SourceDesc*, int);
 SourceDesc* FindSource(char* label);
@@ -790,6 +878,7 @@ int testIdentical(GridDesc* pGrid1, GridDesc* pGrid2);
 int WriteGrid3dBuf(GridDesc*, SourceDesc*, char*, char*);
 int WriteGrid3dHdr(GridDesc*, SourceDesc*, char*, char*);
 int ReadGrid3dBuf(GridDesc*, FILE*);
+void* MapGrid3dBuf(GridDesc*, FILE*);
 int ReadGrid3dHdr(GridDesc*, SourceDesc*, char*, char*);
 int ReadGrid3dHdr_grid_description(FILE *fpio, GridDesc* pgrid, char *fname);
 int ReadGrid3dBufSheet(GRID_FLOAT_TYPE *, GridDesc*, FILE*, int);
@@ -801,6 +890,7 @@ int OpenGrid3dFile(char *, FILE **, FILE **, GridDesc*,
 // 20170207 AJL - GridDesc needed for cleaning up cascading grid header data
 //void CloseGrid3dFile(FILE **, FILE **);
 void CloseGrid3dFile(GridDesc* pgrid, FILE **fp_grid, FILE **fp_hdr); // 20170207 AJL - added
+FILE* OpenGrid3dBufFile(char *fname, GridDesc* pgrid); // 20261016 agent - added
 GRID_FLOAT_TYPE* ReadGridFile(GRID_FLOAT_TYPE* values, char *fname, char* file_type, double* xloc, double* yloc, double* zloc, int nvalues, int iSwapBytes, SourceDesc* psrceIn);
 GRID_FLOAT_TYPE ReadGrid3dValue(FILE *fpgrid, int ix, int iy, int iz, GridDesc * pgrid, int clean_casc_allocs);
 DOUBLE InterpCubeLagrange(DOUBLE, DOUBLE, DOUBLE, DOUBLE, DOUBLE,
@@ -809,6 +899,8 @@ float InterpCubeAngles(DOUBLE, DOUBLE, DOUBLE, DOUBLE, DOUBLE,
         DOUBLE, DOUBLE, DOUBLE, DOUBLE, DOUBLE, DOUBLE);
 GRID_FLOAT_TYPE ReadAbsInterpGrid3d(FILE *, GridDesc*, double, double,
         double, int clean_casc_allocs);
+void ReadAbsInterpGrid3dBatch(GridDesc** pgrids, int ngrids, double xloc, double yloc, double zloc, GRID_FLOAT_TYPE *values);
+void ReadAbsInterpGrid3dColumn(GridDesc* pgrid, double xloc, double yloc, double *zloc, int nz, GRID_FLOAT_TYPE *values); // 20261016 agent - added
 DOUBLE InterpSquareLagrange(DOUBLE, DOUBLE,
         DOUBLE, DOUBLE, DOUBLE, DOUBLE);
 DOUBLE ReadAbsInterpGrid2d(FILE *, GridDesc*,
@@ -825,6 +917,23 @@ int IsGrid2DBigEnough(GridDesc*, GridDesc*, SourceDesc*,
 // 20161019 AJL - added
 int isCascadingGrid(GridDesc* pgrid);
 void setCascadingGrid(GridDesc* pgrid);
+// 20261016 agent - added
+int isCompressedGrid(GridDesc* pgrid);
+void setCompressedGrid(GridDesc* pgrid, int brick_size, double max_error);
+void FreeCompressedGridCache();
+// 20261016 agent - added
+int isTiledGrid(GridDesc* pgrid);
+void setTiledGrid(GridDesc* pgrid, int tiled);
+size_t TiledGridBufferSize(GridDesc* pgrid);
+// 20261016 agent - added
+int isSubGrid(GridDesc* pgrid);
+int setSubGrid(GridDesc* pgrid, double xmin, double xmax, double ymin, double ymax, double zmin, double zmax);
+void unsetSubGrid(GridDesc* pgrid);
+// 20261016 agent - added
+int GridBundle_Open(char *bundle_root);
+void GridBundle_CloseAll();
+int GridBundle_AppendGrid(char *bundle_root, char *grid_root, int remove_files);
+
 void* AllocateGrid_Cascading(GridDesc* pgrid, int allocate_buffer);
 void FreeGrid_Cascading(GridDesc * pgrid);
 
@@ -885,8 +994,9 @@ char* CurrTimeStr(void);
 
 /* file list functions */
 int ExpandWildCards(char*, char[][FILENAME_MAX], int);
+int ExpandWildCardsAlloc(char* fileFilter, char (**pfileList)[FILENAME_MAX], int maxNumFiles);
 int fnmatch_wrapper(const struct dirent* entry);
-extern char ExpandWildCards_pattern[FILENAME_MAX];
+extern NLL_THREAD_LOCAL char ExpandWildCards_pattern[FILENAME_MAX];
 
 /* string / char functions */
 int TrimString(char*);
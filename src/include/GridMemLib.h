@@ -7,8 +7,13 @@ typedef struct gridMem {	/* 3D grid data in memory */
 	void* buffer;		/* corresponding buffer (contiguous floats) */
 	void*** array;		/* corresponding array access to buffer */
 	int grid_read;		/* grid read flag  = 1 if grid has been read from disk */
-	int active;		/* active flag  = 1 if grid is being used in current location */
-
+	int active;		/* active count = number of current locations using grid (> 1 possible with LOCPARALLEL) */
+	// 20261016 agent - added
+	size_t num_bytes;	/* size of grid buffer in bytes */
+	unsigned long last_used;	/* value of grid memory list use counter at last use of grid, for LRU eviction */
+	int index;		/* index of element in GridMemList */
+	struct gridMem* hash_next;	/* next element in hash index chain */
+	int reading;		/* = 1 while grid is being read from disk outside of grid memory list lock */
 
 } GridMemStruct;
 
@@ -16,23 +21,45 @@ typedef struct gridMem {	/* 3D grid data in memory */
 extern GridMemStruct** GridMemList;
 extern int GridMemListSize;
 extern int GridMemListNumElements;
-extern int Num3DGridReadToMemory, MaxNum3DGridMemory;
+extern NLL_THREAD_LOCAL int Num3DGridReadToMemory; // number of grids read to memory for current event
+extern NLL_THREAD_LOCAL long GridMemThreadNumHits; // 20261016 agent - added, grid memory list hits of this thread (LOCPERF)
+extern NLL_THREAD_LOCAL long GridMemThreadNumMisses; // 20261016 agent - added, grid memory list misses of this thread (LOCPERF)
+extern int MaxNum3DGridMemory;
 extern int GridMemListTotalNumElementsAdded;
+extern size_t MaxBytes3DGridMemory; // 20261016 agent - added, byte budget of grid memory list (LOCMEM_BYTES), 0 = no limit
+extern size_t GridMemListNumBytes; // 20261016 agent - added, total bytes of grids in memory list
+
+/* hash index of grid memory list elements, keyed on grid file name (GridDesc title) */
+#define GRID_MEM_HASHSIZE 1024
 
 /* GridLib wrapper functions */
 void* NLL_AllocateGrid(GridDesc* pgrid);
 void NLL_FreeGrid(GridDesc* pgrid);
 void NLL_FreeGridMemory();
+void NLL_GridMemoryOpen();
+void NLL_GridMemoryClose();
 void*** NLL_CreateGridArray(GridDesc* pgrid);
 void NLL_DestroyGridArray(GridDesc* pgrid);
 int NLL_ReadGrid3dBuf(GridDesc* pgrid, FILE* fpio);
+int NLL_PrefetchGrid(GridDesc* pgrid, FILE* fpio, unsigned long min_last_used);
 GridMemStruct* GridMemList_AddGridDesc(GridDesc* pgrid);
 void GridMemList_AddElement(GridMemStruct* pnewGridMemStruct);
 void GridMemList_RemoveElementAt(int index);
 GridMemStruct* GridMemList_TryToReplaceElementAt(GridMemStruct* pGridMemStruct, GridDesc* pgrid);
 GridMemStruct* GridMemList_ElementAt(int index);
 int GridMemList_IndexOfGridDesc(int verbose, GridDesc* pgrid);
+GridMemStruct* GridMemList_FindGridDesc(GridDesc* pgrid);
 int GridMemList_NumElements();
+unsigned long NLL_GridMemoryUseCount();
+void NLL_GridMemoryPrintStats();
+
+/* pool of grid headers and open grid buffer files, keyed on grid file name, for persistence of opened grids across events */
+// 20261016 agent - added
+#define GRID_FILE_POOL_NUM_OPEN 1024	/* maximum number of grid buffer files kept open */
+#define GRID_FILE_POOL_RLIMIT_FRACTION 4	/* 20261017 agent - added, at most 1/GRID_FILE_POOL_RLIMIT_FRACTION of process open file limit (RLIMIT_NOFILE) kept open */
+int NLL_OpenGrid3dFile(char *fname, FILE **fp_grid, FILE **fp_hdr, GridDesc* pgrid, char* file_type, SourceDesc* psrce, int iSwapBytes);
+void NLL_CloseGrid3dFile(GridDesc* pgrid, FILE **fp_grid, FILE **fp_hdr);
+void NLL_GridFilePoolClose();
 
 
 /** end of grid memory management routines */
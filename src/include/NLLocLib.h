@@ -42,6 +42,8 @@ tel: +33(0)493752502  e-mail: anthony@alomax.net  web: http://www.alomax.net
 #include "otime_limit.h"
  * */
 
+#include <pthread.h>
+
 
 /* defines */
 
@@ -139,6 +141,13 @@ typedef struct {
     int use_stations_density; // if 1, weight oct node order in result tree by station density in node
     int stop_on_min_node_size; // if 1, stop search when first min_node_size reached, if 0 stop subdividing a given cell when min_node_size reached
     double mean_cell_velocity; // mean cell velocity (>0 = Increases misfit sigma in proportion to travel time across diagonal of cell.
+    // 20261016 agent - added, convergence early stop
+    int conv_num_subdiv; // number of subdivisions between convergence checks, 0 = no convergence check
+    double conv_tol_integral; // maximum relative change of integrated probability between convergence checks
+    double conv_tol_dist; // maximum change of maximum likelihood node location (km) between convergence checks
+    // 20261016 agent - added, local refinement of maximum likelihood location
+    double refine_tol_step; // refinement stops when step (km) below this value, <= 0 = no refinement
+    int refine_max_iter; // maximum number of refinement iterations
 }
 OcttreeParams;
 
@@ -217,55 +226,88 @@ SearchPdfGridDesc;
 /* globals  */
 
 /* output file path  */
-extern char f_outpath[FILENAME_MAX];
+extern NLL_THREAD_LOCAL char f_outpath[FILENAME_MAX];
 
 /* Gaussian error parameters */
-extern GaussLocParams Gauss;
-extern Gauss2LocParams Gauss2;
-extern int iUseGauss2;
+extern NLL_THREAD_LOCAL GaussLocParams Gauss;
+extern NLL_THREAD_LOCAL Gauss2LocParams Gauss2;
+extern NLL_THREAD_LOCAL int iUseGauss2;
 
 /* Scatter parameters */
-extern ScatterParams Scatter;
-
-
-/* events */
-extern int NumEvents;
-extern int NumEventsLocated;
-extern int NumLocationsCompleted;
+extern NLL_THREAD_LOCAL ScatterParams Scatter;
+
+
+/* parallel location (LOCPARALLEL) */
+#define MAX_NUM_LOC_PARALLEL_THREADS 256
+extern NLL_THREAD_LOCAL int LocParallelNumThreads; // number of location threads, 0 = classic serial location
+extern NLL_THREAD_LOCAL int LocOctParallelNumThreads; // number of threads evaluating oct-tree cells of each event, 0 or 1 = serial
+/* look-ahead grid prefetch (LOCPREFETCH) */
+extern NLL_THREAD_LOCAL int LocPrefetchNumEvents; // number of events read ahead to load time grids into memory, 0 = no prefetch
+int OctParallel_Init(int num_threads, int (*init_thread)(void *arg), void (*cleanup_thread)(), void *init_arg);
+void OctParallel_Free();
+
+/* per-stage timing and run statistics (LOCPERF) */
+// 20261016 agent - added
+#define LOC_PERF_OFF 0
+#define LOC_PERF_FILE 1 // write per-event and run statistics to .perf file
+#define LOC_PERF_HYP 2 // also write PERF line to NLLoc hypocenter output
+#define PERF_OBS 0 // reading of observations (GetNextObs)
+#define PERF_GRID 1 // opening and loading of time grids
+#define PERF_WEIGHT 2 // construction of weight matrix (ConstWeightMatrix)
+#define PERF_SEARCH 3 // location search (LocGridSearch, LocMetropolis, LocOctree)
+#define PERF_STATS 4 // scatter sample and location statistics (CalcExpectationSamples, CalcCovarianceSamples, ...)
+#define PERF_OUTPUT 5 // writing of location output
+#define PERF_NUM_STAGES 6
+typedef struct {
+    double time[PERF_NUM_STAGES]; // elapsed time of each stage (sec)
+    double time_total; // elapsed time from start of reading of event (sec)
+    long num_nodes; // number of search nodes evaluated
+    long num_interp; // number of travel time interpolations
+    long grid_hits; // grids found in grid memory list
+    long grid_misses; // grids not found in grid memory list
+    size_t bytes_read; // bytes read from grid files
+    long num_events;
+} LocPerfStats;
+extern NLL_THREAD_LOCAL int LocPerfMode; // LOC_PERF_OFF, LOC_PERF_FILE or LOC_PERF_HYP
+extern NLL_THREAD_LOCAL LocPerfStats LocPerfEvent; // statistics of event being located by this thread
 
 // 20200107 AJL  #define MAX_NUM_OBS_FILES 10000
 //#define MAX_NUM_OBS_FILES 20000  // 20200107 AJL
 #define MAX_NUM_OBS_FILES 30000  // 20221218 AJL
-extern int NumObsFiles;
 
 /* number of arrivals read from obs file */
-extern int NumArrivalsRead;
+extern NLL_THREAD_LOCAL int NumArrivalsRead;
 
 /* number of arrivals used for location */
-extern int NumArrivalsLocation;
+extern NLL_THREAD_LOCAL int NumArrivalsLocation;
 
-/* observations filenames */
-extern char fn_loc_obs[MAX_NUM_OBS_FILES][FILENAME_MAX];
 /* filetype */
-extern char ftype_obs[MAXLINE];
+extern NLL_THREAD_LOCAL char ftype_obs[MAXLINE];
 
 /* filenames */
-extern char fn_loc_grids[FILENAME_MAX], fn_path_output[FILENAME_MAX];
-extern int iSwapBytesOnInput;
+extern NLL_THREAD_LOCAL char fn_loc_grids[FILENAME_MAX], fn_path_output[FILENAME_MAX];
+extern NLL_THREAD_LOCAL int iSwapBytesOnInput;
+extern NLL_THREAD_LOCAL int iMapGridsOnInput; // 20261016 agent - added, 1 = memory map 3D time grids not read to memory
+extern NLL_THREAD_LOCAL int iTiledGridsInMemory; // 20261016 agent - added, 1 = 3D time grids read to memory have tiled layout (LOCGRIDLAYOUT TILED)
+extern NLL_THREAD_LOCAL int iLocGridROI; // 20261016 agent - added, 1 = only sub-grid of 3D time grids containing search volume plus margin read to memory (LOCGRIDROI)
+extern NLL_THREAD_LOCAL double LocGridROIMargin; // 20261016 agent - added, margin around search volume of sub-grid (LOCGRIDROI)
+extern NLL_THREAD_LOCAL double LocGridROIMin[3], LocGridROIMax[3]; // 20261017 agent - added, x, y, z limits of sub-grid (LOCGRIDROI)
+extern NLL_THREAD_LOCAL int iPrefetchGridsOnInput; // 20261016 agent - added, 1 = GetObservations() only loads 3D time grids into grid memory list (look-ahead prefetch thread)
+extern NLL_THREAD_LOCAL unsigned long PrefetchGridsMinLastUsed; // 20261016 agent - added, grids used at or after this grid memory use count are not removed by prefetch
 
 // model files
-extern FILE *fp_model_grid_P;
-extern FILE *fp_model_hdr_P;
-extern GridDesc model_grid_P;
-extern FILE *fp_model_grid_S;
-extern FILE *fp_model_hdr_S;
-extern GridDesc model_grid_S;
+extern NLL_THREAD_LOCAL FILE *fp_model_grid_P;
+extern NLL_THREAD_LOCAL FILE *fp_model_hdr_P;
+extern NLL_THREAD_LOCAL GridDesc model_grid_P;
+extern NLL_THREAD_LOCAL FILE *fp_model_grid_S;
+extern NLL_THREAD_LOCAL FILE *fp_model_hdr_S;
+extern NLL_THREAD_LOCAL GridDesc model_grid_S;
 
 /* location search type (grid, simulated annealing, Metropolis, etc) */
 #define SEARCH_GRID   0
 #define SEARCH_MET   1
 #define SEARCH_OCTTREE  2
-extern int SearchType;
+extern NLL_THREAD_LOCAL int SearchType;
 
 #define PDF_GRID_UNDEF   0
 #define PDF_GRID_GRID   1
@@ -274,10 +316,10 @@ extern int SearchType;
 #define PDF_GRID_POSTERIOR   1
 #define MAX_NUM_PDF_GRID_FILES 5000
 // location search prior  // 20190510 AJL - added
-extern SearchPdfGridDesc SearchPrior;
-extern int iUseSearchPrior;
-extern SearchPdfGridDesc SearchPosterior;
-extern int iUseSearchPosterior;
+extern NLL_THREAD_LOCAL SearchPdfGridDesc SearchPrior;
+extern NLL_THREAD_LOCAL int iUseSearchPrior;
+extern NLL_THREAD_LOCAL SearchPdfGridDesc SearchPosterior;
+extern NLL_THREAD_LOCAL int iUseSearchPosterior;
 
 /* location method (misfit, etc) */
 #define METH_UNDEF    0
@@ -288,101 +330,81 @@ extern int iUseSearchPosterior;
 #define METH_ML_OT    5
 #define METH_OT_STACK    6
 #define METH_L1_NORM    7         // 20140515 AJL - added for NLDiffLoc
-extern int LocMethod;
-extern int EDT_use_otime_weight;
-extern int EDT_otime_weight_active;
-extern double DistStaGridMin;
-extern double DistStaGridMax;
-extern int MinNumArrLoc;
-extern int MaxNumArrLoc;
-extern int MinNumSArrLoc;
-extern double VpVsRatio;
+extern NLL_THREAD_LOCAL int LocMethod;
+extern NLL_THREAD_LOCAL int EDT_use_otime_weight;
+extern NLL_THREAD_LOCAL int EDT_otime_weight_active;
+/* EDT pair sum kernel */
+// 20261016 agent - added
+#define EDT_KERNEL_LONG_DOUBLE    0     // original kernel, long double accumulation
+#define EDT_KERNEL_DOUBLE    1          // vectorized kernel, double with compensated accumulation
+extern NLL_THREAD_LOCAL int EDT_kernel;
+extern NLL_THREAD_LOCAL double DistStaGridMin;
+extern NLL_THREAD_LOCAL double DistStaGridMax;
+extern NLL_THREAD_LOCAL int MinNumArrLoc;
+extern NLL_THREAD_LOCAL int MaxNumArrLoc;
+extern NLL_THREAD_LOCAL int MinNumSArrLoc;
+extern NLL_THREAD_LOCAL double VpVsRatio;
 
 /* location signature */
-extern char LocSignature[MAXLINE_LONG];
+extern NLL_THREAD_LOCAL char LocSignature[MAXLINE_LONG];
 
 /* location grids */
 #define MAX_NUM_LOCATION_GRIDS 10
-extern GridDesc LocGrid[MAX_NUM_LOCATION_GRIDS];
-extern int NumLocGrids;
-extern int LocGridSave[MAX_NUM_LOCATION_GRIDS]; /* !should be in GridDesc */
+extern NLL_THREAD_LOCAL GridDesc LocGrid[MAX_NUM_LOCATION_GRIDS];
+extern NLL_THREAD_LOCAL int NumLocGrids;
+extern NLL_THREAD_LOCAL int LocGridSave[MAX_NUM_LOCATION_GRIDS]; /* !should be in GridDesc */
 //extern int Num3DGridReadToMemory, MaxNum3DGridMemory;
 
-/* related hypocenter file pointers */
-extern FILE *pSumFileHypNLLoc[MAX_NUM_LOCATION_GRIDS];
-extern FILE *pSumFileHypo71[MAX_NUM_LOCATION_GRIDS];
-extern FILE *pSumFileHypoEll[MAX_NUM_LOCATION_GRIDS];
-extern FILE *pSumFileHypoInv[MAX_NUM_LOCATION_GRIDS];
-extern FILE *pSumFileHypoInvY2K[MAX_NUM_LOCATION_GRIDS];
-extern FILE *pSumFileAlberto4[MAX_NUM_LOCATION_GRIDS];
-extern FILE *pSumFileFmamp[MAX_NUM_LOCATION_GRIDS];
-
-
-/* related flags */
-extern int iWriteHypHeader[MAX_NUM_LOCATION_GRIDS];
-
 /* format specific event data */
-extern char HypoInverseArchiveSumHdr[MAXLINE_LONG];
+extern NLL_THREAD_LOCAL char HypoInverseArchiveSumHdr[MAXLINE_LONG];
 
 /* hypocenter filetype saving flags */
 /* SH 02/26/2004  added iSaveSnapSum for output to be read
     by SNAP */
-extern int iSaveNLLocEvent, iSaveNLLocSum, iSaveNLLocOctree,
+extern NLL_THREAD_LOCAL int iSaveNLLocEvent, iSaveNLLocSum, iSaveNLLocOctree,
     iSaveHypo71Event, iSaveHypo71Sum,
     iSaveHypoEllEvent, iSaveHypoEllSum,
     iSaveHypoInvSum, iSaveHypoInvY2KArc, iSaveAlberto4Sum, iSaveFmamp,
     iSaveSnapSum, iCalcSedOrigin, iSaveDecSec, iSavePublicID, iSaveNone;
 // 20170811 AJL - added to allow saving of expectation hypocenter results instead of maximum likelihood
-extern int iSaveNLLocExpectation;
+extern NLL_THREAD_LOCAL int iSaveNLLocExpectation;
 // 20220131 AJL - added to support JSON output of location results
-extern int iSaveNLLocEvent_JSON;
+extern NLL_THREAD_LOCAL int iSaveNLLocEvent_JSON;
 
 
 // Arrival prior weighting flag (NLL_FORMAT_VER_2)
-extern int iUseArrivalPriorWeights;
+extern NLL_THREAD_LOCAL int iUseArrivalPriorWeights;
 
 /* station distance weighting flag. */
-extern int iSetStationDistributionWeights;
-extern double stationDistributionWeightCutoff;
+extern NLL_THREAD_LOCAL int iSetStationDistributionWeights;
+extern NLL_THREAD_LOCAL double stationDistributionWeightCutoff;
 
 /* station density weghting */
-extern double AveInterStationDistance;
-extern int NumForceOctTreeStaDenWt;
-
-extern int iRejectDuplicateArrivals;
+extern NLL_THREAD_LOCAL double AveInterStationDistance;
+extern NLL_THREAD_LOCAL int NumForceOctTreeStaDenWt;
 
-/* Event Information extracted from phase file */
-extern EventTimeExtract EventTime;
-extern long int EventID;
+extern NLL_THREAD_LOCAL int iRejectDuplicateArrivals;
 
 /* magnitude calculation */
 #define MAG_UNDEF   0
 #define MAG_ML_HB   1
 #define MAG_MD_FMAG   2
-extern int NumMagnitudeMethods;
+extern NLL_THREAD_LOCAL int NumMagnitudeMethods;
 #define MAX_NUM_MAG_METHODS   2
-extern MagDesc Magnitude[MAX_NUM_MAG_METHODS];
+extern NLL_THREAD_LOCAL MagDesc Magnitude[MAX_NUM_MAG_METHODS];
 
 /* station/inst/component parameters */
 #define MAX_NUM_COMP_DESC 1000
-extern CompDesc Component[MAX_NUM_COMP_DESC];
-extern int NumCompDesc;
 
 /* arrival label alias */
 #define MAX_NUM_LOC_ALIAS 1000
 #define MAX_NUM_LOC_ALIAS_CHECKS 2*MAX_NUM_LOC_ALIAS
-extern AliasDesc LocAlias[MAX_NUM_LOC_ALIAS];
-extern int NumLocAlias;
 
 /* exclude arrivals */
 #define MAX_NUM_LOC_EXCLUDE 1000
-extern ExcludeDesc LocExclude[MAX_NUM_LOC_EXCLUDE];
-extern int NumLocExclude;
 
 /* include arrivals */
 #define MAX_NUM_LOC_INCLUDE 1000
-extern ExcludeDesc LocInclude[MAX_NUM_LOC_INCLUDE];
-extern int NumLocInclude;
 
 /* station delays */
 #define WRITE_RESIDUALS 0
@@ -390,68 +412,71 @@ extern int NumLocInclude;
 #define WRITE_PDF_RESIDUALS 2
 #define WRITE_PDF_DELAYS 3
 #define MAX_NUM_STA_DELAYS 10000
-extern TimeDelayDesc TimeDelay[MAX_NUM_STA_DELAYS];
-extern int NumTimeDelays;
 
-extern char TimeDelaySurfacePhase[MAX_SURFACES][PHASE_LABEL_LEN];
-extern double TimeDelaySurfaceMultiplier[MAX_SURFACES];
-extern int NumTimeDelaySurface;
+extern NLL_THREAD_LOCAL char TimeDelaySurfacePhase[MAX_SURFACES][PHASE_LABEL_LEN];
+extern NLL_THREAD_LOCAL double TimeDelaySurfaceMultiplier[MAX_SURFACES];
+extern NLL_THREAD_LOCAL int NumTimeDelaySurface;
 
 /* crustal and elev corrections */
-extern int ApplyElevCorrFlag;
-extern double ElevCorrVelP;
-extern double ElevCorrVelS;
-extern int ApplyCrustElevCorrFlag;
-extern double MinDistCrustElevCorr;
+extern NLL_THREAD_LOCAL int ApplyElevCorrFlag;
+extern NLL_THREAD_LOCAL double ElevCorrVelP;
+extern NLL_THREAD_LOCAL double ElevCorrVelS;
+extern NLL_THREAD_LOCAL int ApplyCrustElevCorrFlag;
+extern NLL_THREAD_LOCAL double MinDistCrustElevCorr;
 
 /* topo surface */
-extern struct surface *topo_surface;
-extern int topo_surface_index; // topo surface index is velmod.h.MAX_SURFACES-1 so as not to interferce with any TimeDelaySurfaces read in
+extern NLL_THREAD_LOCAL struct surface *topo_surface;
+extern NLL_THREAD_LOCAL int topo_surface_index; // topo surface index is velmod.h.MAX_SURFACES-1 so as not to interferce with any TimeDelaySurfaces read in
 
 
 
 /* station list */
-extern int NumStationPhases;
-extern SourceDesc StationPhaseList[X_MAX_NUM_ARRIVALS];
+extern NLL_THREAD_LOCAL int NumStationPhases;
+extern NLL_THREAD_LOCAL SourceDesc StationPhaseList[X_MAX_NUM_ARRIVALS];
 
 /* fixed origin time parameters */
-extern int FixOriginTimeFlag;
+extern NLL_THREAD_LOCAL int FixOriginTimeFlag;
 
 /* Metropolis */
-extern WalkParams Metrop; /* walk parameters */
-extern int MetNumSamples; /* number of samples to evaluate */
-extern int MetLearn; /* learning length in number of samples for calculation of sample statistics */
-extern int MetEquil; /* number of samples to equil before using */
-extern int MetStartSave; /* number of sample to begin saving */
-extern int MetSkip; /* number of samples to wait between saves */
-extern double MetStepInit; /* initial step size (km) (< 0.0 for auto) */
-extern double MetStepMin; /* minimum step size (km) */
-extern double MetStepMax; /* maximum step size (km) (NLDiffLoc) */
-extern double MetStepFact; /* step size factor */
-extern double MetProbMin; /* minimum likelihood necessary after learn */
-extern double MetVelocity; /* velocity for conversion of distance to time */
-extern double MetInititalTemperature; /* initial temperature */
-extern int MetUse; /* number of samples to use = MetNumSamples - MetEquil */
+extern NLL_THREAD_LOCAL WalkParams Metrop; /* walk parameters */
+extern NLL_THREAD_LOCAL int MetNumSamples; /* number of samples to evaluate */
+extern NLL_THREAD_LOCAL int MetLearn; /* learning length in number of samples for calculation of sample statistics */
+extern NLL_THREAD_LOCAL int MetEquil; /* number of samples to equil before using */
+extern NLL_THREAD_LOCAL int MetStartSave; /* number of sample to begin saving */
+extern NLL_THREAD_LOCAL int MetSkip; /* number of samples to wait between saves */
+extern NLL_THREAD_LOCAL double MetStepInit; /* initial step size (km) (< 0.0 for auto) */
+extern NLL_THREAD_LOCAL double MetStepMin; /* minimum step size (km) */
+extern NLL_THREAD_LOCAL double MetStepMax; /* maximum step size (km) (NLDiffLoc) */
+extern NLL_THREAD_LOCAL double MetStepFact; /* step size factor */
+extern NLL_THREAD_LOCAL double MetProbMin; /* minimum likelihood necessary after learn */
+extern NLL_THREAD_LOCAL double MetVelocity; /* velocity for conversion of distance to time */
+extern NLL_THREAD_LOCAL double MetInititalTemperature; /* initial temperature */
+extern NLL_THREAD_LOCAL int MetUse; /* number of samples to use = MetNumSamples - MetEquil */
+#define MET_MAX_NUM_CHAINS 64
+extern NLL_THREAD_LOCAL int MetNumChains; /* number of independent chains */ // 20261016 agent - added
+extern NLL_THREAD_LOCAL double MetChainRhatMax; /* stop walk when Gelman-Rubin statistic of chains < MetChainRhatMax, <= 1.0 = no check */ // 20261016 agent - added
 
 
 /* Octtree */
-extern OcttreeParams octtreeParams; /* Octtree parameters */
-extern Tree3D* octTree; /* Octtree */
-extern ResultTreeNode* resultTreeRoot; /* Octtree likelihood*volume results tree root node */
+extern NLL_THREAD_LOCAL OcttreeParams octtreeParams; /* Octtree parameters */
+extern NLL_THREAD_LOCAL Tree3D* octTree; /* Octtree */
+extern NLL_THREAD_LOCAL ResultTreeNode* resultTreeRoot; /* Octtree likelihood*volume results tree root node */
+extern NLL_THREAD_LOCAL ResultQueue* resultQueue; /* Octtree search priority queue of results tree leaf nodes */
+extern NLL_THREAD_LOCAL OctArena* octArena; /* Octtree search node arena, kept between events */
 //extern ResultTreeNode* resultTreeLikelihoodRoot;	/* Octtree likelihood results tree root node */
 
 
 /* take-off angles */
-extern int angleMode; /* angle mode - ANGLE_MODE_NO, ANGLE_MODE_YES */
-extern int iAngleQualityMin; /* minimum quality for angles to be used */
+extern NLL_THREAD_LOCAL int angleMode; /* angle mode - ANGLE_MODE_NO, ANGLE_MODE_YES */
+extern NLL_THREAD_LOCAL int iAngleQualityMin; /* minimum quality for angles to be used */
 #define ANGLE_MODE_NO 0
 #define ANGLE_MODE_YES 1
 #define ANGLE_MODE_UNDEF -1
 
 
 /* otime list */
-extern OtimeLimit** OtimeLimitList;
-extern int NumOtimeLimit;
+extern NLL_THREAD_LOCAL OtimeLimit** OtimeLimitList;
+extern NLL_THREAD_LOCAL int NumOtimeLimit;
 
 
 
@@ -483,17 +508,15 @@ struct staStatNode { /* station statistics node for linked list */
 typedef struct staStatNode StaStatNode;
 
 #define HASHSIZE 46
-/* table of pointers to list of StaStatNode */
-extern StaStatNode *hashtab[MAX_NUM_LOCATION_GRIDS][HASHSIZE];
 /* maxumum residual values to include in statistics */
-extern int NRdgs_Min;
-extern double RMS_Max, Gap_Max;
-extern double P_ResidualMax;
-extern double S_ResidualMax;
-extern double Ell_Len3_Max;
-extern double Hypo_Depth_Min;
-extern double Hypo_Depth_Max;
-extern double Hypo_Dist_Max;
+extern NLL_THREAD_LOCAL int NRdgs_Min;
+extern NLL_THREAD_LOCAL double RMS_Max, Gap_Max;
+extern NLL_THREAD_LOCAL double P_ResidualMax;
+extern NLL_THREAD_LOCAL double S_ResidualMax;
+extern NLL_THREAD_LOCAL double Ell_Len3_Max;
+extern NLL_THREAD_LOCAL double Hypo_Depth_Min;
+extern NLL_THREAD_LOCAL double Hypo_Depth_Max;
+extern NLL_THREAD_LOCAL double Hypo_Dist_Max;
 
 /* hashtable function declarations */
 StaStatNode *InstallStaStatInTable(int, char*, char*, int, double,
@@ -508,14 +531,186 @@ void UpdateStaStat(int, ArrivalDesc *, int, double, double, double, double);
 
 
 
+/*------------------------------------------------------------*/
+/** location run context */
+
+/* observation file reader state kept between calls to GetNextObs() */
+typedef struct {
+    char line[MAXLINE_LONG];
+    int date_saved, year_save, month_save, day_save;
+    int check_for_S_arrival;
+    int in_hypocenter_event;
+    // NEIC / ISC format
+    char last_label[10];
+    int origin_hour;
+    // DD
+    int hypo_cc_flag;
+    long int dd_event_id_1, dd_event_id_2;
+    double dd_otime_corr;
+} ObsReaderState;
+
+/* state of a location run that is not per-event, i.e. observation files, station tables,
+ *    summary output and run statistics.
+ * 20261016 agent - added, each call to NLLoc() creates its own context, so that several NLLoc() calls
+ *    may run concurrently in different threads; the context is shared by the LOCPARALLEL threads of a run.
+ *    Per-event state and control parameters are thread local (see NLL_THREAD_LOCAL).
+ *    Locate(), LocOctree(), ConstWeightMatrix(), CalcSolutionQuality*() and getTravelTimes() take the context
+ *    of the location explicitly.
+ *    GridLib control parameters (CONTROL, TRANS, LOCSRCE/GTSRCE, LOCPHASEID, LOCQUAL2ERR) are thread local.
+ *    Note: the 3D grid memory list and its parameters (LOCMETH ... maxNum3DGridMemory, LOCMEM_BYTES) remain
+ *    process wide, so that the grids are shared by concurrent NLLoc() calls.
+ */
+typedef struct NLLocContext {
+    /* events */
+    int NumEvents;
+    int NumEventsLocated;
+    int NumLocationsCompleted;
+    /* observations files */
+    int NumObsFiles;
+    char (*fn_loc_obs)[FILENAME_MAX]; // 20261017 agent - allocated for the NumObsFiles files of LOCFILES
+    ObsReaderState obsReader;
+    /* event information extracted from phase file */
+    EventTimeExtract EventTime;
+    long int EventID;
+    /* station/inst/component, alias, exclude, include and delay tables */
+    CompDesc Component[MAX_NUM_COMP_DESC];
+    int NumCompDesc;
+    AliasDesc LocAlias[MAX_NUM_LOC_ALIAS];
+    int NumLocAlias;
+    ExcludeDesc LocExclude[MAX_NUM_LOC_EXCLUDE];
+    int NumLocExclude;
+    ExcludeDesc LocInclude[MAX_NUM_LOC_INCLUDE];
+    int NumLocInclude;
+    TimeDelayDesc TimeDelay[MAX_NUM_STA_DELAYS];
+    int NumTimeDelays;
+    /* station statistics */
+    StaStatNode *hashtab[MAX_NUM_LOCATION_GRIDS][HASHSIZE];
+    /* summary output */
+    FILE *pSumFileHypNLLoc[MAX_NUM_LOCATION_GRIDS];
+    FILE *pSumFileHypo71[MAX_NUM_LOCATION_GRIDS];
+    FILE *pSumFileHypoEll[MAX_NUM_LOCATION_GRIDS];
+    FILE *pSumFileHypoInv[MAX_NUM_LOCATION_GRIDS];
+    FILE *pSumFileHypoInvY2K[MAX_NUM_LOCATION_GRIDS];
+    FILE *pSumFileAlberto4[MAX_NUM_LOCATION_GRIDS];
+    FILE *pSumFileFmamp[MAX_NUM_LOCATION_GRIDS];
+    int iWriteHypHeader[MAX_NUM_LOCATION_GRIDS];
+    int save_location_count;
+    /* run statistics (LOCPERF) */
+    LocPerfStats perf_run;
+    double perf_run_start;
+    FILE *fp_perf;
+    /* LOCPARALLEL commit ordering */
+    pthread_mutex_t commit_mutex;
+    pthread_cond_t commit_cond;
+    long next_commit;
+} NLLocContext;
+
+/* location run: NLLoc_Open(), NLLoc_LocateObs(), NLLoc_Close(), see NLLoc1.c */
+typedef struct NLLocRun NLLocRun;
+
+NLLocContext* NLLocContext_New();
+void NLLocContext_Free(NLLocContext* pcontext);
+
+/* location run context of the current thread */
+extern NLL_THREAD_LOCAL NLLocContext *pNLLocContext;
+
+/** end of location run context */
+/*------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------*/
+/** hot arrival table */
+
+/* structure-of-arrays copy of the ArrivalDesc fields read by the misfit kernels in the inner search loop.
+ *    Built once per event in Locate() after the observations are read and centered, per-node values
+ *    (pred_travel_time, pred_centered, weight) are updated by getTravelTimes() and the kernels,
+ *    and the EDT weights are written back to ArrivalDesc only in SaveBestLocation(). */
+typedef struct {
+    ArrivalDesc *arrival; // ArrivalDesc array this table was built from
+    int num_arrivals;
+    int num_alloc;
+    // per-event values
+    double *obs_centered;
+    long double *obs_time;
+    double *error;
+    double *amplitude;
+    double *station_weight;
+    double *apriori_weight;
+    int *abs_time;
+    // per-node values
+    double *pred_travel_time;
+    double *pred_centered;
+    double *weight;
+} ArrivalHotTable;
+
+int ArrivalHot_Build(ArrivalDesc *arrival, int num_arrivals);
+ArrivalHotTable* ArrivalHot_Get(ArrivalDesc *arrival, int num_arrivals);
+void ArrivalHot_LoadPred(ArrivalDesc *arrival, int num_arrivals);
+void ArrivalHot_Free();
+
+/** end of hot arrival table */
+/*------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------*/
+/** travel time cache at initial oct-tree nodes */
+
+/* The initial oct-tree nodes are the same for every event located in a LOCGRID, so the travel time
+ *    read from a time grid at each initial node is kept between events.  There is one cache for each
+ *    LOCGRID, with one entry for each time grid (GridDesc.title and station position, 2D grids are
+ *    shared by stations).  Raw grid values are cached, tfact and elevation and crust corrections are
+ *    applied to these values as for grid values. */
+// 20261016 agent - added
+
+#define TT_CACHE_HASHSIZE 1024
+#define TT_CACHE_MAX_BYTES (256 * 1024 * 1024)  // maximum size of node value arrays in cache for each thread
+
+typedef struct ttCacheEntry* TTCacheEntryPtr;
+typedef struct ttCacheEntry {
+    TTCacheEntryPtr next; // next entry with same hash value
+    char title[FILENAME_MAX]; // time grid identifier (GridDesc.title)
+    double station_x, station_y; // station position
+    double *value; // raw time grid value at each initial node
+    char *isset; // =1 if value at node is set
+} TTCacheEntry;
+
+typedef struct {
+    // initial oct-tree geometry, cache is cleared if this changes
+    int numx, numy, numz;
+    Vect3D orig;
+    Vect3D ds;
+    int isSpherical;
+    int num_nodes;
+    TTCacheEntry *entry[TT_CACHE_HASHSIZE]; // hash table of entries
+} TTCache;
+
+int TTCache_Attach(int ngrid, Tree3D* tree, ArrivalDesc *arrival, int num_arrivals);
+void TTCache_Detach();
+void TTCache_Free();
+
+/** end of travel time cache at initial oct-tree nodes */
+/*------------------------------------------------------------*/
+
+
+
+
+// 20261016 agent - added, memory streams (functions open_memstream, fmemopen) are POSIX.1-2008, also available with GNU C library extensions
+#if defined(_GNU_SOURCE) || (defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200809L)
+#define NLL_MEMSTREAM
+#endif
+
 
 /*------------------------------------------------------------*/
 /* function declarations */
 
 int NLLoc(char *pid_main, char *fn_control_main, char **param_line_array, int n_param_lines, char **obs_line_array, int n_obs_lines,
         int return_locations, int return_oct_tree_grid, int return_scatter_sample, LocNode **ploc_list_head);
+NLLocRun* NLLoc_Open(char *pid_main, char *fn_control_main, char **param_line_array, int n_param_lines, int locate_in_calling_thread, int *preturn_value);
+int NLLoc_LocateObs(NLLocRun *prun, char **obs_line_array, int n_obs_lines,
+        int return_locations, int return_oct_tree_grid, int return_scatter_sample, LocNode **ploc_list_head);
+int NLLoc_Close(NLLocRun *prun);
 
-int Locate(int ngrid, char* fn_loc_obs, char* fn_root_out, int numArrivalsReject, int return_locations, int return_oct_tree_grid, int return_scatter_sample, LocNode **ploc_list_head);
+int Locate(NLLocContext *pcontext, int ngrid, char* fn_obs, char* fn_root_out, int numArrivalsReject, int return_locations, int return_oct_tree_grid, int return_scatter_sample, LocNode **ploc_list_head);
 
 int checkObs(ArrivalDesc *arrival, int nobs);
 int ExtractFilenameInfo(char*, char*);
@@ -534,6 +729,24 @@ int GetNLLoc_Method(char*);
 int GetNLLoc_SearchType(char*);
 int GetNLLoc_PdfGrid(char*, int);
 int GetNLLoc_FixOriginTime(char*);
+int GetNLLoc_Parallel(char*);
+int GetNLLoc_MemBytes(char*);
+int GetNLLoc_GridLayout(char*);
+int GetNLLoc_GridROI(char*);
+void SetLocGridROI();
+int GetNLLoc_Prefetch(char*);
+int GetNLLoc_Perf(char*);
+double LocPerf_Time();
+double LocPerf_Stage(int stage, double time_start);
+void LocPerf_BeginEvent();
+void LocPerf_SetHypoLine();
+void LocPerf_EndEvent(char *fn_root_out, int iLocated);
+int LocPerf_OpenRun(char *fn_root);
+void LocPerf_CloseRun();
+void LocParallel_Reset();
+void LocParallel_SetTicket(long ticket);
+void LocParallel_BeginCommit();
+void LocParallel_EndCommit();
 int GetObservations(FILE*, char*, char*, ArrivalDesc*, int*, int*, int*, int, HypoDesc*, int*, int*, int);
 int GetNextObs(HypoDesc* phypo, FILE*, ArrivalDesc *, char*, int);
 int IsGoodDate(int, int, int);
@@ -569,21 +782,21 @@ int SaveBestLocation(OctNode* poct_node, int num_arr_total, int num_arr_loc, Arr
         GridDesc* ptgrid, GaussLocParams* gauss_par, HypoDesc* phypo,
         double misfit_max, int iGridType, int ignore_pred_travel_time_best,
         double cell_diagonal_time_var_best, double cell_diagonal_best, double cell_volume_best);
-int ConstWeightMatrix(int, ArrivalDesc*, GaussLocParams*);
+int ConstWeightMatrix(NLLocContext*, int, ArrivalDesc*, GaussLocParams*);
 int CleanWeightMatrix();
 void CalcCenteredTimesObs(int, ArrivalDesc*, GaussLocParams*, HypoDesc*);
 void CalcCenteredTimesPred(int, ArrivalDesc*, GaussLocParams*);
-double CalcSolutionQuality(double hypo_x, double hypo_y, double hypo_z, OctNode* poct_node, int num_arrivals, ArrivalDesc *arrival, GaussLocParams* gauss_par, int itype,
+double CalcSolutionQuality(NLLocContext *pcontext, double hypo_x, double hypo_y, double hypo_z, OctNode* poct_node, int num_arrivals, ArrivalDesc *arrival, GaussLocParams* gauss_par, int itype,
         double* pmisfit, double* potime, double* potime_var, double cell_diagonal_time_var, double cell_diagonal, double cell_volume, double* effective_cell_size, double *pot_variance_factor, double *prior);
-double CalcSolutionQuality_GAU_ANALYTIC(int, ArrivalDesc*, GaussLocParams*, int, double*, double*);
-double CalcSolutionQuality_GAU_TEST(int, ArrivalDesc*, GaussLocParams*, int, double*, double*);
-double CalcSolutionQuality_L1_NORM(int num_arrivals, ArrivalDesc *arrival,
+double CalcSolutionQuality_GAU_ANALYTIC(NLLocContext*, int, ArrivalDesc*, GaussLocParams*, int, double*, double*);
+double CalcSolutionQuality_GAU_TEST(NLLocContext*, int, ArrivalDesc*, GaussLocParams*, int, double*, double*);
+double CalcSolutionQuality_L1_NORM(NLLocContext *pcontext, int num_arrivals, ArrivalDesc *arrival,
         GaussLocParams* gauss_par, int itype, double* pmisfit, double* potime);
-double CalcSolutionQuality_EDT(int num_arrivals, ArrivalDesc *arrival, GaussLocParams* gauss_par, int itype, double* pmisfit, double* potime, double* potime_var, double cell_diagonal_time_var, int method_box);
-double CalcSolutionQuality_OT_STACK(OctNode* poct_node, int num_arrivals, ArrivalDesc *arrival,
+double CalcSolutionQuality_EDT(NLLocContext *pcontext, int num_arrivals, ArrivalDesc *arrival, GaussLocParams* gauss_par, int itype, double* pmisfit, double* potime, double* potime_var, double cell_diagonal_time_var, int method_box);
+double CalcSolutionQuality_OT_STACK(NLLocContext *pcontext, OctNode* poct_node, int num_arrivals, ArrivalDesc *arrival,
         GaussLocParams* gauss_par, int itype, double* pmisfit, double* potime, double* potime_var,
         double cell_half_diagonal_time_range, double cell_diagonal, double cell_volume, double* effective_cell_size, double *pot_variance_factor);
-double CalcSolutionQuality_ML_OT(int num_arrivals, ArrivalDesc *arrival, GaussLocParams* gauss_par, int itype, double* pmisfit, double* potime, double* potime_var, double cell_diagonal_time_var, int method_box);
+double CalcSolutionQuality_ML_OT(NLLocContext *pcontext, int num_arrivals, ArrivalDesc *arrival, GaussLocParams* gauss_par, int itype, double* pmisfit, double* potime, double* potime_var, double cell_diagonal_time_var, int method_box);
 double calc_maximum_likelihood_ot_sort(
         OctNode* poct_node, int num_arrivals, ArrivalDesc *arrival,
         double cell_half_diagonal_time_range, double cell_diagonal, double cell_volume, double *pot_var, int icalc_otime,
@@ -629,19 +842,20 @@ double Calc_MD_FMAG(double coda_dur, double dist, double depth, double sta_corr,
 
 int setStationDistributionWeights(SourceDesc *stations, int numStations, ArrivalDesc *arrival, int nArrivals);
 
-int getTravelTimes(ArrivalDesc *arrival, int num_arr_loc, double xval, double yval, double zval);
+int getTravelTimes(NLLocContext *pcontext, ArrivalDesc *arrival, int num_arr_loc, double xval, double yval, double zval);
+int getTravelTimesNode(ArrivalDesc *arrival, int num_arr_loc, double xval, double yval, double zval, int n_init_node);
 double applyCrustElevCorrection(ArrivalDesc* parrival, double xval, double yval, double zval);
 int isAboveTopo(double xval, double yval, double zval);
 
-Tree3D* InitializeOcttree(GridDesc* ptgrid, OcttreeParams* pParams);
-int LocOctree(int ngrid, int num_arr_total, int num_arr_loc,
+Tree3D* InitializeOcttree(GridDesc* ptgrid, OcttreeParams* pParams, int use_arena);
+int LocOctree(NLLocContext *pcontext, int ngrid, int num_arr_total, int num_arr_loc,
         ArrivalDesc *arrival,
         GridDesc* ptgrid, GaussLocParams* gauss_par, HypoDesc* phypo,
         OcttreeParams* pParams, Tree3D* pOctTree, float* fdata,
         double *poct_node_value_max, double *poct_tree_integral);
 long double LocOctree_core(int ngrid, double xval, double yval, double zval,
         int num_arr_loc, ArrivalDesc *arrival,
-        OctNode* poct_node,
+        OctNode* poct_node, int n_init_node,
         int icalc_cell_diagonal_time_var, double *volume_min,
         double *diagonal, double *cell_diagonal_time_var,
         OcttreeParams* pParams, GaussLocParams* gauss_par, int iGridType,
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+
+ * You should have received a copy of the GNU Lesser Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+/* edt_kernel.h include file */
+
+/* 	History:
+
+        ver 01    20261017  agent  Original version, EDT double kernel pair loop moved from NLLocLib.c
+
+ */
+
+
+#ifndef _EDT_KERNEL_H
+#define	_EDT_KERNEL_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+
+#define EDT_KERNEL_NLANES 8
+
+/* EDT double kernel pair loop input and output */
+typedef struct {
+    int num_arrivals;
+    ArrivalDesc *arrival; // for label/inst of arrivals without absolute timing
+    int *abs_time;
+    double *obs_centered;
+    double *pred_centered;
+    double *valid; // 1.0 = has predicted travel time, 0.0 = ignore
+    double *sigma2; // EDT covariance diagonal
+    double *amplitude;
+    double *sw; // sqrt of station weight
+    double *ap; // sqrt of a priori weight, < 0.0 = not used
+    MatrixDouble edtmtx;
+    double cell_diagonal_time_var;
+    int method_box;
+    // output
+    double *row_prob; // sum of probs for each arrival with following arrivals
+    double *col_prob; // sum of probs for each arrival with preceding arrivals
+    double edt_sum;
+    double edt_weight;
+} EDTKernelData;
+
+void edt_pair_sums(EDTKernelData *kd);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _EDT_KERNEL_H */
@@ -43,13 +43,18 @@
 #define VERY_SMALL_DOUBLE 1.0e-30
 #endif
 
+// storage class for globals that hold per-event state and must be private to each LOCPARALLEL location thread
+#ifndef NLL_THREAD_LOCAL
+#define NLL_THREAD_LOCAL __thread
+#endif
+
 extern char package_name[MAXLINE];
 extern char prog_name[MAXLINE];
 extern char prog_ver[MAXLINE];
 extern char prog_date[MAXLINE];
 extern char prog_copyright[MAXLINE];
-extern int message_flag;
-extern char MsgStr[100 * MAXLINE];
+extern NLL_THREAD_LOCAL int message_flag;
+extern NLL_THREAD_LOCAL char MsgStr[100 * MAXLINE];
 
 /*** function to copy file by Jan Wiszniowski 2022-01-31*/
 void copy_file(char* in_name, char* out_name);
@@ -93,6 +93,7 @@
 #include <math.h>
 
 #include "map_project.h"
+#include "util.h" // 20261017 agent - added for NLL_THREAD_LOCAL
 
 #define PI_2 (2.0*M_PI)
 #define D2R (M_PI/180.0)
@@ -157,26 +158,27 @@ struct ELLIPSOID ellipse[N_ELLIPSOIDS] = {
 // number of projections supported
 #define NUM_PROJ_MAX 10
 
-double EQ_RAD[NUM_PROJ_MAX];
-double ECC[NUM_PROJ_MAX], ECC2[NUM_PROJ_MAX], ECC4[NUM_PROJ_MAX], ECC6[NUM_PROJ_MAX];
+// 20261017 agent - projection parameters are thread local, set by the TRANS statement read by each thread
+NLL_THREAD_LOCAL double EQ_RAD[NUM_PROJ_MAX];
+NLL_THREAD_LOCAL double ECC[NUM_PROJ_MAX], ECC2[NUM_PROJ_MAX], ECC4[NUM_PROJ_MAX], ECC6[NUM_PROJ_MAX];
 //double M_PR_DEG;
 
 /* fields from struct MAP_PROJECTIONS taken from gmt_project.h,
         and converted to globals.
         WARNING - many fields removed! */
 
-BOOLEAN NorthPole[NUM_PROJ_MAX]; /* TRUE if projection is on northern
+NLL_THREAD_LOCAL BOOLEAN NorthPole[NUM_PROJ_MAX]; /* TRUE if projection is on northern
 					  hermisphere, FALSE on southern */
-double CentralMeridian[NUM_PROJ_MAX]; /* Central meridian for projection */
-double Pole[NUM_PROJ_MAX]; /* +90 pr -90, depending on which pole */
+NLL_THREAD_LOCAL double CentralMeridian[NUM_PROJ_MAX]; /* Central meridian for projection */
+NLL_THREAD_LOCAL double Pole[NUM_PROJ_MAX]; /* +90 pr -90, depending on which pole */
 
 
 /* Lambert conformal conic parameters.
                 (See Snyder for details on all parameters) */
 
-double LambertConfConic_N[NUM_PROJ_MAX];
-double LambertConfConic_F[NUM_PROJ_MAX];
-double LambertConfConic_rho0[NUM_PROJ_MAX];
+NLL_THREAD_LOCAL double LambertConfConic_N[NUM_PROJ_MAX];
+NLL_THREAD_LOCAL double LambertConfConic_F[NUM_PROJ_MAX];
+NLL_THREAD_LOCAL double LambertConfConic_rho0[NUM_PROJ_MAX];
 
 
 
@@ -334,7 +336,7 @@ struct TRANS_MERCATOR {
     double t_ic1, t_ic2, t_ic3, t_ic4;
 
 };
-struct TRANS_MERCATOR TransverseMercator[NUM_PROJ_MAX];
+NLL_THREAD_LOCAL struct TRANS_MERCATOR TransverseMercator[NUM_PROJ_MAX];
 
 /*
  *	TRANSFORMATION ROUTINES FOR THE Transverse Mercator Projection (TM)
@@ -595,7 +597,7 @@ struct AZIMUTHAL_EQUIDIST {
     double cosp;
 
 };
-struct AZIMUTHAL_EQUIDIST AzimuthalEquidistant[NUM_PROJ_MAX];
+NLL_THREAD_LOCAL struct AZIMUTHAL_EQUIDIST AzimuthalEquidistant[NUM_PROJ_MAX];
 
 
 /*
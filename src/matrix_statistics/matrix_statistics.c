@@ -44,7 +44,7 @@
 #define LARGE_DOUBLE 1.0e20
 #endif
 
-static char error_message[4096];
+static NLL_THREAD_LOCAL char error_message[4096];
 
 /** function to print error and return last error message */
 char *get_matrix_statistics_error_mesage() {
@@ -49,15 +49,25 @@ tel: +33(0)493752502  e-mail: anthony@alomax.net  web: http://www.alomax.net
 #include "ran1.h"
 #include "octtree.h"
 
+static OctNode* initOctNode(OctNode* node, OctNode* parent, Vect3D center, Vect3D ds, double value, void *pdata);
+
 /*** function to create a new OctNode */
 
 OctNode* newOctNode(OctNode* parent, Vect3D center, Vect3D ds, double value, void *pdata) {
 
-    int l, m, n;
     OctNode* node;
 
     node = (OctNode*) malloc(sizeof (OctNode));
 
+    return (initOctNode(node, parent, center, ds, value, pdata));
+}
+
+/*** function to initialize an allocated OctNode */
+
+static OctNode* initOctNode(OctNode* node, OctNode* parent, Vect3D center, Vect3D ds, double value, void *pdata) {
+
+    int l, m, n;
+
     node->parent = parent;
     node->center = center;
     node->ds = ds;
@@ -95,8 +105,16 @@ void freeTree3D(Tree3D* tree, int freeDataPointer) {
     for (ix = 0; ix < tree->numx; ix++) {
         for (iy = 0; iy < tree->numy; iy++) {
             for (iz = 0; iz < tree->numz; iz++) {
-                if (tree->nodeArray[ix][iy][iz] != NULL) // case of Tree3D_spherical
-                    freeNode(tree->nodeArray[ix][iy][iz], freeDataPointer);
+                if (tree->nodeArray[ix][iy][iz] != NULL) { // case of Tree3D_spherical
+                    if (tree->arena != NULL) {
+                        // 20261016 agent - child nodes are in arena, released by resetOctArena() or freeOctArena()
+                        if (freeDataPointer && tree->nodeArray[ix][iy][iz]->pdata != NULL)
+                            free(tree->nodeArray[ix][iy][iz]->pdata);
+                        free(tree->nodeArray[ix][iy][iz]);
+                    } else {
+                        freeNode(tree->nodeArray[ix][iy][iz], freeDataPointer);
+                    }
+                }
             }
             free(tree->nodeArray[ix][iy]);
         }
@@ -169,6 +187,7 @@ Tree3D* newTree3D(int data_code, int numx, int numy, int numz,
     tree->ds = ds;
     tree->integral = integral;
     tree->isSpherical = 0;
+    tree->arena = NULL;
 
     return (tree);
 
@@ -269,6 +288,7 @@ Tree3D* newTree3D_spherical(int data_code, int numx_nominal, int numy, int numz,
     tree->ds = tree_ds;
     tree->integral = integral;
     tree->isSpherical = 1;
+    tree->arena = NULL;
 
     return (tree);
 
@@ -291,8 +311,26 @@ double get_dx_spherical(double dx_nominal, double origx, double x_max, double ce
 
 void subdivide(OctNode* parent, double value, void *pdata) {
 
+    subdivideArena(parent, value, pdata, NULL);
+
+}
+
+/*** function to subdivide a node into child nodes, the 8 child nodes are allocated contiguously from arena if arena != NULL ***/
+
+// 20261016 agent - added
+
+void subdivideArena(OctNode* parent, double value, void *pdata, OctArena* arena) {
+
     int ix, iy, iz;
     Vect3D center, ds;
+    OctNode* children = NULL;
+
+    if (arena != NULL) {
+        if ((children = (OctNode*) allocOctArena(arena, 8 * sizeof (OctNode))) == NULL) {
+            fprintf(stderr, "ERROR allocating memory for octtree child nodes.\n");
+            return;
+        }
+    }
 
     ds.x = parent->ds.x / 2.0;
     ds.y = parent->ds.y / 2.0;
@@ -306,7 +344,10 @@ void subdivide(OctNode* parent, double value, void *pdata) {
             center.y = parent->center.y + (double) (2 * iy - 1) * ds.y / 2.0;
             for (iz = 0; iz < 2; iz++) {
                 center.z = parent->center.z + (double) (2 * iz - 1) * ds.z / 2.0;
-                parent->child[ix][iy][iz] = newOctNode(parent, center, ds, value, pdata);
+                if (children != NULL)
+                    parent->child[ix][iy][iz] = initOctNode(children++, parent, center, ds, value, pdata);
+                else
+                    parent->child[ix][iy][iz] = newOctNode(parent, center, ds, value, pdata);
             }
         }
     }
@@ -316,6 +357,96 @@ void subdivide(OctNode* parent, double value, void *pdata) {
 
 }
 
+/*** function to create a new node arena */
+
+// 20261016 agent - added
+// Nodes of an octtree search are allocated by bumping a pointer in large blocks.
+// Memory is released for all nodes at once by resetOctArena(), the blocks are kept for re-use by the next search.
+
+OctArena* newOctArena(size_t block_size) {
+
+    OctArena* arena;
+
+    if ((arena = (OctArena*) malloc(sizeof (OctArena))) == NULL)
+        return (NULL);
+    arena->first = arena->current = NULL;
+    arena->block_size = block_size > 0 ? block_size : OCT_ARENA_BLOCK_SIZE;
+
+    return (arena);
+}
+
+/*** function to allocate memory from a node arena, returns NULL on allocation error */
+
+#define OCT_ARENA_ALIGN 16
+
+void* allocOctArena(OctArena* arena, size_t size) {
+
+    OctArenaBlock* block;
+    void* ptr;
+
+    size = (size + OCT_ARENA_ALIGN - 1) & ~((size_t) OCT_ARENA_ALIGN - 1);
+
+    // advance to next kept block or create new block if current block is full
+    block = arena->current;
+    while (block == NULL || block->used + size > block->size) {
+        OctArenaBlock* next = block == NULL ? arena->first : block->next;
+        if (next == NULL) {
+            size_t block_size = size > arena->block_size ? size : arena->block_size;
+            if ((next = (OctArenaBlock*) malloc(sizeof (OctArenaBlock))) == NULL)
+                return (NULL);
+            if ((next->data = (char*) malloc(block_size)) == NULL) {
+                free(next);
+                return (NULL);
+            }
+            next->size = block_size;
+            next->next = NULL;
+            if (block == NULL)
+                arena->first = next;
+            else
+                block->next = next;
+        }
+        next->used = 0;
+        block = arena->current = next;
+    }
+
+    ptr = block->data + block->used;
+    block->used += size;
+
+    return (ptr);
+}
+
+/*** function to release all memory allocated from a node arena for re-use, O(1) */
+
+void resetOctArena(OctArena* arena) {
+
+    if (arena == NULL)
+        return;
+
+    arena->current = arena->first;
+    if (arena->first != NULL)
+        arena->first->used = 0;
+
+}
+
+/*** function to free a node arena and all its blocks */
+
+void freeOctArena(OctArena* arena) {
+
+    OctArenaBlock* block;
+    OctArenaBlock* next;
+
+    if (arena == NULL)
+        return;
+
+    for (block = arena->first; block != NULL; block = next) {
+        next = block->next;
+        free(block->data);
+        free(block);
+    }
+    free(arena);
+
+}
+
 /*** function to free an OctNode and all its child nodes ***/
 
 void freeNode(OctNode* node, int freeDataPointer) {
@@ -525,34 +656,44 @@ int extendedNodeContains(OctNode* node, double x, double y, double z, int checkZ
 
 ResultTreeNode* addResult(ResultTreeNode* prtree, double value, double volume, OctNode* pnode) {
 
-    // put address in result tree based on value
-
-    if (prtree == NULL) { // at empty node
-        if ((prtree = (ResultTreeNode*) malloc(sizeof (ResultTreeNode))) == NULL)
-            fprintf(stderr, "ERROR allocating memory for result-tree node.\n");
-        prtree->value = value;
-        prtree->level = pnode->level;
-        prtree->volume = volume; // node volume depends on geometry in physical space, may not be dx*dy*dz
-        prtree->pnode = pnode;
-        prtree->left = prtree->right = NULL;
-
-        /* 20101213 AJL removed this block - causes memory errors in trace_processing/location.c
-           } else if (value == prtree->value) { // prevent assymetric tree if multiple identical values
-            if (get_rand_int(-10000, 9999) < 0)
-                prtree->left = addResult(prtree->left, value, volume, pnode);
-            else
-                prtree->right = addResult(prtree->right, value, volume, pnode);
-         */
+    addResultNode(&prtree, value, volume, pnode, NULL);
 
-    } else if (value < prtree->value) {
-        prtree->left = addResult(prtree->left, value, volume, pnode);
+    return (prtree);
+}
 
-    } else {
+/*** function to put Octtree node in results tree in order of value, returns new result-tree node */
+
+// 20261016 agent - added, iterative version of addResult() (avoids deep recursion in unbalanced tree)
+
+ResultTreeNode* addResultNode(ResultTreeNode** pprtree, double value, double volume, OctNode* pnode, OctArena* arena) {
+
+    ResultTreeNode* prtree_new;
 
-        prtree->right = addResult(prtree->right, value, volume, pnode);
+    // find empty node in result tree based on value
+    while (*pprtree != NULL) {
+        if (value < (*pprtree)->value)
+            pprtree = &((*pprtree)->left);
+        else
+            pprtree = &((*pprtree)->right);
     }
 
-    return (prtree);
+    // nodes allocated from arena are released by resetOctArena(), do not call freeResultTree() for these nodes
+    if (arena != NULL)
+        prtree_new = (ResultTreeNode*) allocOctArena(arena, sizeof (ResultTreeNode));
+    else
+        prtree_new = (ResultTreeNode*) malloc(sizeof (ResultTreeNode));
+    if (prtree_new == NULL) {
+        fprintf(stderr, "ERROR allocating memory for result-tree node.\n");
+        return (NULL);
+    }
+    prtree_new->value = value;
+    prtree_new->level = pnode->level;
+    prtree_new->volume = volume; // node volume depends on geometry in physical space, may not be dx*dy*dz
+    prtree_new->pnode = pnode;
+    prtree_new->left = prtree_new->right = NULL;
+    *pprtree = prtree_new;
+
+    return (prtree_new);
 }
 
 /*** function to free results tree */
@@ -637,6 +778,164 @@ ResultTreeNode* getHighestLeafValueMinSize(ResultTreeNode* prtree, double sizeMi
 }
 
 
+/*** priority queue of result-tree leaf nodes for oct-tree search */
+
+// 20261016 agent - added
+//    Binary max-heaps of result-tree nodes ordered by value, and for equal values by insertion order (later first),
+//    so the nodes returned are the same as for getHighestLeafValue() and getHighestLeafValueMinSize() on the result tree.
+//    Nodes that are no longer leaves (subdivided) are removed lazily when they reach the top of a heap.
+//    Leaf nodes smaller than the minimum size are moved to a second heap by getHighestLeafValueMinSizeQueue(),
+//    assumes the minimum size does not decrease during a search.
+
+#define RESULT_HEAP_SIZE_INIT 1024
+
+/** returns 1 if heap entry a has priority over entry b */
+
+static int resultHeapPriority(ResultHeapEntry* a, ResultHeapEntry* b) {
+
+    if (a->prtn->value > b->prtn->value)
+        return (1);
+    if (a->prtn->value == b->prtn->value && a->order > b->order)
+        return (1);
+
+    return (0);
+}
+
+static int resultHeapPush(ResultHeap* pheap, ResultTreeNode* prtn, long order) {
+
+    int n, nparent;
+    ResultHeapEntry entry;
+
+    if (pheap->num >= pheap->size) {
+        int size_new = pheap->size > 0 ? 2 * pheap->size : RESULT_HEAP_SIZE_INIT;
+        ResultHeapEntry* entry_new = (ResultHeapEntry*) realloc(pheap->entry, size_new * sizeof (ResultHeapEntry));
+        if (entry_new == NULL) {
+            fprintf(stderr, "ERROR allocating memory for result-heap.\n");
+            return (-1);
+        }
+        pheap->entry = entry_new;
+        pheap->size = size_new;
+    }
+
+    entry.prtn = prtn;
+    entry.order = order;
+
+    // sift up
+    n = pheap->num++;
+    while (n > 0) {
+        nparent = (n - 1) / 2;
+        if (!resultHeapPriority(&entry, pheap->entry + nparent))
+            break;
+        pheap->entry[n] = pheap->entry[nparent];
+        n = nparent;
+    }
+    pheap->entry[n] = entry;
+
+    return (0);
+}
+
+static void resultHeapPop(ResultHeap* pheap) {
+
+    int n, nchild;
+    ResultHeapEntry entry;
+
+    if (pheap->num < 1)
+        return;
+
+    entry = pheap->entry[--pheap->num];
+
+    // sift down
+    n = 0;
+    while ((nchild = 2 * n + 1) < pheap->num) {
+        if (nchild + 1 < pheap->num && resultHeapPriority(pheap->entry + nchild + 1, pheap->entry + nchild))
+            nchild++;
+        if (!resultHeapPriority(pheap->entry + nchild, &entry))
+            break;
+        pheap->entry[n] = pheap->entry[nchild];
+        n = nchild;
+    }
+    pheap->entry[n] = entry;
+
+}
+
+/** removes subdivided (non-leaf) nodes from top of heap, returns top entry or NULL if heap empty */
+
+static ResultHeapEntry* resultHeapTopLeaf(ResultHeap* pheap) {
+
+    while (pheap->num > 0 && !pheap->entry[0].prtn->pnode->isLeaf)
+        resultHeapPop(pheap);
+
+    return (pheap->num > 0 ? pheap->entry : NULL);
+}
+
+/*** function to create an empty result queue */
+
+ResultQueue* newResultQueue() {
+
+    ResultQueue* pqueue;
+
+    if ((pqueue = (ResultQueue*) calloc(1, sizeof (ResultQueue))) == NULL)
+        fprintf(stderr, "ERROR allocating memory for result-queue.\n");
+
+    return (pqueue);
+}
+
+/*** function to free result queue, does not free result-tree nodes */
+
+void freeResultQueue(ResultQueue* pqueue) {
+
+    if (pqueue == NULL)
+        return;
+
+    free(pqueue->heap.entry);
+    free(pqueue->heap_small.entry);
+    free(pqueue);
+}
+
+/*** function to put result-tree node in result queue */
+
+int addResultQueue(ResultQueue* pqueue, ResultTreeNode* prtn) {
+
+    if (pqueue == NULL || prtn == NULL)
+        return (-1);
+
+    return (resultHeapPush(&(pqueue->heap), prtn, pqueue->num_added++));
+}
+
+/*** function to get result-queue leaf node with highest value */
+
+ResultTreeNode* getHighestLeafValueQueue(ResultQueue* pqueue) {
+
+    ResultHeapEntry* pentry = resultHeapTopLeaf(&(pqueue->heap));
+    ResultHeapEntry* pentry_small = resultHeapTopLeaf(&(pqueue->heap_small));
+
+    if (pentry == NULL || (pentry_small != NULL && resultHeapPriority(pentry_small, pentry)))
+        pentry = pentry_small;
+
+    return (pentry == NULL ? NULL : pentry->prtn);
+}
+
+/*** function to get result-queue leaf node with highest value, node must be larger than specified minimum size */
+
+ResultTreeNode* getHighestLeafValueMinSizeQueue(ResultQueue* pqueue, double sizeMinX, double sizeMinY, double sizeMinZ) {
+
+    ResultHeapEntry* pentry;
+    OctNode* pnode;
+
+    while ((pentry = resultHeapTopLeaf(&(pqueue->heap))) != NULL) {
+        pnode = pentry->prtn->pnode;
+        if (pnode->ds.x >= sizeMinX && pnode->ds.y >= sizeMinY && pnode->ds.z >= sizeMinZ) // not too small
+            return (pentry->prtn);
+        // too small, move to heap of small nodes
+        if (resultHeapPush(&(pqueue->heap_small), pentry->prtn, pentry->order) < 0)
+            return (NULL);
+        resultHeapPop(&(pqueue->heap));
+    }
+
+    return (NULL);
+}
+
+
 #define SIZE_TOLERANCE 1.0e-20
 
 /*** function to get ResultTree Leaf Node with highest value, node size must be less than or equal to specified maximum size */
@@ -81,6 +81,27 @@ typedef struct octnode
 
 
 
+/* bump allocator for nodes of one octtree search */
+// 20261016 agent - added
+
+#define OCT_ARENA_BLOCK_SIZE (4 * 1024 * 1024)	/* default arena block size (bytes) */
+
+typedef struct octArenaBlock* OctArenaBlockPtr;
+typedef struct octArenaBlock {
+	OctArenaBlockPtr next;		/* next block in arena */
+	size_t size;			/* usable size of block (bytes) */
+	size_t used;			/* bytes used in block */
+	char* data;			/* block memory */
+} OctArenaBlock;
+
+typedef struct {
+	OctArenaBlock* first;		/* first block, blocks are kept between resets */
+	OctArenaBlock* current;		/* block currently allocated from */
+	size_t block_size;		/* default block size (bytes) */
+} OctArena;
+
+
+
 /* 3D tree with Nx, Ny, Nz arbitrary */
 
 typedef struct
@@ -94,6 +115,7 @@ typedef struct
         int* num_x;                 // array of true num_x values for spherical case
 	double integral;
         int isSpherical;            // =1 if Tree3D is spherical, 0 otherwise
+        OctArena* arena;            // arena holding all non-root nodes, NULL if nodes allocated individually, not owned by tree // 20261016 agent - added
 }
 Tree3D;
 
@@ -110,6 +132,26 @@ typedef struct resultTreeNode {
 	OctNode* pnode;			/* corresponding octree node */
 } ResultTreeNode;
 
+/* priority queue of result-tree leaf nodes */
+// 20261016 agent - added
+
+typedef struct {
+	ResultTreeNode* prtn;		/* result-tree node */
+	long order;			/* insertion order */
+} ResultHeapEntry;
+
+typedef struct {
+	ResultHeapEntry* entry;		/* binary max-heap array */
+	int num;			/* number of entries */
+	int size;			/* allocated size */
+} ResultHeap;
+
+typedef struct {
+	ResultHeap heap;		/* leaf nodes */
+	ResultHeap heap_small;		/* leaf nodes smaller than search minimum size */
+	long num_added;			/* number of nodes added */
+} ResultQueue;
+
 
 
 /* */
@@ -142,6 +184,11 @@ Tree3D* newTree3D_spherical(int data_code, int numx_nominal, int numy, int numz,
 double get_dx_spherical(double dx_nominal, double origx, double x_max, double center_y, int *pnum_x);
 OctNode* newOctNode(OctNode* parent, Vect3D center, Vect3D ds, double value, void *pdata);
 void subdivide(OctNode* parent, double value, void *pdata);
+void subdivideArena(OctNode* parent, double value, void *pdata, OctArena* arena);
+OctArena* newOctArena(size_t block_size);
+void* allocOctArena(OctArena* arena, size_t size);
+void resetOctArena(OctArena* arena);
+void freeOctArena(OctArena* arena);
 void freeTree3D(Tree3D* tree, int freeDataPointer);
 void freeNode(OctNode* node, int freeDataPointer);
 OctNode* getTreeNodeContaining(Tree3D* tree, Vect3D coords, double *padjusted_coords_x);
@@ -149,6 +196,7 @@ OctNode* getLeafNodeContaining(Tree3D* tree, Vect3D coords);
 OctNode* getLeafContaining(OctNode* node, double x, double y, double z);
 
 ResultTreeNode* addResult(ResultTreeNode* prtn, double value, double volume, OctNode* pnode);
+ResultTreeNode* addResultNode(ResultTreeNode** pprtree, double value, double volume, OctNode* pnode, OctArena* arena);
 void freeResultTree(ResultTreeNode* prtn);
 ResultTreeNode* getHighestValue(ResultTreeNode* prtn);
 ResultTreeNode* getHighestLeafValue(ResultTreeNode* prtree);
@@ -158,6 +206,11 @@ ResultTreeNode* getHighestLeafValueOfSpecifiedSize(ResultTreeNode* prtree, doubl
 ResultTreeNode* getHighestLeafValueAtSpecifiedLevel(ResultTreeNode* prtree, int level);
 ResultTreeNode* getHighestLeafValueLESpecifiedLevel(ResultTreeNode* prtree, int level);
 ResultTreeNode* getHighestLeafValueGESpecifiedLevel(ResultTreeNode* prtree, int level);
+ResultQueue* newResultQueue();
+void freeResultQueue(ResultQueue* pqueue);
+int addResultQueue(ResultQueue* pqueue, ResultTreeNode* prtn);
+ResultTreeNode* getHighestLeafValueQueue(ResultQueue* pqueue);
+ResultTreeNode* getHighestLeafValueMinSizeQueue(ResultQueue* pqueue, double sizeMinX, double sizeMinY, double sizeMinZ);
 
 Tree3D* readTree3D(FILE *fpio);
 int readNode(FILE *fpio, OctNode* node);
@@ -2,6 +2,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
 #include "ran1.h"
 
 
@@ -98,9 +99,13 @@ void test_rand_int()
  *	Global variables for rstart & uni
  */
 
-double uni_u[98];	/* Was U(97) in Fortran version -- too lazy to fix */
-double uni_c, uni_cd, uni_cm;
-int uni_ui, uni_uj;
+NLL_THREAD_LOCAL double uni_u[98];	/* Was U(97) in Fortran version -- too lazy to fix */
+NLL_THREAD_LOCAL double uni_c, uni_cd, uni_cm;
+NLL_THREAD_LOCAL int uni_ui, uni_uj;
+
+/* current random number stream of thread (see random number streams below) */
+NLL_THREAD_LOCAL int rand_type = RAND_STREAM_UNI;	/* 20261016 agent - added */
+NLL_THREAD_LOCAL uint64_t xoshiro_s[4];		/* xoshiro256** state */
 
  double uni(void)
 {
@@ -146,6 +151,7 @@ int uni_ui, uni_uj;
 	uni_cm = 16777213.0 / 16777216.0;
 	uni_ui = 97;	/*  There is a bug in the original Fortran version */
 	uni_uj = 33;	/*  of UNI -- i and j should be SAVEd in UNI()     */
+	rand_type = RAND_STREAM_UNI;	/* 20261016 agent - added, UNI is current stream of thread */
 }
 
 
@@ -232,3 +238,177 @@ void rinit(int ijkl)
 }
 
 
+
+
+
+/*//////// random number streams */
+
+/*
+ *	A random number stream (RandStream) holds the state of one generator:
+ *	the classic UNI generator above, or xoshiro256** (D. Blackman and
+ *	S. Vigna, "Scrambled linear pseudorandom number generators", 2018)
+ *	seeded through splitmix64, which gives independent, reproducible
+ *	streams from a (seed, index) pair, e.g. (run seed, event number) or
+ *	(event stream, chain number).
+ *
+ *	get_rand_double(), get_rand_int() and RAND_FUNC() draw from the current
+ *	stream of the calling thread.  This is the UNI generator set up by
+ *	SRAND_FUNC() (rinit()) unless another stream is made current with
+ *	rand_stream_set(), so programs that only use SRAND_FUNC() give the
+ *	same numbers as before.
+ *
+ *	20261016 agent - added
+ */
+
+static inline uint64_t rotl64(const uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t splitmix64(uint64_t *x)
+{
+	uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+static inline uint64_t xoshiro_next(uint64_t *s)
+{
+	const uint64_t result = rotl64(s[1] * 5, 7) * 9;
+	const uint64_t t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl64(s[3], 45);
+	return result;
+}
+
+/* ~rand_next: next number in [0,1) from the current stream of the thread */
+
+double rand_next(void)
+{
+	if (rand_type == RAND_STREAM_XOSHIRO)
+		return (double) (xoshiro_next(xoshiro_s) >> 11) * 0x1.0p-53;
+	return uni();
+}
+
+/* ~rand_stream_seed: set up an xoshiro256** stream from seed and index,
+ *	different (seed, index) pairs give independent streams
+ */
+
+void rand_stream_seed(RandStream *stream, uint64_t seed, uint64_t index)
+{
+	int n;
+	uint64_t x = splitmix64(&seed) ^ (index * 0xd1342543de82ef95ULL + 0x2545f4914f6cdd1dULL);
+
+	stream->type = RAND_STREAM_XOSHIRO;
+	for (n = 0; n < 4; n++)
+		stream->s[n] = splitmix64(&x);
+}
+
+/* ~rand_stream_split: set up an xoshiro256** stream from a seed drawn
+ *	from the current stream of the thread and index
+ */
+
+void rand_stream_split(RandStream *stream, uint64_t index)
+{
+	uint64_t seed;
+
+	if (rand_type == RAND_STREAM_XOSHIRO)
+		seed = xoshiro_next(xoshiro_s);
+	else
+		seed = ((uint64_t) (uni() * 4294967296.0) << 32) ^ (uint64_t) (uni() * 4294967296.0);
+	rand_stream_seed(stream, seed, index);
+}
+
+/* ~rand_stream_jump: advance an xoshiro256** stream by 2^128 numbers,
+ *	gives non-overlapping sub-streams of one stream
+ */
+
+void rand_stream_jump(RandStream *stream)
+{
+	static const uint64_t jump[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+		0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+	uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	int i, b;
+
+	if (stream->type != RAND_STREAM_XOSHIRO)
+		return;
+	for (i = 0; i < 4; i++) {
+		for (b = 0; b < 64; b++) {
+			if (jump[i] & ((uint64_t) 1 << b)) {
+				s0 ^= stream->s[0];
+				s1 ^= stream->s[1];
+				s2 ^= stream->s[2];
+				s3 ^= stream->s[3];
+			}
+			xoshiro_next(stream->s);
+		}
+	}
+	stream->s[0] = s0;
+	stream->s[1] = s1;
+	stream->s[2] = s2;
+	stream->s[3] = s3;
+}
+
+/* ~rand_stream_get, rand_stream_set: save the current stream of the
+ *	thread, make a stream the current stream of the thread (e.g. to
+ *	continue a Metropolis chain on any thread)
+ */
+
+void rand_stream_get(RandStream *stream)
+{
+	int n;
+
+	stream->type = rand_type;
+	if (rand_type == RAND_STREAM_XOSHIRO) {
+		for (n = 0; n < 4; n++)
+			stream->s[n] = xoshiro_s[n];
+		return;
+	}
+	for (n = 0; n < 98; n++)
+		stream->uni.u[n] = uni_u[n];
+	stream->uni.c = uni_c;
+	stream->uni.cd = uni_cd;
+	stream->uni.cm = uni_cm;
+	stream->uni.ui = uni_ui;
+	stream->uni.uj = uni_uj;
+}
+
+void rand_stream_set(const RandStream *stream)
+{
+	int n;
+
+	rand_type = stream->type;
+	if (rand_type == RAND_STREAM_XOSHIRO) {
+		for (n = 0; n < 4; n++)
+			xoshiro_s[n] = stream->s[n];
+		return;
+	}
+	for (n = 0; n < 98; n++)
+		uni_u[n] = stream->uni.u[n];
+	uni_c = stream->uni.c;
+	uni_cd = stream->uni.cd;
+	uni_cm = stream->uni.cm;
+	uni_ui = stream->uni.ui;
+	uni_uj = stream->uni.uj;
+}
+
+/* ~rand_stream_double, rand_stream_int: draw directly from an xoshiro256**
+ *	stream, without making it the current stream of the thread
+ */
+
+double rand_stream_double(RandStream *stream, const double xmin, const double xmax)
+{
+	return (xmin + (double) (xoshiro_next(stream->s) >> 11) * 0x1.0p-53 * (xmax - xmin));
+}
+
+int rand_stream_int(RandStream *stream, const int imin, const int imax)
+{
+	return (imin + (int) ((double) (xoshiro_next(stream->s) >> 11) * 0x1.0p-53 * (double) (imax - imin + 1)));
+}
@@ -2,6 +2,13 @@
 #ifndef _RAN1_H
 #define _RAN1_H
 
+#include <stdint.h>
+
+// generator state is private to each LOCPARALLEL location thread
+#ifndef NLL_THREAD_LOCAL
+#define NLL_THREAD_LOCAL __thread
+#endif
+
 
 int get_rand_int(const int, const int);
 double get_rand_double(const double, const double);
@@ -35,7 +42,7 @@ void test_rand_int();
 /* UNI */
 
 #define SRAND_FUNC(x) rinit((int) x)
-#define RAND_FUNC() uni()
+#define RAND_FUNC() rand_next()
 #define RAND_MAX1 1.0
 
 
@@ -63,5 +70,36 @@ double uni(void);
 void rstart(int i, int j, int k, int l);
 void rinit(int ijkl);
 
+/* UNI generator state */
+// 20261016 agent - added
+typedef struct {
+	double u[98];
+	double c, cd, cm;
+	int ui, uj;
+} UniState;
+
+
+
+/*//////// random number streams */
+// 20261016 agent - added
+
+#define RAND_STREAM_UNI 0	/* UNI generator (rinit(), uni()) */
+#define RAND_STREAM_XOSHIRO 1	/* xoshiro256** generator seeded from (seed, index) */
+
+typedef struct {
+	int type;
+	UniState uni;
+	uint64_t s[4];
+} RandStream;
+
+double rand_next(void);
+void rand_stream_seed(RandStream *stream, uint64_t seed, uint64_t index);
+void rand_stream_split(RandStream *stream, uint64_t index);
+void rand_stream_jump(RandStream *stream);
+void rand_stream_get(RandStream *stream);
+void rand_stream_set(const RandStream *stream);
+double rand_stream_double(RandStream *stream, const double xmin, const double xmax);
+int rand_stream_int(RandStream *stream, const int imin, const int imax);
+
 
 #endif
@@ -44,8 +44,8 @@ char prog_name[MAXLINE];
 char prog_ver[MAXLINE];
 char prog_date[MAXLINE];
 char prog_copyright[MAXLINE];
-int message_flag;
-char MsgStr[100 * MAXLINE];
+NLL_THREAD_LOCAL int message_flag; // 20261016 agent - thread local, so message output can be set per thread (e.g. look-ahead grid prefetch thread)
+NLL_THREAD_LOCAL char MsgStr[100 * MAXLINE];
 
 
 